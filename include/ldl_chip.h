@@ -37,11 +37,17 @@
  * - LDL_Chip_read()
  * - LDL_Chip_write()
  * - LDL_Chip_reset()
+ * - LDL_Chip_submit() (only if #LDL_ENABLE_CHIP_ASYNC is defined)
  * 
  * The following interface MUST be called when the radio signals an interrupt:
  * 
  * - LDL_Radio_interrupt()
  * 
+ * The following interface MUST be called when a batch passed to LDL_Chip_submit()
+ * has completed:
+ * 
+ * - LDL_Radio_chipComplete()
+ * 
  * The @ref ldl_radio_connector must be implemented in such a way as to ensure that LDL_Radio_interrupt()
  * will not be called before LDL_MAC_init() has been performed.
  * 
@@ -86,6 +92,8 @@
  *  - The radio connector needs to detect the rising edge and call LDL_Radio_interrupt() with the line number as argument
  *  - Edge detection can be by interrupt or polling
  *  - If interrupt is used, LDL_SYSTEM_ENTER_CRITICAL() and LDL_SYSTEM_LEAVE_CRITICAL() must be defined
+ *  - If #LDL_ENABLE_FSK is defined, DIO1 must be signalled on both edges since the FSK FIFO is
+ *    serviced from LDL_Radio_interrupt() as FifoLevel changes
  * - DIOx interrupt example:
  * 
  * @code{.c}
@@ -108,7 +116,45 @@
  *   LDL_Radio_interrupt(&radio, 3);
  * }
  * @endcode
- * 
+ *
+ * ### SX1261 and SX1262
+ *
+ * The following connections are required:
+ *
+ * | signal | direction    | type                    | polarity    |
+ * |--------|--------------|-------------------------|-------------|
+ * | MOSI   | input        | hiz                     |             |
+ * | MISO   | output       | push-pull/hiz           |             |
+ * | SCK    | input        | hiz                     |             |
+ * | NSS    | input        | hiz                     | active-low  |
+ * | Reset  | input/output | open-collector + pullup | active-low  |
+ * | BUSY   | output       | push-pull               | active-high |
+ * | DIO1   | output       | push-pull               | active-high |
+ *
+ * - The driver uses the command interface: `addr` is the opcode
+ *  - LDL_Chip_write() sends the opcode followed by the parameters
+ *  - LDL_Chip_read() sends the opcode then clocks out the bytes already
+ *    in `data` while reading into the same place, so the bytes read
+ *    begin with the status byte(s) the chip returns in place of the NOP
+ *    (and offset/address) bytes. The driver fills `data` with 0x00
+ *    except for the offset of ReadBuffer (0x1E).
+ * - BUSY must be low before NSS is asserted. The exception is the
+ *   transaction that follows SetSleep (0x84) which wakes the chip.
+ * - With #LDL_ENABLE_CHIP_ASYNC each transfer passed to
+ *   LDL_Chip_submit() says whether BUSY must be waited for
+ *   (ldl_chip_xfer.wait). The wait is a step of the connector's
+ *   transfer state machine (e.g. arm an interrupt on the falling edge
+ *   of BUSY and select the chip from there) so that neither the
+ *   connector nor the main loop spins on BUSY. `wait` is clear for the
+ *   transfer that wakes the chip.
+ * - All interrupts are routed to DIO1. The radio connector needs to
+ *   detect the rising edge and call LDL_Radio_interrupt() with 1 as the
+ *   argument. LDL_Radio_interrupt() does not access the chip; RX done
+ *   and RX timeout are told apart when the MAC collects the frame.
+ * - DIO2 and DIO3 are only driven by the chip if
+ *   #LDL_ENABLE_SX126X_DIO2_RF_SWITCH and #LDL_ENABLE_SX126X_TCXO
+ *   are defined
+ *
  * 
  * @{
  * */
@@ -159,6 +205,45 @@ void LDL_Chip_write(void *self, uint8_t addr, const void *data, uint8_t size);
  * */
 void LDL_Chip_read(void *self, uint8_t addr, void *data, uint8_t size);
 
+#ifdef LDL_ENABLE_CHIP_ASYNC
+
+/** One transfer in a batch passed to LDL_Chip_submit() */
+struct ldl_chip_xfer {
+    
+    uint8_t addr;           /**< register address */
+    const void *write;      /**< bytes to write (NULL for a read) */
+    void *read;             /**< read into this buffer (NULL for a write) */
+    uint8_t size;           /**< size of transfer in bytes */
+    bool wait;              /**< wait for the chip to be ready (SX126x BUSY low) before selecting it */
+};
+
+/** Start a batch of transfers and return without waiting
+ * 
+ * @param[in] self      board from LDL_Radio_init()
+ * @param[in] xfer      transfers to perform in order
+ * @param[in] count     number of transfers
+ * 
+ * Each transfer must be performed exactly as LDL_Chip_write() or
+ * LDL_Chip_read() would perform it (i.e. one chip select per transfer).
+ * A transfer with `wait` set is not started until the chip is ready;
+ * the connector should complete this wait asynchronously rather than
+ * poll for it.
+ * LDL_Radio_chipComplete() must be called once the last transfer has
+ * finished. This may be from an interrupt (e.g. DMA complete).
+ * 
+ * The transfers and the buffers they point to remain valid until
+ * LDL_Radio_chipComplete() is called. The driver will not call
+ * LDL_Chip_read(), LDL_Chip_write() or LDL_Chip_submit() while a batch
+ * is in progress.
+ * 
+ * A batch in progress should be abandoned if LDL_Chip_reset() is called
+ * to hold the chip in reset.
+ * 
+ * */
+void LDL_Chip_submit(void *self, const struct ldl_chip_xfer *xfer, uint8_t count);
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,6 +51,7 @@ struct ldl_frame_data {
     bool adr;
     bool adrAckReq;
     bool pending;
+    bool classB;
 
     const uint8_t *opts;
     uint8_t optsLen;
@@ -129,15 +130,51 @@ struct ldl_frame_down {
     uint32_t mic;    
 };
 
+struct ldl_frame_up {
+
+    enum ldl_frame_type type;
+    
+    uint32_t devAddr;
+    uint16_t counter;
+    bool ack;
+    bool adr;
+    bool adrAckReq;
+    bool classB;
+
+    uint8_t *opts;      /* NULL when not present */
+    uint8_t optsLen;    /* 0..15; 0 when not present */
+
+    bool dataPresent;   /* possible to have port without data */
+
+    uint8_t port;       /* valid when dataPresent is true */
+    
+    uint8_t *data;      /* NULL when not present */
+    uint8_t dataLen;    /* 0 when not present */
+    
+    uint32_t mic;    
+};
+
+struct ldl_frame_beacon {
+    
+    uint32_t time;      /* GPS seconds */
+    
+    const uint8_t *gwSpecific;  /* NULL when second CRC fails */
+};
+
 /* function prototypes ************************************************/
 
 void LDL_Frame_updateMIC(void *msg, uint8_t len, uint32_t mic);
 uint8_t LDL_Frame_putData(const struct ldl_frame_data *f, void *out, uint8_t max, struct ldl_frame_data_offset *off);
 uint8_t LDL_Frame_putJoinRequest(const struct ldl_frame_join_request *f, void *out, uint8_t max);
 uint8_t LDL_Frame_putRejoinRequest(const struct ldl_frame_rejoin_request *f, void *out, uint8_t max);
+bool LDL_Frame_peek(const void *in, uint8_t len, enum ldl_frame_type *type);
 bool LDL_Frame_decode(struct ldl_frame_down *f, void *in, uint8_t len);
+bool LDL_Frame_decodeUp(struct ldl_frame_up *f, void *in, uint8_t len);
+
+bool LDL_Frame_decodeBeacon(struct ldl_frame_beacon *f, const void *in, uint8_t len);
 
 uint8_t LDL_Frame_sizeofJoinAccept(bool withCFList);
+uint8_t LDL_Frame_sizeofBeacon(void);
 uint8_t LDL_Frame_getPhyPayloadSize(uint8_t dataLen, uint8_t optsLen);
 uint8_t LDL_Frame_phyOverhead(void);
 uint8_t LDL_Frame_dataOverhead(void);
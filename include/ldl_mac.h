@@ -95,6 +95,12 @@
  * - LDL_MAC_enableADR()
  * - LDL_MAC_disableADR()
  * - LDL_MAC_setMaxDCycle()
+ * - LDL_MAC_enableCAD() (if #LDL_ENABLE_CAD)
+ * - LDL_MAC_disableCAD() (if #LDL_ENABLE_CAD)
+ * - LDL_MAC_enableClassC() (if #LDL_ENABLE_CLASS_C)
+ * - LDL_MAC_disableClassC() (if #LDL_ENABLE_CLASS_C)
+ * - LDL_MAC_enableClassB() (if #LDL_ENABLE_CLASS_B)
+ * - LDL_MAC_disableClassB() (if #LDL_ENABLE_CLASS_B)
  * 
  * Data services are not available until #ldl_mac is joined to a network.
  * The join procedure is initiated by calling LDL_MAC_otaa(). LDL_MAC_otaa() will return false if the join procedure cannot be initiated. The application
@@ -126,6 +132,12 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+
+/* frames collected in the background (or into the TX buffer) must
+ * outlive LDL_MAC_process() */
+#if !defined(LDL_ENABLE_STATIC_RX_BUFFER) && (defined(LDL_ENABLE_SHARED_BUFFER) || defined(LDL_ENABLE_CHIP_ASYNC) || defined(LDL_ENABLE_FSK))
+#   define LDL_ENABLE_STATIC_RX_BUFFER
+#endif
  
 struct ldl_mac;
 struct ldl_sm;
@@ -212,7 +224,29 @@ enum ldl_mac_response_type {
     /** deviceTimeAns receieved
      * 
      * */
-    LDL_MAC_DEVICE_TIME
+    LDL_MAC_DEVICE_TIME,
+    
+    /** diagnostic event: beacon window opened (class B) */
+    LDL_MAC_BEACON_SLOT,
+    
+    /** diagnostic event: ping slot opened (class B) */
+    LDL_MAC_PING_SLOT,
+    
+    /** beacon received (class B)
+     * 
+     * Ping slots are open until the beacon is lost.
+     * 
+     * */
+    LDL_MAC_BEACON,
+    
+    /** beacon expected but not received (class B) */
+    LDL_MAC_BEACON_MISSED,
+    
+    /** too many beacons missed; ping slots are closed until the 
+     * time is learnt and the beacon acquired again (class B) 
+     * 
+     * */
+    LDL_MAC_BEACON_LOST
 };
 
 struct ldl_mac_session;
@@ -229,6 +263,7 @@ union ldl_mac_response_arg {
         
         int16_t rssi;   /**< rssi of frame */
         int16_t snr;    /**< snr of frame */
+        int32_t freqError;  /**< estimated carrier frequency error (Hz) */
         uint8_t size;   /**< size of frame */
         
     } downstream;
@@ -251,7 +286,7 @@ union ldl_mac_response_arg {
         
     } link_status;
     
-    /** #LDL_MAC_RX1_SLOT and #LDL_MAC_RX2_SLOT argument */
+    /** #LDL_MAC_RX1_SLOT, #LDL_MAC_RX2_SLOT, #LDL_MAC_BEACON_SLOT and #LDL_MAC_PING_SLOT argument */
     struct {
     
         uint32_t margin;                /**< allowed error margin */
@@ -296,6 +331,15 @@ union ldl_mac_response_arg {
         
     } device_time;
     
+    /** #LDL_MAC_BEACON argument */
+    struct {
+        
+        uint32_t time;      /**< GPS time of beacon (seconds) */
+        int16_t rssi;       /**< rssi of beacon */
+        int16_t snr;        /**< snr of beacon */
+        
+    } beacon;
+    
     /** #LDL_MAC_JOIN_COMPLETE argument */
     struct {
         
@@ -320,6 +364,74 @@ union ldl_mac_response_arg {
  * */
 typedef void (*ldl_mac_response_fn)(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg);
 
+#ifdef LDL_ENABLE_TRACE
+/** Trace record types
+ * 
+ * A trace is made of two kinds of record:
+ * 
+ * - inputs consumed by #ldl_mac (ticks, random numbers, received frames, etc.)
+ * - calls made into #ldl_mac that may consume inputs or change state
+ * 
+ * Repeating the calls in the order they were recorded while feeding
+ * back the inputs will reproduce the session exactly. LDL_MAC_init() is
+ * not recorded and must be called with the same arguments before replay.
+ * 
+ * Multi-byte fields are little-endian. The format of each record
+ * is given as header fields followed by (optional) data.
+ * 
+ * @see #ldl_mac_trace_fn
+ * 
+ * */
+enum ldl_mac_trace_type {
+    
+    LDL_TRACE_TICKS,            /**< input: LDL_System_ticks() (u32) */
+    LDL_TRACE_RAND,             /**< input: LDL_System_rand() (u8) */
+    LDL_TRACE_BATTERY,          /**< input: LDL_System_getBatteryLevel() (u8) */
+    LDL_TRACE_ENTROPY,          /**< input: LDL_Radio_entropyEnd() (u32) */
+    LDL_TRACE_RX,               /**< input: LDL_Radio_collect() (rssi s16, snr s16, timeout u8 | frame) */
+    LDL_TRACE_CAD,              /**< input: LDL_Radio_cadDetected() (detected u8) */
+    
+    LDL_TRACE_RADIO_EVENT,      /**< call: LDL_MAC_radioEvent() (event u8) */
+    LDL_TRACE_PROCESS,          /**< call: LDL_MAC_process() */
+    LDL_TRACE_OTAA,             /**< call: LDL_MAC_otaa() */
+    LDL_TRACE_DATA,             /**< call: LDL_MAC_unconfirmedData() or LDL_MAC_confirmedData() (confirmed u8, port u8, opts u8, nbTrans u8, check u8, getTime u8, dither u8 | data) */
+    LDL_TRACE_FORGET,           /**< call: LDL_MAC_forget() */
+    LDL_TRACE_CANCEL,           /**< call: LDL_MAC_cancel() */
+    LDL_TRACE_SET_RATE,         /**< call: LDL_MAC_setRate() (rate u8) */
+    LDL_TRACE_SET_POWER,        /**< call: LDL_MAC_setPower() (power u8) */
+    LDL_TRACE_ENABLE_ADR,       /**< call: LDL_MAC_enableADR() */
+    LDL_TRACE_DISABLE_ADR,      /**< call: LDL_MAC_disableADR() */
+    LDL_TRACE_SET_MAX_DCYCLE,   /**< call: LDL_MAC_setMaxDCycle() (maxDCycle u8) */
+    LDL_TRACE_ADD_CHANNEL,      /**< call: LDL_MAC_addChannel() (chIndex u8, freq u32, minRate u8, maxRate u8) */
+    LDL_TRACE_MASK_CHANNEL,     /**< call: LDL_MAC_maskChannel() (chIndex u8) */
+    LDL_TRACE_UNMASK_CHANNEL,   /**< call: LDL_MAC_unmaskChannel() (chIndex u8) */
+    LDL_TRACE_TICKS_UNTIL_NEXT_EVENT,   /**< call: LDL_MAC_ticksUntilNextEvent() */
+    LDL_TRACE_TIME_SINCE_VALID_DOWNLINK,/**< call: LDL_MAC_timeSinceValidDownlink() */
+    LDL_TRACE_PRIORITY,         /**< call: LDL_MAC_priority() (interval u8) */
+    LDL_TRACE_ENABLE_CAD,       /**< call: LDL_MAC_enableCAD() (backoff u32) */
+    LDL_TRACE_DISABLE_CAD,      /**< call: LDL_MAC_disableCAD() */
+    LDL_TRACE_ENABLE_CLASS_C,   /**< call: LDL_MAC_enableClassC() */
+    LDL_TRACE_DISABLE_CLASS_C,  /**< call: LDL_MAC_disableClassC() */
+    LDL_TRACE_ENABLE_CLASS_B,   /**< call: LDL_MAC_enableClassB() (periodicity u8) */
+    LDL_TRACE_DISABLE_CLASS_B   /**< call: LDL_MAC_disableClassB() */
+};
+
+/** LDL calls this function pointer to emit a trace record
+ * 
+ * Records may be emitted from the same interrupt context as 
+ * LDL_MAC_radioEvent().
+ * 
+ * @param[in] app       app from LDL_MAC_init()
+ * @param[in] type      #ldl_mac_trace_type
+ * @param[in] hdr       record header fields
+ * @param[in] hdrLen    
+ * @param[in] data      **OPTIONAL** record data
+ * @param[in] dataLen
+ * 
+ * */
+typedef void (*ldl_mac_trace_fn)(void *app, enum ldl_mac_trace_type type, const void *hdr, uint8_t hdrLen, const void *data, uint8_t dataLen);
+#endif
+
 /** MAC state */
 enum ldl_mac_state {
 
@@ -334,8 +446,14 @@ enum ldl_mac_state {
     LDL_STATE_ENTROPY,         /**< sample entropy */
 
     LDL_STATE_IDLE,        /**< ready for operations */
+#ifdef LDL_ENABLE_CLASS_C
+    LDL_STATE_RXC,         /**< ready for operations, receiving on RX2 settings (class C) */
+#endif    
     
     LDL_STATE_WAIT_TX,     /**< waiting for channel to become available */
+#ifdef LDL_ENABLE_CAD
+    LDL_STATE_CAD,         /**< radio is checking the channel for activity */
+#endif
     LDL_STATE_TX,          /**< radio is TX */
     LDL_STATE_WAIT_RX1,    /**< waiting for first RX window */
     LDL_STATE_RX1,         /**< first RX window */
@@ -344,6 +462,11 @@ enum ldl_mac_state {
     
     LDL_STATE_RX2_LOCKOUT, /**< used to ensure an out of range RX2 window is not clobbered */
     
+#ifdef LDL_ENABLE_CLASS_B
+    LDL_STATE_BEACON,      /**< beacon window (class B) */
+    LDL_STATE_PING,        /**< ping slot (class B) */
+#endif    
+    
     LDL_STATE_WAIT_RETRY   /**< wait to retry */
     
 };
@@ -392,6 +515,9 @@ enum ldl_timer_inst {
     LDL_TIMER_WAITA,
     LDL_TIMER_WAITB,
     LDL_TIMER_BAND,
+#ifdef LDL_ENABLE_CLASS_B
+    LDL_TIMER_BEACON,
+#endif    
     LDL_TIMER_MAX
 };
 
@@ -405,7 +531,13 @@ enum ldl_input_type {
   
     LDL_INPUT_TX_COMPLETE,
     LDL_INPUT_RX_READY,
-    LDL_INPUT_RX_TIMEOUT
+    LDL_INPUT_RX_TIMEOUT,
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    LDL_INPUT_CHIP_COMPLETE,
+#endif    
+#ifdef LDL_ENABLE_CAD
+    LDL_INPUT_CAD_DONE,
+#endif    
 };
 
 struct ldl_input {
@@ -415,24 +547,36 @@ struct ldl_input {
     uint32_t time;
 };
 
+/* frequencies are kept in 100Hz units as three bytes (little endian)
+ * the way LoRaWAN encodes them */
 struct ldl_mac_channel {
     
-    uint32_t freqAndRate;
-#ifndef LDL_DISABLE_CMD_DL_CHANNEL    
-    uint32_t dlFreq;
-#endif    
+    uint8_t freq[3U];
+    uint8_t rate;       /* minRate (upper nibble) and maxRate (lower nibble) */
+    uint8_t band;       /* UINT8_MAX if freq is outside the region bands */
 };
 
-/** session cache */
+/** session cache 
+ * 
+ * Members are ordered by alignment so that the structure does not
+ * need padding.
+ * 
+ * */
 struct ldl_mac_session {
     
     /* frame counters */
     uint32_t up;
-    uint16_t appDown;
-    uint16_t nwkDown;
     
     uint32_t devAddr;    
     uint32_t netID;
+    
+    uint16_t appDown;
+    uint16_t nwkDown;
+    
+    uint16_t adr_ack_limit;
+    uint16_t adr_ack_delay;
+    
+    uint16_t pending_cmds;
 
 #ifdef LDL_DISABLE_FULL_CHANNEL_CONFIG    
     struct ldl_mac_channel chConfig[8U];
@@ -440,7 +584,9 @@ struct ldl_mac_session {
     struct ldl_mac_channel chConfig[16U];
 #endif    
     
-    uint8_t chMask[72U / 8U];
+    uint8_t chMask[(LDL_REGION_MAX_CHANNELS + 7U) / 8U];
+    
+    uint8_t rx2Freq[3U];
     
     uint8_t rate;
     uint8_t power;
@@ -451,20 +597,12 @@ struct ldl_mac_session {
     uint8_t rx1DROffset;    
     uint8_t rx1Delay;        
     uint8_t rx2DataRate;    
-    uint8_t rx2Rate;   
-    
-    uint32_t rx2Freq;
     
     bool joined;
     bool adr;
     
     uint8_t version;
     
-    uint16_t adr_ack_limit;
-    uint16_t adr_ack_delay;
-    
-    uint16_t pending_cmds;
-    
     struct ldl_rx_param_setup_ans rx_param_setup_ans;
     struct ldl_dl_channel_ans dl_channel_ans;
     
@@ -483,36 +621,63 @@ struct ldl_mac_data_opts {
     uint8_t dither;         /**< seconds of dither to add to the transmit schedule (0..60) */
 };
 
-/** MAC layer data */
+#ifdef LDL_ENABLE_CAD
+/** channel activity detection outcomes for one channel
+ * 
+ * Counters wrap.
+ * 
+ * */
+struct ldl_mac_channel_activity {
+    
+    uint16_t clear;     /**< CAD found the channel clear */
+    uint16_t busy;      /**< CAD detected activity on the channel */
+};
+#endif
+
+/** MAC layer data 
+ * 
+ * Members are grouped by alignment to keep padding to a minimum.
+ * 
+ * */
 struct ldl_mac {
 
     enum ldl_mac_state state;
     enum ldl_mac_operation op;
     enum ldl_mac_errno errno;
     
-    uint8_t joinEUI[8U];
-    uint8_t devEUI[8U];
+    enum ldl_region region;
     
-#ifdef LDL_ENABLE_STATIC_RX_BUFFER
-    uint8_t rx_buffer[LDL_MAX_PACKET];
-#endif    
-    uint8_t buffer[LDL_MAX_PACKET];
-    uint8_t bufferLen;
+    struct ldl_sm *sm;
+    struct ldl_radio *radio;
+    
+    ldl_mac_response_fn handler;
+    void *app;
+    
+#ifdef LDL_ENABLE_TRACE
+    ldl_mac_trace_fn trace;
+#endif
     
     /* off-time in ms per band */    
     uint32_t band[LDL_BAND_MAX];
     
     uint32_t polled_band_ticks;
     
-    uint16_t devNonce;
     uint32_t joinNonce;
     
-    int16_t snr_min;    /* could be optimised: used to keep the snr min for the last rx settings */
-    int16_t margin;     /* margin calculated for last DevStatusReq */
-
     /* time of the last valid downlink in seconds */
     uint32_t last_valid_downlink;
     
+    uint32_t rx1_margin;
+    uint32_t rx2_margin;
+    
+    uint32_t time;
+    uint32_t polled_time_ticks;
+    
+    uint32_t service_start_time;
+    
+    /* number of join/data trials */
+    uint32_t trials;
+    
     /* the settings currently being used to TX */
     struct {
         
@@ -523,23 +688,60 @@ struct ldl_mac {
         uint8_t power;        
     } tx;
     
-    uint32_t rx1_margin;
-    uint32_t rx2_margin;
-    
-    uint8_t rx1_symbols;    
-    uint8_t rx2_symbols;
-    
     struct ldl_mac_session ctx;
     
-    struct ldl_sm *sm;
-    struct ldl_radio *radio;
     struct ldl_input inputs;
     struct ldl_timer timers[LDL_TIMER_MAX];
     
-    enum ldl_region region;
+#ifdef LDL_ENABLE_CLASS_B
+    uint32_t beacon_time;       /* GPS seconds at the start of this beacon period */
+    uint32_t beacon_ticks;      /* ticks at beacon_time */
+    uint32_t tx_end_ticks;      /* ticks at the end of the last uplink */
+    uint32_t slot_margin;
+    uint16_t ping_slot;         /* next ping slot in this beacon period */
+    uint16_t ping_offset;       /* slots */
+    bool classB;
+    bool beacon_valid;          /* beacon_time and beacon_ticks can be used to predict the next beacon */
+    bool beacon_locked;         /* beacon_ticks was measured from a received beacon */
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    uint32_t beacon_ready;      /* ticks at RX ready for the beacon being collected */
+#endif
+    bool ping_info_pending;     /* PingSlotInfoReq not yet answered */
+    uint8_t ping_periodicity;
+    uint8_t beacon_missed;      /* consecutive beacons missed */
+    uint8_t slot_symbols;
+#endif
     
-    ldl_mac_response_fn handler;
-    void *app;
+#ifdef LDL_ENABLE_CLASS_C
+    /* wait state, operation and wait timers put aside while a frame 
+     * received in RXC is handled (rxc_state is LDL_STATE_IDLE otherwise) */
+    struct ldl_timer rxc_timers[2U];
+    enum ldl_mac_state rxc_state;
+    enum ldl_mac_operation rxc_op;
+#endif
+    
+#ifdef LDL_ENABLE_CAD
+    /* listen before talk */
+    struct ldl_mac_channel_activity activity[LDL_REGION_MAX_CHANNELS];
+    uint16_t cad_backoff;   /* ms */
+    bool cad;
+    uint8_t cad_attempts;
+#endif
+    
+    uint16_t devNonce;
+    
+    int16_t snr_min;    /* could be optimised: used to keep the snr min for the last rx settings */
+    int16_t margin;     /* margin calculated for last DevStatusReq */
+    
+    /* added to the power setting given to radio to compensate 
+     * for gains/losses */
+    int16_t gain;
+    
+    /* options and overrides applicable to current data service */
+    struct ldl_mac_data_opts opts;
+    
+    uint8_t rx1_symbols;    
+    uint8_t rx2_symbols;
     
     bool rxParamSetupAns_pending;    
     bool dlChannelAns_pending;
@@ -549,20 +751,38 @@ struct ldl_mac {
     uint8_t adrAckCounter;
     bool adrAckReq;
     
-    uint32_t time;
-    uint32_t polled_time_ticks;
+    uint16_t deferred_cmds;     /* (1 << type) for each MAC command that did not fit into the last uplink */
     
-    uint32_t service_start_time;
+#ifdef LDL_ENABLE_CLASS_C
+    bool classC;
+#endif
     
-    /* number of join/data trials */
-    uint32_t trials;
-  
-    /* options and overrides applicable to current data service */
-    struct ldl_mac_data_opts opts;
+    uint8_t joinEUI[8U];
+    uint8_t devEUI[8U];
     
-    /* added to the power setting given to radio to compensate 
-     * for gains/losses */
-    int16_t gain;
+    uint8_t bufferLen;
+    uint8_t buffer[LDL_MAX_PACKET];
+    
+#ifdef LDL_ENABLE_SHARED_BUFFER
+    /* the data frame in buffer is rebuilt from this before it is sent
+     * since a downlink may have been collected over it */
+    struct {
+        
+        const uint8_t *data;    /* application payload */
+        uint8_t len;
+        uint8_t port;           /* opts is the payload if port is 0 */
+        bool confirmed;
+        bool adr;
+        bool adrAckReq;
+        bool classB;
+        uint8_t optsLen;
+        uint8_t opts[30U];
+    } up;
+#endif    
+    
+#if defined(LDL_ENABLE_STATIC_RX_BUFFER) && !defined(LDL_ENABLE_SHARED_BUFFER)
+    uint8_t rx_buffer[LDL_MAX_PACKET];
+#endif    
 };
 
 /** passed as an argument to LDL_MAC_init() 
@@ -620,6 +840,11 @@ struct ldl_mac_init_arg {
      * 
      * */
     int16_t gain;
+    
+#ifdef LDL_ENABLE_TRACE
+    /** optional trace callback #ldl_mac_trace_fn */
+    ldl_mac_trace_fn trace;
+#endif
 };
 
 
@@ -643,6 +868,7 @@ struct ldl_mac_init_arg {
  * - ldl_mac_init_arg.joinNonce the next joinNonce to use in OTAA
  * - ldl_mac_init_arg.session   optional pointer to restored session state
  * - ldl_mac_init_arg.gain      gain compensation dB x 10^-2  (e.g. -2.4dB == -240)
+ * - ldl_mac_init_arg.trace     optional trace callback (#LDL_ENABLE_TRACE)
  * 
  * More members may be added in future releases and so it is 
  * recommended to clear #ldl_mac_init_arg before using. This will ensure
@@ -679,9 +905,11 @@ void LDL_MAC_init(struct ldl_mac *self, enum ldl_region region, const struct ldl
  * #ldl_mac_response_fn will push #LDL_MAC_DATA_COMPLETE on completion.
  * 
  * Be aware that pending MAC commands (i.e. MAC commands LDL is waiting to send to the server)
- * are piggy-backed onto upstream data frames. If the pending MAC commands will
- * not fit into the same frame as the application data, the MAC commands will be prioritised.
- * This means that:
+ * are piggy-backed onto upstream data frames. Commands that do not fit alongside the 
+ * application data are deferred to the next uplink if they can wait. Sticky answers, 
+ * requests made with this invocation, and commands that have already waited cannot.
+ * If those will not fit into the same frame as the application data, the MAC commands 
+ * will be prioritised. This means that:
  * 
  * 1. LDL_MAC_unconfirmedData() function will return false to indicate failure to the application
  * 2. LDL_MAC_errno() will return LDL_ERRNO_MACPRIORITY
@@ -693,7 +921,7 @@ void LDL_MAC_init(struct ldl_mac *self, enum ldl_region region, const struct ldl
  * 
  * @param[in] self  #ldl_mac
  * @param[in] port  lorawan port (must be >0)
- * @param[in] data  pointer to message to send
+ * @param[in] data  pointer to message to send (must remain valid until the operation completes if #LDL_ENABLE_SHARED_BUFFER)
  * @param[in] len   byte length of data
  * @param[in] opts  #ldl_mac_data_opts (may be NULL)
  * 
@@ -722,7 +950,7 @@ bool LDL_MAC_unconfirmedData(struct ldl_mac *self, uint8_t port, const void *dat
  * 
  * @param[in] self  #ldl_mac
  * @param[in] port  lorawan port (must be >0)
- * @param[in] data  pointer to message to send
+ * @param[in] data  pointer to message to send (must remain valid until the operation completes if #LDL_ENABLE_SHARED_BUFFER)
  * @param[in] len   byte length of data
  * @param[in] opts  #ldl_mac_data_opts (may be NULL)
  * 
@@ -786,6 +1014,7 @@ void LDL_MAC_process(struct ldl_mac *self);
  * - LDL_MAC_unconfirmedData()
  * - LDL_MAC_confirmedData()
  * - LDL_Radio_interrupt()
+ * - LDL_Radio_chipComplete() (if #LDL_ENABLE_CHIP_ASYNC is defined)
  * 
  * @param[in] self  #ldl_mac
  * 
@@ -866,6 +1095,131 @@ void LDL_MAC_disableADR(struct ldl_mac *self);
  * */
 bool LDL_MAC_adr(const struct ldl_mac *self);
 
+#ifdef LDL_ENABLE_CLASS_C
+/** Enable class C operation
+ * 
+ * While joined and not performing an operation the MAC will keep the 
+ * radio receiving on the RX2 frequency and rate. Frames received this
+ * way are reported with #LDL_MAC_RX as they would be in an RX window.
+ * 
+ * The receiver stays on while an operation waits to transmit and 
+ * waits for its receive windows. It is only interrupted to transmit and 
+ * for the RX1 and RX2 windows. LDL_MAC_state() returns #LDL_STATE_RXC 
+ * while receiving and idle, and while a frame received during an
+ * operation is being handled.
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * */
+void LDL_MAC_enableClassC(struct ldl_mac *self);
+
+/** Disable class C operation
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * */
+void LDL_MAC_disableClassC(struct ldl_mac *self);
+
+/** Is class C operation enabled?
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * @retval true     enabled
+ * @retval false    not enabled
+ * 
+ * */
+bool LDL_MAC_classC(const struct ldl_mac *self);
+#endif
+
+#ifdef LDL_ENABLE_CLASS_B
+/** Enable class B operation
+ * 
+ * Once joined, the MAC piggy-backs DeviceTimeReq and PingSlotInfoReq 
+ * on the next data frames until they are answered. With the time known
+ * the MAC opens a window for each beacon. After a beacon is received 
+ * the MAC opens a ping slot every 2^periodicity x 0.96 seconds and 
+ * frames received in these slots are reported with #LDL_MAC_RX.
+ * 
+ * Beacon and ping slot windows are only opened while the MAC is 
+ * idle. LDL_MAC_state() returns #LDL_STATE_BEACON or #LDL_STATE_PING
+ * while a window is open. A window that would open while the MAC is
+ * performing an operation is skipped.
+ * 
+ * Class B and class C are exclusive; enabling one disables the other.
+ * 
+ * @param[in] self          #ldl_mac
+ * @param[in] periodicity   0..7
+ * 
+ * @retval true     enabled
+ * @retval false    region does not support class B or periodicity is invalid
+ * 
+ * */
+bool LDL_MAC_enableClassB(struct ldl_mac *self, uint8_t periodicity);
+
+/** Disable class B operation
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * */
+void LDL_MAC_disableClassB(struct ldl_mac *self);
+
+/** Is class B operation enabled?
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * @retval true     enabled
+ * @retval false    not enabled
+ * 
+ * */
+bool LDL_MAC_classB(const struct ldl_mac *self);
+
+/** Is the beacon being tracked?
+ * 
+ * Ping slots are only opened while the beacon is tracked.
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * @retval true     tracking
+ * @retval false    not tracking
+ * 
+ * */
+bool LDL_MAC_beaconLocked(const struct ldl_mac *self);
+#endif
+
+#ifdef LDL_ENABLE_CAD
+/** Enable channel activity detection before each transmission
+ * 
+ * If activity is detected the MAC will wait a random interval of up 
+ * to backoff milliseconds and then try again on another available 
+ * channel. The frame is sent without CAD after #LDL_CAD_MAX_ATTEMPTS 
+ * busy channels.
+ * 
+ * @param[in] self      #ldl_mac
+ * @param[in] backoff   maximum back-off interval (ms)
+ * 
+ * */
+void LDL_MAC_enableCAD(struct ldl_mac *self, uint16_t backoff);
+
+/** Disable channel activity detection
+ * 
+ * @param[in] self  #ldl_mac
+ * 
+ * */
+void LDL_MAC_disableCAD(struct ldl_mac *self);
+
+/** Read the channel activity detection outcomes for a channel
+ * 
+ * @param[in] self      #ldl_mac
+ * @param[in] chIndex   channel index
+ * @param[out] activity
+ * 
+ * @retval true     channel exists in this region
+ * @retval false    channel does not exist
+ * 
+ * */
+bool LDL_MAC_getChannelActivity(const struct ldl_mac *self, uint8_t chIndex, struct ldl_mac_channel_activity *activity);
+#endif
+
 /** Read the last error
  * 
  * The following functions will set the errno when they fail:
@@ -959,7 +1313,7 @@ uint32_t LDL_MAC_bwToNumber(enum ldl_signal_bandwidth bw);
  * 
  * - region
  * - rate
- * - pending mac commands
+ * - pending mac commands that cannot wait for a later uplink
  * 
  * @param[in] self  #ldl_mac
  * @retval mtu
@@ -1030,6 +1384,10 @@ void LDL_MAC_removeChannel(struct ldl_mac *self, uint8_t chIndex);
 bool LDL_MAC_maskChannel(struct ldl_mac *self, uint8_t chIndex);
 bool LDL_MAC_unmaskChannel(struct ldl_mac *self, uint8_t chIndex);
 
+/* as LDL_MAC_addChannel() and LDL_MAC_unmaskChannel() but not traced (used by the region) */
+bool LDL_MAC_setChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint8_t minRate, uint8_t maxRate);
+bool LDL_MAC_enableChannel(struct ldl_mac *self, uint8_t chIndex);
+
 void LDL_MAC_timerSet(struct ldl_mac *self, enum ldl_timer_inst timer, uint32_t timeout);
 bool LDL_MAC_timerCheck(struct ldl_mac *self, enum ldl_timer_inst timer, uint32_t *error);
 void LDL_MAC_timerClear(struct ldl_mac *self, enum ldl_timer_inst timer);
@@ -31,6 +31,7 @@ extern "C" {
 
 struct ldl_stream;
 
+/* in CID order (LINK_CHECK is CID 2) */
 enum ldl_mac_cmd_type {
     
     LDL_CMD_LINK_CHECK,
@@ -47,7 +48,12 @@ enum ldl_mac_cmd_type {
     LDL_CMD_ADR_PARAM_SETUP,
     LDL_CMD_DEVICE_TIME,
     LDL_CMD_FORCE_REJOIN,
-    LDL_CMD_REJOIN_PARAM_SETUP
+    LDL_CMD_REJOIN_PARAM_SETUP,
+    
+    LDL_CMD_PING_SLOT_INFO,
+    LDL_CMD_PING_SLOT_CHANNEL,
+    LDL_CMD_BEACON_TIMING,
+    LDL_CMD_BEACON_FREQ
 };
 
 struct ldl_link_check_ans {
@@ -176,6 +182,23 @@ struct ldl_rejoin_param_setup_ans {
     uint8_t timeOK;
 };
 
+struct ldl_ping_slot_channel_req {
+    
+    uint32_t freq;
+    uint8_t dataRate;
+};
+
+struct ldl_beacon_timing_ans {
+    
+    uint16_t delay;
+    uint8_t channel;
+};
+
+struct ldl_beacon_freq_req {
+    
+    uint32_t freq;
+};
+
 struct ldl_downstream_cmd {
   
     enum ldl_mac_cmd_type type;
@@ -196,6 +219,10 @@ struct ldl_downstream_cmd {
         struct ldl_device_time_ans deviceTime;
         struct ldl_force_rejoin_req forceRejoin;
         struct ldl_rejoin_param_setup_req rejoinParamSetup;        
+        /* ping_slot_info_ans */
+        struct ldl_ping_slot_channel_req pingSlotChannel;
+        struct ldl_beacon_timing_ans beaconTiming;
+        struct ldl_beacon_freq_req beaconFreq;
         
     } fields;    
 };
@@ -243,11 +270,14 @@ void LDL_MAC_putRekeyInd(struct ldl_stream *s, const struct ldl_rekey_ind *value
 void LDL_MAC_putADRParamSetupAns(struct ldl_stream *s);
 void LDL_MAC_putDeviceTimeReq(struct ldl_stream *s);
 void LDL_MAC_putRejoinParamSetupAns(struct ldl_stream *s, struct ldl_rejoin_param_setup_ans *value);
+void LDL_MAC_putPingSlotInfoReq(struct ldl_stream *s, uint8_t periodicity);
 
 bool LDL_MAC_getDownCommand(struct ldl_stream *s, struct ldl_downstream_cmd *cmd);
 bool LDL_MAC_getUpCommand(struct ldl_stream *s, struct ldl_upstream_cmd *cmd);
 
-bool LDL_MAC_peekNextCommand(struct ldl_stream *s, enum ldl_mac_cmd_type *type);
+/* decode commands until the end of the block, an unknown CID, or max
+ * commands; returns the number decoded */
+uint8_t LDL_MAC_getDownCommands(const uint8_t *in, uint8_t len, struct ldl_downstream_cmd *cmd, uint8_t max);
 
 uint8_t LDL_MAC_sizeofCommandUp(enum ldl_mac_cmd_type type);
 
@@ -35,6 +35,8 @@
  * 
  * */
 
+#include "ldl_platform.h"
+
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -61,6 +63,66 @@ void LDL_OPS_micDataFrame(struct ldl_mac *self, void *buffer, uint8_t size);
 /* derive expected 32 bit downcounter from 16 least significant bits and update the copy in ldl_mac */
 void LDL_OPS_syncDownCounter(struct ldl_mac *self, uint8_t port, uint16_t counter);
 
+#ifdef LDL_ENABLE_CLASS_B
+/* ping slot offset (0..period-1) for the beacon period starting at beaconTime */
+uint16_t LDL_OPS_pingOffset(uint32_t beaconTime, uint32_t devAddr, uint16_t period);
+#endif
+
+#ifdef LDL_ENABLE_UPLINK_VERIFY
+
+/* Network side
+ * 
+ * The same codec and security module used by the device can be used
+ * by a network server to verify and decrypt batches of data uplinks.
+ * 
+ * */
+
+#include "ldl_frame.h"
+
+struct ldl_sm;
+
+/* per device state the network server must look up */
+struct ldl_ops_session {
+    
+    struct ldl_sm *sm;  /* session keys */
+    uint8_t version;    /* 0 (1.0) or 1 (1.1) */
+    uint32_t up;        /* last accepted uplink counter */
+};
+
+enum ldl_ops_uplink_result {
+    
+    LDL_OPS_UPLINK_OK,
+    LDL_OPS_UPLINK_INVALID,     /* not a well formed data uplink */
+    LDL_OPS_UPLINK_UNKNOWN,     /* no session for devAddr */
+    LDL_OPS_UPLINK_MIC          /* MIC did not verify */
+};
+
+struct ldl_ops_uplink {
+    
+    /* input */
+    uint8_t *in;        /* decrypted in place when result is LDL_OPS_UPLINK_OK */
+    uint8_t len;
+    uint8_t rate;       /* TxDr (1.1 only) */
+    uint8_t chIndex;    /* TxCh (1.1 only) */
+    
+    /* output */
+    struct ldl_frame_up f;
+    uint32_t counter;   /* 32 bit uplink counter */
+    enum ldl_ops_uplink_result result;
+};
+
+/* return true and write session if devAddr is known */
+typedef bool (*ldl_ops_session_fn)(void *receiver, uint32_t devAddr, struct ldl_ops_session *session);
+
+/* verify and decrypt a batch of uplinks, returning the number that verified
+ * 
+ * consecutive frames from the same devAddr share a single lookup
+ * 
+ * */
+uint32_t LDL_OPS_receiveUplinks(struct ldl_ops_uplink *batch, uint32_t n, ldl_ops_session_fn lookup, void *receiver);
+
+#endif
+
 
 
 #endif
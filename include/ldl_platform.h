@@ -76,6 +76,20 @@
     #define LDL_ENABLE_SX1276
     //#undef LDL_ENABLE_SX1276 
 
+    /** 
+     * Define to add support for SX1261
+     * 
+     * */
+    #define LDL_ENABLE_SX1261
+    #undef LDL_ENABLE_SX1261
+
+    /** 
+     * Define to add support for SX1262
+     * 
+     * */
+    #define LDL_ENABLE_SX1262
+    #undef LDL_ENABLE_SX1262
+
     /** 
      * Define to remove the link-check feature.
      * 
@@ -84,7 +98,7 @@
     #undef LDL_DISABLE_CHECK
 
     /** 
-     * Define to remove event generation when RX1 and RX2 are opened.
+     * Define to remove event generation when RX1, RX2 and (class B) beacon and ping slots are opened.
      * 
      * */
     #define LDL_DISABLE_SLOT_EVENT
@@ -226,6 +240,24 @@
      * */
     #define LDL_ENABLE_STATIC_RX_BUFFER
     #undef LDL_ENABLE_STATIC_RX_BUFFER
+
+    /**
+     * Define to collect downlinks into the TX frame buffer rather than
+     * a separate RX buffer.
+     * 
+     * This saves #LDL_MAX_PACKET bytes of RAM (or stack if
+     * #LDL_ENABLE_STATIC_RX_BUFFER is not defined).
+     * 
+     * Downlinks are collected from the start of the buffer. A join
+     * request is rebuilt before it is sent again, and a data frame is
+     * rebuilt from its port and payload before every transmission. This
+     * means the data passed to LDL_MAC_unconfirmedData() and
+     * LDL_MAC_confirmedData() must remain valid until the operation
+     * completes.
+     * 
+     * */
+    #define LDL_ENABLE_SHARED_BUFFER
+    #undef LDL_ENABLE_SHARED_BUFFER
     
     /**
      * Define to remove the #LDL_MAC_SESSION_UPDATED event
@@ -293,6 +325,161 @@
     #define LDL_LITTLE_ENDIAN
     #undef LDL_LITTLE_ENDIAN
     
+    /**
+     * Define to add LDL_OPS_receiveUplinks()
+     * 
+     * This is a network side interface for verifying and decrypting
+     * batches of data uplinks using the same codec and security module
+     * as the device. It is of no use on a device.
+     * 
+     * */
+    #define LDL_ENABLE_UPLINK_VERIFY
+    #undef LDL_ENABLE_UPLINK_VERIFY
+
+    /**
+     * Define to add ldl_mac_init_arg.trace
+     *
+     * #ldl_mac will pass a record of every input it consumes
+     * (ticks, random numbers, radio events, received frames) and
+     * every call made into it to #ldl_mac_trace_fn. A session can
+     * then be reproduced offline by replaying the records.
+     *
+     * @see #ldl_mac_trace_type
+     *
+     * */
+    #define LDL_ENABLE_TRACE
+    #undef LDL_ENABLE_TRACE
+
+    /**
+     * Define to add an energy model to the radio driver
+     * 
+     * The driver will timestamp radio state changes and accumulate
+     * time and charge using a table of current per state and
+     * output power.
+     * 
+     * @see LDL_Radio_getEnergy()
+     * 
+     * */
+    #define LDL_ENABLE_RADIO_ENERGY
+    #undef LDL_ENABLE_RADIO_ENERGY
+
+    /**
+     * Define to program the radio through LDL_Chip_submit()
+     * 
+     * The driver will queue the transfers needed to transmit, receive
+     * and collect a frame and submit them as a batch instead of
+     * waiting on each one. LDL_Radio_chipComplete() must be called by
+     * the @ref ldl_radio_connector when a batch has completed.
+     * 
+     * Frames are collected in the background over several calls to
+     * LDL_MAC_process(). This option implies a static RX buffer
+     * (see #LDL_ENABLE_STATIC_RX_BUFFER).
+     * 
+     * LDL_MAC_process() returns without doing anything while a batch
+     * is in progress and LDL_MAC_ticksUntilNextEvent() returns 
+     * UINT32_MAX, so the application should sleep until an interrupt
+     * (i.e. the one that leads to LDL_Radio_chipComplete()).
+     * 
+     * */
+    #define LDL_ENABLE_CHIP_ASYNC
+    #undef LDL_ENABLE_CHIP_ASYNC
+
+    /**
+     * Define to add channel activity detection (listen before talk)
+     * 
+     * Once enabled with LDL_MAC_enableCAD() the MAC will run CAD on
+     * the channel before each transmission. If activity is detected
+     * the MAC backs off and tries another available channel, up to
+     * #LDL_CAD_MAX_ATTEMPTS times before transmitting regardless.
+     * 
+     * Clear and busy outcomes are counted per channel.
+     * 
+     * @see LDL_MAC_getChannelActivity()
+     * 
+     * */
+    #define LDL_ENABLE_CAD
+    #undef LDL_ENABLE_CAD
+
+    /**
+     * Define to add class C operation
+     * 
+     * The radio is kept receiving on the RX2 settings between uplinks
+     * once enabled with LDL_MAC_enableClassC(). This gives downlink 
+     * latency in the order of the frame airtime at the cost of the 
+     * receive current.
+     * 
+     * */
+    #define LDL_ENABLE_CLASS_C
+    #undef LDL_ENABLE_CLASS_C
+
+    /**
+     * Define to add class B operation
+     * 
+     * Once enabled with LDL_MAC_enableClassB() the MAC learns the
+     * network time with DeviceTimeReq, acquires the beacon and then
+     * opens ping slots at the periodicity given. Beacon and ping slot
+     * windows are widened by LDL_System_eps() for every second since 
+     * the last beacon was received. Tracking is lost after 
+     * #LDL_BEACON_MISSED_MAX consecutive beacons are missed.
+     * 
+     * Class B windows are only opened while the MAC is idle; a window 
+     * falling within a class A sequence is skipped.
+     * 
+     * Requires DeviceTimeReq (do not define #LDL_DISABLE_DEVICE_TIME).
+     * 
+     * Only supported in regions where the beacon is on a fixed channel
+     * (EU_863_870, EU_433).
+     * 
+     * */
+    #define LDL_ENABLE_CLASS_B
+    #undef LDL_ENABLE_CLASS_B
+
+    /**
+     * Define to add FSK modulation (DR7 in EU_863_870 and EU_433)
+     *
+     * DR7 becomes available on channels added by the application or
+     * the network (not the default or CFList channels).
+     *
+     * Frames longer than the radio FIFO are moved through it in
+     * chunks as the FifoLevel flag changes. The radio connector must
+     * call LDL_Radio_interrupt() for DIO1 on both edges, and for DIO2
+     * (RX timeout in FSK mode).
+     *
+     * This option implies a static RX buffer
+     * (see #LDL_ENABLE_STATIC_RX_BUFFER).
+     *
+     * FSK is only supported by the SX1272 and SX1276 drivers.
+     *
+     * */
+    #define LDL_ENABLE_FSK
+    #undef LDL_ENABLE_FSK
+
+    /**
+     * Define if the SX126x DIO2 line drives the antenna switch
+     * 
+     * */
+    #define LDL_ENABLE_SX126X_DIO2_RF_SWITCH
+    #undef LDL_ENABLE_SX126X_DIO2_RF_SWITCH
+
+    /**
+     * Define if the SX126x is clocked by a TCXO powered from DIO3
+     * 
+     * The supply voltage is set by #LDL_SX126X_TCXO_VOLTAGE.
+     * 
+     * */
+    #define LDL_ENABLE_SX126X_TCXO
+    #undef LDL_ENABLE_SX126X_TCXO
+
+    /**
+     * Define to run the SX126x from its LDO instead of the DC-DC
+     * converter
+     * 
+     * Only needed if the board does not fit the DC-DC inductor.
+     * 
+     * */
+    #define LDL_DISABLE_SX126X_DCDC
+    #undef LDL_DISABLE_SX126X_DCDC
+
     
 
 #endif
@@ -342,5 +529,37 @@
     #define LDL_REDUNDANCY_MAX 0xfU
 #endif
 
+#ifndef LDL_CAD_MAX_ATTEMPTS
+    /** Redefine to change the number of busy channels tolerated
+     * before a frame is transmitted without CAD
+     * 
+     * Only applies if #LDL_ENABLE_CAD is defined.
+     * 
+     * */
+    #define LDL_CAD_MAX_ATTEMPTS 4U
+#endif
+
+#ifndef LDL_BEACON_MISSED_MAX
+    /** Redefine to change the number of consecutive beacons that 
+     * can be missed before class B operation is suspended
+     * 
+     * The default is about two hours of beacon-less operation.
+     * 
+     * Only applies if #LDL_ENABLE_CLASS_B is defined.
+     * 
+     * */
+    #define LDL_BEACON_MISSED_MAX 56U
+#endif
+
+#ifndef LDL_SX126X_TCXO_VOLTAGE
+    /** Redefine to change the TCXO supply voltage setting
+     * (SetDIO3AsTcxoCtrl, 0x02 is 1.8V)
+     * 
+     * Only applies if #LDL_ENABLE_SX126X_TCXO is defined.
+     * 
+     * */
+    #define LDL_SX126X_TCXO_VOLTAGE 0x02U
+#endif
+
 /** @} */
 #endif
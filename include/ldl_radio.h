@@ -48,13 +48,36 @@ extern "C" {
 
 #include "ldl_platform.h"
 #include "ldl_radio_defs.h"
+#ifdef LDL_ENABLE_CHIP_ASYNC
+#include "ldl_chip.h"
+#endif
 #include <stdint.h>
 #include <stdbool.h>
 
+/* defined when any driver of the family is included */
+#if defined(LDL_ENABLE_SX1272) || defined(LDL_ENABLE_SX1276)
+#   define LDL_ENABLE_SX127X
+#endif
+#if defined(LDL_ENABLE_SX1261) || defined(LDL_ENABLE_SX1262)
+#   define LDL_ENABLE_SX126X
+#endif
+
+/* defined when more than one driver is included, in which case
+ * LDL_Radio_init() selects the driver operations at run time */
+#if (defined(LDL_ENABLE_SX1272) + defined(LDL_ENABLE_SX1276) + defined(LDL_ENABLE_SX1261) + defined(LDL_ENABLE_SX1262)) > 1
+#   define LDL_ENABLE_RADIO_OPS
+#endif
+
 enum ldl_radio_event {    
     LDL_RADIO_EVENT_TX_COMPLETE,
     LDL_RADIO_EVENT_RX_READY,
     LDL_RADIO_EVENT_RX_TIMEOUT,    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    LDL_RADIO_EVENT_CHIP_COMPLETE,
+#endif    
+#ifdef LDL_ENABLE_CAD
+    LDL_RADIO_EVENT_CAD_DONE,
+#endif    
     LDL_RADIO_EVENT_NONE,
 };
 
@@ -67,6 +90,8 @@ enum ldl_radio_event {
  * 
  * - #LDL_ENABLE_SX1272
  * - #LDL_ENABLE_SX1276
+ * - #LDL_ENABLE_SX1261
+ * - #LDL_ENABLE_SX1262
  * 
  * */
 enum ldl_radio_type {
@@ -75,6 +100,12 @@ enum ldl_radio_type {
 #endif    
 #ifdef LDL_ENABLE_SX1276   
     LDL_RADIO_SX1276,      /**< SX1276 */
+#endif    
+#ifdef LDL_ENABLE_SX1261
+    LDL_RADIO_SX1261,      /**< SX1261 */
+#endif    
+#ifdef LDL_ENABLE_SX1262
+    LDL_RADIO_SX1262,      /**< SX1262 */
 #endif    
     LDL_RADIO_NONE         /**< no radio */
 };
@@ -90,17 +121,32 @@ struct ldl_radio_tx_setting {
 struct ldl_radio_rx_setting {
     
     bool continuous;
+    bool beacon;        /**< implicit header of max bytes without CRC, IQ not inverted */
     uint32_t freq;                  
     enum ldl_signal_bandwidth bw;
     enum ldl_spreading_factor sf;
     uint8_t timeout;
     uint8_t max;
+#ifdef LDL_ENABLE_FSK
+    uint8_t *buffer;    /**< FSK frames are moved out of the FIFO into this buffer (at least max bytes) as they arrive */
+#endif
+};
+
+#ifdef LDL_ENABLE_CAD
+struct ldl_radio_cad_setting {
+    
+    uint32_t freq;
+    enum ldl_signal_bandwidth bw;
+    enum ldl_spreading_factor sf;
 };
+#endif
 
 struct ldl_radio_packet_metadata {
     
     int16_t rssi;
     int16_t snr;
+    int32_t freqError;      /**< estimated carrier frequency error (Hz) */
+    bool timeout;           /**< the window ended without a frame (radios that signal both on one line) */
     //enum ldl_signal_bandwidth bw;
     //enum ldl_spreading_factor sf;
     //uint32_t freq;
@@ -113,9 +159,79 @@ enum ldl_radio_pa {
 };
 
 struct ldl_mac;
+struct ldl_radio_plan;
+struct ldl_radio_ops;
 
 typedef void (*ldl_radio_event_fn)(struct ldl_mac *self, enum ldl_radio_event event);
 
+#ifdef LDL_ENABLE_CHIP_ASYNC
+/* operation waiting for LDL_Radio_resume() */
+enum ldl_radio_next {
+    LDL_RADIO_NEXT_NONE,
+    LDL_RADIO_NEXT_TRANSMIT,
+    LDL_RADIO_NEXT_RECEIVE,
+#ifdef LDL_ENABLE_CAD
+    LDL_RADIO_NEXT_CAD,
+#endif
+    LDL_RADIO_NEXT_CLEAR_INTERRUPT,
+    LDL_RADIO_NEXT_SLEEP,
+#ifdef LDL_ENABLE_SX126X
+    LDL_RADIO_NEXT_WRITE_BUFFER,    /* rest of the SX126x frame */
+#endif
+};
+#endif
+
+#ifdef LDL_ENABLE_RADIO_ENERGY
+
+/** Radio states tracked by the energy model */
+enum ldl_radio_state {
+    LDL_RADIO_STATE_SLEEP,      /**< sleep or held in reset */
+    LDL_RADIO_STATE_STANDBY,    /**< standby */
+    LDL_RADIO_STATE_RX,         /**< receiver on */
+    LDL_RADIO_STATE_TX,         /**< transmitter on */
+    LDL_RADIO_STATE_MAX
+};
+
+/** Transmit current at an output power */
+struct ldl_radio_tx_current {
+    
+    int16_t dbm;        /**< output power (dBm) */
+    uint32_t current;   /**< uA */
+};
+
+/** Current drawn by the radio in each state
+ * 
+ * The transmit current used is that of the first entry with
+ * a power at or above the power requested, or the last entry
+ * if there is none. Entries must be sorted by power.
+ * 
+ * */
+struct ldl_radio_current_table {
+    
+    uint32_t sleep;     /**< uA */
+    uint32_t standby;   /**< uA */
+    uint32_t rx;        /**< uA */
+    
+    const struct ldl_radio_tx_current *rfo;     /**< #LDL_RADIO_PA_RFO */
+    uint8_t rfoLen;
+    
+    const struct ldl_radio_tx_current *boost;   /**< #LDL_RADIO_PA_BOOST */
+    uint8_t boostLen;
+};
+
+/** Energy counters
+ * 
+ * Counters wrap. Take the difference of two readings to find
+ * the cost of an operation.
+ * 
+ * */
+struct ldl_radio_energy {
+    
+    uint32_t time[LDL_RADIO_STATE_MAX];     /**< ticks spent in each #ldl_radio_state */
+    uint32_t charge;                        /**< uC */
+};
+#endif
+
 /** Radio data */
 struct ldl_radio {
     
@@ -123,8 +239,86 @@ struct ldl_radio {
     enum ldl_radio_pa pa;
     uint8_t dio_mapping1;    
     enum ldl_radio_type type;
+#ifdef LDL_ENABLE_RADIO_OPS
+    const struct ldl_radio_ops *ops;
+#endif
     struct ldl_mac *mac;
     ldl_radio_event_fn handler;    
+    
+    /* shadow copy of configuration registers */
+    uint8_t shadow[19U];
+    uint32_t shadow_valid;
+    
+    /* register writes staged for coalescing */
+    struct ldl_radio_plan *plan;
+    
+    /* frame being collected */
+    enum ldl_signal_bandwidth rx_bw;
+    uint8_t rx_status[27U];
+    uint8_t *rx_data;
+    uint8_t rx_max;
+    uint8_t rx_len;
+    uint8_t rx_step;
+    
+#ifdef LDL_ENABLE_SX126X
+    /* parameters of the SX126x configuration commands last sent */
+    uint8_t cmd_shadow[54U];
+    
+    /* interrupts routed to DIO1 for the operation in progress */
+    uint16_t irq_mask;
+#endif
+    
+#ifdef LDL_ENABLE_FSK
+    /* frame moving through the FIFO in FSK mode */
+    bool fsk;
+    const uint8_t *fsk_tx;
+    uint8_t *fsk_rx;
+    uint8_t fsk_max;
+    uint8_t fsk_len;
+    uint16_t fsk_pos;   /* FIFO bytes moved including the length byte */
+#endif
+    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    /* transfers queued for LDL_Chip_submit() 
+     * 
+     * Sized for the largest batch so that a batch never has to
+     * wait for another to complete. */
+    struct ldl_chip_xfer xfer[20U];
+    uint8_t xfer_len;
+    uint8_t xfer_data[64U];
+    uint8_t xfer_data_len;
+    bool batch;
+    volatile bool busy;
+    
+    /* operation requested while a batch was in progress */
+    enum ldl_radio_next next;
+    union {
+        
+        struct ldl_radio_tx_setting tx;
+        struct ldl_radio_rx_setting rx;
+#ifdef LDL_ENABLE_CAD
+        struct ldl_radio_cad_setting cad;
+#endif
+    } next_setting;
+    const uint8_t *next_data;
+    uint8_t next_len;
+    uint8_t next_pos;
+    
+    /* the chip is asleep so the next transfer wakes it without waiting for BUSY */
+    bool asleep;
+#endif
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    void *app;
+    bool counting;
+    const struct ldl_radio_current_table *current;
+    enum ldl_radio_state state;
+    bool continuous;    /* receiver stays on after an RX event */
+    uint32_t state_since;
+    uint32_t tx_current;
+    uint32_t time[LDL_RADIO_STATE_MAX];
+    uint64_t charge;    /* uA x ticks */
+#endif
 };
 
 
@@ -146,6 +340,9 @@ void LDL_Radio_init(struct ldl_radio *self, enum ldl_radio_type type, void *boar
  * - LDL_RADIO_SX1272
  * - LDL_RADIO_SX1276
  * 
+ * The SX1261 and SX1262 each have a single power amplifier which
+ * the driver configures from the radio type.
+ * 
  * These radios have different hardware connections for different
  * power amplifiers. This setting tells the driver which one is connected.
  * 
@@ -170,18 +367,99 @@ void LDL_Radio_setPA(struct ldl_radio *self, enum ldl_radio_pa pa);
  * */
 void LDL_Radio_interrupt(struct ldl_radio *self, uint8_t n);
 
+#ifdef LDL_ENABLE_CHIP_ASYNC
+/** Signal that the batch passed to LDL_Chip_submit() has completed
+ * 
+ * @param[in] self  #ldl_radio
+ * 
+ * @ingroup ldl_radio_connector
+ * 
+ * @note may be called from an interrupt
+ * 
+ * */
+void LDL_Radio_chipComplete(struct ldl_radio *self);
+
+/** Start the operation that was requested while a batch was in progress
+ * 
+ * LDL_Radio_transmit(), LDL_Radio_receive(), LDL_Radio_cad(),
+ * LDL_Radio_clearInterrupt() and LDL_Radio_sleep() return without 
+ * touching the chip if a batch is in progress. The last one requested
+ * is started by this function once the batch has completed.
+ * 
+ * Operations that need more than one batch also continue from here.
+ * 
+ * @param[in] self  #ldl_radio
+ * 
+ * */
+void LDL_Radio_resume(struct ldl_radio *self);
+
+/** @retval true a batch is in progress */
+bool LDL_Radio_busy(const struct ldl_radio *self);
+
+/** @retval true LDL_Radio_resume() has an operation to start */
+bool LDL_Radio_pending(const struct ldl_radio *self);
+#endif
+
+#ifdef LDL_ENABLE_RADIO_ENERGY
+/** Start energy accounting
+ * 
+ * The driver will timestamp state changes from this point on using
+ * LDL_System_ticks(). Call after LDL_Radio_init() and before LDL_MAC_init().
+ * 
+ * @param[in] self
+ * @param[in] app   passed to LDL_System_ticks()
+ * 
+ * */
+void LDL_Radio_enableEnergy(struct ldl_radio *self, void *app);
+
+/** Replace the current table
+ * 
+ * LDL_Radio_init() selects a table of typical values from the
+ * datasheet of the radio. Use this interface if you have measured
+ * your own hardware.
+ * 
+ * @param[in] self
+ * @param[in] table   must remain valid for the lifetime of the driver
+ * 
+ * */
+void LDL_Radio_setCurrentTable(struct ldl_radio *self, const struct ldl_radio_current_table *table);
+
+/** Read the energy counters
+ * 
+ * Time spent in the current state is included up to the moment
+ * of the call. Counting begins at LDL_Radio_enableEnergy().
+ * 
+ * @param[in] self
+ * @param[out] energy
+ * 
+ * */
+void LDL_Radio_getEnergy(struct ldl_radio *self, struct ldl_radio_energy *energy);
+#endif
+
 void LDL_Radio_setHandler(struct ldl_radio *self, struct ldl_mac *mac, ldl_radio_event_fn handler);
 
 void LDL_Radio_entropyBegin(struct ldl_radio *self);
 unsigned int LDL_Radio_entropyEnd(struct ldl_radio *self);
 enum ldl_radio_event LDL_Radio_signal(struct ldl_radio *self, uint8_t n);
 void LDL_Radio_reset(struct ldl_radio *self, bool state);
+#ifndef LDL_ENABLE_CHIP_ASYNC
 uint8_t LDL_Radio_collect(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta, void *data, uint8_t max);
+#endif
+void LDL_Radio_collectBegin(struct ldl_radio *self, void *data, uint8_t max);
+bool LDL_Radio_collectResume(struct ldl_radio *self);
+uint8_t LDL_Radio_collectEnd(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
 void LDL_Radio_sleep(struct ldl_radio *self);
 void LDL_Radio_transmit(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const void *data, uint8_t len);
 void LDL_Radio_receive(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
 void LDL_Radio_clearInterrupt(struct ldl_radio *self);
+#ifdef LDL_ENABLE_CAD
+void LDL_Radio_cad(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings);
+bool LDL_Radio_cadDetected(struct ldl_radio *self);
+#endif
 int16_t LDL_Radio_minSNR(const struct ldl_radio *self, enum ldl_spreading_factor sf);
+#ifdef LDL_ENABLE_FSK
+bool LDL_Radio_supportsFSK(const struct ldl_radio *self);
+#endif
 
 #ifdef LDL_ENABLE_RADIO_TEST
 void LDL_Radio_setFreq(struct ldl_radio *self, uint32_t freq);
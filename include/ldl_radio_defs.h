@@ -39,6 +39,7 @@ enum ldl_spreading_factor {
     LDL_SF_10,      /**< 1024 chips/symbol */
     LDL_SF_11,      /**< 2048 chips/symbol */
     LDL_SF_12,      /**< 4096 chips/symbol */
+    LDL_SF_FSK,     /**< FSK modulation at 50kbps (bandwidth does not apply) */
 };
 
 /** signal bandwidth */
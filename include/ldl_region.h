@@ -63,6 +63,20 @@ enum ldl_region {
 #endif    
 };
 
+/* defined when more than one region is included, in which case the
+ * region passed to LDL_MAC_init() selects the region descriptor at run
+ * time */
+#if (defined(LDL_ENABLE_EU_863_870) + defined(LDL_ENABLE_US_902_928) + defined(LDL_ENABLE_AU_915_928) + defined(LDL_ENABLE_EU_433)) > 1
+#   define LDL_ENABLE_REGION_SELECT
+#endif
+
+/* largest number of channels in the included regions */
+#if defined(LDL_ENABLE_US_902_928) || defined(LDL_ENABLE_AU_915_928)
+#   define LDL_REGION_MAX_CHANNELS 72U
+#else
+#   define LDL_REGION_MAX_CHANNELS 16U
+#endif
+
 struct ldl_mac;
 
 void LDL_Region_convertRate(enum ldl_region region, uint8_t rate, enum ldl_spreading_factor *sf, enum ldl_signal_bandwidth *bw, uint8_t *mtu);
@@ -86,6 +100,9 @@ uint8_t LDL_Region_getJoinRate(enum ldl_region region, uint32_t trial);
 void LDL_Region_getDefaultChannels(enum ldl_region region, struct ldl_mac *mac);
 void LDL_Region_processCFList(enum ldl_region region, struct ldl_mac *mac, const uint8_t *cfList, uint8_t cfListLen);
 uint32_t LDL_Region_getMaxDCycleOffLimit(enum ldl_region region);
+#ifdef LDL_ENABLE_CLASS_B
+bool LDL_Region_getBeaconChannel(enum ldl_region region, uint32_t *freq, uint8_t *rate);
+#endif
 
 #ifdef __cplusplus
 }
@@ -28,6 +28,14 @@
 /* static function prototypes *****************************************/
 
 static bool getFrameType(uint8_t tag, enum ldl_frame_type *type);
+static bool dataIsValid(const uint8_t *in, uint8_t len);
+static uint16_t getU16(const uint8_t *in);
+static uint32_t getU24(const uint8_t *in);
+static uint32_t getU32(const uint8_t *in);
+static uint8_t putU16(uint8_t *out, uint16_t value);
+static uint8_t putU32(uint8_t *out, uint32_t value);
+static uint16_t frameSize(bool port, uint8_t dataLen, uint8_t optsLen);
+static uint16_t beaconCRC(const uint8_t *in, uint8_t len);
 
 /* functions **********************************************************/
 
@@ -35,15 +43,9 @@ void LDL_Frame_updateMIC(void *msg, uint8_t len, uint32_t mic)
 {
     LDL_PEDANTIC(msg != NULL)
     
-    struct ldl_stream s;    
-    
     if(len > sizeof(mic)){
     
-        LDL_Stream_init(&s, msg, len);
-        
-        (void)LDL_Stream_seekSet(&s, len - sizeof(mic));
-        
-        (void)LDL_Stream_putU32(&s, mic);    
+        (void)putU32(&((uint8_t *)msg)[len - sizeof(mic)], mic);
     }
 }
 
@@ -51,30 +53,46 @@ uint8_t LDL_Frame_putData(const struct ldl_frame_data *f, void *out, uint8_t max
 {
     LDL_PEDANTIC(f != NULL)
     
-    struct ldl_stream s;    
-    
-    LDL_Stream_init(&s, out, max);
+    uint8_t *ptr = (uint8_t *)out;
+    uint8_t optsLen = f->optsLen & 0xfU;
+    uint8_t retval = 0U;
+    uint8_t pos;
     
     (void)memset(off, 0, sizeof(*off));
     
-    (void)LDL_Stream_putU8(&s, ((uint8_t)f->type) << 5);
-    (void)LDL_Stream_putU32(&s, f->devAddr);
-    (void)LDL_Stream_putU8(&s, (f->adr ? 0x80U : 0U) | (f->adrAckReq ? 0x40U : 0U) | (f->ack ? 0x20U : 0U) | (f->pending ? 0x10U : 0U) | (f->optsLen & 0xfU));
-    (void)LDL_Stream_putU16(&s, f->counter);
-    
-    off->opts = LDL_Stream_tell(&s);
-    (void)LDL_Stream_write(&s, f->opts, f->optsLen & 0xfU);
-    
-    if(f->data != NULL){
-
-        (void)LDL_Stream_putU8(&s, f->port);            
-        off->data = LDL_Stream_tell(&s);            
-        (void)LDL_Stream_write(&s, f->data, f->dataLen);        
+    /* capacity is checked once so that the rest can be written directly */
+    if(frameSize((f->data != NULL), f->dataLen, optsLen) <= max){
+        
+        ptr[0] = ((uint8_t)f->type) << 5;
+        pos = 1U;
+        pos += putU32(&ptr[pos], f->devAddr);
+        ptr[pos] = (f->adr ? 0x80U : 0U) | (f->adrAckReq ? 0x40U : 0U) | (f->ack ? 0x20U : 0U) | ((f->pending || f->classB) ? 0x10U : 0U) | optsLen;
+        pos++;
+        pos += putU16(&ptr[pos], f->counter);
+        
+        off->opts = pos;
+        
+        if(optsLen > 0U){
+            
+            (void)memcpy(&ptr[pos], f->opts, optsLen);
+            pos += optsLen;
+        }
+        
+        if(f->data != NULL){
+        
+            ptr[pos] = f->port;
+            pos++;
+            off->data = pos;
+            (void)memcpy(&ptr[pos], f->data, f->dataLen);
+            pos += f->dataLen;
+        }
+        
+        pos += putU32(&ptr[pos], f->mic);
+        
+        retval = pos;
     }
     
-    (void)LDL_Stream_putU32(&s, f->mic);                
-    
-    return LDL_Stream_error(&s) ? 0U : LDL_Stream_tell(&s);
+    return retval;
 }
 
 uint8_t LDL_Frame_putJoinRequest(const struct ldl_frame_join_request *f, void *out, uint8_t max)
@@ -120,6 +138,40 @@ uint8_t LDL_Frame_sizeofJoinAccept(bool withCFList)
     return 17U + (withCFList ? 16U : 0U);
 }
 
+bool LDL_Frame_peek(const void *in, uint8_t len, enum ldl_frame_type *type)
+{
+    LDL_PEDANTIC(type != NULL)
+    
+    const uint8_t *ptr = (const uint8_t *)in;
+    bool retval = false;
+    
+    if((len > 0U) && getFrameType(ptr[0], type)){
+        
+        switch(*type){
+        default:
+        case FRAME_TYPE_REJOIN_REQ:
+        case FRAME_TYPE_JOIN_REQ:
+            break;
+            
+        case FRAME_TYPE_JOIN_ACCEPT:
+        
+            /* buffer should only be one of these sizes */
+            retval = (len == LDL_Frame_sizeofJoinAccept(false)) || (len == LDL_Frame_sizeofJoinAccept(true));
+            break;
+            
+        case FRAME_TYPE_DATA_UNCONFIRMED_UP:
+        case FRAME_TYPE_DATA_CONFIRMED_UP:
+        case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:
+        case FRAME_TYPE_DATA_CONFIRMED_DOWN:
+        
+            retval = dataIsValid(ptr, len);
+            break;
+        }
+    }
+    
+    return retval;
+}
+
 bool LDL_Frame_decode(struct ldl_frame_down *f, void *in, uint8_t len)
 {
     LDL_PEDANTIC(f != NULL)
@@ -127,106 +179,202 @@ bool LDL_Frame_decode(struct ldl_frame_down *f, void *in, uint8_t len)
     
     uint8_t *ptr = (uint8_t *)in;
     bool retval = false;    
-    uint8_t fhdr = 0U;
-    uint8_t tag;
-    uint8_t dlSettings = 0U;
-    struct ldl_stream s;    
-    
-    (void)memset(f, 0, sizeof(*f));    
+    uint8_t fhdr;
+    uint8_t dlSettings;
+    uint8_t pos;
     
-    LDL_Stream_initReadOnly(&s, in, len);
-
-    if(LDL_Stream_getU8(&s, &tag)){
-    
-        if(getFrameType(tag, &f->type)){
+    if(LDL_Frame_peek(in, len, &f->type)){
     
-            switch(f->type){
-            default:  
-            case FRAME_TYPE_REJOIN_REQ:            
-            case FRAME_TYPE_JOIN_REQ:
-            case FRAME_TYPE_DATA_UNCONFIRMED_UP:
-            case FRAME_TYPE_DATA_CONFIRMED_UP:
-                break;
-                
-            case FRAME_TYPE_JOIN_ACCEPT:
+        switch(f->type){
+        default:  
+        case FRAME_TYPE_REJOIN_REQ:            
+        case FRAME_TYPE_JOIN_REQ:
+        case FRAME_TYPE_DATA_UNCONFIRMED_UP:
+        case FRAME_TYPE_DATA_CONFIRMED_UP:
+            break;
             
-                (void)LDL_Stream_getU24(&s, &f->joinNonce);
-                (void)LDL_Stream_getU24(&s, &f->netID);
-                (void)LDL_Stream_getU32(&s, &f->devAddr);
-                (void)LDL_Stream_getU8(&s, &dlSettings);
-                (void)LDL_Stream_getU8(&s, &f->rxDelay);
-                
-                f->optNeg =             ((dlSettings & 0x80U) != 0);
-                f->rx1DataRateOffset =  (dlSettings >> 4) & 0x7U;
-                f->rx2DataRate =        dlSettings & 0xfU;                    
-                
-                f->rxDelay = ( f->rxDelay == 0U) ? 1U : f->rxDelay;
-                
-                /* cflist is included */
-                if(LDL_Stream_remaining(&s) > sizeof(f->mic)){
-                
-                    f->cfList = &ptr[LDL_Stream_tell(&s)];
-                    f->cfListLen = 16U;
-                    (void)LDL_Stream_seekCur(&s, f->cfListLen);
-                }
-                
-                (void)LDL_Stream_getU32(&s, &f->mic);
-                    
-                if(!LDL_Stream_error(&s)){
-                    
-                    /* buffer should only be this size */
-                    if(LDL_Stream_remaining(&s) == 0U){
-                        
-                        retval = true;                    
-                    }                    
-                }
-                break;
-
-            case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:            
-            case FRAME_TYPE_DATA_CONFIRMED_DOWN:
-
-                (void)LDL_Stream_getU32(&s, &f->devAddr);
-                (void)LDL_Stream_getU8(&s, &fhdr);
+        case FRAME_TYPE_JOIN_ACCEPT:
+        
+            f->joinNonce = getU24(&ptr[1U]);
+            f->netID = getU24(&ptr[4U]);
+            f->devAddr = getU32(&ptr[7U]);
+            
+            dlSettings = ptr[11U];
+            
+            f->optNeg =             ((dlSettings & 0x80U) != 0);
+            f->rx1DataRateOffset =  (dlSettings >> 4) & 0x7U;
+            f->rx2DataRate =        dlSettings & 0xfU;                    
+            
+            f->rxDelay = (ptr[12U] == 0U) ? 1U : ptr[12U];
+            
+            if(len == LDL_Frame_sizeofJoinAccept(true)){
+            
+                f->cfList = &ptr[13U];
+                f->cfListLen = 16U;
+            }
+            else{
                 
-                f->adr =        ((fhdr & 0x80U) > 0U) ? true : false;
-                f->adrAckReq =  ((fhdr & 0x40U) > 0U) ? true : false;
-                f->ack =        ((fhdr & 0x20U) > 0U) ? true : false;
-                f->pending =    ((fhdr & 0x10U) > 0U) ? true : false;
-                f->optsLen =    fhdr & 0xfU;
+                f->cfList = NULL;
+                f->cfListLen = 0U;
+            }
+            
+            f->mic = getU32(&ptr[len - sizeof(f->mic)]);
+            
+            retval = true;
+            break;
+
+        case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:            
+        case FRAME_TYPE_DATA_CONFIRMED_DOWN:
+
+            f->devAddr = getU32(&ptr[1U]);
+            
+            fhdr = ptr[5U];
+            
+            f->adr =        ((fhdr & 0x80U) > 0U) ? true : false;
+            f->adrAckReq =  ((fhdr & 0x40U) > 0U) ? true : false;
+            f->ack =        ((fhdr & 0x20U) > 0U) ? true : false;
+            f->pending =    ((fhdr & 0x10U) > 0U) ? true : false;
+            f->optsLen =    fhdr & 0xfU;
+            
+            f->counter = getU16(&ptr[6U]);
+            
+            f->opts = (f->optsLen > 0U) ? &ptr[8U] : NULL;
+            
+            pos = 8U + f->optsLen;
+            
+            f->dataPresent = ((uint8_t)(len - pos) > sizeof(f->mic));
+            
+            if(f->dataPresent){
                 
-                (void)LDL_Stream_getU16(&s, &f->counter);
+                f->port = ptr[pos];
+                pos++;
+                f->dataLen = len - pos - sizeof(f->mic);
+                f->data = (f->dataLen == 0U) ? NULL : &ptr[pos];
+            }
+            else{
                 
-                f->opts = (f->optsLen > 0U) ? &ptr[LDL_Stream_tell(&s)] : NULL; 
-                (void)LDL_Stream_seekCur(&s, f->optsLen);
+                f->port = 0U;
+                f->dataLen = 0U;
+                f->data = NULL;
+            }
+            
+            f->mic = getU32(&ptr[len - sizeof(f->mic)]);
+            
+            retval = true;
+            break;
+        }
+    }
+    
+    return retval;
+}
+
+bool LDL_Frame_decodeUp(struct ldl_frame_up *f, void *in, uint8_t len)
+{
+    LDL_PEDANTIC(f != NULL)
+    LDL_PEDANTIC((in != NULL) && (len > 0U))
+    
+    uint8_t *ptr = (uint8_t *)in;
+    bool retval = false;    
+    uint8_t fhdr;
+    uint8_t pos;
+    
+    if(LDL_Frame_peek(in, len, &f->type)){
+    
+        switch(f->type){
+        default:  
+        case FRAME_TYPE_REJOIN_REQ:            
+        case FRAME_TYPE_JOIN_REQ:
+        case FRAME_TYPE_JOIN_ACCEPT:
+        case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:
+        case FRAME_TYPE_DATA_CONFIRMED_DOWN:
+            break;
+            
+        case FRAME_TYPE_DATA_UNCONFIRMED_UP:            
+        case FRAME_TYPE_DATA_CONFIRMED_UP:
+
+            f->devAddr = getU32(&ptr[1U]);
+            
+            fhdr = ptr[5U];
+            
+            f->adr =        ((fhdr & 0x80U) > 0U) ? true : false;
+            f->adrAckReq =  ((fhdr & 0x40U) > 0U) ? true : false;
+            f->ack =        ((fhdr & 0x20U) > 0U) ? true : false;
+            f->classB =     ((fhdr & 0x10U) > 0U) ? true : false;
+            f->optsLen =    fhdr & 0xfU;
+            
+            f->counter = getU16(&ptr[6U]);
+            
+            f->opts = (f->optsLen > 0U) ? &ptr[8U] : NULL;
+            
+            pos = 8U + f->optsLen;
+            
+            f->dataPresent = ((uint8_t)(len - pos) > sizeof(f->mic));
+            
+            if(f->dataPresent){
                 
-                if(LDL_Stream_remaining(&s) > sizeof(f->mic)){
-                    
-                    f->dataPresent = true;
-                    
-                    (void)LDL_Stream_getU8(&s, &f->port);
-                    f->dataLen = LDL_Stream_remaining(&s) - sizeof(f->mic);                                                
-                    f->data = (f->dataLen == 0U) ? NULL : &ptr[LDL_Stream_tell(&s)];                    
-                    (void)LDL_Stream_seekCur(&s, f->dataLen);
-                }
+                f->port = ptr[pos];
+                pos++;
+                f->dataLen = len - pos - sizeof(f->mic);
+                f->data = (f->dataLen == 0U) ? NULL : &ptr[pos];
+            }
+            else{
                 
-                (void)LDL_Stream_getU32(&s, &f->mic);
+                f->port = 0U;
+                f->dataLen = 0U;
+                f->data = NULL;
+            }
+            
+            f->mic = getU32(&ptr[len - sizeof(f->mic)]);
+            
+            retval = true;
+            break;
+        }
+    }
+    
+    return retval;
+}
+
+bool LDL_Frame_decodeBeacon(struct ldl_frame_beacon *f, const void *in, uint8_t len)
+{
+    LDL_PEDANTIC(f != NULL)
+    LDL_PEDANTIC(in != NULL)
+    
+    /* RFU (2) | Time (4) | CRC (2) | GwSpecific (7) | CRC (2) */
+    const uint8_t *ptr = (const uint8_t *)in;
+    bool retval = false;
+    
+    (void)memset(f, 0, sizeof(*f));
+    
+    if(len == LDL_Frame_sizeofBeacon()){
+        
+        if(beaconCRC(ptr, 6U) == ((uint16_t)ptr[6] | ((uint16_t)ptr[7] << 8))){
+            
+            f->time = (uint32_t)ptr[2] | ((uint32_t)ptr[3] << 8) | ((uint32_t)ptr[4] << 16) | ((uint32_t)ptr[5] << 24);
+            
+            if(beaconCRC(&ptr[8], 7U) == ((uint16_t)ptr[15] | ((uint16_t)ptr[16] << 8))){
                 
-                if(!LDL_Stream_error(&s)){
-                    
-                    /* cannot have fopts when data is present and port == 0 */
-                    if(!(f->dataPresent && (f->optsLen > 0) && (f->port == 0U))){
-                        
-                        retval = true;
-                    }                                
-                }
-                break;
+                f->gwSpecific = &ptr[8];
             }
+            
+            retval = true;
         }
     }
     
     return retval;
 }
 
+uint8_t LDL_Frame_sizeofBeacon(void)
+{
+    return 17U;
+}
+
+uint8_t LDL_Frame_getPhyPayloadSize(uint8_t dataLen, uint8_t optsLen)
+{
+    uint16_t size = frameSize((dataLen > 0U), dataLen, optsLen);
+    
+    return (size > UINT8_MAX) ? UINT8_MAX : (uint8_t)size;
+}
+
 uint8_t LDL_Frame_dataOverhead(void)
 {
     /* DevAddr + FCtrl + FCnt + FOpts + FPort */
@@ -242,6 +390,86 @@ uint8_t LDL_Frame_phyOverhead(void)
 
 /* static functions ***************************************************/
 
+static bool dataIsValid(const uint8_t *in, uint8_t len)
+{
+    /* MHDR + DevAddr + FCtrl + FCnt + MIC */
+    const uint8_t overhead = 1U + 4U + 1U + 2U + 4U;
+    bool retval = false;
+    uint8_t optsLen;
+    
+    if(len >= overhead){
+        
+        optsLen = in[5U] & 0xfU;
+        
+        if(len >= (overhead + optsLen)){
+            
+            /* cannot have fopts when data is present and port == 0 */
+            retval = (len == (overhead + optsLen)) || (optsLen == 0U) || (in[overhead + optsLen - 4U] != 0U);
+        }
+    }
+    
+    return retval;
+}
+
+static uint16_t getU16(const uint8_t *in)
+{
+    return (uint16_t)in[0] | ((uint16_t)in[1] << 8);
+}
+
+static uint32_t getU24(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16);
+}
+
+static uint32_t getU32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+static uint8_t putU16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    
+    return 2U;
+}
+
+static uint8_t putU32(uint8_t *out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    
+    return 4U;
+}
+
+static uint16_t frameSize(bool port, uint8_t dataLen, uint8_t optsLen)
+{
+    /* MHDR + DevAddr + FCtrl + FCnt + FOpts + FPort + FRMPayload + MIC */
+    return (uint16_t)LDL_Frame_phyOverhead() + (4U + 1U + 2U) + optsLen + (port ? (1U + (uint16_t)dataLen) : 0U);
+}
+
+static uint16_t beaconCRC(const uint8_t *in, uint8_t len)
+{
+    /* CRC-16/CCITT (polynomial 0x1021, initial value 0) */
+    uint16_t crc = 0U;
+    uint8_t i;
+    uint8_t j;
+    
+    for(i=0U; i < len; i++){
+        
+        crc ^= (uint16_t)in[i] << 8;
+        
+        for(j=0U; j < 8U; j++){
+            
+            crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    
+    return crc;
+}
+
 static bool getFrameType(uint8_t tag, enum ldl_frame_type *type)
 {
     bool retval = false;
@@ -30,6 +30,14 @@
 #include "ldl_ops.h"
 #include <string.h>
 
+#ifdef LDL_ENABLE_TRACE
+#   define TRACE(SELF, TYPE) trace((SELF), (TYPE), NULL, 0U, NULL, 0U)
+#   define TRACE_U8(SELF, TYPE, VALUE) traceU8((SELF), (TYPE), (VALUE))
+#else
+#   define TRACE(SELF, TYPE) do{}while(0)
+#   define TRACE_U8(SELF, TYPE, VALUE) do{}while(0)
+#endif
+
 enum {
     
     ADRAckLimit = 64U,
@@ -37,34 +45,141 @@ enum {
     ADRAckTimeout = 2U
 };
 
+#ifdef LDL_ENABLE_CLASS_B
+#ifdef LDL_DISABLE_DEVICE_TIME
+#   error "LDL_ENABLE_CLASS_B needs DeviceTimeReq; remove LDL_DISABLE_DEVICE_TIME"
+#endif
+
+enum {
+    
+    BeaconPeriod = 128U,    /* seconds */
+    BeaconReserved = 2120U, /* ms */
+    PingSlotLen = 30U,      /* ms */
+    BeaconSize = 17U
+};
+#endif
+
+/* session changes staged by the commands of one downlink */
+struct cmd_delta {
+    
+    uint16_t staged;        /**< (1 << type) for each command to apply */
+    
+    uint16_t adr_ack_limit;
+    uint16_t adr_ack_delay;
+    
+    uint32_t rx2Freq;       /**< 100Hz units */
+    
+    uint8_t chMask[(LDL_REGION_MAX_CHANNELS + 7U) / 8U];
+    
+    uint8_t rate;
+    uint8_t power;
+    uint8_t nbTrans;
+    uint8_t maxDutyCycle;
+    uint8_t rx1DROffset;
+    uint8_t rx2DataRate;
+    uint8_t rx1Delay;
+};
+
+/* uplink MAC commands in the order they are packed into FOpts */
+static const uint8_t upCommands[] = {
+    
+    /* sticky */
+    LDL_CMD_REKEY,
+    LDL_CMD_RX_PARAM_SETUP,
+    LDL_CMD_DL_CHANNEL,
+    LDL_CMD_RX_TIMING_SETUP,
+    
+    /* single shot */
+    LDL_CMD_LINK_ADR,
+    LDL_CMD_DEV_STATUS,
+    LDL_CMD_NEW_CHANNEL,
+    LDL_CMD_REJOIN_PARAM_SETUP,
+    LDL_CMD_ADR_PARAM_SETUP,
+    LDL_CMD_TX_PARAM_SETUP,
+    LDL_CMD_DUTY_CYCLE,
+    
+    /* requests */
+    LDL_CMD_LINK_CHECK,
+    LDL_CMD_DEVICE_TIME,
+    LDL_CMD_PING_SLOT_INFO
+};
+
 /* static function prototypes *****************************************/
 
 static uint8_t extraSymbols(uint32_t xtal_error, uint32_t symbol_period);
 static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t port, const void *data, uint8_t len, const struct ldl_mac_data_opts *opts);
 static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len);
+static void applyDelta(struct ldl_mac *self, const struct cmd_delta *delta);
+static void putUpCommand(struct ldl_mac *self, struct ldl_stream *s, enum ldl_mac_cmd_type type);
+static bool upCommandIsWanted(const struct ldl_mac *self, enum ldl_mac_cmd_type type);
+static bool upCommandIsUrgent(const struct ldl_mac *self, enum ldl_mac_cmd_type type);
+static uint8_t urgentSize(const struct ldl_mac *self);
+static void packUpCommands(struct ldl_mac *self, struct ldl_stream *s, uint8_t room);
 static bool selectChannel(const struct ldl_mac *self, uint8_t rate, uint8_t prevChIndex, uint32_t limit, uint8_t *chIndex, uint32_t *freq);
-static void registerTime(struct ldl_mac *self, uint32_t freq, uint32_t airTime);
+static void registerTime(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint32_t airTime);
 static bool getChannel(const struct ldl_mac *self, uint8_t chIndex, uint32_t *freq, uint8_t *minRate, uint8_t *maxRate);
 static bool isAvailable(const struct ldl_mac *self, uint8_t chIndex, uint8_t rate, uint32_t limit);
 static uint32_t transmitTime(enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, uint8_t size, bool crc);
 static void restoreDefaults(struct ldl_mac *self, bool keep);
 static bool setChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint8_t minRate, uint8_t maxRate);
+static bool getChannelBand(const struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint8_t *band);
+static uint32_t getFreq(const uint8_t *in);
+static void putFreq(uint8_t *out, uint32_t freq);
 static bool maskChannel(uint8_t *mask, uint8_t max, enum ldl_region region, uint8_t chIndex);
 static bool unmaskChannel(uint8_t *mask, uint8_t max, enum ldl_region region, uint8_t chIndex);
 static void unmaskAllChannels(uint8_t *mask, uint8_t max);
 static bool channelIsMasked(const uint8_t *mask, uint8_t max, enum ldl_region region, uint8_t chIndex);
 static uint32_t symbolPeriod(enum ldl_spreading_factor sf, enum ldl_signal_bandwidth bw);
 static bool msUntilAvailable(const struct ldl_mac *self, uint8_t chIndex, uint8_t rate, uint32_t *ms);
-static bool rateSettingIsValid(enum ldl_region region, uint8_t rate);
+static bool rateSettingIsValid(const struct ldl_mac *self, uint8_t rate);
+static bool rateIsSupported(const struct ldl_mac *self, uint8_t rate);
 static void adaptRate(struct ldl_mac *self);
 static uint32_t timeNow(struct ldl_mac *self);
+static void processState(struct ldl_mac *self);
 static void processBands(struct ldl_mac *self);
 static uint32_t nextBandEvent(const struct ldl_mac *self);
 static void downlinkMissingHandler(struct ldl_mac *self);
+static void rxTimeoutHandler(struct ldl_mac *self);
 static uint32_t ticksToMS(uint32_t ticks);
 static uint32_t ticksToMSCoarse(uint32_t ticks);
 static uint32_t msUntilNextChannel(const struct ldl_mac *self, uint8_t rate);
-static uint32_t rand32(void *app);
+static uint32_t rand32(const struct ldl_mac *self);
+static uint8_t getRand(const struct ldl_mac *self);
+static uint32_t getTicks(const struct ldl_mac *self);
+static void forget(struct ldl_mac *self);
+static void cancel(struct ldl_mac *self);
+static void transmit(struct ldl_mac *self);
+static bool isIdle(const struct ldl_mac *self);
+#ifdef LDL_ENABLE_CLASS_C
+static bool listenPending(const struct ldl_mac *self);
+static void listenContinuous(struct ldl_mac *self);
+static void stopListening(struct ldl_mac *self);
+static void openRXC(struct ldl_mac *self);
+static bool waitingInRXC(const struct ldl_mac *self);
+static void suspendWait(struct ldl_mac *self);
+static void resumeWait(struct ldl_mac *self);
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+static void processClassB(struct ldl_mac *self);
+static void scheduleClassB(struct ldl_mac *self);
+static void syncBeacon(struct ldl_mac *self, uint32_t seconds, uint8_t fractions);
+static void beaconMissed(struct ldl_mac *self);
+static void stopSlot(struct ldl_mac *self);
+static void stopClassB(struct ldl_mac *self);
+static uint16_t pingNb(const struct ldl_mac *self);
+static uint16_t pingPeriod(const struct ldl_mac *self);
+static uint32_t beaconAirTime(enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf);
+static uint32_t msToTicks(uint32_t ms);
+#endif
+#ifdef LDL_ENABLE_CAD
+static void listenBeforeTalk(struct ldl_mac *self);
+static bool rateIsFSK(enum ldl_region region, uint8_t rate);
+#endif
+#ifdef LDL_ENABLE_TRACE
+static void trace(const struct ldl_mac *self, enum ldl_mac_trace_type type, const void *hdr, uint8_t hdrLen, const void *data, uint8_t dataLen);
+static void traceU8(const struct ldl_mac *self, enum ldl_mac_trace_type type, uint8_t value);
+static void traceU32(const struct ldl_mac *self, enum ldl_mac_trace_type type, uint32_t value);
+#endif
 static uint32_t getRetryDuty(uint32_t seconds_since);
 static uint32_t timerDelta(uint32_t timeout, uint32_t time);
 #ifndef LDL_DISABLE_SESSION_UPDATE
@@ -75,6 +190,21 @@ static bool allChannelsAreMasked(const uint8_t *mask, uint8_t max);
 static bool commandIsPending(const struct ldl_mac *self, enum ldl_mac_cmd_type type);
 static void clearPendingCommand(struct ldl_mac *self, enum ldl_mac_cmd_type type);
 static void setPendingCommand(struct ldl_mac *self, enum ldl_mac_cmd_type type);
+#ifdef LDL_ENABLE_CHIP_ASYNC
+static bool collectResume(struct ldl_mac *self);
+#endif
+static uint8_t getNbTrans(const struct ldl_mac *self);
+static void prepareJoinRequest(struct ldl_mac *self);
+#ifdef LDL_ENABLE_SHARED_BUFFER
+static void saveData(struct ldl_mac *self, const struct ldl_frame_data *f);
+static void prepareData(struct ldl_mac *self);
+#endif
+#ifdef LDL_ENABLE_STATIC_RX_BUFFER
+static uint8_t *rxBuffer(struct ldl_mac *self, uint8_t *max);
+#endif
+#ifdef LDL_ENABLE_FSK
+static void setRXBuffer(struct ldl_mac *self, struct ldl_radio_rx_setting *setting);
+#endif
 
 /* functions **********************************************************/
 
@@ -94,6 +224,9 @@ void LDL_MAC_init(struct ldl_mac *self, enum ldl_region region, const struct ldl
     self->region = region;
     
     self->app = arg->app;    
+#ifdef LDL_ENABLE_TRACE
+    self->trace = arg->trace;
+#endif
     self->handler = arg->handler ? arg->handler : dummyResponseHandler;
     self->radio = arg->radio;
     self->sm = arg->sm;      
@@ -129,7 +262,7 @@ void LDL_MAC_init(struct ldl_mac *self, enum ldl_region region, const struct ldl
     
     self->band[LDL_BAND_GLOBAL] = (uint32_t)LDL_STARTUP_DELAY;
     
-    self->polled_band_ticks = LDL_System_ticks(self->app);
+    self->polled_band_ticks = getTicks(self);
     self->polled_time_ticks = self->polled_band_ticks;
     
     LDL_Radio_reset(self->radio, false);
@@ -176,17 +309,25 @@ bool LDL_MAC_otaa(struct ldl_mac *self)
     LDL_PEDANTIC(self != NULL)
     
     uint32_t delay;
-    struct ldl_frame_join_request f;
     
     bool retval = false;
     
+    TRACE(self, LDL_TRACE_OTAA);
+    
     self->errno = LDL_ERRNO_NONE;
     
-    if(self->state == LDL_STATE_IDLE){
+    if(isIdle(self)){
+        
+#ifdef LDL_ENABLE_CLASS_C
+        stopListening(self);
+#endif        
+#ifdef LDL_ENABLE_CLASS_B
+        stopSlot(self);
+#endif
         
         if(self->ctx.joined){
             
-            LDL_MAC_forget(self);
+            forget(self);
         }
         
         self->trials = 0U;
@@ -202,19 +343,14 @@ bool LDL_MAC_otaa(struct ldl_mac *self)
 #ifndef LDL_DISABLE_POINTONE          
                 LDL_OPS_deriveJoinKeys(self);
 #endif                
-            
-                f.joinEUI = self->joinEUI;
-                f.devEUI = self->devEUI;
                 
 #ifdef LDL_DISABLE_POINTONE
                 /* LoRAWAN 1.0 uses random nonce */
-                self->devNonce = rand32(self->app);
+                self->devNonce = rand32(self);
 #endif                                
-                f.devNonce = self->devNonce;
-
-                self->bufferLen = LDL_OPS_prepareJoinRequest(self, &f, self->buffer, sizeof(self->buffer));
+                prepareJoinRequest(self);
 
-                delay = rand32(self->app) % (60UL*LDL_System_tps());
+                delay = rand32(self) % (60UL*LDL_System_tps());
                 
                 LDL_DEBUG(self->app, "sending join in %"PRIu32" ticks", delay)
                             
@@ -252,35 +388,18 @@ void LDL_MAC_forget(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)    
     
-    LDL_MAC_cancel(self);    
-    
-    if(self->ctx.joined){
+    TRACE(self, LDL_TRACE_FORGET);
     
-        restoreDefaults(self, true);    
-        
-#ifndef LDL_DISABLE_SESSION_UPDATE        
-        pushSessionUpdate(self);   
-#endif
-    }
+    forget(self);
 }
 
 void LDL_MAC_cancel(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
     
-    switch(self->state){
-    case LDL_STATE_IDLE:
-    case LDL_STATE_INIT_RESET:
-    case LDL_STATE_INIT_LOCKOUT:
-    case LDL_STATE_RECOVERY_RESET:    
-    case LDL_STATE_RECOVERY_LOCKOUT:    
-    case LDL_STATE_ENTROPY:    
-        break;
-    default:
-        self->state = LDL_STATE_IDLE;
-        LDL_Radio_sleep(self->radio);    
-        break;
-    }   
+    TRACE(self, LDL_TRACE_CANCEL);
+    
+    cancel(self);
 }
 
 uint32_t LDL_MAC_transmitTimeUp(enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, uint8_t size)
@@ -297,17 +416,52 @@ void LDL_MAC_process(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE(self, LDL_TRACE_PROCESS);
+    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    /* nothing touches the radio while a batch is in progress, 
+     * the state machine carries on once it has completed */
+    LDL_Radio_resume(self->radio);
+    
+    if(!LDL_Radio_busy(self->radio)){
+        
+        processState(self);
+    }
+#else
+    processState(self);
+#endif
+}
+
+static void processState(struct ldl_mac *self)
+{
     uint32_t error;    
     union ldl_mac_response_arg arg;
-
+    
     (void)timeNow(self);    
     
     processBands(self);
     
+#ifdef LDL_ENABLE_CLASS_B
+    processClassB(self);
+#endif    
+
+#ifdef LDL_ENABLE_CLASS_C
+    /* a frame received in RXC while waiting is handled as it would be in RXC */
+    if(waitingInRXC(self) && LDL_MAC_inputCheck(self, LDL_INPUT_RX_READY, &error)){
+        
+        suspendWait(self);
+    }
+#endif
+    
     switch(self->state){
     default:
     case LDL_STATE_IDLE:
-        /* do nothing */
+#ifdef LDL_ENABLE_CLASS_C
+        if(listenPending(self)){
+            
+            listenContinuous(self);
+        }
+#endif        
         break;    
     case LDL_STATE_INIT:
     
@@ -374,6 +528,10 @@ void LDL_MAC_process(struct ldl_mac *self)
             self->op = LDL_OP_RESET;
             
             arg.startup.entropy = LDL_Radio_entropyEnd(self->radio);                    
+            
+#ifdef LDL_ENABLE_TRACE
+            traceU32(self, LDL_TRACE_ENTROPY, arg.startup.entropy);
+#endif
                 
             self->state = LDL_STATE_IDLE;
             self->op = LDL_OP_NONE;
@@ -388,43 +546,86 @@ void LDL_MAC_process(struct ldl_mac *self)
     
         if(LDL_MAC_timerCheck(self, LDL_TIMER_WAITA, &error)){
             
-            struct ldl_radio_tx_setting radio_setting;
-            uint32_t tx_time;
-            uint8_t mtu;
-            
-            LDL_Region_convertRate(self->region, self->tx.rate, &radio_setting.sf, &radio_setting.bw, &mtu);
-            
-            radio_setting.dbm = LDL_Region_getTXPower(self->region, self->tx.power) + self->gain;
-            
-            radio_setting.freq = self->tx.freq;
-            
-            tx_time = transmitTime(radio_setting.bw, radio_setting.sf, self->bufferLen, true);
-            
-            LDL_MAC_inputClear(self);  
-            LDL_MAC_inputArm(self, LDL_INPUT_TX_COMPLETE);  
+#ifdef LDL_ENABLE_CAD
+            /* CAD only detects LoRa */
+            if(self->cad && (self->cad_attempts < LDL_CAD_MAX_ATTEMPTS) && !rateIsFSK(self->region, self->tx.rate)){
+                
+                listenBeforeTalk(self);
+            }
+            else{
+                
+                transmit(self);
+            }
+#else
+            transmit(self);
+#endif            
+        }
+        break;
+        
+#ifdef LDL_ENABLE_CAD
+    case LDL_STATE_CAD:
+    
+        if(LDL_MAC_inputCheck(self, LDL_INPUT_CAD_DONE, &error)){
             
-            LDL_Radio_transmit(self->radio, &radio_setting, self->buffer, self->bufferLen);
-
-            registerTime(self, self->tx.freq, tx_time);
+            LDL_MAC_inputClear(self);
             
-            self->state = LDL_STATE_TX;
+            bool detected = LDL_Radio_cadDetected(self->radio);
             
-            LDL_PEDANTIC((tx_time & 0x80000000UL) != 0x80000000UL)
+#ifdef LDL_ENABLE_TRACE
+            traceU8(self, LDL_TRACE_CAD, detected ? 1U : 0U);
+#endif
             
-            /* reset the radio if the tx complete interrupt doesn't appear after double the expected time */      
-            LDL_MAC_timerSet(self, LDL_TIMER_WAITA, tx_time << 1UL);    
+            LDL_Radio_clearInterrupt(self->radio);
             
-#ifndef LDL_DISABLE_TX_BEGIN_EVENT            
-            arg.tx_begin.freq = self->tx.freq;
-            arg.tx_begin.power = self->tx.power;
-            arg.tx_begin.sf = radio_setting.sf;
-            arg.tx_begin.bw = radio_setting.bw;
-            arg.tx_begin.size = self->bufferLen;
+            if(detected){
+                
+                self->activity[self->tx.chIndex].busy++;
+                self->cad_attempts++;
+                
+                if(selectChannel(self, self->tx.rate, self->tx.chIndex, 0UL, &self->tx.chIndex, &self->tx.freq)){
+                    
+                    /* MIC must be refreshed when channel changes */
+                    if((self->op != LDL_OP_JOINING) && (self->ctx.version > 0)){
+                        
+                        LDL_OPS_micDataFrame(self, self->buffer, self->bufferLen);
+                    }
+                }
+                
+                uint32_t delay = rand32(self) % (((LDL_System_tps() / 1000UL) * self->cad_backoff) + 1UL);
+                
+                LDL_DEBUG(self->app, "channel busy, back-off by %"PRIu32" ticks", delay)
+                
+                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, delay);
+                self->state = LDL_STATE_WAIT_TX;
+            }
+            else{
+                
+                self->activity[self->tx.chIndex].clear++;
+                
+                transmit(self);
+            }
+        }
+        else{
             
-            self->handler(self->app, LDL_MAC_TX_BEGIN, &arg);
-#endif            
+            if(LDL_MAC_timerCheck(self, LDL_TIMER_WAITA, &error)){
+                
+#ifndef LDL_DISABLE_CHIP_ERROR_EVENT                
+                self->handler(self->app, LDL_MAC_CHIP_ERROR, NULL);                
+#endif                
+                LDL_MAC_inputClear(self);
+                
+                self->state = LDL_STATE_RECOVERY_RESET;
+                self->op = LDL_OP_RESET;
+                self->cad_attempts = 0U;
+                
+                LDL_Radio_reset(self->radio, true);
+                
+                /* hold reset for at least 100us */
+                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, ((LDL_System_tps() + LDL_System_eps())/10000UL) + 1UL);
+            }
         }
         break;
+#endif
         
     case LDL_STATE_TX:
     
@@ -458,6 +659,11 @@ void LDL_MAC_process(struct ldl_mac *self)
              * */
             advance = LDL_System_advance() + error;    
             
+#ifdef LDL_ENABLE_CLASS_B
+            /* DeviceTimeAns refers to the end of the uplink */
+            self->tx_end_ticks = getTicks(self) - error;
+#endif
+            
             /* RX1 */
             {
                 LDL_Region_getRX1DataRate(self->region, self->tx.rate, self->ctx.rx1DROffset, &rate);
@@ -476,7 +682,7 @@ void LDL_MAC_process(struct ldl_mac *self)
             
             /* RX2 */
             {
-                LDL_Region_convertRate(self->region, self->ctx.rx2Rate, &sf, &bw, &mtu);
+                LDL_Region_convertRate(self->region, self->ctx.rx2DataRate, &sf, &bw, &mtu);
                 
                 xtal_error = ((waitSeconds + 1UL) * LDL_System_eps() * 2UL);
                 
@@ -514,6 +720,14 @@ void LDL_MAC_process(struct ldl_mac *self)
             
             LDL_Radio_clearInterrupt(self->radio);
             
+#ifdef LDL_ENABLE_CLASS_C
+            /* listen in RXC until the first window opens */
+            if(self->classC && self->ctx.joined){
+                
+                openRXC(self);
+            }
+#endif
+            
 #ifndef LDL_DISABLE_TX_COMPLETE_EVENT            
             self->handler(self->app, LDL_MAC_TX_COMPLETE, NULL);                        
 #endif            
@@ -552,11 +766,16 @@ void LDL_MAC_process(struct ldl_mac *self)
             LDL_Region_convertRate(self->region, rate, &radio_setting.sf, &radio_setting.bw, &radio_setting.max);
             
             radio_setting.max += LDL_Frame_phyOverhead();
+#ifdef LDL_ENABLE_FSK
+            setRXBuffer(self, &radio_setting);
+#endif
             
             self->state = LDL_STATE_RX1;
             
             if(error <= self->rx1_margin){
                 
+                radio_setting.continuous = false;
+                radio_setting.beacon = false;
                 radio_setting.freq = freq;
                 radio_setting.timeout = self->rx1_symbols;
                 
@@ -598,12 +817,17 @@ void LDL_MAC_process(struct ldl_mac *self)
             LDL_Region_convertRate(self->region, self->ctx.rx2DataRate, &radio_setting.sf, &radio_setting.bw, &radio_setting.max);
             
             radio_setting.max += LDL_Frame_phyOverhead();
+#ifdef LDL_ENABLE_FSK
+            setRXBuffer(self, &radio_setting);
+#endif
             
             self->state = LDL_STATE_RX2;
             
             if(error <= self->rx2_margin){
                 
-                radio_setting.freq = self->ctx.rx2Freq;
+                radio_setting.continuous = false;
+                radio_setting.beacon = false;
+                radio_setting.freq = getFreq(self->ctx.rx2Freq);
                 radio_setting.timeout = self->rx2_symbols;
                 
                 LDL_MAC_inputClear(self);
@@ -628,7 +852,7 @@ void LDL_MAC_process(struct ldl_mac *self)
             arg.rx_slot.margin = self->rx2_margin;                
             arg.rx_slot.timeout = self->rx2_symbols;                
             arg.rx_slot.error = error;
-            arg.rx_slot.freq = self->ctx.rx2Freq;
+            arg.rx_slot.freq = getFreq(self->ctx.rx2Freq);
             arg.rx_slot.bw = radio_setting.bw;
             arg.rx_slot.sf = radio_setting.sf;           
                  
@@ -639,16 +863,47 @@ void LDL_MAC_process(struct ldl_mac *self)
         
     case LDL_STATE_RX1:    
     case LDL_STATE_RX2:
+#ifdef LDL_ENABLE_CLASS_C
+    case LDL_STATE_RXC:
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_STATE_PING:
+#endif
 
+#ifdef LDL_ENABLE_CHIP_ASYNC
+        /* the frame is collected over several calls before it is processed */
         if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_READY, &error)){
         
             LDL_MAC_inputClear(self);
+            LDL_MAC_inputArm(self, LDL_INPUT_CHIP_COMPLETE);
+            
+            LDL_MAC_timerClear(self, LDL_TIMER_WAITB);
+            
+            /* chip error if the transfers take longer than 100ms */
+            LDL_MAC_timerSet(self, LDL_TIMER_WAITA, ((LDL_System_tps() + LDL_System_eps())/10UL) + 1UL);
+            
+            uint8_t max;
+            uint8_t *buffer = rxBuffer(self, &max);
+            
+            LDL_Radio_collectBegin(self->radio, buffer, max);
+        }
+        else if(LDL_MAC_inputCheck(self, LDL_INPUT_CHIP_COMPLETE, &error) && collectResume(self)){
+#else
+        if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_READY, &error)){
+#endif        
+            LDL_MAC_inputClear(self);
     
+#ifdef LDL_ENABLE_CLASS_C
+            /* received in RXC while an operation was waiting */
+            bool resume = (self->state == LDL_STATE_RXC) && (self->rxc_state != LDL_STATE_IDLE);
+#endif
             struct ldl_frame_down frame;
-#ifdef LDL_ENABLE_STATIC_RX_BUFFER         
-            uint8_t *buffer = self->rx_buffer;
+#ifdef LDL_ENABLE_STATIC_RX_BUFFER
+            uint8_t max;
+            uint8_t *buffer = rxBuffer(self, &max);
 #else   
             uint8_t buffer[LDL_MAX_PACKET];
+            uint8_t max = sizeof(buffer);
 #endif            
             uint8_t len;
             
@@ -658,23 +913,52 @@ void LDL_MAC_process(struct ldl_mac *self)
             uint8_t foptsLen;
             
             LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
-            LDL_MAC_timerClear(self, LDL_TIMER_WAITB);
             
-            len = LDL_Radio_collect(self->radio, &meta, buffer, LDL_MAX_PACKET);        
+#ifdef LDL_ENABLE_CHIP_ASYNC
+            len = LDL_Radio_collectEnd(self->radio, &meta);
+#else
+            len = LDL_Radio_collect(self->radio, &meta, buffer, max);        
+#endif            
             
             LDL_Radio_clearInterrupt(self->radio);
             
+#ifdef LDL_ENABLE_TRACE
+            {
+                uint8_t hdr[5U];
+                
+                hdr[0] = (uint8_t)meta.rssi;
+                hdr[1] = (uint8_t)((uint16_t)meta.rssi >> 8);
+                hdr[2] = (uint8_t)meta.snr;
+                hdr[3] = (uint8_t)((uint16_t)meta.snr >> 8);
+                hdr[4] = meta.timeout ? 1U : 0U;
+                
+                trace(self, LDL_TRACE_RX, hdr, sizeof(hdr), buffer, len);
+            }
+#endif
+            
             /* notify of a downstream message */
-#ifndef LDL_DISABLE_DOWNSTREAM_EVENT            
-            arg.downstream.rssi = meta.rssi;
-            arg.downstream.snr = meta.snr;
-            arg.downstream.size = len;
+            if(!meta.timeout){
+                
+                /* RX2 will not be needed */
+                LDL_MAC_timerClear(self, LDL_TIMER_WAITB);
             
-            self->handler(self->app, LDL_MAC_DOWNSTREAM, &arg);      
+#ifndef LDL_DISABLE_DOWNSTREAM_EVENT            
+                arg.downstream.rssi = meta.rssi;
+                arg.downstream.snr = meta.snr;
+                arg.downstream.freqError = meta.freqError;
+                arg.downstream.size = len;
+                
+                self->handler(self->app, LDL_MAC_DOWNSTREAM, &arg);      
 #endif  
-            self->margin = meta.snr - self->snr_min;
+                self->margin = meta.snr - self->snr_min;
+            }
             
-            if(LDL_OPS_receiveFrame(self, &frame, buffer, len)){
+            /* RX done and RX timeout share an interrupt on some radios */
+            if(meta.timeout){
+                
+                rxTimeoutHandler(self);
+            }
+            else if(LDL_OPS_receiveFrame(self, &frame, buffer, len)){
                 
                 self->last_valid_downlink = timeNow(self);
                 
@@ -743,7 +1027,7 @@ void LDL_MAC_process(struct ldl_mac *self)
                     fopts = frame.opts;
                     foptsLen = frame.optsLen;
                                         
-                    if((frame.data != NULL) && (frame.port == 0U)){
+                    if(frame.data != NULL){
                     
                         if(frame.port == 0U){
                     
@@ -766,6 +1050,9 @@ void LDL_MAC_process(struct ldl_mac *self)
                     processCommands(self, fopts, foptsLen);
                     
                     switch(self->op){
+                    case LDL_OP_NONE:
+                        /* class C downlink */
+                        break;
                     default:
                     case LDL_OP_DATA_UNCONFIRMED:
 #ifndef LDL_DISABLE_DATA_COMPLETE_EVENT
@@ -804,8 +1091,34 @@ void LDL_MAC_process(struct ldl_mac *self)
             }
             else{
                 
-                downlinkMissingHandler(self);
+                switch(self->state){
+#ifdef LDL_ENABLE_CLASS_C
+                case LDL_STATE_RXC:
+                    
+                    /* listen again */
+                    self->state = LDL_STATE_IDLE;
+                    break;
+#endif                    
+#ifdef LDL_ENABLE_CLASS_B
+                case LDL_STATE_PING:
+                    
+                    /* wait for the next slot */
+                    self->state = LDL_STATE_IDLE;
+                    break;
+#endif                    
+                default:
+                    
+                    downlinkMissingHandler(self);
+                    break;
+                }
+            }
+            
+#ifdef LDL_ENABLE_CLASS_C
+            if(resume){
+                
+                resumeWait(self);
             }
+#endif
         }
         else if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_TIMEOUT, &error)){
             
@@ -813,26 +1126,7 @@ void LDL_MAC_process(struct ldl_mac *self)
             
             LDL_Radio_clearInterrupt(self->radio);
             
-            if(self->state == LDL_STATE_RX2){
-            
-                LDL_MAC_timerClear(self, LDL_TIMER_WAITB);
-                
-                uint8_t mtu;
-                enum ldl_spreading_factor sf;
-                enum ldl_signal_bandwidth bw;
-                
-                LDL_Region_convertRate(self->region, self->tx.rate, &sf, &bw, &mtu);                        
-                
-                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, transmitTime(bw, sf, mtu, false));
-                
-                self->state = LDL_STATE_RX2_LOCKOUT;
-            }
-            else{
-                
-                LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
-                
-                self->state = LDL_STATE_WAIT_RX2;
-            }   
+            rxTimeoutHandler(self);
         }
         else{
             
@@ -857,39 +1151,170 @@ void LDL_MAC_process(struct ldl_mac *self)
         }
         break;
     
-    case LDL_STATE_RX2_LOCKOUT:
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_STATE_BEACON:
     
-        if(LDL_MAC_timerCheck(self, LDL_TIMER_WAITA, &error)){
+#ifdef LDL_ENABLE_CHIP_ASYNC
+        /* the beacon is collected over several calls before it is processed */
+        if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_READY, &error)){
+        
+            LDL_MAC_inputClear(self);
+            LDL_MAC_inputArm(self, LDL_INPUT_CHIP_COMPLETE);
             
-            downlinkMissingHandler(self);  
+            self->beacon_ready = getTicks(self) - error;
             
-#ifndef LDL_DISABLE_SESSION_UPDATE              
-            pushSessionUpdate(self);
-#endif            
+            /* chip error if the transfers take longer than 100ms */
+            LDL_MAC_timerSet(self, LDL_TIMER_WAITA, ((LDL_System_tps() + LDL_System_eps())/10UL) + 1UL);
+            
+            uint8_t max;
+            uint8_t *buffer = rxBuffer(self, &max);
+            
+            LDL_Radio_collectBegin(self->radio, buffer, BeaconSize);
         }
-        break;
-    
-    case LDL_STATE_WAIT_RETRY:
-        
-        if(self->band[LDL_BAND_RETRY] == 0U){
+        else if(LDL_MAC_inputCheck(self, LDL_INPUT_CHIP_COMPLETE, &error) && collectResume(self)){
+#else
+        if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_READY, &error)){
+#endif
+            
+            struct ldl_frame_beacon frame;
+            struct ldl_radio_packet_metadata meta;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+            uint8_t max;
+            uint8_t *buffer = rxBuffer(self, &max);
+            uint32_t ready = self->beacon_ready;
+#else
+            uint8_t buffer[BeaconSize];
+            uint32_t ready = getTicks(self) - error;
+#endif
+            uint32_t freq;
+            uint8_t rate;
+            uint8_t mtu;
+            enum ldl_spreading_factor sf;
+            enum ldl_signal_bandwidth bw;
+            uint8_t len;
+            
+            LDL_MAC_inputClear(self);
+            LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+            
+#ifdef LDL_ENABLE_CHIP_ASYNC
+            len = LDL_Radio_collectEnd(self->radio, &meta);
+#else
+            len = LDL_Radio_collect(self->radio, &meta, buffer, sizeof(buffer));
+#endif
+            
+#ifdef LDL_ENABLE_TRACE
+            {
+                uint8_t hdr[4U];
                 
-            if(self->band[LDL_BAND_GLOBAL] == 0UL){
+                hdr[0] = (uint8_t)meta.rssi;
+                hdr[1] = (uint8_t)((uint16_t)meta.rssi >> 8);
+                hdr[2] = (uint8_t)meta.snr;
+                hdr[3] = (uint8_t)((uint16_t)meta.snr >> 8);
                 
-                uint32_t delay = (self->state == LDL_STATE_WAIT_RETRY) ? (rand32(self->app) % (LDL_System_tps()*30UL)) : 0UL;
-                            
-                LDL_DEBUG(self->app, "dither retry by %"PRIu32" ticks", delay)
-                        
-                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, delay);
-                self->state = LDL_STATE_WAIT_TX;
-            }                            
-        }
-        break;    
-    }
-    
-    {
-        uint32_t next = nextBandEvent(self);     
+                trace(self, LDL_TRACE_RX, hdr, sizeof(hdr), buffer, len);
+            }
+#endif
             
-        if(next < ticksToMSCoarse(60UL*LDL_System_tps())){
+            LDL_Radio_clearInterrupt(self->radio);
+            
+            self->state = LDL_STATE_IDLE;
+            
+            if(LDL_Frame_decodeBeacon(&frame, buffer, len)){
+                
+                (void)LDL_Region_getBeaconChannel(self->region, &freq, &rate);
+                LDL_Region_convertRate(self->region, rate, &sf, &bw, &mtu);
+                
+                /* the beacon started one airtime before RX ready */
+                self->beacon_ticks = ready - beaconAirTime(bw, sf);
+                self->beacon_time = frame.time;
+                self->beacon_valid = true;
+                self->beacon_locked = true;
+                self->beacon_missed = 0U;
+                
+                self->ping_offset = LDL_OPS_pingOffset(self->beacon_time, self->ctx.devAddr, pingPeriod(self));
+                self->ping_slot = 0U;
+                
+                scheduleClassB(self);
+                
+                arg.beacon.time = frame.time;
+                arg.beacon.rssi = meta.rssi;
+                arg.beacon.snr = meta.snr;
+                
+                self->handler(self->app, LDL_MAC_BEACON, &arg);
+            }
+            else{
+                
+                beaconMissed(self);
+            }
+        }
+        else if(LDL_MAC_inputCheck(self, LDL_INPUT_RX_TIMEOUT, &error)){
+            
+            LDL_MAC_inputClear(self);
+            LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+            
+            LDL_Radio_clearInterrupt(self->radio);
+            
+            self->state = LDL_STATE_IDLE;
+            
+            beaconMissed(self);
+        }
+        else{
+            
+            /* this is a hardware failure condition */
+            if(LDL_MAC_timerCheck(self, LDL_TIMER_WAITA, &error)){
+                
+#ifndef LDL_DISABLE_CHIP_ERROR_EVENT                
+                self->handler(self->app, LDL_MAC_CHIP_ERROR, NULL); 
+#endif                
+                LDL_MAC_inputClear(self);
+                
+                beaconMissed(self);
+                
+                self->state = LDL_STATE_RECOVERY_RESET;
+                self->op = LDL_OP_RESET;
+                
+                LDL_Radio_reset(self->radio, true);
+                
+                /* hold reset for at least 100us */
+                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, ((LDL_System_tps() + LDL_System_eps())/10000UL) + 1U);                     
+            }
+        }
+        break;
+#endif
+    
+    case LDL_STATE_RX2_LOCKOUT:
+    
+        if(LDL_MAC_timerCheck(self, LDL_TIMER_WAITA, &error)){
+            
+            downlinkMissingHandler(self);  
+            
+#ifndef LDL_DISABLE_SESSION_UPDATE              
+            pushSessionUpdate(self);
+#endif            
+        }
+        break;
+    
+    case LDL_STATE_WAIT_RETRY:
+        
+        if(self->band[LDL_BAND_RETRY] == 0U){
+                
+            if(self->band[LDL_BAND_GLOBAL] == 0UL){
+                
+                uint32_t delay = (self->state == LDL_STATE_WAIT_RETRY) ? (rand32(self) % (LDL_System_tps()*30UL)) : 0UL;
+                            
+                LDL_DEBUG(self->app, "dither retry by %"PRIu32" ticks", delay)
+                        
+                LDL_MAC_timerSet(self, LDL_TIMER_WAITA, delay);
+                self->state = LDL_STATE_WAIT_TX;
+            }                            
+        }
+        break;    
+    }
+    
+    {
+        uint32_t next = nextBandEvent(self);     
+            
+        if(next < ticksToMSCoarse(60UL*LDL_System_tps())){
             
             LDL_MAC_timerSet(self, LDL_TIMER_BAND, LDL_System_tps() / 1000UL * (next+1U));                    
         }
@@ -906,10 +1331,31 @@ uint32_t LDL_MAC_ticksUntilNextEvent(const struct ldl_mac *self)
     
     uint32_t retval = 0UL;
     
-    if(!LDL_MAC_inputPending(self)){
-     
+    TRACE(self, LDL_TRACE_TICKS_UNTIL_NEXT_EVENT);
+    
+#ifdef LDL_ENABLE_CLASS_C
+    /* receiver must be (re)started */
+    bool pending = LDL_MAC_inputPending(self) || listenPending(self);
+#else
+    bool pending = LDL_MAC_inputPending(self);
+#endif     
+    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    if(LDL_Radio_busy(self->radio)){
+        
+        /* LDL_Radio_chipComplete() is the next event */
+        retval = UINT32_MAX;
+    }
+    else if(!pending && !LDL_Radio_pending(self->radio)){
+        
         retval = LDL_MAC_timerTicksUntilNext(self);    
     }
+#else
+    if(!pending){
+        
+        retval = LDL_MAC_timerTicksUntilNext(self);    
+    }
+#endif
     
     return retval;
 }
@@ -919,9 +1365,12 @@ bool LDL_MAC_setRate(struct ldl_mac *self, uint8_t rate)
     LDL_PEDANTIC(self != NULL)
     
     bool retval = false;    
+    
+    TRACE_U8(self, LDL_TRACE_SET_RATE, rate);
+    
     self->errno = LDL_ERRNO_NONE;
     
-    if(rateSettingIsValid(self->region, rate)){
+    if(rateSettingIsValid(self, rate)){
         
         self->ctx.rate = rate;
         
@@ -950,6 +1399,9 @@ bool LDL_MAC_setPower(struct ldl_mac *self, uint8_t power)
     LDL_PEDANTIC(self != NULL)
     
     bool retval = false;
+    
+    TRACE_U8(self, LDL_TRACE_SET_POWER, power);
+    
     self->errno = LDL_ERRNO_NONE;
         
     if(LDL_Region_validateTXPower(self->region, power)){
@@ -979,6 +1431,8 @@ void LDL_MAC_enableADR(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE(self, LDL_TRACE_ENABLE_ADR);
+    
     self->ctx.adr = true;
     
 #ifndef LDL_DISABLE_SESSION_UPDATE    
@@ -993,10 +1447,148 @@ bool LDL_MAC_adr(const struct ldl_mac *self)
     return self->ctx.adr;
 }
 
+#ifdef LDL_ENABLE_CLASS_C
+void LDL_MAC_enableClassC(struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    TRACE(self, LDL_TRACE_ENABLE_CLASS_C);
+    
+#ifdef LDL_ENABLE_CLASS_B
+    stopClassB(self);
+#endif    
+    
+    self->classC = true;
+}
+
+void LDL_MAC_disableClassC(struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    TRACE(self, LDL_TRACE_DISABLE_CLASS_C);
+    
+    self->classC = false;
+    
+    stopListening(self);
+}
+
+bool LDL_MAC_classC(const struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    return self->classC;
+}
+#endif
+
+#ifdef LDL_ENABLE_CLASS_B
+bool LDL_MAC_enableClassB(struct ldl_mac *self, uint8_t periodicity)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    bool retval = false;
+    uint32_t freq;
+    uint8_t rate;
+    
+    TRACE_U8(self, LDL_TRACE_ENABLE_CLASS_B, periodicity);
+    
+    if((periodicity <= 7U) && LDL_Region_getBeaconChannel(self->region, &freq, &rate)){
+        
+#ifdef LDL_ENABLE_CLASS_C
+        self->classC = false;
+        stopListening(self);
+#endif        
+        if(!self->classB || (self->ping_periodicity != periodicity)){
+            
+            self->ping_info_pending = true;
+        }
+        
+        self->classB = true;
+        self->ping_periodicity = periodicity;
+        
+        if(self->beacon_locked){
+            
+            /* slots at the new periodicity start from the next beacon */
+            self->ping_offset = LDL_OPS_pingOffset(self->beacon_time, self->ctx.devAddr, pingPeriod(self));
+            self->ping_slot = pingNb(self);
+            
+            scheduleClassB(self);
+        }
+        
+        retval = true;
+    }
+    
+    return retval;
+}
+
+void LDL_MAC_disableClassB(struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    TRACE(self, LDL_TRACE_DISABLE_CLASS_B);
+    
+    stopClassB(self);
+}
+
+bool LDL_MAC_classB(const struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    return self->classB;
+}
+
+bool LDL_MAC_beaconLocked(const struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    return self->beacon_locked;
+}
+#endif
+
+#ifdef LDL_ENABLE_CAD
+void LDL_MAC_enableCAD(struct ldl_mac *self, uint16_t backoff)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+#ifdef LDL_ENABLE_TRACE
+    traceU32(self, LDL_TRACE_ENABLE_CAD, backoff);
+#endif
+    
+    self->cad = true;
+    self->cad_backoff = backoff;
+}
+
+void LDL_MAC_disableCAD(struct ldl_mac *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    TRACE(self, LDL_TRACE_DISABLE_CAD);
+    
+    self->cad = false;
+}
+
+bool LDL_MAC_getChannelActivity(const struct ldl_mac *self, uint8_t chIndex, struct ldl_mac_channel_activity *activity)
+{
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC(activity != NULL)
+    
+    bool retval = false;
+    
+    if(chIndex < LDL_Region_numChannels(self->region)){
+        
+        *activity = self->activity[chIndex];
+        retval = true;
+    }
+    
+    return retval;
+}
+#endif
+
 void LDL_MAC_disableADR(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE(self, LDL_TRACE_DISABLE_ADR);
+    
     self->ctx.adr = false;
     
 #ifndef LDL_DISABLE_SESSION_UPDATE    
@@ -1010,7 +1602,7 @@ bool LDL_MAC_ready(const struct ldl_mac *self)
     
     bool retval = false;
     
-    if(self->state == LDL_STATE_IDLE){
+    if(isIdle(self)){
         
         retval = (msUntilNextChannel(self, self->ctx.rate) == 0UL);
     }
@@ -1042,6 +1634,8 @@ void LDL_MAC_radioEvent(struct ldl_mac *self, enum ldl_radio_event event)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE_U8(self, LDL_TRACE_RADIO_EVENT, (uint8_t)event);
+    
     switch(event){
     case LDL_RADIO_EVENT_TX_COMPLETE:
         LDL_MAC_inputSignal(self, LDL_INPUT_TX_COMPLETE);
@@ -1052,6 +1646,16 @@ void LDL_MAC_radioEvent(struct ldl_mac *self, enum ldl_radio_event event)
     case LDL_RADIO_EVENT_RX_TIMEOUT:
         LDL_MAC_inputSignal(self, LDL_INPUT_RX_TIMEOUT);        
         break;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    case LDL_RADIO_EVENT_CHIP_COMPLETE:
+        LDL_MAC_inputSignal(self, LDL_INPUT_CHIP_COMPLETE);
+        break;
+#endif        
+#ifdef LDL_ENABLE_CAD
+    case LDL_RADIO_EVENT_CAD_DONE:
+        LDL_MAC_inputSignal(self, LDL_INPUT_CAD_DONE);
+        break;
+#endif        
     case LDL_RADIO_EVENT_NONE:
     default:
         break;
@@ -1074,17 +1678,8 @@ uint8_t LDL_MAC_mtu(const struct ldl_mac *self)
     
     if(self->ctx.joined){
         
-        overhead += commandIsPending(self, LDL_CMD_LINK_ADR) ? LDL_MAC_sizeofCommandUp(LDL_CMD_LINK_ADR) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_DUTY_CYCLE) ? LDL_MAC_sizeofCommandUp(LDL_CMD_DUTY_CYCLE) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_RX_PARAM_SETUP) ? LDL_MAC_sizeofCommandUp(LDL_CMD_RX_PARAM_SETUP) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_DEV_STATUS) ? LDL_MAC_sizeofCommandUp(LDL_CMD_DEV_STATUS) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_NEW_CHANNEL) ? LDL_MAC_sizeofCommandUp(LDL_CMD_NEW_CHANNEL) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_RX_TIMING_SETUP) ? LDL_MAC_sizeofCommandUp(LDL_CMD_RX_TIMING_SETUP) : 0U;        
-        overhead += commandIsPending(self, LDL_CMD_DL_CHANNEL) ? LDL_MAC_sizeofCommandUp(LDL_CMD_DL_CHANNEL) : 0U;
-        
-        overhead += commandIsPending(self, LDL_CMD_REKEY) ? LDL_MAC_sizeofCommandUp(LDL_CMD_REKEY) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_ADR_PARAM_SETUP) ? LDL_MAC_sizeofCommandUp(LDL_CMD_ADR_PARAM_SETUP) : 0U;
-        overhead += commandIsPending(self, LDL_CMD_REJOIN_PARAM_SETUP) ? LDL_MAC_sizeofCommandUp(LDL_CMD_REJOIN_PARAM_SETUP) : 0U;
+        /* commands that can wait are deferred to make room */
+        overhead += urgentSize(self);
     }
     
     return (overhead > max) ? 0 : (max - overhead);    
@@ -1094,6 +1689,8 @@ uint32_t LDL_MAC_timeSinceValidDownlink(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE(self, LDL_TRACE_TIME_SINCE_VALID_DOWNLINK);
+    
     return (self->last_valid_downlink == 0) ? UINT32_MAX : (timeNow(self) - self->last_valid_downlink);
 }
 
@@ -1101,6 +1698,8 @@ void LDL_MAC_setMaxDCycle(struct ldl_mac *self, uint8_t maxDCycle)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE_U8(self, LDL_TRACE_SET_MAX_DCYCLE, maxDCycle);
+    
     self->ctx.maxDutyCycle = maxDCycle & 0xfU;
     
 #ifndef LDL_DISABLE_SESSION_UPDATE    
@@ -1121,6 +1720,22 @@ bool LDL_MAC_addChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, ui
     
     LDL_DEBUG(self->app, "adding chIndex=%u freq=%"PRIu32" minRate=%u maxRate=%u", chIndex, freq, minRate, maxRate)
     
+#ifdef LDL_ENABLE_TRACE
+    {
+        uint8_t hdr[7U];
+        
+        hdr[0] = chIndex;
+        hdr[1] = (uint8_t)freq;
+        hdr[2] = (uint8_t)(freq >> 8);
+        hdr[3] = (uint8_t)(freq >> 16);
+        hdr[4] = (uint8_t)(freq >> 24);
+        hdr[5] = minRate;
+        hdr[6] = maxRate;
+        
+        trace(self, LDL_TRACE_ADD_CHANNEL, hdr, sizeof(hdr), NULL, 0U);
+    }
+#endif
+    
     return setChannel(self, chIndex, freq, minRate, maxRate);
 }
 
@@ -1128,6 +1743,8 @@ bool LDL_MAC_maskChannel(struct ldl_mac *self, uint8_t chIndex)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE_U8(self, LDL_TRACE_MASK_CHANNEL, chIndex);
+    
     return maskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, chIndex);
 }
 
@@ -1135,6 +1752,24 @@ bool LDL_MAC_unmaskChannel(struct ldl_mac *self, uint8_t chIndex)
 {
     LDL_PEDANTIC(self != NULL)
     
+    TRACE_U8(self, LDL_TRACE_UNMASK_CHANNEL, chIndex);
+    
+    return unmaskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, chIndex);
+}
+
+bool LDL_MAC_setChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint8_t minRate, uint8_t maxRate)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    LDL_DEBUG(self->app, "adding chIndex=%u freq=%"PRIu32" minRate=%u maxRate=%u", chIndex, freq, minRate, maxRate)
+    
+    return setChannel(self, chIndex, freq, minRate, maxRate);
+}
+
+bool LDL_MAC_enableChannel(struct ldl_mac *self, uint8_t chIndex)
+{
+    LDL_PEDANTIC(self != NULL)
+    
     return unmaskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, chIndex);
 }
 
@@ -1142,7 +1777,7 @@ void LDL_MAC_timerSet(struct ldl_mac *self, enum ldl_timer_inst timer, uint32_t
 {
     LDL_SYSTEM_ENTER_CRITICAL(self->app)
    
-    self->timers[timer].time = LDL_System_ticks(self->app) + (timeout & INT32_MAX);
+    self->timers[timer].time = getTicks(self) + (timeout & INT32_MAX);
     self->timers[timer].armed = true;
     
     LDL_SYSTEM_LEAVE_CRITICAL(self->app)
@@ -1167,7 +1802,7 @@ bool LDL_MAC_timerCheck(struct ldl_mac *self, enum ldl_timer_inst timer, uint32_
         
     if(self->timers[timer].armed){
         
-        time = LDL_System_ticks(self->app);
+        time = getTicks(self);
         
         if(timerDelta(self->timers[timer].time, time) < INT32_MAX){
     
@@ -1193,7 +1828,7 @@ uint32_t LDL_MAC_timerTicksUntilNext(const struct ldl_mac *self)
     uint32_t retval = UINT32_MAX;
     uint32_t time;
     
-    time = LDL_System_ticks(self->app);
+    time = getTicks(self);
 
     for(i=0U; i < (sizeof(self->timers)/sizeof(*self->timers)); i++){
 
@@ -1234,7 +1869,7 @@ uint32_t LDL_MAC_timerTicksUntil(const struct ldl_mac *self, enum ldl_timer_inst
     
     if(self->timers[timer].armed){
         
-        time = LDL_System_ticks(self->app);
+        time = getTicks(self);
     
         *error = timerDelta(self->timers[timer].time, time);
         
@@ -1261,7 +1896,7 @@ void LDL_MAC_inputSignal(struct ldl_mac *self, enum ldl_input_type type)
     
         if((self->inputs.armed & (1U << type)) > 0U){
     
-            self->inputs.time = LDL_System_ticks(self->app);
+            self->inputs.time = getTicks(self);
             self->inputs.state = (1U << type);
         }
     }
@@ -1286,7 +1921,7 @@ bool LDL_MAC_inputCheck(const struct ldl_mac *self, enum ldl_input_type type, ui
     
     if((self->inputs.state & (1U << type)) > 0U){
         
-        *error = timerDelta(self->inputs.time, LDL_System_ticks(self->app));
+        *error = timerDelta(self->inputs.time, getTicks(self));
         retval = true;
     }
     
@@ -1317,6 +1952,8 @@ bool LDL_MAC_priority(const struct ldl_mac *self, uint8_t interval)
     bool retval;
     uint32_t error;
     
+    TRACE_U8(self, LDL_TRACE_PRIORITY, interval);
+    
     /* todo */
     (void)interval; 
     
@@ -1326,11 +1963,18 @@ bool LDL_MAC_priority(const struct ldl_mac *self, uint8_t interval)
     default:
         retval = false;
         break;
+#ifdef LDL_ENABLE_CAD
+    case LDL_STATE_CAD:
+#endif        
     case LDL_STATE_TX:    
     case LDL_STATE_WAIT_RX1:
     case LDL_STATE_RX1:
     case LDL_STATE_WAIT_RX2:
     case LDL_STATE_RX2:
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_STATE_BEACON:
+    case LDL_STATE_PING:
+#endif        
         retval = true;
         break;
     }
@@ -1349,10 +1993,39 @@ static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t po
     struct ldl_frame_data f;
     struct ldl_stream s;
     uint8_t macs[30U]; // large enough for all possible MAC commands
+    uint8_t avail;
+    uint8_t room;
+    
+#ifdef LDL_ENABLE_TRACE
+    {
+        uint8_t hdr[7U];
+        
+        (void)memset(hdr, 0, sizeof(hdr));
+        
+        hdr[0] = confirmed ? 1U : 0U;
+        hdr[1] = port;
+        
+        if(opts != NULL){
+            
+            hdr[2] = 1U;
+            hdr[3] = opts->nbTrans;
+            hdr[4] = opts->check ? 1U : 0U;
+            hdr[5] = opts->getTime ? 1U : 0U;
+            hdr[6] = opts->dither;
+        }
+        
+        trace(self, LDL_TRACE_DATA, hdr, sizeof(hdr), data, len);
+    }
+#endif
                         
     self->errno = LDL_ERRNO_NONE;
 
-    if(self->state == LDL_STATE_IDLE){
+    if(isIdle(self)){
+        
+        /* RXC stays open until it is time to transmit */
+#ifdef LDL_ENABLE_CLASS_B
+        stopSlot(self);
+#endif
         
         if(self->ctx.joined){
         
@@ -1391,6 +2064,9 @@ static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t po
                             f.adr = self->ctx.adr;
                             f.adrAckReq = self->adrAckReq;
                             f.port = port;
+#ifdef LDL_ENABLE_CLASS_B
+                            f.classB = self->beacon_locked;
+#endif
                             
                             /* 1.1 has to awkwardly re-calculate the MIC when a frame is retried on a 
                              * different channel and the counter is a parameter */
@@ -1399,140 +2075,34 @@ static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t po
                             self->ctx.up++;
 
                             /* serialise pending MAC commands */
-                            {
-                                LDL_Stream_init(&s, macs, sizeof(macs));
+                            LDL_Stream_init(&s, macs, sizeof(macs));
+                            
+                            LDL_DEBUG(self->app, "preparing data frame")
+                            
+                            avail = maxPayload - LDL_Frame_dataOverhead();
+                            room = (len <= avail) ? (uint8_t)(avail - len) : 0U;
+                            room = (room > 15U) ? 15U : room;
+                            
+                            /* mac commands fit into fopts; those that can wait are deferred if need be */
+                            if((len <= avail) && (urgentSize(self) <= room)){
                                 
-                                LDL_DEBUG(self->app, "preparing data frame")
+                                packUpCommands(self, &s, room);
                                 
-                                /* sticky commands */
+                                LDL_DEBUG(self->app, "%uB data %uB mac", len, LDL_Stream_tell(&s))
                                 
-                                if(commandIsPending(self, LDL_CMD_REKEY)){
-                                    
-                                    struct ldl_rekey_ind ind = {
-                                        .version = self->ctx.version
-                                    };
-                                    
-                                    LDL_MAC_putRekeyInd(&s, &ind);
-                                    
-                                    LDL_DEBUG(self->app, "adding rekey_ind: version=%u", self->ctx.version)
-                                }                            
+                                f.opts = macs;
+                                f.optsLen = LDL_Stream_tell(&s);
                                 
-                                if(commandIsPending(self, LDL_CMD_RX_PARAM_SETUP)){
-                                    
-                                    LDL_MAC_putRXParamSetupAns(&s, &self->ctx.rx_param_setup_ans);
-                                    
-                                    LDL_DEBUG(self->app, "adding rx_param_setup_ans: rx1DROffsetOK=%s rx2DataRate=%s rx2Freq=%s",                
-                                        self->ctx.rx_param_setup_ans.rx1DROffsetOK ? "true" : "false",
-                                        self->ctx.rx_param_setup_ans.rx2DataRateOK ? "true" : "false",
-                                        self->ctx.rx_param_setup_ans.channelOK ? "true" : "false"       
-                                    )                                    
-                                }
+                                f.data = data;
+                                f.dataLen = len;
                                 
-                                if(commandIsPending(self, LDL_CMD_DL_CHANNEL)){
-                                    
-                                    LDL_MAC_putDLChannelAns(&s, &self->ctx.dl_channel_ans);
-                                    
-                                    LDL_DEBUG(self->app, "adding dl_channel_ans: uplinkFreqOK=%s channelFreqOK=%s",
-                                        self->ctx.dl_channel_ans.uplinkFreqOK ? "true" : "false",
-                                        self->ctx.dl_channel_ans.channelFreqOK ? "true" : "false"
-                                    )                                    
-                                }
+                                /* indicate success to application */
+                                retval = true;
+                            }
+                            /* MAC commands won't fit into Fopts; frame becomes a port 0 data frame (and application loses) */
+                            else{
                                 
-                                if(commandIsPending(self, LDL_CMD_RX_TIMING_SETUP)){
-                                    
-                                    LDL_MAC_putRXTimingSetupAns(&s);
-                                    LDL_DEBUG(self->app, "adding rx_timing_setup_ans")
-                                }
-                            
-                                /* single shot commands */                                
-                                
-                                if(commandIsPending(self, LDL_CMD_LINK_ADR)){
-                                    
-                                    LDL_MAC_putLinkADRAns(&s, &self->ctx.link_adr_ans);                                
-                                    clearPendingCommand(self, LDL_CMD_LINK_ADR);
-                                    
-                                    LDL_DEBUG(self->app, "adding link_adr_ans: powerOK=%s dataRateOK=%s channelMaskOK=%s",
-                                        self->ctx.link_adr_ans.dataRateOK ? "true" : "false", 
-                                        self->ctx.link_adr_ans.powerOK ? "true" : "false", 
-                                        self->ctx.link_adr_ans.channelMaskOK ? "true" : "false"
-                                    )                                    
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_DEV_STATUS)){
-                                    
-                                    LDL_MAC_putDevStatusAns(&s, &self->ctx.dev_status_ans);                                
-                                    clearPendingCommand(self, LDL_CMD_DEV_STATUS);
-                                    
-                                    LDL_DEBUG(self->app, "adding dev_status_ans: battery=%u margin=%i",
-                                        self->ctx.dev_status_ans.battery,
-                                        self->ctx.dev_status_ans.margin
-                                    )                                                                        
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_NEW_CHANNEL)){
-                                    
-                                    LDL_MAC_putNewChannelAns(&s, &self->ctx.new_channel_ans);                                
-                                    clearPendingCommand(self, LDL_CMD_NEW_CHANNEL);
-                                    
-                                    LDL_DEBUG(self->app, "adding new_channel_ans: dataRateRangeOK=%s channelFreqOK=%s", 
-                                        self->ctx.new_channel_ans.dataRateRangeOK ? "true" : "false",
-                                        self->ctx.new_channel_ans.channelFreqOK ? "true" : "false"
-                                    )                                    
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_REJOIN_PARAM_SETUP)){
-                                    
-                                    LDL_MAC_putRejoinParamSetupAns(&s, &self->ctx.rejoin_param_setup_ans);                                
-                                    clearPendingCommand(self, LDL_CMD_REJOIN_PARAM_SETUP);
-                                    
-                                    LDL_DEBUG(self->app, "adding rejoin_param_setup_ans: timeOK=%s", 
-                                        self->ctx.rejoin_param_setup_ans.timeOK ? "true" : "false"
-                                    )
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_ADR_PARAM_SETUP)){
-                                    
-                                    LDL_MAC_putADRParamSetupAns(&s);                                
-                                    clearPendingCommand(self, LDL_CMD_ADR_PARAM_SETUP);
-                                    
-                                    LDL_DEBUG(self->app, "adding adr_param_setup_ans")
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_TX_PARAM_SETUP)){
-                                    
-                                    LDL_MAC_putTXParamSetupAns(&s);                                
-                                    clearPendingCommand(self, LDL_CMD_TX_PARAM_SETUP);
-                                    
-                                    LDL_DEBUG(self->app, "adding tx_param_setup_ans")
-                                }
-                                
-                                if(commandIsPending(self, LDL_CMD_DUTY_CYCLE)){
-                                    
-                                    LDL_MAC_putDutyCycleAns(&s);                                
-                                    clearPendingCommand(self, LDL_CMD_DUTY_CYCLE);
-                                    
-                                    LDL_DEBUG(self->app, "adding duty_cycle_ans")
-                                }                                
-#ifndef LDL_DISABLE_CHECK    
-                                if(self->opts.check){
-
-                                    LDL_MAC_putLinkCheckReq(&s);
-                                    LDL_DEBUG(self->app, "adding link_check_req")
-                                }                   
-#endif        
-#ifndef LDL_DISABLE_DEVICE_TIME    
-                                if(self->opts.getTime){
-                                
-                                    LDL_MAC_putDeviceTimeReq(&s);
-                                    LDL_DEBUG(self->app, "adding device_time_req")
-                                }             
-#endif                              
-                            }
-
-                            LDL_DEBUG(self->app, "%uB data %uB mac", len, LDL_Stream_tell(&s))
-
-                            /* MAC commands won't fit into Fopts; frame becomes a port 0 data frame (and application loses) */
-                            if((LDL_Stream_tell(&s) > 15U) || (LDL_Frame_dataOverhead() + len + LDL_Stream_tell(&s)) > maxPayload){
+                                packUpCommands(self, &s, sizeof(macs));
                                 
                                 LDL_DEBUG(self->app, "MAC commands and data too large for frame; MAC commands prioritised")
                                 
@@ -1554,19 +2124,14 @@ static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t po
                                 /* provide reason for failure to application */
                                 self->errno = LDL_ERRNO_MACPRIORITY;
                             }
-                            /* mac commands fit into fopts */
-                            else{
-                                
-                                f.opts = macs;
-                                f.optsLen = LDL_Stream_tell(&s);
-                                
-                                f.data = data;
-                                f.dataLen = len;
-                                
-                                /* indicate success to application */
-                                retval = true;
-                            }
                             
+                            /* piggy-backed requests only apply to this frame */
+                            self->opts.check = false;
+                            self->opts.getTime = false;
+                            
+#ifdef LDL_ENABLE_SHARED_BUFFER
+                            saveData(self, &f);
+#endif
                             self->bufferLen = LDL_OPS_prepareData(self, &f, self->buffer, sizeof(self->buffer));                            
                             
                             LDL_OPS_micDataFrame(self, self->buffer, self->bufferLen);                                    
@@ -1578,7 +2143,7 @@ static bool externalDataCommand(struct ldl_mac *self, bool confirmed, uint8_t po
                         
                         if(self->opts.dither > 0U){
                             
-                            send_delay = (rand32(self->app) % ((uint32_t)self->opts.dither * LDL_System_tps()));
+                            send_delay = (rand32(self) % ((uint32_t)self->opts.dither * LDL_System_tps()));
                         }
                         
                         self->service_start_time = timeNow(self) + (send_delay / LDL_System_tps());            
@@ -1714,12 +2279,42 @@ static uint32_t transmitTime(enum ldl_signal_bandwidth bw, enum ldl_spreading_fa
 
     Tpacket = Tpreamble + Tpayload;
 
+#ifdef LDL_ENABLE_FSK
+    /* FSK frames are sent at 50kbps as:
+     * 
+     * preamble (5) + sync word (3) + length (1) + PL + CRC (2)
+     * 
+     * The CRC is present in both directions.
+     * 
+     * */
+    if(sf == LDL_SF_FSK){
+        
+        Tpacket = ((5UL + 3UL + 1UL + (uint32_t)size + 2UL) * 8UL * LDL_System_tps()) / 50000UL;
+    }
+#endif
+
     return Tpacket;
 }
 
 static uint32_t symbolPeriod(enum ldl_spreading_factor sf, enum ldl_signal_bandwidth bw)
 {
-    return ((((uint32_t)1U) << sf) * LDL_System_tps()) / LDL_MAC_bwToNumber(bw);
+    uint32_t retval;
+    
+#ifdef LDL_ENABLE_FSK
+    /* one byte at 50kbps */
+    if(sf == LDL_SF_FSK){
+        
+        retval = (8UL * LDL_System_tps()) / 50000UL;
+    }
+    else{
+        
+        retval = ((((uint32_t)1U) << sf) * LDL_System_tps()) / LDL_MAC_bwToNumber(bw);
+    }
+#else
+    retval = ((((uint32_t)1U) << sf) * LDL_System_tps()) / LDL_MAC_bwToNumber(bw);
+#endif
+    
+    return retval;
 }
 
 static uint8_t extraSymbols(uint32_t xtal_error, uint32_t symbol_period)
@@ -1729,46 +2324,40 @@ static uint8_t extraSymbols(uint32_t xtal_error, uint32_t symbol_period)
 
 static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len)
 {
-    struct ldl_stream s_in;
-    
-    /* rollback cache */
-    uint8_t chMask[sizeof(self->ctx.chMask)];
-    uint8_t nbTrans;
-    uint8_t power;
-    uint8_t rate;
-    
-    struct ldl_downstream_cmd cmd;                                                
-    enum ldl_mac_cmd_type next_cmd;
+    struct cmd_delta delta;
+    struct ldl_downstream_cmd cmds[15U];
+    const struct ldl_downstream_cmd *cmd;
+    uint8_t n;
+    uint8_t c;
     
     enum {
         
         _NO_ADR,
-        _ADR_OK,
-        _ADR_BAD
+        _ADR_BLOCK,
+        _ADR_DONE
         
     } adr_state = _NO_ADR;
     
-    /* these things can be rolled back */
-    nbTrans = self->ctx.nbTrans;
-    power = self->ctx.power;
-    rate = self->ctx.rate;
-    (void)memcpy(&chMask, self->ctx.chMask, sizeof(chMask));
+    /* nothing touches the session until every command has been seen */
+    delta.staged = 0U;
     
-    LDL_Stream_initReadOnly(&s_in, in, len);
+    /* as many as fit in FOpts, anything after that is ignored in the 
+     * same way as anything after an unknown CID */
+    n = LDL_MAC_getDownCommands(in, len, cmds, (uint8_t)(sizeof(cmds)/sizeof(*cmds)));
     
-    self->ctx.link_adr_ans.channelMaskOK = true;
-    
-    while(LDL_MAC_getDownCommand(&s_in, &cmd)){
+    for(c=0U; c < n; c++){
+        
+        cmd = &cmds[c];
         
-        switch(cmd.type){
+        switch(cmd->type){
         default:
-            LDL_DEBUG(self->app, "not handling type %u", cmd.type)
+            LDL_DEBUG(self->app, "not handling type %u", cmd->type)
             break;     
 #ifndef LDL_DISABLE_CHECK                                   
         case LDL_CMD_LINK_CHECK:                
         {                
             union ldl_mac_response_arg arg;
-            const struct ldl_link_check_ans *ans = &cmd.fields.linkCheck;
+            const struct ldl_link_check_ans *ans = &cmd->fields.linkCheck;
             
             arg.link_status.margin = ans->margin;
             arg.link_status.gwCount = ans->gwCount;            
@@ -1784,7 +2373,7 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
 #endif                            
         case LDL_CMD_LINK_ADR:              
         {
-            const struct ldl_link_adr_req *req = &cmd.fields.linkADR;
+            const struct ldl_link_adr_req *req = &cmd->fields.linkADR;
             
             LDL_DEBUG(self->app, "link_adr_req: dataRate=%u txPower=%u chMask=%04x chMaskCntl=%u nbTrans=%u",
                 req->dataRate, req->txPower, req->channelMask, req->channelMaskControl, req->nbTrans)
@@ -1793,7 +2382,20 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
             
             /* this is against the standard but we simply ignore any additional 
              * blocks after the first one */
-            if(!commandIsPending(self, LDL_CMD_LINK_ADR)){
+            if(adr_state != _ADR_DONE){
+            
+                if(adr_state == _NO_ADR){
+                    
+                    (void)memcpy(delta.chMask, self->ctx.chMask, sizeof(delta.chMask));
+                    
+                    delta.rate = self->ctx.rate;
+                    delta.power = self->ctx.power;
+                    delta.nbTrans = self->ctx.nbTrans;
+                    
+                    self->ctx.link_adr_ans.channelMaskOK = true;
+                    
+                    adr_state = _ADR_BLOCK;
+                }
             
                 if(LDL_Region_isDynamic(self->region)){
                     
@@ -1805,18 +2407,18 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                             
                             if((req->channelMask & (1U << i)) > 0U){
                                 
-                                (void)unmaskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, i);
+                                (void)unmaskChannel(delta.chMask, sizeof(delta.chMask), self->region, i);
                             }
                             else{
                                 
-                                (void)maskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, i);
+                                (void)maskChannel(delta.chMask, sizeof(delta.chMask), self->region, i);
                             }
                         }
                         break;            
                         
                     case 6U:
                     
-                        unmaskAllChannels(self->ctx.chMask, sizeof(self->ctx.chMask));
+                        unmaskAllChannels(delta.chMask, sizeof(delta.chMask));
                         break;           
                          
                     default:
@@ -1837,11 +2439,11 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                             
                             if(req->channelMaskControl == 6U){
                                 
-                                (void)unmaskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, i);
+                                (void)unmaskChannel(delta.chMask, sizeof(delta.chMask), self->region, i);
                             }
                             else{
                                 
-                                (void)maskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, i);
+                                (void)maskChannel(delta.chMask, sizeof(delta.chMask), self->region, i);
                             }            
                         }                                  
                         break;
@@ -1852,18 +2454,18 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                             
                             if((req->channelMask & (1U << i)) > 0U){
                                 
-                                (void)unmaskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, (req->channelMaskControl * 16U) + i);
+                                (void)unmaskChannel(delta.chMask, sizeof(delta.chMask), self->region, (req->channelMaskControl * 16U) + i);
                             }
                             else{
                                 
-                                (void)maskChannel(self->ctx.chMask, sizeof(self->ctx.chMask), self->region, (req->channelMaskControl * 16U) + i);
+                                (void)maskChannel(delta.chMask, sizeof(delta.chMask), self->region, (req->channelMaskControl * 16U) + i);
                             }
                         }
                         break;
                     }            
                 }
                 
-                if(!LDL_MAC_peekNextCommand(&s_in, &next_cmd) || (next_cmd != LDL_CMD_LINK_ADR)){
+                if(((c + 1U) == n) || (cmds[c + 1U].type != LDL_CMD_LINK_ADR)){
                  
                     self->ctx.link_adr_ans.dataRateOK = true;
                     self->ctx.link_adr_ans.powerOK = true;
@@ -1871,11 +2473,11 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                     /* nbTrans setting 0 means keep existing */
                     if(req->nbTrans > 0U){
                     
-                        self->ctx.nbTrans = req->nbTrans & 0xfU;
+                        delta.nbTrans = req->nbTrans & 0xfU;
                         
-                        if(self->ctx.nbTrans > LDL_REDUNDANCY_MAX){
+                        if(delta.nbTrans > LDL_REDUNDANCY_MAX){
                             
-                            self->ctx.nbTrans = LDL_REDUNDANCY_MAX;
+                            delta.nbTrans = LDL_REDUNDANCY_MAX;
                         }
                     }
                     
@@ -1883,9 +2485,9 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                     if(req->dataRate < 0xfU){            
                         
                         // todo: need to pin out of range to maximum
-                        if(rateSettingIsValid(self->region, req->dataRate)){
+                        if(rateSettingIsValid(self, req->dataRate)){
                         
-                            self->ctx.rate = req->dataRate;            
+                            delta.rate = req->dataRate;            
                         }
                         else{
                                             
@@ -1898,7 +2500,7 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                         
                         if(LDL_Region_validateTXPower(self->region, req->txPower)){
                         
-                            self->ctx.power = req->txPower;        
+                            delta.power = req->txPower;        
                         }
                         else{
                          
@@ -1907,23 +2509,23 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                     }   
                  
                     /* do not allow server to mask all channels */
-                    if(allChannelsAreMasked(self->ctx.chMask, sizeof(self->ctx.chMask))){ 
+                    if(allChannelsAreMasked(delta.chMask, sizeof(delta.chMask))){ 
                         
                         LDL_INFO(self->app, "server attempted to mask all channels")
                         self->ctx.link_adr_ans.channelMaskOK = false;
                     }
                  
+                    /* the block is applied in full or not at all */
                     if(self->ctx.link_adr_ans.dataRateOK && self->ctx.link_adr_ans.powerOK && self->ctx.link_adr_ans.channelMaskOK){
                         
-                        adr_state = _ADR_OK;
+                        delta.staged |= (1U << LDL_CMD_LINK_ADR);
                     }
                     else{
                         
-                        adr_state = _ADR_BAD;
+                        LDL_DEBUG(self->app, "bad ADR setting; discarded")
                     }
-                   
-                 
                     
+                    adr_state = _ADR_DONE;
                  
                     setPendingCommand(self, LDL_CMD_LINK_ADR);
                 }                
@@ -1937,16 +2539,17 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         
         case LDL_CMD_DUTY_CYCLE:
          
-            LDL_DEBUG(self->app, "duty_cycle_req: %u", cmd.fields.dutyCycle.maxDutyCycle)
+            LDL_DEBUG(self->app, "duty_cycle_req: %u", cmd->fields.dutyCycle.maxDutyCycle)
         
-            self->ctx.maxDutyCycle = cmd.fields.dutyCycle.maxDutyCycle;                        
+            delta.maxDutyCycle = cmd->fields.dutyCycle.maxDutyCycle;
+            delta.staged |= (1U << LDL_CMD_DUTY_CYCLE);
             
             setPendingCommand(self, LDL_CMD_DUTY_CYCLE);
             break;
         
         case LDL_CMD_RX_PARAM_SETUP:     
         {
-            const struct ldl_rx_param_setup_req *req = &cmd.fields.rxParamSetup;
+            const struct ldl_rx_param_setup_req *req = &cmd->fields.rxParamSetup;
             
             LDL_DEBUG(self->app, "rx_param_setup_req: rx1DROffset=%u rx2DataRate=%u freq=%"PRIu32,
                 req->rx1DROffset,
@@ -1956,14 +2559,18 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
             
             // todo: validation
             
-            self->ctx.rx1DROffset = req->rx1DROffset;
-            self->ctx.rx2DataRate = req->rx2DataRate;
-            self->ctx.rx2Freq = req->freq;
-            
             self->ctx.rx_param_setup_ans.rx1DROffsetOK = true;
-            self->ctx.rx_param_setup_ans.rx2DataRateOK = true;
+            self->ctx.rx_param_setup_ans.rx2DataRateOK = rateIsSupported(self, req->rx2DataRate);
             self->ctx.rx_param_setup_ans.channelOK = true;       
             
+            if(self->ctx.rx_param_setup_ans.rx2DataRateOK){
+            
+                delta.rx1DROffset = req->rx1DROffset;
+                delta.rx2DataRate = req->rx2DataRate;
+                delta.rx2Freq = req->freq;
+                delta.staged |= (1U << LDL_CMD_RX_PARAM_SETUP);
+            }
+            
             setPendingCommand(self, LDL_CMD_RX_PARAM_SETUP);
         }
             break;
@@ -1974,6 +2581,8 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
             
             self->ctx.dev_status_ans.battery = LDL_System_getBatteryLevel(self->app);
             
+            TRACE_U8(self, LDL_TRACE_BATTERY, self->ctx.dev_status_ans.battery);
+            
             self->ctx.dev_status_ans.margin = (int8_t)(self->margin / 100);
             
             if(self->ctx.dev_status_ans.margin > 31){
@@ -1992,20 +2601,20 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_NEW_CHANNEL:    
                     
             LDL_DEBUG(self->app, "new_channel_req: chIndex=%u freq=%"PRIu32" maxDR=%u minDR=%u",
-                cmd.fields.newChannel.chIndex,
-                cmd.fields.newChannel.freq,
-                cmd.fields.newChannel.maxDR,
-                cmd.fields.newChannel.minDR
+                cmd->fields.newChannel.chIndex,
+                cmd->fields.newChannel.freq,
+                cmd->fields.newChannel.maxDR,
+                cmd->fields.newChannel.minDR
             )
         
             if(LDL_Region_isDynamic(self->region)){
             
-                self->ctx.new_channel_ans.dataRateRangeOK = LDL_Region_validateRate(self->region, cmd.fields.newChannel.chIndex, cmd.fields.newChannel.minDR, cmd.fields.newChannel.maxDR);        
-                self->ctx.new_channel_ans.channelFreqOK = LDL_Region_validateFreq(self->region, cmd.fields.newChannel.chIndex, cmd.fields.newChannel.freq);
+                self->ctx.new_channel_ans.dataRateRangeOK = LDL_Region_validateRate(self->region, cmd->fields.newChannel.chIndex, cmd->fields.newChannel.minDR, cmd->fields.newChannel.maxDR);        
+                self->ctx.new_channel_ans.channelFreqOK = LDL_Region_validateFreq(self->region, cmd->fields.newChannel.chIndex, cmd->fields.newChannel.freq);
                 
                 if(self->ctx.new_channel_ans.dataRateRangeOK && self->ctx.new_channel_ans.channelFreqOK){
                     
-                    (void)setChannel(self, cmd.fields.newChannel.chIndex, cmd.fields.newChannel.freq, cmd.fields.newChannel.minDR, cmd.fields.newChannel.maxDR);                        
+                    (void)setChannel(self, cmd->fields.newChannel.chIndex, cmd->fields.newChannel.freq * 100UL, cmd->fields.newChannel.minDR, cmd->fields.newChannel.maxDR);                        
                 }            
 
                 setPendingCommand(self, LDL_CMD_NEW_CHANNEL);
@@ -2019,8 +2628,8 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_DL_CHANNEL:            
             
             LDL_DEBUG(self->app, "dl_channel_req: chIndex=%u freq=%"PRIu32,
-                cmd.fields.dlChannel.chIndex,
-                cmd.fields.dlChannel.freq
+                cmd->fields.dlChannel.chIndex,
+                cmd->fields.dlChannel.freq
             )
 
             if(LDL_Region_isDynamic(self->region)){
@@ -2030,7 +2639,7 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
                 self->ctx.dl_channel_ans.channelFreqOK = false;
 #else
                 self->ctx.dl_channel_ans.uplinkFreqOK = true;
-                self->ctx.dl_channel_ans.channelFreqOK = LDL_Region_validateFreq(self->region, cmd.fields.dlChannel.chIndex, cmd.fields.dlChannel.freq);
+                self->ctx.dl_channel_ans.channelFreqOK = LDL_Region_validateFreq(self->region, cmd->fields.dlChannel.chIndex, cmd->fields.dlChannel.freq);
 #endif                
                 setPendingCommand(self, LDL_CMD_DL_CHANNEL);
             }
@@ -2043,10 +2652,11 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_RX_TIMING_SETUP:
 
             LDL_DEBUG(self->app, "rx_timing_setup_req: delay=%u",
-                cmd.fields.rxTimingSetup.delay
+                cmd->fields.rxTimingSetup.delay
             )
             
-            self->ctx.rx1Delay = cmd.fields.rxTimingSetup.delay;
+            delta.rx1Delay = cmd->fields.rxTimingSetup.delay;
+            delta.staged |= (1U << LDL_CMD_RX_TIMING_SETUP);
             
             setPendingCommand(self, LDL_CMD_RX_TIMING_SETUP);
             break;
@@ -2054,9 +2664,9 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_TX_PARAM_SETUP:        
                          
             LDL_DEBUG(self->app, "tx_param_setup_req: downlinkDwellTime=%s uplinkDwellTime=%s maxEIRP=%u",
-                cmd.fields.txParamSetup.downlinkDwell ? "true" : "false",
-                cmd.fields.txParamSetup.uplinkDwell ? "true" : "false",
-                cmd.fields.txParamSetup.maxEIRP
+                cmd->fields.txParamSetup.downlinkDwell ? "true" : "false",
+                cmd->fields.txParamSetup.uplinkDwell ? "true" : "false",
+                cmd->fields.txParamSetup.maxEIRP
             )    
         
             if(LDL_Region_isDynamic(self->region)){
@@ -2074,8 +2684,8 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         {
             union ldl_mac_response_arg arg;
             
-            arg.device_time.seconds = cmd.fields.deviceTime.seconds;
-            arg.device_time.fractions = cmd.fields.deviceTime.fractions;
+            arg.device_time.seconds = cmd->fields.deviceTime.seconds;
+            arg.device_time.fractions = cmd->fields.deviceTime.fractions;
             
             LDL_DEBUG(self->app, "device_time_ans: seconds=%"PRIu32" fractions=%u", 
                 arg.device_time.seconds,
@@ -2083,31 +2693,47 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
             )
             
             self->handler(self->app, LDL_MAC_DEVICE_TIME, &arg);                                                                                     
+            
+#ifdef LDL_ENABLE_CLASS_B
+            if(self->classB && !self->beacon_locked){
+                
+                syncBeacon(self, arg.device_time.seconds, arg.device_time.fractions);
+            }
+#endif            
         }
             break;
 #endif            
+#ifdef LDL_ENABLE_CLASS_B
+        case LDL_CMD_PING_SLOT_INFO:
+        
+            LDL_DEBUG(self->app, "ping_slot_info_ans")
+            
+            self->ping_info_pending = false;
+            break;
+#endif
         case LDL_CMD_ADR_PARAM_SETUP:
         
             LDL_DEBUG(self->app, "adr_param_setup: limit_exp=%u delay_exp=%u", 
-                cmd.fields.adrParamSetup.limit_exp,
-                cmd.fields.adrParamSetup.delay_exp        
+                cmd->fields.adrParamSetup.limit_exp,
+                cmd->fields.adrParamSetup.delay_exp        
             )
             
-            self->ctx.adr_ack_limit = (1U << cmd.fields.adrParamSetup.limit_exp);
-            self->ctx.adr_ack_delay = (1U << cmd.fields.adrParamSetup.delay_exp);
+            delta.adr_ack_limit = (1U << cmd->fields.adrParamSetup.limit_exp);
+            delta.adr_ack_delay = (1U << cmd->fields.adrParamSetup.delay_exp);
+            delta.staged |= (1U << LDL_CMD_ADR_PARAM_SETUP);
             
             setPendingCommand(self, LDL_CMD_ADR_PARAM_SETUP);            
             break;
             
         case LDL_CMD_REKEY:
         
-            LDL_DEBUG(self->app, "rekey_conf: version=%u", cmd.fields.rekey.version)
+            LDL_DEBUG(self->app, "rekey_conf: version=%u", cmd->fields.rekey.version)
         
             /* The server version must be greater than 0 (0 is not allowed), and smaller or equal (<=) to the
              * device’s LoRaWAN version. Therefore for a LoRaWAN1.1 device the only valid value is 1. If
              * the server’s version is invalid the device SHALL discard the RekeyConf command and
              * retransmit the RekeyInd in the next uplink frame */
-            if(cmd.fields.rekey.version == self->ctx.version){
+            if(cmd->fields.rekey.version == self->ctx.version){
                 
                 clearPendingCommand(self, LDL_CMD_REKEY);
             }
@@ -2116,10 +2742,10 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_FORCE_REJOIN:
                 
             LDL_DEBUG(self->app, "force_rejoin_req: max_retries=%u rejoin_type=%u period=% dr=%u",
-                cmd.fields.forceRejoin.max_retries,
-                cmd.fields.forceRejoin.rejoin_type,
-                cmd.fields.forceRejoin.period,
-                cmd.fields.forceRejoin.dr
+                cmd->fields.forceRejoin.max_retries,
+                cmd->fields.forceRejoin.rejoin_type,
+                cmd->fields.forceRejoin.period,
+                cmd->fields.forceRejoin.dr
             )
         
             LDL_DEBUG(self->app, "force rejoin not implemented")
@@ -2131,8 +2757,8 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         case LDL_CMD_REJOIN_PARAM_SETUP:
         
             LDL_DEBUG(self->app, "rejoin_param_setup_req: maxTimeN=%u maxCountN=%u",
-                cmd.fields.rejoinParamSetup.maxTimeN,
-                cmd.fields.rejoinParamSetup.maxCountN
+                cmd->fields.rejoinParamSetup.maxTimeN,
+                cmd->fields.rejoinParamSetup.maxCountN
             )
             
             self->ctx.rejoin_param_setup_ans.timeOK = false;
@@ -2141,25 +2767,312 @@ static void processCommands(struct ldl_mac *self, const uint8_t *in, uint8_t len
         }
     }
     
-    /* roll back ADR request if not successful */
-    if(adr_state == _ADR_BAD){
+    applyDelta(self, &delta);
+}
+
+static void putUpCommand(struct ldl_mac *self, struct ldl_stream *s, enum ldl_mac_cmd_type type)
+{
+    switch(type){
+    default:
+        /* not sent up */
+        break;
+        
+    case LDL_CMD_REKEY:
+    {
+        struct ldl_rekey_ind ind = {
+            .version = self->ctx.version
+        };
+        
+        LDL_MAC_putRekeyInd(s, &ind);
+        
+        LDL_DEBUG(self->app, "adding rekey_ind: version=%u", self->ctx.version)
+    }
+        break;
+        
+    case LDL_CMD_RX_PARAM_SETUP:
+        
+        LDL_MAC_putRXParamSetupAns(s, &self->ctx.rx_param_setup_ans);
+        
+        LDL_DEBUG(self->app, "adding rx_param_setup_ans: rx1DROffsetOK=%s rx2DataRate=%s rx2Freq=%s",                
+            self->ctx.rx_param_setup_ans.rx1DROffsetOK ? "true" : "false",
+            self->ctx.rx_param_setup_ans.rx2DataRateOK ? "true" : "false",
+            self->ctx.rx_param_setup_ans.channelOK ? "true" : "false"       
+        )
+        break;
+        
+    case LDL_CMD_DL_CHANNEL:
+        
+        LDL_MAC_putDLChannelAns(s, &self->ctx.dl_channel_ans);
+        
+        LDL_DEBUG(self->app, "adding dl_channel_ans: uplinkFreqOK=%s channelFreqOK=%s",
+            self->ctx.dl_channel_ans.uplinkFreqOK ? "true" : "false",
+            self->ctx.dl_channel_ans.channelFreqOK ? "true" : "false"
+        )
+        break;
+        
+    case LDL_CMD_RX_TIMING_SETUP:
+        
+        LDL_MAC_putRXTimingSetupAns(s);
+        LDL_DEBUG(self->app, "adding rx_timing_setup_ans")
+        break;
+        
+    /* single shot commands */
+    
+    case LDL_CMD_LINK_ADR:
+        
+        LDL_MAC_putLinkADRAns(s, &self->ctx.link_adr_ans);                                
+        clearPendingCommand(self, LDL_CMD_LINK_ADR);
         
-        LDL_DEBUG(self->app, "bad ADR setting; rollback")
+        LDL_DEBUG(self->app, "adding link_adr_ans: powerOK=%s dataRateOK=%s channelMaskOK=%s",
+            self->ctx.link_adr_ans.dataRateOK ? "true" : "false", 
+            self->ctx.link_adr_ans.powerOK ? "true" : "false", 
+            self->ctx.link_adr_ans.channelMaskOK ? "true" : "false"
+        )
+        break;
         
-        (void)memcpy(self->ctx.chMask, chMask, sizeof(self->ctx.chMask));
+    case LDL_CMD_DEV_STATUS:
         
-        self->ctx.rate = rate;
-        self->ctx.power = power;
-        self->ctx.nbTrans = nbTrans;
-    }    
+        LDL_MAC_putDevStatusAns(s, &self->ctx.dev_status_ans);                                
+        clearPendingCommand(self, LDL_CMD_DEV_STATUS);
+        
+        LDL_DEBUG(self->app, "adding dev_status_ans: battery=%u margin=%i",
+            self->ctx.dev_status_ans.battery,
+            self->ctx.dev_status_ans.margin
+        )
+        break;
+        
+    case LDL_CMD_NEW_CHANNEL:
+        
+        LDL_MAC_putNewChannelAns(s, &self->ctx.new_channel_ans);                                
+        clearPendingCommand(self, LDL_CMD_NEW_CHANNEL);
+        
+        LDL_DEBUG(self->app, "adding new_channel_ans: dataRateRangeOK=%s channelFreqOK=%s", 
+            self->ctx.new_channel_ans.dataRateRangeOK ? "true" : "false",
+            self->ctx.new_channel_ans.channelFreqOK ? "true" : "false"
+        )
+        break;
+        
+    case LDL_CMD_REJOIN_PARAM_SETUP:
+        
+        LDL_MAC_putRejoinParamSetupAns(s, &self->ctx.rejoin_param_setup_ans);                                
+        clearPendingCommand(self, LDL_CMD_REJOIN_PARAM_SETUP);
+        
+        LDL_DEBUG(self->app, "adding rejoin_param_setup_ans: timeOK=%s", 
+            self->ctx.rejoin_param_setup_ans.timeOK ? "true" : "false"
+        )
+        break;
+        
+    case LDL_CMD_ADR_PARAM_SETUP:
+        
+        LDL_MAC_putADRParamSetupAns(s);                                
+        clearPendingCommand(self, LDL_CMD_ADR_PARAM_SETUP);
+        
+        LDL_DEBUG(self->app, "adding adr_param_setup_ans")
+        break;
+        
+    case LDL_CMD_TX_PARAM_SETUP:
+        
+        LDL_MAC_putTXParamSetupAns(s);                                
+        clearPendingCommand(self, LDL_CMD_TX_PARAM_SETUP);
+        
+        LDL_DEBUG(self->app, "adding tx_param_setup_ans")
+        break;
+        
+    case LDL_CMD_DUTY_CYCLE:
+        
+        LDL_MAC_putDutyCycleAns(s);                                
+        clearPendingCommand(self, LDL_CMD_DUTY_CYCLE);
+        
+        LDL_DEBUG(self->app, "adding duty_cycle_ans")
+        break;
+        
+    /* requests */
+#ifndef LDL_DISABLE_CHECK        
+    case LDL_CMD_LINK_CHECK:
+        
+        LDL_MAC_putLinkCheckReq(s);
+        LDL_DEBUG(self->app, "adding link_check_req")
+        break;
+#endif
+#ifndef LDL_DISABLE_DEVICE_TIME        
+    case LDL_CMD_DEVICE_TIME:
+        
+        LDL_MAC_putDeviceTimeReq(s);
+        LDL_DEBUG(self->app, "adding device_time_req")
+        break;
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_CMD_PING_SLOT_INFO:
+        
+        LDL_MAC_putPingSlotInfoReq(s, self->ping_periodicity);
+        LDL_DEBUG(self->app, "adding ping_slot_info_req: periodicity=%u", self->ping_periodicity)
+        break;
+#endif        
+    }
+}
+
+static bool upCommandIsWanted(const struct ldl_mac *self, enum ldl_mac_cmd_type type)
+{
+    bool retval;
+    
+    switch(type){
+    default:
+        retval = commandIsPending(self, type);
+        break;
+#ifndef LDL_DISABLE_CHECK        
+    case LDL_CMD_LINK_CHECK:
+        retval = self->opts.check;
+        break;
+#endif        
+#ifndef LDL_DISABLE_DEVICE_TIME        
+    case LDL_CMD_DEVICE_TIME:
+#ifdef LDL_ENABLE_CLASS_B
+        /* class B needs the time to find the beacon */
+        retval = self->opts.getTime || (self->classB && !self->beacon_valid);
+#else
+        retval = self->opts.getTime;
+#endif        
+        break;
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_CMD_PING_SLOT_INFO:
+        retval = self->classB && self->ping_info_pending;
+        break;
+#endif        
+    }
+    
+    return retval;
+}
+
+static bool upCommandIsUrgent(const struct ldl_mac *self, enum ldl_mac_cmd_type type)
+{
+    bool retval;
+    
+    switch(type){
+    default:
+        /* anything that has already waited for one uplink */
+        retval = ((self->deferred_cmds & (uint16_t)(1UL << type)) != 0U);
+        break;
+        
+    /* sticky answers go in every uplink until a downlink is received */
+    case LDL_CMD_REKEY:
+    case LDL_CMD_RX_PARAM_SETUP:
+    case LDL_CMD_DL_CHANNEL:
+    case LDL_CMD_RX_TIMING_SETUP:
+    
+    /* the application asked for these with this frame */
+    case LDL_CMD_LINK_CHECK:
+        retval = true;
+        break;
+        
+    case LDL_CMD_DEVICE_TIME:
+        retval = self->opts.getTime || ((self->deferred_cmds & (uint16_t)(1UL << type)) != 0U);
+        break;
+    }
+    
+    return retval;
+}
+
+static uint8_t urgentSize(const struct ldl_mac *self)
+{
+    uint8_t retval = 0U;
+    uint8_t i;
+    
+    for(i=0U; i < sizeof(upCommands); i++){
+        
+        if(upCommandIsWanted(self, upCommands[i]) && upCommandIsUrgent(self, upCommands[i])){
+            
+            retval += LDL_MAC_sizeofCommandUp(upCommands[i]);
+        }
+    }
+    
+    return retval;
+}
+
+static void packUpCommands(struct ldl_mac *self, struct ldl_stream *s, uint8_t room)
+{
+    enum ldl_mac_cmd_type type;
+    uint8_t size;
+    uint8_t i;
+    uint16_t deferred = 0U;
+    
+    LDL_PEDANTIC(urgentSize(self) <= room)
+    
+    room -= urgentSize(self);
+    
+    for(i=0U; i < sizeof(upCommands); i++){
+        
+        type = upCommands[i];
+        
+        if(upCommandIsWanted(self, type)){
+        
+            size = LDL_MAC_sizeofCommandUp(type);
+            
+            if(upCommandIsUrgent(self, type)){
+                
+                putUpCommand(self, s, type);
+            }
+            else if(size <= room){
+                
+                putUpCommand(self, s, type);
+                room -= size;
+            }
+            else{
+                
+                LDL_DEBUG(self->app, "deferring type %u to the next uplink", type)
+                deferred |= (uint16_t)(1UL << type);
+            }
+        }
+    }
+    
+    /* anything that was sent is no longer deferred */
+    self->deferred_cmds = deferred;
+}
+
+static void applyDelta(struct ldl_mac *self, const struct cmd_delta *delta)
+{
+    if((delta->staged & (1U << LDL_CMD_LINK_ADR)) > 0U){
+        
+        (void)memcpy(self->ctx.chMask, delta->chMask, sizeof(self->ctx.chMask));
+        
+        self->ctx.rate = delta->rate;
+        self->ctx.power = delta->power;
+        self->ctx.nbTrans = delta->nbTrans;
+    }
+    
+    if((delta->staged & (1U << LDL_CMD_DUTY_CYCLE)) > 0U){
+        
+        self->ctx.maxDutyCycle = delta->maxDutyCycle;
+    }
+    
+    if((delta->staged & (1U << LDL_CMD_RX_PARAM_SETUP)) > 0U){
+        
+        self->ctx.rx1DROffset = delta->rx1DROffset;
+        self->ctx.rx2DataRate = delta->rx2DataRate;
+        /* already in 100Hz units */
+        self->ctx.rx2Freq[0] = (uint8_t)delta->rx2Freq;
+        self->ctx.rx2Freq[1] = (uint8_t)(delta->rx2Freq >> 8);
+        self->ctx.rx2Freq[2] = (uint8_t)(delta->rx2Freq >> 16);
+    }
+    
+    if((delta->staged & (1U << LDL_CMD_RX_TIMING_SETUP)) > 0U){
+        
+        self->ctx.rx1Delay = delta->rx1Delay;
+    }
+    
+    if((delta->staged & (1U << LDL_CMD_ADR_PARAM_SETUP)) > 0U){
+        
+        self->ctx.adr_ack_limit = delta->adr_ack_limit;
+        self->ctx.adr_ack_delay = delta->adr_ack_delay;
+    }
 }
 
-static void registerTime(struct ldl_mac *self, uint32_t freq, uint32_t airTime)
+static void registerTime(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint32_t airTime)
 {
     uint8_t band;
     uint32_t offtime;
     
-    if(LDL_Region_getBand(self->region, freq, &band)){
+    if(getChannelBand(self, chIndex, freq, &band)){
     
         offtime = LDL_Region_getOffTimeFactor(self->region, band);
     
@@ -2205,13 +3118,14 @@ static bool selectChannel(const struct ldl_mac *self, uint8_t rate, uint8_t prev
     uint8_t minRate;
     uint8_t maxRate;    
     uint8_t except = UINT8_MAX;
+    uint8_t numChannels = LDL_Region_numChannels(self->region);
     
     uint8_t mask[sizeof(self->ctx.chMask)];
     
     (void)memset(mask, 0, sizeof(mask));
     
     /* count number of available channels for this rate */
-    for(i=0U; i < LDL_Region_numChannels(self->region); i++){
+    for(i=0U; i < numChannels; i++){
         
         if(isAvailable(self, i, rate, limit)){
         
@@ -2239,9 +3153,9 @@ static bool selectChannel(const struct ldl_mac *self, uint8_t rate, uint8_t prev
             }
         }
     
-        selection = LDL_System_rand(self->app) % available;
+        selection = getRand(self) % available;
         
-        for(i=0U; i < LDL_Region_numChannels(self->region); i++){
+        for(i=0U; i < numChannels; i++){
         
             if(channelIsMasked(mask, sizeof(mask), self->region, i)){
         
@@ -2280,7 +3194,7 @@ static bool isAvailable(const struct ldl_mac *self, uint8_t chIndex, uint8_t rat
             
             if((rate >= minRate) && (rate <= maxRate)){
             
-                if(LDL_Region_getBand(self->region, freq, &band)){
+                if(getChannelBand(self, chIndex, freq, &band)){
                 
                     LDL_PEDANTIC( band < LDL_BAND_MAX )
                 
@@ -2310,7 +3224,7 @@ static bool msUntilAvailable(const struct ldl_mac *self, uint8_t chIndex, uint8_
             
             if((rate >= minRate) && (rate <= maxRate)){
             
-                if(LDL_Region_getBand(self->region, freq, &band)){
+                if(getChannelBand(self, chIndex, freq, &band)){
                 
                     LDL_PEDANTIC( band < LDL_BAND_MAX )
                 
@@ -2349,7 +3263,7 @@ static void restoreDefaults(struct ldl_mac *self, bool keep)
     self->ctx.rx1DROffset = LDL_Region_getRX1Offset(self->region);
     self->ctx.rx1Delay = LDL_Region_getRX1Delay(self->region);
     self->ctx.rx2DataRate = LDL_Region_getRX2Rate(self->region);
-    self->ctx.rx2Freq = LDL_Region_getRX2Freq(self->region);    
+    putFreq(self->ctx.rx2Freq, LDL_Region_getRX2Freq(self->region));
     self->ctx.version = 0U;
 
     self->ctx.adr_ack_limit = ADRAckLimit;
@@ -2373,9 +3287,9 @@ static bool getChannel(const struct ldl_mac *self, uint8_t chIndex, uint32_t *fr
             
                 chConfig = &self->ctx.chConfig[chIndex];
                 
-                *freq = (chConfig->freqAndRate >> 8) * 100U;
-                *minRate = (chConfig->freqAndRate >> 4) & 0xfU;
-                *maxRate = chConfig->freqAndRate & 0xfU;
+                *freq = getFreq(chConfig->freq);
+                *minRate = chConfig->rate >> 4;
+                *maxRate = chConfig->rate & 0xfU;
                 
                 retval = true;
             }
@@ -2399,7 +3313,16 @@ static bool setChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uin
         
         if(chIndex < sizeof(self->ctx.chConfig)/sizeof(*self->ctx.chConfig)){
         
-            self->ctx.chConfig[chIndex].freqAndRate = ((freq/100U) << 8) | ((minRate << 4) & 0xfU) | (maxRate & 0xfU);
+            struct ldl_mac_channel *chConfig = &self->ctx.chConfig[chIndex];
+            
+            putFreq(chConfig->freq, freq);
+            chConfig->rate = (uint8_t)((minRate << 4) | (maxRate & 0xfU));
+            
+            if(!LDL_Region_getBand(self->region, freq, &chConfig->band)){
+                
+                chConfig->band = UINT8_MAX;
+            }
+            
             retval = true;
         }        
     }
@@ -2407,17 +3330,59 @@ static bool setChannel(struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uin
     return retval;
 }
 
-static bool maskChannel(uint8_t *mask, uint8_t max, enum ldl_region region, uint8_t chIndex)
+static bool getChannelBand(const struct ldl_mac *self, uint8_t chIndex, uint32_t freq, uint8_t *band)
 {
-    bool retval = false;
+    bool retval;
     
-    if(chIndex < LDL_Region_numChannels(region)){
+    /* the band of a dynamic channel is found when the channel is set */
+    if(LDL_Region_isDynamic(self->region) && (chIndex < sizeof(self->ctx.chConfig)/sizeof(*self->ctx.chConfig))){
         
-        if(chIndex < (max*8U)){
-    
-            mask[chIndex / 8U] |= (1U << (chIndex % 8U));
-            retval = true;
-        }
+        *band = self->ctx.chConfig[chIndex].band;
+        
+        /* a channel without a frequency is disabled */
+        retval = (freq > 0U) && (*band != UINT8_MAX);
+    }
+    else{
+        
+        retval = LDL_Region_getBand(self->region, freq, band);
+    }
+    
+    return retval;
+}
+
+static uint32_t getFreq(const uint8_t *in)
+{
+    uint32_t retval;
+    
+    retval = in[2];
+    retval <<= 8;
+    retval |= in[1];
+    retval <<= 8;
+    retval |= in[0];
+    
+    return retval * 100UL;
+}
+
+static void putFreq(uint8_t *out, uint32_t freq)
+{
+    freq /= 100UL;
+    
+    out[0] = (uint8_t)freq;
+    out[1] = (uint8_t)(freq >> 8);
+    out[2] = (uint8_t)(freq >> 16);
+}
+
+static bool maskChannel(uint8_t *mask, uint8_t max, enum ldl_region region, uint8_t chIndex)
+{
+    bool retval = false;
+    
+    if(chIndex < LDL_Region_numChannels(region)){
+        
+        if(chIndex < (max*8U)){
+    
+            mask[chIndex / 8U] |= (1U << (chIndex % 8U));
+            retval = true;
+        }
     }
     
     return retval;
@@ -2476,16 +3441,16 @@ static bool allChannelsAreMasked(const uint8_t *mask, uint8_t max)
     return retval;
 }
 
-static bool rateSettingIsValid(enum ldl_region region, uint8_t rate)
+static bool rateSettingIsValid(const struct ldl_mac *self, uint8_t rate)
 {
     bool retval = false;
     uint8_t i;
     
-    for(i=0U; i < LDL_Region_numChannels(region); i++){
+    for(i=0U; i < LDL_Region_numChannels(self->region); i++){
         
-        if(LDL_Region_validateRate(region, i, rate, rate)){
+        if(LDL_Region_validateRate(self->region, i, rate, rate)){
             
-            retval = true;
+            retval = rateIsSupported(self, rate);
             break;
         }
     }
@@ -2493,6 +3458,26 @@ static bool rateSettingIsValid(enum ldl_region region, uint8_t rate)
     return retval;
 }
 
+static bool rateIsSupported(const struct ldl_mac *self, uint8_t rate)
+{
+    bool retval = true;
+#ifdef LDL_ENABLE_FSK    
+    enum ldl_spreading_factor sf;
+    enum ldl_signal_bandwidth bw;
+    uint8_t mtu;
+    
+    /* not every radio has an FSK modem */
+    LDL_Region_convertRate(self->region, rate, &sf, &bw, &mtu);
+    
+    retval = (sf != LDL_SF_FSK) || LDL_Radio_supportsFSK(self->radio);
+#else
+    (void)self;
+    (void)rate;
+#endif
+    
+    return retval;
+}
+
 static uint32_t timeNow(struct ldl_mac *self)
 {
     uint32_t seconds;
@@ -2500,7 +3485,7 @@ static uint32_t timeNow(struct ldl_mac *self)
     uint32_t since;
     uint32_t part;
     
-    ticks = LDL_System_ticks(self->app);
+    ticks = getTicks(self);
     since = timerDelta(self->polled_time_ticks, ticks);
     
     seconds = since / LDL_System_tps();
@@ -2549,7 +3534,7 @@ static void processBands(struct ldl_mac *self)
     uint32_t diff;
     size_t i;
     
-    ticks = LDL_System_ticks(self->app);
+    ticks = getTicks(self);
     diff = timerDelta(self->polled_band_ticks, ticks);    
     since = diff / LDL_System_tps() * 1000UL;
     
@@ -2593,6 +3578,46 @@ static uint32_t nextBandEvent(const struct ldl_mac *self)
     return retval;
 }
 
+static void rxTimeoutHandler(struct ldl_mac *self)
+{
+    if(self->state == LDL_STATE_RX2){
+    
+        LDL_MAC_timerClear(self, LDL_TIMER_WAITB);
+        
+        uint8_t mtu;
+        enum ldl_spreading_factor sf;
+        enum ldl_signal_bandwidth bw;
+        
+        LDL_Region_convertRate(self->region, self->tx.rate, &sf, &bw, &mtu);                        
+        
+        LDL_MAC_timerSet(self, LDL_TIMER_WAITA, transmitTime(bw, sf, mtu, false));
+        
+        self->state = LDL_STATE_RX2_LOCKOUT;
+    }
+#ifdef LDL_ENABLE_CLASS_B
+    else if(self->state == LDL_STATE_PING){
+        
+        LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+        
+        self->state = LDL_STATE_IDLE;
+    }
+#endif            
+    else{
+        
+        LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+        
+#ifdef LDL_ENABLE_CLASS_C
+        /* listen in RXC until the second window opens */
+        if((self->state == LDL_STATE_RX1) && self->classC && self->ctx.joined){
+            
+            openRXC(self);
+        }
+#endif
+        
+        self->state = LDL_STATE_WAIT_RX2;
+    }   
+}
+
 static void downlinkMissingHandler(struct ldl_mac *self)
 {
     union ldl_mac_response_arg arg;
@@ -2606,14 +3631,7 @@ static void downlinkMissingHandler(struct ldl_mac *self)
     
     (void)memset(&arg, 0, sizeof(arg));
     
-    if(self->opts.nbTrans > 0U){
-        
-        nbTrans = self->opts.nbTrans;
-    }
-    else{
-        
-        nbTrans = (self->ctx.nbTrans > 0) ? self->ctx.nbTrans : 1U;
-    }
+    nbTrans = getNbTrans(self);
     
     self->trials++;
     
@@ -2705,6 +3723,10 @@ static void downlinkMissingHandler(struct ldl_mac *self)
 
     case LDL_OP_JOINING:
 
+#ifdef LDL_ENABLE_SHARED_BUFFER
+        /* the downlink may have been collected over the request */
+        prepareJoinRequest(self);
+#endif
         self->band[LDL_BAND_RETRY] = tx_time * getRetryDuty(delta);
         
         self->tx.rate = LDL_Region_getJoinRate(self->region, self->trials);
@@ -2761,21 +3783,594 @@ static uint32_t msUntilNextChannel(const struct ldl_mac *self, uint8_t rate)
     return min;
 }
 
-static uint32_t rand32(void *app)
+static uint32_t rand32(const struct ldl_mac *self)
 {
     uint32_t retval;
     
-    retval = LDL_System_rand(app);
+    retval = getRand(self);
     retval <<= 8;
-    retval |= LDL_System_rand(app);
+    retval |= getRand(self);
     retval <<= 8;
-    retval |= LDL_System_rand(app);
+    retval |= getRand(self);
     retval <<= 8;
-    retval |= LDL_System_rand(app);
+    retval |= getRand(self);
+    
+    return retval;
+}
+
+static uint8_t getRand(const struct ldl_mac *self)
+{
+    uint8_t retval;
+    
+    retval = LDL_System_rand(self->app);
+    
+    TRACE_U8(self, LDL_TRACE_RAND, retval);
+    
+    return retval;
+}
+
+static uint32_t getTicks(const struct ldl_mac *self)
+{
+    uint32_t retval;
+    
+    retval = LDL_System_ticks(self->app);
+    
+#ifdef LDL_ENABLE_TRACE
+    traceU32(self, LDL_TRACE_TICKS, retval);
+#endif
     
     return retval;
 }
 
+static void forget(struct ldl_mac *self)
+{
+    cancel(self);    
+    
+    if(self->ctx.joined){
+    
+        restoreDefaults(self, true);    
+        
+#ifndef LDL_DISABLE_SESSION_UPDATE        
+        pushSessionUpdate(self);   
+#endif
+    }
+}
+
+static bool isIdle(const struct ldl_mac *self)
+{
+    bool retval = (self->state == LDL_STATE_IDLE);
+    
+#ifdef LDL_ENABLE_CLASS_C
+    retval = retval || ((self->state == LDL_STATE_RXC) && (self->rxc_state == LDL_STATE_IDLE));
+#endif    
+#ifdef LDL_ENABLE_CLASS_B
+    /* beacon and ping slot windows give way to class A */
+    retval = retval || (self->state == LDL_STATE_BEACON) || (self->state == LDL_STATE_PING);
+#endif    
+
+    return retval;
+}
+
+#ifdef LDL_ENABLE_CLASS_C
+static bool listenPending(const struct ldl_mac *self)
+{
+    return ((self->state == LDL_STATE_IDLE) && self->classC && self->ctx.joined);
+}
+
+static void listenContinuous(struct ldl_mac *self)
+{
+    openRXC(self);
+    
+    self->state = LDL_STATE_RXC;
+    self->rxc_state = LDL_STATE_IDLE;
+}
+
+static void stopListening(struct ldl_mac *self)
+{
+    if(((self->state == LDL_STATE_RXC) && (self->rxc_state == LDL_STATE_IDLE)) || waitingInRXC(self)){
+        
+        LDL_MAC_inputClear(self);
+        
+        LDL_Radio_clearInterrupt(self->radio);
+        
+        if(self->state == LDL_STATE_RXC){
+            
+            self->state = LDL_STATE_IDLE;
+        }
+    }
+}
+
+static void openRXC(struct ldl_mac *self)
+{
+    struct ldl_radio_rx_setting radio_setting;
+    
+    LDL_Region_convertRate(self->region, self->ctx.rx2DataRate, &radio_setting.sf, &radio_setting.bw, &radio_setting.max);
+    
+    radio_setting.max += LDL_Frame_phyOverhead();
+#ifdef LDL_ENABLE_FSK
+    setRXBuffer(self, &radio_setting);
+#endif
+    radio_setting.continuous = true;
+    radio_setting.beacon = false;
+    radio_setting.freq = getFreq(self->ctx.rx2Freq);
+    radio_setting.timeout = 0U;
+    
+    LDL_MAC_inputClear(self);
+    LDL_MAC_inputArm(self, LDL_INPUT_RX_READY);
+    
+    LDL_Radio_receive(self->radio, &radio_setting);
+    
+    self->snr_min = LDL_Radio_minSNR(self->radio, radio_setting.sf);
+}
+
+static bool waitingInRXC(const struct ldl_mac *self)
+{
+    bool retval;
+    
+    switch(self->state){
+    case LDL_STATE_WAIT_TX:
+    case LDL_STATE_WAIT_RX1:
+    case LDL_STATE_WAIT_RX2:
+        /* RX ready is only armed in these states by openRXC() */
+        retval = ((self->inputs.armed & (1U << LDL_INPUT_RX_READY)) != 0U);
+        break;
+    default:
+        retval = false;
+        break;
+    }
+    
+    return retval;
+}
+
+/* hand the frame to RXC without losing the operation or its schedule */
+static void suspendWait(struct ldl_mac *self)
+{
+    self->rxc_state = self->state;
+    self->rxc_op = self->op;
+    self->rxc_timers[0] = self->timers[LDL_TIMER_WAITA];
+    self->rxc_timers[1] = self->timers[LDL_TIMER_WAITB];
+    
+    /* handled as a class C downlink */
+    self->state = LDL_STATE_RXC;
+    self->op = LDL_OP_NONE;
+}
+
+/* a timer that expired in the meantime fires late */
+static void resumeWait(struct ldl_mac *self)
+{
+    /* unless the operation was cancelled in the meantime */
+    if(self->rxc_state != LDL_STATE_IDLE){
+    
+        self->state = self->rxc_state;
+        self->op = self->rxc_op;
+        self->timers[LDL_TIMER_WAITA] = self->rxc_timers[0];
+        self->timers[LDL_TIMER_WAITB] = self->rxc_timers[1];
+        
+        self->rxc_state = LDL_STATE_IDLE;
+        
+        if(self->classC){
+            
+            openRXC(self);
+        }
+    }
+}
+#endif
+
+#ifdef LDL_ENABLE_CLASS_B
+static void processClassB(struct ldl_mac *self)
+{
+    union ldl_mac_response_arg arg;
+    struct ldl_radio_rx_setting radio_setting;
+    uint32_t error;
+    uint32_t margin;
+    uint8_t symbols;
+    uint8_t rate;
+    bool beacon;
+    
+    if(LDL_MAC_timerCheck(self, LDL_TIMER_BEACON, &error)){
+        
+        beacon = !(self->beacon_locked && (self->ping_slot < pingNb(self)));
+        
+        margin = self->slot_margin;
+        symbols = self->slot_symbols;
+        
+        if(!self->ctx.joined){
+            
+            /* the time is learnt again after the next join */
+            self->beacon_valid = false;
+            self->beacon_locked = false;
+        }
+        else if((self->state == LDL_STATE_IDLE) && (error <= margin)){
+            
+            (void)LDL_Region_getBeaconChannel(self->region, &radio_setting.freq, &rate);
+            LDL_Region_convertRate(self->region, rate, &radio_setting.sf, &radio_setting.bw, &radio_setting.max);
+            
+            radio_setting.continuous = false;
+            radio_setting.timeout = symbols;
+            
+            if(beacon){
+                
+                radio_setting.beacon = true;
+                radio_setting.max = BeaconSize;
+                
+                self->state = LDL_STATE_BEACON;
+            }
+            else{
+                
+                radio_setting.beacon = false;
+                radio_setting.max += LDL_Frame_phyOverhead();
+                
+                self->state = LDL_STATE_PING;
+                
+                self->ping_slot++;
+                scheduleClassB(self);
+            }
+#ifdef LDL_ENABLE_FSK
+            setRXBuffer(self, &radio_setting);
+#endif
+            
+            LDL_MAC_inputClear(self);
+            LDL_MAC_inputArm(self, LDL_INPUT_RX_READY);
+            LDL_MAC_inputArm(self, LDL_INPUT_RX_TIMEOUT);
+            
+            LDL_Radio_receive(self->radio, &radio_setting);
+            
+            /* use waitA as a guard */
+            LDL_MAC_timerSet(self, LDL_TIMER_WAITA, (LDL_System_tps()) << 4U);
+            
+            self->snr_min = LDL_Radio_minSNR(self->radio, radio_setting.sf);
+            
+#ifndef LDL_DISABLE_SLOT_EVENT                           
+            arg.rx_slot.margin = margin;
+            arg.rx_slot.timeout = symbols;
+            arg.rx_slot.error = error;
+            arg.rx_slot.freq = radio_setting.freq;
+            arg.rx_slot.bw = radio_setting.bw;
+            arg.rx_slot.sf = radio_setting.sf;
+                            
+            self->handler(self->app, beacon ? LDL_MAC_BEACON_SLOT : LDL_MAC_PING_SLOT, &arg);                    
+#else
+            (void)arg;
+#endif                
+        }
+        else if(beacon){
+            
+            beaconMissed(self);
+        }
+        else{
+            
+            self->ping_slot++;
+            scheduleClassB(self);
+        }
+    }
+}
+
+static void scheduleClassB(struct ldl_mac *self)
+{
+    enum ldl_spreading_factor sf;
+    enum ldl_signal_bandwidth bw;
+    uint32_t freq;
+    uint32_t offset;
+    uint32_t uncertainty;
+    uint32_t when;
+    uint32_t Ts;
+    uint8_t rate;
+    uint8_t mtu;
+    uint8_t extra_symbols;
+    
+    (void)LDL_Region_getBeaconChannel(self->region, &freq, &rate);
+    LDL_Region_convertRate(self->region, rate, &sf, &bw, &mtu);
+    
+    Ts = symbolPeriod(sf, bw);
+    
+    /* ping slots are only predicted from a received beacon */
+    if(self->beacon_locked && (self->ping_slot < pingNb(self))){
+        
+        offset = msToTicks(BeaconReserved + (((uint32_t)self->ping_offset + ((uint32_t)self->ping_slot * pingPeriod(self))) * PingSlotLen));
+    }
+    else{
+        
+        offset = BeaconPeriod * LDL_System_tps();
+    }
+    
+    /* the clock may have drifted either way since beacon_ticks was measured */
+    uncertainty = (((uint32_t)self->beacon_missed * BeaconPeriod) + (offset / LDL_System_tps()) + 1UL) * LDL_System_eps();
+    
+    /* DeviceTimeAns is only accurate to 1/256 seconds */
+    if(!self->beacon_locked){
+        
+        uncertainty += (LDL_System_tps() / 256UL) + 1UL;
+    }
+    
+    extra_symbols = extraSymbols(uncertainty * 2UL, Ts);
+    
+    extra_symbols = (extra_symbols > (UINT8_MAX - 8U)) ? (UINT8_MAX - 8U) : extra_symbols;
+    
+    self->slot_margin = (3UL + extra_symbols) * Ts;
+    self->slot_symbols = 8U + extra_symbols;
+    
+    /* same as the RX windows: open early by the uncertainty and the timing advance */
+    when = self->beacon_ticks + offset + uncertainty - LDL_System_advance() - (extra_symbols * Ts);
+    
+    /* armed in absolute time so that lateness is measured against the window */
+    LDL_SYSTEM_ENTER_CRITICAL(self->app)
+    
+    self->timers[LDL_TIMER_BEACON].time = when;
+    self->timers[LDL_TIMER_BEACON].armed = true;
+    
+    LDL_SYSTEM_LEAVE_CRITICAL(self->app)
+}
+
+static void syncBeacon(struct ldl_mac *self, uint32_t seconds, uint8_t fractions)
+{
+    uint32_t phase = seconds % BeaconPeriod;
+    
+    /* the beacon period that contains the end of the uplink */
+    self->beacon_time = seconds - phase;
+    self->beacon_ticks = self->tx_end_ticks - ((phase * LDL_System_tps()) + (((uint32_t)fractions * LDL_System_tps()) / 256UL));
+    
+    self->beacon_valid = true;
+    self->beacon_missed = 0U;
+    
+    /* next window is the beacon */
+    self->ping_slot = pingNb(self);
+    
+    LDL_DEBUG(self->app, "beacon expected at %"PRIu32, self->beacon_time + BeaconPeriod)
+    
+    scheduleClassB(self);
+}
+
+static void beaconMissed(struct ldl_mac *self)
+{
+    self->beacon_missed++;
+    
+    if(self->beacon_missed > LDL_BEACON_MISSED_MAX){
+        
+        self->beacon_valid = false;
+        self->beacon_locked = false;
+        self->beacon_missed = 0U;
+        
+        LDL_MAC_timerClear(self, LDL_TIMER_BEACON);
+        
+        self->handler(self->app, LDL_MAC_BEACON_LOST, NULL);
+    }
+    else{
+        
+        /* keep time from the beacon that should have been received */
+        self->beacon_ticks += BeaconPeriod * LDL_System_tps();
+        self->beacon_time += BeaconPeriod;
+        
+        self->ping_offset = LDL_OPS_pingOffset(self->beacon_time, self->ctx.devAddr, pingPeriod(self));
+        self->ping_slot = 0U;
+        
+        scheduleClassB(self);
+        
+        self->handler(self->app, LDL_MAC_BEACON_MISSED, NULL);
+    }
+}
+
+static void stopSlot(struct ldl_mac *self)
+{
+    switch(self->state){
+    case LDL_STATE_BEACON:
+    case LDL_STATE_PING:
+    
+        LDL_MAC_inputClear(self);
+        LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+        
+        LDL_Radio_clearInterrupt(self->radio);
+        
+        if(self->state == LDL_STATE_BEACON){
+            
+            self->state = LDL_STATE_IDLE;
+            beaconMissed(self);
+        }
+        else{
+            
+            self->state = LDL_STATE_IDLE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void stopClassB(struct ldl_mac *self)
+{
+    LDL_MAC_timerClear(self, LDL_TIMER_BEACON);
+    
+    self->classB = false;
+    self->beacon_valid = false;
+    self->beacon_locked = false;
+    self->beacon_missed = 0U;
+    self->ping_info_pending = false;
+    
+    switch(self->state){
+    case LDL_STATE_BEACON:
+    case LDL_STATE_PING:
+    
+        LDL_MAC_inputClear(self);
+        LDL_MAC_timerClear(self, LDL_TIMER_WAITA);
+        
+        LDL_Radio_clearInterrupt(self->radio);
+        
+        self->state = LDL_STATE_IDLE;
+        break;
+    default:
+        break;
+    }
+}
+
+static uint16_t pingNb(const struct ldl_mac *self)
+{
+    return (uint16_t)(1U << (7U - self->ping_periodicity));
+}
+
+static uint16_t pingPeriod(const struct ldl_mac *self)
+{
+    return (uint16_t)(1U << (5U + self->ping_periodicity));
+}
+
+static uint32_t beaconAirTime(enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf)
+{
+    /* implicit header, no CRC and two more preamble symbols than a data frame */
+    return transmitTime(bw, sf, BeaconSize, false) + (2UL * symbolPeriod(sf, bw));
+}
+
+static uint32_t msToTicks(uint32_t ms)
+{
+    return ((ms / 1000UL) * LDL_System_tps()) + (((ms % 1000UL) * LDL_System_tps()) / 1000UL);
+}
+#endif
+
+static void transmit(struct ldl_mac *self)
+{
+#ifndef LDL_DISABLE_TX_BEGIN_EVENT
+    union ldl_mac_response_arg arg;
+#endif
+    struct ldl_radio_tx_setting radio_setting;
+    uint32_t tx_time;
+    uint8_t mtu;
+    
+#ifdef LDL_ENABLE_SHARED_BUFFER
+    /* a downlink may have been collected over the frame */
+    switch(self->op){
+    default:
+        break;
+    case LDL_OP_DATA_UNCONFIRMED:
+    case LDL_OP_DATA_CONFIRMED:
+        prepareData(self);
+        break;
+    }
+#endif
+    
+    LDL_Region_convertRate(self->region, self->tx.rate, &radio_setting.sf, &radio_setting.bw, &mtu);
+    
+    radio_setting.dbm = LDL_Region_getTXPower(self->region, self->tx.power) + self->gain;
+    
+    radio_setting.freq = self->tx.freq;
+    
+    tx_time = transmitTime(radio_setting.bw, radio_setting.sf, self->bufferLen, true);
+    
+    LDL_MAC_inputClear(self);  
+    LDL_MAC_inputArm(self, LDL_INPUT_TX_COMPLETE);  
+    
+    LDL_Radio_transmit(self->radio, &radio_setting, self->buffer, self->bufferLen);
+
+    registerTime(self, self->tx.chIndex, self->tx.freq, tx_time);
+    
+    self->state = LDL_STATE_TX;
+    
+    LDL_PEDANTIC((tx_time & 0x80000000UL) != 0x80000000UL)
+    
+    /* reset the radio if the tx complete interrupt doesn't appear after double the expected time */      
+    LDL_MAC_timerSet(self, LDL_TIMER_WAITA, tx_time << 1UL);    
+    
+#ifndef LDL_DISABLE_TX_BEGIN_EVENT            
+    arg.tx_begin.freq = self->tx.freq;
+    arg.tx_begin.power = self->tx.power;
+    arg.tx_begin.sf = radio_setting.sf;
+    arg.tx_begin.bw = radio_setting.bw;
+    arg.tx_begin.size = self->bufferLen;
+    
+    self->handler(self->app, LDL_MAC_TX_BEGIN, &arg);
+#endif
+    
+#ifdef LDL_ENABLE_CAD
+    self->cad_attempts = 0U;
+#endif
+}
+
+#ifdef LDL_ENABLE_CAD
+static void listenBeforeTalk(struct ldl_mac *self)
+{
+    struct ldl_radio_cad_setting radio_setting;
+    uint8_t mtu;
+    
+    LDL_Region_convertRate(self->region, self->tx.rate, &radio_setting.sf, &radio_setting.bw, &mtu);
+    
+    radio_setting.freq = self->tx.freq;
+    
+    LDL_MAC_inputClear(self);
+    LDL_MAC_inputArm(self, LDL_INPUT_CAD_DONE);
+    
+    LDL_Radio_cad(self->radio, &radio_setting);
+    
+    self->state = LDL_STATE_CAD;
+    
+    /* CAD takes about two symbols, reset the radio if CAD done doesn't appear after eight */
+    LDL_MAC_timerSet(self, LDL_TIMER_WAITA, symbolPeriod(radio_setting.sf, radio_setting.bw) * 8UL);
+}
+
+static bool rateIsFSK(enum ldl_region region, uint8_t rate)
+{
+    enum ldl_signal_bandwidth bw;
+    enum ldl_spreading_factor sf;
+    uint8_t mtu;
+    
+    LDL_Region_convertRate(region, rate, &sf, &bw, &mtu);
+    
+    return (sf == LDL_SF_FSK);
+}
+#endif
+
+static void cancel(struct ldl_mac *self)
+{
+#ifdef LDL_ENABLE_CLASS_B
+    /* a cancelled beacon window still counts as missed */
+    stopSlot(self);
+#endif
+
+    switch(self->state){
+    case LDL_STATE_IDLE:
+    case LDL_STATE_INIT_RESET:
+    case LDL_STATE_INIT_LOCKOUT:
+    case LDL_STATE_RECOVERY_RESET:    
+    case LDL_STATE_RECOVERY_LOCKOUT:    
+    case LDL_STATE_ENTROPY:    
+        break;
+    default:
+        self->state = LDL_STATE_IDLE;
+        LDL_Radio_sleep(self->radio);    
+        break;
+    }   
+    
+#ifdef LDL_ENABLE_CLASS_C
+    self->rxc_state = LDL_STATE_IDLE;
+#endif
+    
+#ifdef LDL_ENABLE_CAD
+    self->cad_attempts = 0U;
+#endif
+}
+
+#ifdef LDL_ENABLE_TRACE
+static void trace(const struct ldl_mac *self, enum ldl_mac_trace_type type, const void *hdr, uint8_t hdrLen, const void *data, uint8_t dataLen)
+{
+    if(self->trace != NULL){
+        
+        self->trace(self->app, type, hdr, hdrLen, data, dataLen);
+    }
+}
+
+static void traceU8(const struct ldl_mac *self, enum ldl_mac_trace_type type, uint8_t value)
+{
+    trace(self, type, &value, sizeof(value), NULL, 0U);
+}
+
+static void traceU32(const struct ldl_mac *self, enum ldl_mac_trace_type type, uint32_t value)
+{
+    uint8_t hdr[4U];
+    
+    hdr[0] = (uint8_t)value;
+    hdr[1] = (uint8_t)(value >> 8);
+    hdr[2] = (uint8_t)(value >> 16);
+    hdr[3] = (uint8_t)(value >> 24);
+    
+    trace(self, type, hdr, sizeof(hdr), NULL, 0U);
+}
+#endif
+
 #ifndef LDL_DISABLE_SESSION_UPDATE
 static void pushSessionUpdate(struct ldl_mac *self)
 {
@@ -2806,3 +4401,134 @@ static void setPendingCommand(struct ldl_mac *self, enum ldl_mac_cmd_type type)
 {
     self->ctx.pending_cmds |= ((uint16_t)(1UL << type));
 }
+
+#ifdef LDL_ENABLE_CHIP_ASYNC
+/* take the next step in collecting a frame
+ * 
+ * @retval true frame is ready
+ * 
+ * */
+static bool collectResume(struct ldl_mac *self)
+{
+    /* armed before the radio can submit the next batch */
+    LDL_MAC_inputClear(self);
+    LDL_MAC_inputArm(self, LDL_INPUT_CHIP_COMPLETE);
+    
+    return LDL_Radio_collectResume(self->radio);
+}
+#endif
+
+static uint8_t getNbTrans(const struct ldl_mac *self)
+{
+    uint8_t retval;
+    
+    if(self->opts.nbTrans > 0U){
+        
+        retval = self->opts.nbTrans;
+    }
+    else{
+        
+        retval = (self->ctx.nbTrans > 0U) ? self->ctx.nbTrans : 1U;
+    }
+    
+    return retval;
+}
+
+static void prepareJoinRequest(struct ldl_mac *self)
+{
+    struct ldl_frame_join_request f;
+    
+    f.joinEUI = self->joinEUI;
+    f.devEUI = self->devEUI;
+    f.devNonce = self->devNonce;
+    
+    self->bufferLen = LDL_OPS_prepareJoinRequest(self, &f, self->buffer, sizeof(self->buffer));
+}
+
+#ifdef LDL_ENABLE_SHARED_BUFFER
+static void saveData(struct ldl_mac *self, const struct ldl_frame_data *f)
+{
+    self->up.confirmed = (f->type == FRAME_TYPE_DATA_CONFIRMED_UP);
+    self->up.adr = f->adr;
+    self->up.adrAckReq = f->adrAckReq;
+    self->up.classB = f->classB;
+    self->up.port = f->port;
+    
+    if(f->port == 0U){
+        
+        self->up.data = NULL;
+        self->up.len = 0U;
+        
+        self->up.optsLen = f->dataLen;
+        (void)memcpy(self->up.opts, f->data, f->dataLen);
+    }
+    else{
+        
+        self->up.data = f->data;
+        self->up.len = f->dataLen;
+        
+        self->up.optsLen = f->optsLen;
+        (void)memcpy(self->up.opts, f->opts, f->optsLen);
+    }
+}
+
+static void prepareData(struct ldl_mac *self)
+{
+    struct ldl_frame_data f;
+    
+    (void)memset(&f, 0, sizeof(f));
+    
+    f.type = self->up.confirmed ? FRAME_TYPE_DATA_CONFIRMED_UP : FRAME_TYPE_DATA_UNCONFIRMED_UP;
+    f.devAddr = self->ctx.devAddr;
+    f.counter = (uint16_t)self->tx.counter;
+    f.adr = self->up.adr;
+    f.adrAckReq = self->up.adrAckReq;
+    f.classB = self->up.classB;
+    f.port = self->up.port;
+    
+    if(self->up.port == 0U){
+        
+        f.data = self->up.opts;
+        f.dataLen = self->up.optsLen;
+    }
+    else{
+        
+        f.opts = self->up.opts;
+        f.optsLen = self->up.optsLen;
+        f.data = self->up.data;
+        f.dataLen = self->up.len;
+    }
+    
+    self->bufferLen = LDL_OPS_prepareData(self, &f, self->buffer, sizeof(self->buffer));
+    
+    LDL_OPS_micDataFrame(self, self->buffer, self->bufferLen);
+}
+#endif
+
+#ifdef LDL_ENABLE_STATIC_RX_BUFFER
+static uint8_t *rxBuffer(struct ldl_mac *self, uint8_t *max)
+{
+    uint8_t *retval;
+    
+#ifdef LDL_ENABLE_SHARED_BUFFER
+    /* a frame that will be sent again is rebuilt beforehand */
+    retval = self->buffer;
+    *max = (uint8_t)sizeof(self->buffer);
+#else
+    retval = self->rx_buffer;
+    *max = (uint8_t)sizeof(self->rx_buffer);
+#endif    
+    return retval;
+}
+#endif
+
+#ifdef LDL_ENABLE_FSK
+static void setRXBuffer(struct ldl_mac *self, struct ldl_radio_rx_setting *setting)
+{
+    uint8_t max;
+    
+    /* the driver moves the frame into the buffer as it arrives */
+    setting->buffer = rxBuffer(self, &max);
+    setting->max = (setting->max < max) ? setting->max : max;
+}
+#endif
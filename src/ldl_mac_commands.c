@@ -19,78 +19,92 @@
  *
  * */
 
+
 #include "ldl_mac_commands.h"
 #include "ldl_stream.h"
 #include "ldl_debug.h"
 
-struct type_to_tag {
-  
-    uint8_t tag;    
-    enum ldl_mac_cmd_type type;    
+#ifdef LDL_ENABLE_AVR
+
+    #include <avr/pgmspace.h>
+    
+#else
+
+    #include <string.h>
+    
+    #define PROGMEM
+    #define memcpy_P memcpy
+    
+#endif
+
+#include <stddef.h>
+
+/* CID of the first command in the table (LDL_CMD_LINK_CHECK) */
+#define CID_FIRST 2U
+
+/* payload size of a command that is never sent in this direction */
+#define NOT_SENT UINT8_MAX
+
+/* largest payload the network can send (NewChannelReq, DeviceTimeAns) */
+#define MAX_DOWN 5U
+
+/* largest payload the device can send (DevStatusAns) */
+#define MAX_UP 2U
+
+struct ldl_mac_cmd_desc {
+    
+    uint8_t down;   /**< payload size sent by the network */
+    uint8_t up;     /**< payload size sent by the device */
 };
 
-static uint8_t typeToTag(enum ldl_mac_cmd_type type);    
+/* static function prototypes *****************************************/
+
 static bool tagToType(uint8_t tag, enum ldl_mac_cmd_type *type);
+static void getDesc(enum ldl_mac_cmd_type type, struct ldl_mac_cmd_desc *desc);
+static uint8_t getCommand(const uint8_t *in, uint8_t len, struct ldl_downstream_cmd *cmd);
+static void putCommand(struct ldl_stream *s, enum ldl_mac_cmd_type type, const uint8_t *payload);
+static uint16_t getU16(const uint8_t *in);
+static uint32_t getU24(const uint8_t *in);
+static void getFields(const uint8_t *in, struct ldl_downstream_cmd *cmd);
+
 
-static const struct type_to_tag tags[] = {
-    {2U, LDL_CMD_LINK_CHECK},
-    {3U, LDL_CMD_LINK_ADR},
-    {4U, LDL_CMD_DUTY_CYCLE},
-    {5U, LDL_CMD_RX_PARAM_SETUP},
-    {6U, LDL_CMD_DEV_STATUS},
-    {7U, LDL_CMD_NEW_CHANNEL},
-    {8U, LDL_CMD_RX_TIMING_SETUP},
-    {9U, LDL_CMD_TX_PARAM_SETUP},
-    {10U, LDL_CMD_DL_CHANNEL},    
-    {11U, LDL_CMD_REKEY},
-    {12U, LDL_CMD_ADR_PARAM_SETUP},
-    {13U, LDL_CMD_DEVICE_TIME},
-    {14U, LDL_CMD_FORCE_REJOIN},
-    {15U, LDL_CMD_REJOIN_PARAM_SETUP}   
+/* indexed by type (which is CID - CID_FIRST) */
+static const struct ldl_mac_cmd_desc cmds[] PROGMEM = {
+    [LDL_CMD_LINK_CHECK] = {2U, 0U},
+    [LDL_CMD_LINK_ADR] = {4U, 1U},
+    [LDL_CMD_DUTY_CYCLE] = {1U, 0U},
+    [LDL_CMD_RX_PARAM_SETUP] = {4U, 1U},
+    [LDL_CMD_DEV_STATUS] = {0U, 2U},
+    [LDL_CMD_NEW_CHANNEL] = {5U, 1U},
+    [LDL_CMD_RX_TIMING_SETUP] = {1U, 0U},
+    [LDL_CMD_TX_PARAM_SETUP] = {1U, 0U},
+    [LDL_CMD_DL_CHANNEL] = {4U, 1U},
+    [LDL_CMD_REKEY] = {1U, 1U},
+    [LDL_CMD_ADR_PARAM_SETUP] = {1U, 0U},
+    [LDL_CMD_DEVICE_TIME] = {5U, 0U},
+    [LDL_CMD_FORCE_REJOIN] = {2U, NOT_SENT},
+    [LDL_CMD_REJOIN_PARAM_SETUP] = {1U, 1U},
+    [LDL_CMD_PING_SLOT_INFO] = {0U, 1U},
+    [LDL_CMD_PING_SLOT_CHANNEL] = {4U, 1U},
+    [LDL_CMD_BEACON_TIMING] = {3U, 0U},
+    [LDL_CMD_BEACON_FREQ] = {3U, 1U}
 };
 
 /* functions **********************************************************/
 
-bool LDL_MAC_peekNextCommand(struct ldl_stream *s, enum ldl_mac_cmd_type *type)
-{
-    uint8_t tag;
-    bool retval = false;
-    
-    if(LDL_Stream_peek(s, &tag)){
-        
-        retval = tagToType(tag, type);            
-    }
-    
-    return retval;
-}
-
 uint8_t LDL_MAC_sizeofCommandUp(enum ldl_mac_cmd_type type)
 {
+    struct ldl_mac_cmd_desc desc;
     uint8_t retval = 0U;
     
-    switch(type){        
-    case LDL_CMD_LINK_CHECK:
-    case LDL_CMD_DUTY_CYCLE:
-    case LDL_CMD_RX_TIMING_SETUP:
-    case LDL_CMD_TX_PARAM_SETUP:
-    case LDL_CMD_ADR_PARAM_SETUP:
-    case LDL_CMD_DEVICE_TIME:
-        retval = 1U;
-        break;
-    case LDL_CMD_LINK_ADR:
-    case LDL_CMD_RX_PARAM_SETUP:
-    case LDL_CMD_NEW_CHANNEL:
-    case LDL_CMD_DL_CHANNEL:
-    case LDL_CMD_REKEY:
-    case LDL_CMD_REJOIN_PARAM_SETUP:
-        retval = 2U;
-        break;        
-    case LDL_CMD_DEV_STATUS:
-    case LDL_CMD_FORCE_REJOIN:
-        retval = 3U;
-        break;    
-    default:      
-        break;
+    if((size_t)type < (sizeof(cmds)/sizeof(*cmds))){
+        
+        getDesc(type, &desc);
+        
+        if(desc.up != NOT_SENT){
+            
+            retval = 1U + desc.up;
+        }
     }
     
     return retval;
@@ -98,7 +112,7 @@ uint8_t LDL_MAC_sizeofCommandUp(enum ldl_mac_cmd_type type)
 
 void LDL_MAC_putLinkCheckReq(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_LINK_CHECK));
+    putCommand(s, LDL_CMD_LINK_CHECK, NULL);
 }
 
 void LDL_MAC_putLinkADRAns(struct ldl_stream *s, const struct ldl_link_adr_ans *value)
@@ -107,13 +121,12 @@ void LDL_MAC_putLinkADRAns(struct ldl_stream *s, const struct ldl_link_adr_ans *
     
     buf = (value->powerOK ? 4U : 0U) | (value->dataRateOK ? 2U : 0U) | (value->channelMaskOK ? 1U : 0U);
     
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_LINK_ADR));        
-    (void)LDL_Stream_putU8(s, buf);
+    putCommand(s, LDL_CMD_LINK_ADR, &buf);
 }
 
 void LDL_MAC_putDutyCycleAns(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_DUTY_CYCLE));
+    putCommand(s, LDL_CMD_DUTY_CYCLE, NULL);
 }
 
 void LDL_MAC_putRXParamSetupAns(struct ldl_stream *s, const struct ldl_rx_param_setup_ans *value)
@@ -122,15 +135,17 @@ void LDL_MAC_putRXParamSetupAns(struct ldl_stream *s, const struct ldl_rx_param_
     
     buf = (value->rx1DROffsetOK ? 4U : 0U) | (value->rx2DataRateOK ? 2U : 0U) | (value->channelOK ? 1U : 0U);
     
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_RX_PARAM_SETUP));
-    (void)LDL_Stream_putU8(s, buf);
+    putCommand(s, LDL_CMD_RX_PARAM_SETUP, &buf);
 }
 
 void LDL_MAC_putDevStatusAns(struct ldl_stream *s, const struct ldl_dev_status_ans *value)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_DEV_STATUS));
-    (void)LDL_Stream_putU8(s, value->battery);
-    (void)LDL_Stream_putU8(s, ((uint8_t)value->margin) & 0x3fU);           
+    uint8_t buf[2U];
+    
+    buf[0] = value->battery;
+    buf[1] = ((uint8_t)value->margin) & 0x3fU;
+    
+    putCommand(s, LDL_CMD_DEV_STATUS, buf);
 }
 
 void LDL_MAC_putNewChannelAns(struct ldl_stream *s, const struct ldl_new_channel_ans *value)
@@ -139,221 +154,285 @@ void LDL_MAC_putNewChannelAns(struct ldl_stream *s, const struct ldl_new_channel
     
     buf = (value->dataRateRangeOK ? 2U : 0U) | (value->channelFreqOK ? 1U : 0U);
     
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_NEW_CHANNEL));
-    (void)LDL_Stream_putU8(s, buf);           
+    putCommand(s, LDL_CMD_NEW_CHANNEL, &buf);
 }
 
-
 void LDL_MAC_putDLChannelAns(struct ldl_stream *s, const struct ldl_dl_channel_ans *value)
 {
     uint8_t buf;
     
     buf = (value->uplinkFreqOK ? 2U : 0U) | (value->channelFreqOK ? 1U : 0U);
     
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_DL_CHANNEL));
-    (void)LDL_Stream_putU8(s, buf);    
+    putCommand(s, LDL_CMD_DL_CHANNEL, &buf);
 }
 
 void LDL_MAC_putRXTimingSetupAns(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_RX_TIMING_SETUP));
+    putCommand(s, LDL_CMD_RX_TIMING_SETUP, NULL);
 }
 
 void LDL_MAC_putTXParamSetupAns(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_TX_PARAM_SETUP));
+    putCommand(s, LDL_CMD_TX_PARAM_SETUP, NULL);
 }
 
 void LDL_MAC_putRekeyInd(struct ldl_stream *s, const struct ldl_rekey_ind *value)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_REKEY));
-    (void)LDL_Stream_putU8(s, value->version);
+    putCommand(s, LDL_CMD_REKEY, &value->version);
 }
 
 void LDL_MAC_putADRParamSetupAns(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_ADR_PARAM_SETUP));
+    putCommand(s, LDL_CMD_ADR_PARAM_SETUP, NULL);
 }
 
 void LDL_MAC_putDeviceTimeReq(struct ldl_stream *s)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_DEVICE_TIME));
+    putCommand(s, LDL_CMD_DEVICE_TIME, NULL);
 }
 
 void LDL_MAC_putRejoinParamSetupAns(struct ldl_stream *s, struct ldl_rejoin_param_setup_ans *value)
 {
-    (void)LDL_Stream_putU8(s, typeToTag(LDL_CMD_REJOIN_PARAM_SETUP));
-    (void)LDL_Stream_putU8(s, value->timeOK);
+    putCommand(s, LDL_CMD_REJOIN_PARAM_SETUP, &value->timeOK);
+}
+
+void LDL_MAC_putPingSlotInfoReq(struct ldl_stream *s, uint8_t periodicity)
+{
+    uint8_t buf;
+    
+    buf = periodicity & 0x7U;
+    
+    putCommand(s, LDL_CMD_PING_SLOT_INFO, &buf);
 }
 
 bool LDL_MAC_getDownCommand(struct ldl_stream *s, struct ldl_downstream_cmd *cmd)
 {
-    uint8_t tag;
-    bool retval = false;
+    uint8_t buf[1U + MAX_DOWN];
+    uint8_t pos;
+    uint8_t len;
+    uint8_t size = 0U;
+    
+    pos = LDL_Stream_tell(s);
+    len = LDL_Stream_remaining(s);
+    len = (len < sizeof(buf)) ? len : (uint8_t)sizeof(buf);
     
-    if(LDL_Stream_getU8(s, &tag)){
+    /* read ahead and then seek to the end of the command */
+    if(LDL_Stream_read(s, buf, len)){
         
-        retval = tagToType(tag, &cmd->type);
+        size = getCommand(buf, len, cmd);
+    }
+    
+    (void)LDL_Stream_seekSet(s, pos + size);
+    
+    return (size > 0U);
+}
+
+uint8_t LDL_MAC_getDownCommands(const uint8_t *in, uint8_t len, struct ldl_downstream_cmd *cmd, uint8_t max)
+{
+    uint8_t pos = 0U;
+    uint8_t size;
+    uint8_t retval = 0U;
+    
+    while(retval < max){
         
-        if(retval){
-            
-            switch(cmd->type){
-            default:
-                /* impossible */
-                break;
-                
-            case LDL_CMD_LINK_CHECK:
-                
-                (void)LDL_Stream_getU8(s, &cmd->fields.linkCheck.margin);
-                (void)LDL_Stream_getU8(s, &cmd->fields.linkCheck.gwCount);    
-                break;
-                
-            case LDL_CMD_LINK_ADR:                    
-            {
-                uint8_t buf;
-                
-                (void)LDL_Stream_getU8(s, &buf);
-                
-                cmd->fields.linkADR.dataRate = buf >> 4;
-                cmd->fields.linkADR.txPower = buf & 0xfU;
-                
-                (void)LDL_Stream_getU16(s, &cmd->fields.linkADR.channelMask);
-                        
-                (void)LDL_Stream_getU8(s, &buf);
-                        
-                cmd->fields.linkADR.channelMaskControl = (buf >> 4) & 0x7U;
-                cmd->fields.linkADR.nbTrans = buf & 0xfU;
-            }
-                break;
-            
-            case LDL_CMD_DUTY_CYCLE:                
-            
-                (void)LDL_Stream_getU8(s, &cmd->fields.dutyCycle.maxDutyCycle);
-                cmd->fields.dutyCycle.maxDutyCycle &= 0xfU;             
-                break;
-            
-            case LDL_CMD_RX_PARAM_SETUP:
-            
-                (void)LDL_Stream_getU8(s, &cmd->fields.rxParamSetup.rx1DROffset);
-                (void)LDL_Stream_getU24(s, &cmd->fields.rxParamSetup.freq);                 
-                break;
-            
-            case LDL_CMD_DEV_STATUS:
-            
-                // no args
-                break;
-            
-            case LDL_CMD_NEW_CHANNEL:
-            {
-                uint8_t buf;
-    
-                (void)LDL_Stream_getU8(s, &cmd->fields.newChannel.chIndex);        
-                (void)LDL_Stream_getU24(s, &cmd->fields.newChannel.freq);
-                (void)LDL_Stream_getU8(s, &buf);
-
-                cmd->fields.newChannel.maxDR = buf >> 4;
-                cmd->fields.newChannel.minDR = buf & 0xfU;           
-            }
-                break;
-                
-            case LDL_CMD_DL_CHANNEL:
-            
-                (void)LDL_Stream_getU8(s, &cmd->fields.dlChannel.chIndex);
-                (void)LDL_Stream_getU24(s, &cmd->fields.dlChannel.freq);     
-                break;
-            
-            case LDL_CMD_RX_TIMING_SETUP:
-            
-                (void)LDL_Stream_getU8(s, &cmd->fields.rxTimingSetup.delay);
-                cmd->fields.rxTimingSetup.delay &= 0xfU;   
-                break;
-            
-            case LDL_CMD_TX_PARAM_SETUP:
-            {
-                uint8_t buf;
-                
-                (void)LDL_Stream_getU8(s, &buf);
-                
-                cmd->fields.txParamSetup.downlinkDwell = ((buf & 0x20U) == 0x20U); 
-                cmd->fields.txParamSetup.uplinkDwell = ((buf & 0x10U) == 0x10U); 
-                cmd->fields.txParamSetup.maxEIRP = buf & 0xfU; 
-            }
-                break;
-            
-            case LDL_CMD_REKEY:
-            
-                (void)LDL_Stream_getU8(s, &cmd->fields.rekey.version);
-                cmd->fields.rekey.version &= 0xfU; 
-                break;
-            
-            case LDL_CMD_ADR_PARAM_SETUP:
-            {
-                uint8_t buf;
-                
-                (void)LDL_Stream_getU8(s, &buf);
-    
-                cmd->fields.adrParamSetup.limit_exp = buf >> 4;
-                cmd->fields.adrParamSetup.delay_exp = buf & 0xfU;
-            }
-                break;
-            
-            case LDL_CMD_DEVICE_TIME:
-            
-                (void)LDL_Stream_getU32(s, &cmd->fields.deviceTime.seconds);
-                (void)LDL_Stream_getU8(s, &cmd->fields.deviceTime.fractions);
-                break;
-            
-            case LDL_CMD_FORCE_REJOIN:
-            {
-                uint16_t buf;
-    
-                (void)LDL_Stream_getU16(s, &buf);
-                
-                cmd->fields.forceRejoin.period = (buf >> 10) & 0x7U;
-                cmd->fields.forceRejoin.max_retries = (buf >> 7) & 0x7U;
-                cmd->fields.forceRejoin.rejoin_type = (buf >> 4) & 0x7U;
-                cmd->fields.forceRejoin.dr = buf & 0xfU;
-            }
-                break;
+        size = getCommand(&in[pos], (uint8_t)(len - pos), &cmd[retval]);
+        
+        if(size == 0U){
             
-            case LDL_CMD_REJOIN_PARAM_SETUP:
-            {
-                uint8_t buf;
-    
-                (void)LDL_Stream_getU8(s, &buf);
-                
-                cmd->fields.rejoinParamSetup.maxTimeN = buf >> 4;
-                cmd->fields.rejoinParamSetup.maxCountN = buf & 0xfU;
-            }
-                break;
-            }
+            break;
         }
+        
+        pos += size;
+        retval++;
     }
     
-    return LDL_Stream_error(s) ? false : retval;
+    return retval;
 }
 
 /* static functions ***************************************************/
 
-static uint8_t typeToTag(enum ldl_mac_cmd_type type)
+static bool tagToType(uint8_t tag, enum ldl_mac_cmd_type *type)
 {
-    return tags[type].tag;
+    bool retval = false;
+    
+    if((tag >= CID_FIRST) && ((tag - CID_FIRST) < (sizeof(cmds)/sizeof(*cmds)))){
+        
+        *type = (enum ldl_mac_cmd_type)(tag - CID_FIRST);
+        retval = true;
+    }
+    
+    return retval;
 }
 
-static bool tagToType(uint8_t tag, enum ldl_mac_cmd_type *type)
+static void getDesc(enum ldl_mac_cmd_type type, struct ldl_mac_cmd_desc *desc)
 {
-    bool retval = false;
-    uint8_t i;
+    (void)memcpy_P(desc, &cmds[type], sizeof(*desc));
+}
+
+static uint8_t getCommand(const uint8_t *in, uint8_t len, struct ldl_downstream_cmd *cmd)
+{
+    struct ldl_mac_cmd_desc desc;
+    enum ldl_mac_cmd_type type;
+    uint8_t retval = 0U;
     
-    for(i=0U; i < (sizeof(tags)/sizeof(*tags)); i++){
+    if((len > 0U) && tagToType(in[0], &type)){
+        
+        getDesc(type, &desc);
         
-        if(tags[i].tag == tag){
+        if(desc.down < len){
             
-            *type = tags[i].type;
-            retval = true;
-            break;
+            cmd->type = type;
+            
+            getFields(&in[1], cmd);
+            
+            retval = 1U + desc.down;
         }
     }
     
     return retval;
 }
+
+static void putCommand(struct ldl_stream *s, enum ldl_mac_cmd_type type, const uint8_t *payload)
+{
+    uint8_t buf[1U + MAX_UP];
+    struct ldl_mac_cmd_desc desc;
+    
+    getDesc(type, &desc);
+    
+    LDL_PEDANTIC(desc.up <= MAX_UP)
+    
+    buf[0] = CID_FIRST + (uint8_t)type;
+    
+    if(desc.up > 0U){
+        
+        (void)memcpy(&buf[1], payload, desc.up);
+    }
+    
+    (void)LDL_Stream_write(s, buf, 1U + desc.up);
+}
+
+static uint16_t getU16(const uint8_t *in)
+{
+    return ((uint16_t)in[1] << 8) | in[0];
+}
+
+static uint32_t getU24(const uint8_t *in)
+{
+    return ((uint32_t)in[2] << 16) | ((uint32_t)in[1] << 8) | in[0];
+}
+
+static void getFields(const uint8_t *in, struct ldl_downstream_cmd *cmd)
+{
+    switch(cmd->type){
+    default:
+    case LDL_CMD_DEV_STATUS:
+    case LDL_CMD_PING_SLOT_INFO:
+        /* no payload */
+        break;
+    
+    case LDL_CMD_LINK_CHECK:
+    
+        cmd->fields.linkCheck.margin = in[0];
+        cmd->fields.linkCheck.gwCount = in[1];
+        break;
+    
+    case LDL_CMD_LINK_ADR:
+    
+        cmd->fields.linkADR.dataRate = in[0] >> 4;
+        cmd->fields.linkADR.txPower = in[0] & 0xfU;
+        cmd->fields.linkADR.channelMask = getU16(&in[1]);
+        cmd->fields.linkADR.channelMaskControl = (in[3] >> 4) & 0x7U;
+        cmd->fields.linkADR.nbTrans = in[3] & 0xfU;
+        break;
+    
+    case LDL_CMD_DUTY_CYCLE:
+    
+        cmd->fields.dutyCycle.maxDutyCycle = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_RX_PARAM_SETUP:
+    
+        cmd->fields.rxParamSetup.rx1DROffset = (in[0] >> 4) & 0x7U;
+        cmd->fields.rxParamSetup.rx2DataRate = in[0] & 0xfU;
+        cmd->fields.rxParamSetup.freq = getU24(&in[1]);
+        break;
+    
+    case LDL_CMD_NEW_CHANNEL:
+    
+        cmd->fields.newChannel.chIndex = in[0];
+        cmd->fields.newChannel.freq = getU24(&in[1]);
+        cmd->fields.newChannel.maxDR = in[4] >> 4;
+        cmd->fields.newChannel.minDR = in[4] & 0xfU;
+        break;
+    
+    case LDL_CMD_RX_TIMING_SETUP:
+    
+        cmd->fields.rxTimingSetup.delay = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_TX_PARAM_SETUP:
+    
+        cmd->fields.txParamSetup.downlinkDwell = ((in[0] & 0x20U) == 0x20U);
+        cmd->fields.txParamSetup.uplinkDwell = ((in[0] & 0x10U) == 0x10U);
+        cmd->fields.txParamSetup.maxEIRP = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_DL_CHANNEL:
+    
+        cmd->fields.dlChannel.chIndex = in[0];
+        cmd->fields.dlChannel.freq = getU24(&in[1]);
+        break;
+    
+    case LDL_CMD_REKEY:
+    
+        cmd->fields.rekey.version = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_ADR_PARAM_SETUP:
+    
+        cmd->fields.adrParamSetup.limit_exp = in[0] >> 4;
+        cmd->fields.adrParamSetup.delay_exp = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_DEVICE_TIME:
+    
+        cmd->fields.deviceTime.seconds = ((uint32_t)in[3] << 24) | getU24(in);
+        cmd->fields.deviceTime.fractions = in[4];
+        break;
+    
+    case LDL_CMD_FORCE_REJOIN:
+    
+    {
+        uint16_t buf = getU16(in);
+        
+        cmd->fields.forceRejoin.period = (buf >> 10) & 0x7U;
+        cmd->fields.forceRejoin.max_retries = (buf >> 7) & 0x7U;
+        cmd->fields.forceRejoin.rejoin_type = (buf >> 4) & 0x7U;
+        cmd->fields.forceRejoin.dr = buf & 0xfU;
+    }
+        break;
+    
+    case LDL_CMD_REJOIN_PARAM_SETUP:
+    
+        cmd->fields.rejoinParamSetup.maxTimeN = in[0] >> 4;
+        cmd->fields.rejoinParamSetup.maxCountN = in[0] & 0xfU;
+        break;
+    
+    case LDL_CMD_PING_SLOT_CHANNEL:
+    
+        cmd->fields.pingSlotChannel.freq = getU24(in);
+        cmd->fields.pingSlotChannel.dataRate = in[3] & 0xfU;
+        break;
+    
+    case LDL_CMD_BEACON_TIMING:
+    
+        cmd->fields.beaconTiming.delay = getU16(in);
+        cmd->fields.beaconTiming.channel = in[2];
+        break;
+    
+    case LDL_CMD_BEACON_FREQ:
+    
+        cmd->fields.beaconFreq.freq = getU24(in);
+        break;
+    }
+}
@@ -25,6 +25,9 @@
 #include "ldl_system.h"
 #include "ldl_frame.h"
 #include "ldl_debug.h"
+#ifdef LDL_ENABLE_CLASS_B
+#include "ldl_aes.h"
+#endif
 #include <string.h>
 
 struct ldl_block {
@@ -38,6 +41,10 @@ static void initA(struct ldl_block *a, uint32_t devAddr, bool up, uint32_t count
 static void initB(struct ldl_block *b, uint16_t confirmCounter, uint8_t rate, uint8_t chIndex, bool up, uint32_t devAddr, uint32_t upCounter, uint8_t len);
 
 static uint32_t deriveDownCounter(struct ldl_mac *self, uint8_t port, uint16_t counter);
+#ifdef LDL_ENABLE_UPLINK_VERIFY
+static uint32_t deriveUpCounter(uint32_t last, uint16_t counter);
+static enum ldl_ops_uplink_result receiveUplink(const struct ldl_ops_session *session, struct ldl_ops_uplink *u);
+#endif
 
 static uint8_t putU8(uint8_t *buf, uint8_t value);
 static uint8_t putU16(uint8_t *buf, uint16_t value);
@@ -65,6 +72,29 @@ void LDL_OPS_syncDownCounter(struct ldl_mac *self, uint8_t port, uint16_t counte
     }    
 }
          
+#ifdef LDL_ENABLE_CLASS_B
+uint16_t LDL_OPS_pingOffset(uint32_t beaconTime, uint32_t devAddr, uint16_t period)
+{
+    LDL_PEDANTIC(period > 0U)
+    
+    struct ldl_aes_ctx ctx;
+    struct ldl_block rand;
+    uint8_t pos = 0U;
+    
+    /* the key is sixteen zeros so the security module is not needed */
+    (void)memset(rand.value, 0, sizeof(rand.value));
+    
+    LDL_AES_init(&ctx, rand.value);
+    
+    pos += putU32(&rand.value[pos], beaconTime);
+    pos += putU32(&rand.value[pos], devAddr);
+    
+    LDL_AES_encrypt(&ctx, rand.value);
+    
+    return (uint16_t)(((uint16_t)rand.value[0] + ((uint16_t)rand.value[1] << 8)) % period);
+}
+#endif
+
 void LDL_OPS_deriveKeys(struct ldl_mac *self)
 {
     LDL_PEDANTIC(self != NULL)
@@ -220,13 +250,17 @@ bool LDL_OPS_receiveFrame(struct ldl_mac *self, struct ldl_frame_down *f, uint8_
 {
     bool retval;
     uint32_t mic;
+    enum ldl_frame_type type;
         
     retval = false;
     
-    if(LDL_Frame_decode(f, in, len)){
+    /* the frame is decoded once it is known to be wanted (and decrypted) */
+    if(LDL_Frame_peek(in, len, &type)){
         
-        switch(f->type){
+        switch(type){
         default:
+        
+            LDL_DEBUG(self->app, "unexpected frame type")
             break;
         
         case FRAME_TYPE_JOIN_ACCEPT:
@@ -244,49 +278,32 @@ bool LDL_OPS_receiveFrame(struct ldl_mac *self, struct ldl_frame_down *f, uint8_
                     LDL_SM_ecb(self->sm, key, &in[LDL_Frame_sizeofJoinAccept(false)]);
                 }
                 
-                if(LDL_Frame_decode(f, in, len)){
+                /* size has been checked and is not changed by decryption */
+                (void)LDL_Frame_decode(f, in, len);
+                
+                if(f->optNeg){
+                    
+                    if(f->joinNonce >= self->joinNonce){
                     
-                    if(f->optNeg){
+                        struct ldl_block hdr;
+                        uint8_t pos;
                         
-                        if(f->joinNonce >= self->joinNonce){
+                        pos = 0U;
                         
-                            struct ldl_block hdr;
-                            uint8_t pos;
-                            
-                            pos = 0U;
-                            
-                            switch(self->op){
-                            default:
-                            case LDL_OP_JOINING:
-                                pos += putU8(&hdr.value[pos], 0xffU);
-                                break;
-                            case LDL_OP_REJOINING:                        
-                                pos += putU8(&hdr.value[pos], 2U);
-                                break;
-                            }
-                            
-                            pos += putEUI(&hdr.value[pos], self->joinEUI);
-                            pos += putU16(&hdr.value[pos], self->devNonce);
-                            
-                            mic = LDL_SM_mic(self->sm, LDL_SM_KEY_JSINT, &hdr, pos, in, len-sizeof(mic));
-                            
-                            if(f->mic == mic){
-                            
-                                retval = true;                    
-                            }
-                            else{
-                                
-                                LDL_DEBUG(self->app, "joinAccept MIC failed")
-                            }                           
-                        }
-                        else{
-                            
-                            LDL_DEBUG(self->app, "invalid joinNonce")
+                        switch(self->op){
+                        default:
+                        case LDL_OP_JOINING:
+                            pos += putU8(&hdr.value[pos], 0xffU);
+                            break;
+                        case LDL_OP_REJOINING:                        
+                            pos += putU8(&hdr.value[pos], 2U);
+                            break;
                         }
-                    }
-                    else{
                         
-                        mic = LDL_SM_mic(self->sm, LDL_SM_KEY_NWK, NULL, 0U, in, len-sizeof(mic));                        
+                        pos += putEUI(&hdr.value[pos], self->joinEUI);
+                        pos += putU16(&hdr.value[pos], self->devNonce);
+                        
+                        mic = LDL_SM_mic(self->sm, LDL_SM_KEY_JSINT, &hdr, pos, in, len-sizeof(mic));
                         
                         if(f->mic == mic){
                         
@@ -295,9 +312,26 @@ bool LDL_OPS_receiveFrame(struct ldl_mac *self, struct ldl_frame_down *f, uint8_
                         else{
                             
                             LDL_DEBUG(self->app, "joinAccept MIC failed")
-                        }   
-                    }                     
-                }                                
+                        }                           
+                    }
+                    else{
+                        
+                        LDL_DEBUG(self->app, "invalid joinNonce")
+                    }
+                }
+                else{
+                    
+                    mic = LDL_SM_mic(self->sm, LDL_SM_KEY_NWK, NULL, 0U, in, len-sizeof(mic));                        
+                    
+                    if(f->mic == mic){
+                    
+                        retval = true;                    
+                    }
+                    else{
+                        
+                        LDL_DEBUG(self->app, "joinAccept MIC failed")
+                    }   
+                }                     
             }
             else{
                 
@@ -308,12 +342,22 @@ bool LDL_OPS_receiveFrame(struct ldl_mac *self, struct ldl_frame_down *f, uint8_
         case FRAME_TYPE_DATA_UNCONFIRMED_DOWN:
         case FRAME_TYPE_DATA_CONFIRMED_DOWN:
         
+            (void)LDL_Frame_decode(f, in, len);
+            
             if(
                 ((self->ctx.version > 0) && (self->op == LDL_OP_REJOINING))
                 ||
                 (self->op  == LDL_OP_DATA_UNCONFIRMED)
                 ||
                 (self->op == LDL_OP_DATA_CONFIRMED)
+#ifdef LDL_ENABLE_CLASS_C
+                ||
+                (self->state == LDL_STATE_RXC)
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+                ||
+                (self->state == LDL_STATE_PING)
+#endif
             ){
             
                 if(self->ctx.devAddr == f->devAddr){
@@ -378,6 +422,55 @@ bool LDL_OPS_receiveFrame(struct ldl_mac *self, struct ldl_frame_down *f, uint8_
     return retval;
 }
 
+#ifdef LDL_ENABLE_UPLINK_VERIFY
+uint32_t LDL_OPS_receiveUplinks(struct ldl_ops_uplink *batch, uint32_t n, ldl_ops_session_fn lookup, void *receiver)
+{
+    LDL_PEDANTIC((batch != NULL) || (n == 0U))
+    LDL_PEDANTIC(lookup != NULL)
+    
+    struct ldl_ops_session session;
+    bool cached = false;
+    bool known = false;
+    uint32_t devAddr = 0U;
+    uint32_t retval = 0U;
+    uint32_t i;
+    
+    for(i=0U; i < n; i++){
+        
+        if(LDL_Frame_decodeUp(&batch[i].f, batch[i].in, batch[i].len)){
+            
+            if(!cached || (batch[i].f.devAddr != devAddr)){
+                
+                devAddr = batch[i].f.devAddr;
+                known = lookup(receiver, devAddr, &session);
+                cached = true;
+            }
+            
+            if(known){
+                
+                batch[i].result = receiveUplink(&session, &batch[i]);
+                
+                if(batch[i].result == LDL_OPS_UPLINK_OK){
+                    
+                    session.up = batch[i].counter;
+                    retval++;
+                }
+            }
+            else{
+                
+                batch[i].result = LDL_OPS_UPLINK_UNKNOWN;
+            }
+        }
+        else{
+            
+            batch[i].result = LDL_OPS_UPLINK_INVALID;
+        }
+    }
+    
+    return retval;
+}
+#endif
+
 /* static functions ***************************************************/
 
 static void initA(struct ldl_block *a, uint32_t devAddr, bool up, uint32_t counter, uint8_t i)
@@ -428,6 +521,73 @@ static uint32_t deriveDownCounter(struct ldl_mac *self, uint8_t port, uint16_t c
     return mine;
 }
 
+#ifdef LDL_ENABLE_UPLINK_VERIFY
+static uint32_t deriveUpCounter(uint32_t last, uint16_t counter)
+{
+    uint32_t retval = (last & 0xffff0000UL) | (uint32_t)counter;
+    
+    if(retval < last){
+        
+        retval += 0x10000UL;
+    }
+    
+    return retval;
+}
+
+static enum ldl_ops_uplink_result receiveUplink(const struct ldl_ops_session *session, struct ldl_ops_uplink *u)
+{
+    enum ldl_ops_uplink_result retval;
+    struct ldl_frame_up *f = &u->f;
+    struct ldl_block B;
+    struct ldl_block A;
+    uint32_t micF;
+    uint32_t micS;
+    uint32_t mic;
+    
+    u->counter = deriveUpCounter(session->up, f->counter);
+    
+    initB(&B, 0U, 0U, 0U, true, f->devAddr, u->counter, u->len - sizeof(mic));
+    
+    micF = LDL_SM_mic(session->sm, LDL_SM_KEY_FNWKSINT, &B, sizeof(B.value), u->in, u->len - sizeof(mic));
+    
+    if(session->version == 1U){
+        
+        initB(&B, 0U, u->rate, u->chIndex, true, f->devAddr, u->counter, u->len - sizeof(mic));
+        
+        micS = LDL_SM_mic(session->sm, LDL_SM_KEY_SNWKSINT, &B, sizeof(B.value), u->in, u->len - sizeof(mic));
+        
+        mic = (micF << 16) | (micS & 0xffffUL);
+    }
+    else{
+        
+        mic = micF;
+    }
+    
+    if(mic == f->mic){
+        
+        /* V1.1 encrypts the opts */
+        if(session->version == 1U){
+            
+            initA(&A, f->devAddr, true, u->counter, 0U);
+            
+            LDL_SM_ctr(session->sm, LDL_SM_KEY_NWKSENC, &A, f->opts, f->optsLen);
+        }
+        
+        initA(&A, f->devAddr, true, u->counter, 1U);
+        
+        LDL_SM_ctr(session->sm, (f->port == 0U) ? LDL_SM_KEY_NWKSENC : LDL_SM_KEY_APPS, &A, f->data, f->dataLen);
+        
+        retval = LDL_OPS_UPLINK_OK;
+    }
+    else{
+        
+        retval = LDL_OPS_UPLINK_MIC;
+    }
+    
+    return retval;
+}
+#endif
+
 static uint8_t putEUI(uint8_t *buf, const uint8_t *value)
 {
     buf[0] = value[7];
@@ -25,9 +25,11 @@
 #include "ldl_radio.h"
 #include "ldl_chip.h"
 #include "ldl_platform.h"
+#include "ldl_system.h"
 
-#if defined(LDL_ENABLE_SX1272) || defined(LDL_ENABLE_SX1276)
+#if defined(LDL_ENABLE_SX127X) || defined(LDL_ENABLE_SX126X)
 
+#ifdef LDL_ENABLE_SX127X
 enum ldl_radio_sx1272_register {
     RegFifo=0x00,
     RegOpMode=0x01,
@@ -140,38 +142,583 @@ enum ldl_radio_sx1272_register {
     RegBitRateFrac=0x70
 };
 
+#ifdef LDL_ENABLE_FSK
+/* FSK packet engine FIFO (bytes) */
+enum {
+    FifoSize = 64,
+    FifoThreshold = 31
+};
+#endif
+#endif
+
+#ifdef LDL_ENABLE_SX126X
+enum ldl_radio_sx126x_opcode {
+    SetSleep=0x84,
+    SetStandby=0x80,
+    SetTx=0x83,
+    SetRx=0x82,
+    SetCad=0xC5,
+    SetRegulatorMode=0x96,
+    Calibrate=0x89,
+    CalibrateImage=0x98,
+    SetPaConfig=0x95,
+    WriteRegister=0x0D,
+    WriteBuffer=0x0E,
+    ReadBuffer=0x1E,
+    SetDioIrqParams=0x08,
+    GetIrqStatus=0x12,
+    ClearIrqStatus=0x02,
+    SetDIO2AsRfSwitchCtrl=0x9D,
+    SetDIO3AsTcxoCtrl=0x97,
+    SetRfFrequency=0x86,
+    SetPacketType=0x8A,
+    SetTxParams=0x8E,
+    SetModulationParams=0x8B,
+    SetPacketParams=0x8C,
+    SetCadParams=0x88,
+    SetBufferBaseAddress=0x8F,
+    SetLoRaSymbNumTimeout=0xA0,
+    GetRssiInst=0x15,
+    GetRxBufferStatus=0x13,
+    GetPacketStatus=0x14
+};
+
+enum ldl_radio_sx126x_irq {
+    IrqTxDone=0x0001,
+    IrqRxDone=0x0002,
+    IrqHeaderErr=0x0020,
+    IrqCrcErr=0x0040,
+    IrqCadDone=0x0080,
+    IrqCadDetected=0x0100,
+    IrqTimeout=0x0200
+};
+
+/* Configuration commands remembered in cmd_shadow
+ * 
+ * The slot is also the bit in shadow_valid. A command is only sent 
+ * if its parameters differ from those last sent.
+ * 
+ * */
+enum ldl_radio_sx126x_slot {
+    SlotRegulatorMode,
+    SlotTcxo,
+    SlotRfSwitch,
+    SlotPacketType,
+    SlotBufferBaseAddress,
+    SlotSyncWord,
+    SlotCalibrateImage,
+    SlotRfFrequency,
+    SlotModulationParams,
+    SlotPacketParams,
+    SlotIQ,
+    SlotDioIrqParams,
+    SlotTxParams,
+    SlotPaConfig,
+    SlotSymbNumTimeout,
+    SlotCadParams
+};
+
+struct ldl_radio_sx126x_command {
+    
+    uint8_t opcode;
+    uint8_t offset;     /* of parameters in cmd_shadow */
+    uint8_t size;       /* of parameters */
+};
+
+static const struct ldl_radio_sx126x_command sx126x_command[] = {
+    {SetRegulatorMode, 0U, 1U},
+    {SetDIO3AsTcxoCtrl, 1U, 4U},
+    {SetDIO2AsRfSwitchCtrl, 5U, 1U},
+    {SetPacketType, 6U, 1U},
+    {SetBufferBaseAddress, 7U, 2U},
+    {WriteRegister, 9U, 4U},            /* 0x0740 LoRa sync word */
+    {CalibrateImage, 13U, 2U},
+    {SetRfFrequency, 15U, 4U},
+    {SetModulationParams, 19U, 4U},
+    {SetPacketParams, 23U, 6U},
+    {WriteRegister, 29U, 3U},           /* 0x0736 IQ polarity */
+    {SetDioIrqParams, 32U, 8U},
+    {SetTxParams, 40U, 2U},
+    {SetPaConfig, 42U, 4U},
+    {SetLoRaSymbNumTimeout, 46U, 1U},
+    {SetCadParams, 47U, 7U}
+};
+
+/* rx_status after collectBeginSX126X() (each read starts with the chip status) */
+enum {
+    RxIrqStatus = 0,
+    RxBufferStatus = 3,
+    RxPacketStatus = 6,
+    RxHead = 10             /* offset, NOP, then the first two bytes of the frame */
+};
+#endif
+
+#ifdef LDL_ENABLE_RADIO_ENERGY
+
+/* typical values from the datasheets (LNA boost on, 868MHz band, sleep rounded up to 1uA) */
+
+#ifdef LDL_ENABLE_SX1272
+static const struct ldl_radio_tx_current sx1272_rfo[] = {
+    {7, 18000UL},
+    {13, 28000UL}
+};
+
+static const struct ldl_radio_tx_current sx1272_boost[] = {
+    {17, 90000UL},
+    {20, 125000UL}
+};
+
+static const struct ldl_radio_current_table sx1272_current = {
+    .sleep = 1UL,
+    .standby = 1400UL,
+    .rx = 11200UL,
+    .rfo = sx1272_rfo,
+    .rfoLen = sizeof(sx1272_rfo)/sizeof(*sx1272_rfo),
+    .boost = sx1272_boost,
+    .boostLen = sizeof(sx1272_boost)/sizeof(*sx1272_boost)
+};
+#endif
+
+#ifdef LDL_ENABLE_SX1276
+static const struct ldl_radio_tx_current sx1276_rfo[] = {
+    {7, 20000UL},
+    {13, 29000UL}
+};
+
+static const struct ldl_radio_tx_current sx1276_boost[] = {
+    {17, 87000UL},
+    {20, 120000UL}
+};
+
+static const struct ldl_radio_current_table sx1276_current = {
+    .sleep = 1UL,
+    .standby = 1600UL,
+    .rx = 11500UL,
+    .rfo = sx1276_rfo,
+    .rfoLen = sizeof(sx1276_rfo)/sizeof(*sx1276_rfo),
+    .boost = sx1276_boost,
+    .boostLen = sizeof(sx1276_boost)/sizeof(*sx1276_boost)
+};
+#endif
+
+/* SX126x typical values (DC-DC regulator, 868MHz band, warm start sleep 
+ * rounded up to 2uA) with the same table for either PA setting */
+
+#ifdef LDL_ENABLE_SX1261
+static const struct ldl_radio_tx_current sx1261_tx[] = {
+    {14, 25500UL},
+    {15, 32700UL}
+};
+
+static const struct ldl_radio_current_table sx1261_current = {
+    .sleep = 2UL,
+    .standby = 600UL,
+    .rx = 4600UL,
+    .rfo = sx1261_tx,
+    .rfoLen = sizeof(sx1261_tx)/sizeof(*sx1261_tx),
+    .boost = sx1261_tx,
+    .boostLen = sizeof(sx1261_tx)/sizeof(*sx1261_tx)
+};
+#endif
+
+#ifdef LDL_ENABLE_SX1262
+static const struct ldl_radio_tx_current sx1262_tx[] = {
+    {14, 45000UL},
+    {17, 58000UL},
+    {22, 118000UL}
+};
+
+static const struct ldl_radio_current_table sx1262_current = {
+    .sleep = 2UL,
+    .standby = 600UL,
+    .rx = 4600UL,
+    .rfo = sx1262_tx,
+    .rfoLen = sizeof(sx1262_tx)/sizeof(*sx1262_tx),
+    .boost = sx1262_tx,
+    .boostLen = sizeof(sx1262_tx)/sizeof(*sx1262_tx)
+};
+#endif
+
+#endif
+
+#ifdef LDL_ENABLE_SX127X
+/* Register writes staged between planBegin() and planEnd()
+ * 
+ * Writes are sorted by address and issued as burst transactions
+ * over contiguous ranges, so the order of writes within a plan is
+ * not preserved. Only registers that can be written in any order
+ * while in standby should be staged.
+ * 
+ * */
+struct ldl_radio_plan {
+    
+    uint8_t reg[20U];
+    uint8_t data[20U];
+    uint8_t len;
+};
+#endif
+
+/* Operations of one radio type
+ * 
+ * LDL_Radio_init() selects the table for the type. If only one type is
+ * included the table is referenced directly so that calls through it
+ * resolve at compile time.
+ * 
+ * */
+struct ldl_radio_ops {
+    
+    void (*transmit)(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len);
+    void (*receive)(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
+#ifdef LDL_ENABLE_CAD
+    void (*cad)(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings);
+    bool (*cadDetected)(struct ldl_radio *self);
+#endif
+    void (*collectBegin)(struct ldl_radio *self);
+    bool (*collectResume)(struct ldl_radio *self);
+    void (*collect)(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
+    enum ldl_radio_event (*signal)(struct ldl_radio *self, uint8_t n);
+    void (*entropyBegin)(struct ldl_radio *self);
+    unsigned int (*entropyEnd)(struct ldl_radio *self);
+    void (*sleep)(struct ldl_radio *self);
+    void (*clearInterrupt)(struct ldl_radio *self);
+    
+    /* settings that differ between types of the same family */
+    void (*setModemConfig)(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit);
+    void (*setPower)(struct ldl_radio *self, int16_t dbm);
+    
+#ifdef LDL_ENABLE_FSK
+    /* the FSK modem is driven */
+    bool fsk;
+#endif
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    /* queued transfers wait for the chip to be ready (BUSY) */
+    bool wait;
+#endif
+#ifdef LDL_ENABLE_RADIO_TEST
+    void (*setFreq)(struct ldl_radio *self, uint32_t freq);
+    void (*enableLora)(struct ldl_radio *self);
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    const struct ldl_radio_current_table *current;
+#endif
+};
+
+#if defined(LDL_ENABLE_RADIO_OPS)
+#   define RADIO_OPS(SELF) ((SELF)->ops)
+#elif defined(LDL_ENABLE_SX1272)
+#   define RADIO_OPS(SELF) (&sx1272_ops)
+#elif defined(LDL_ENABLE_SX1276)
+#   define RADIO_OPS(SELF) (&sx1276_ops)
+#elif defined(LDL_ENABLE_SX1261)
+#   define RADIO_OPS(SELF) (&sx1261_ops)
+#else
+#   define RADIO_OPS(SELF) (&sx1262_ops)
+#endif
+
 /* static function prototypes *****************************************/
 
-static uint8_t readFIFO(struct ldl_radio *self, uint8_t *data, uint8_t max);
+#ifdef LDL_ENABLE_SX127X
+static void transmitSX127X(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len);
+static void receiveSX127X(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
+#ifdef LDL_ENABLE_CAD
+static void cadSX127X(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings);
+static bool cadDetectedSX127X(struct ldl_radio *self);
+#endif
+static void collectBeginSX127X(struct ldl_radio *self);
+static bool collectResumeSX127X(struct ldl_radio *self);
+static void collectSX127X(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
+static enum ldl_radio_event signalSX127X(struct ldl_radio *self, uint8_t n);
+static void entropyBeginSX127X(struct ldl_radio *self, uint8_t config1, uint8_t config2);
+static unsigned int entropyEndSX127X(struct ldl_radio *self);
+static void clearInterruptSX127X(struct ldl_radio *self);
+#ifdef LDL_ENABLE_RADIO_TEST
+static void setFreqSX127X(struct ldl_radio *self, uint32_t freq);
+#endif
 static void writeFIFO(struct ldl_radio *self, const uint8_t *data, uint8_t len);
 static void setFreq(struct ldl_radio *self, uint32_t freq);
-static void setModemConfig(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf);
-static void setPower(struct ldl_radio *self, int16_t dbm);
 static uint8_t readReg(struct ldl_radio *self, uint8_t reg);
 static void writeReg(struct ldl_radio *self, uint8_t reg, uint8_t data);
-static void burstRead(struct ldl_radio *self, uint8_t reg, uint8_t *data, uint8_t len);
+static void putReg(struct ldl_radio *self, uint8_t reg, uint8_t data);
+static void planBegin(struct ldl_radio *self, struct ldl_radio_plan *plan);
+static void planEnd(struct ldl_radio *self);
+static void planFlush(struct ldl_radio *self);
+static uint8_t shadowSlot(uint8_t reg);
+static bool shadowHit(const struct ldl_radio *self, uint8_t reg, uint8_t data);
+static void shadowUpdate(struct ldl_radio *self, uint8_t reg, uint8_t data);
 static void burstWrite(struct ldl_radio *self, uint8_t reg, const uint8_t *data, uint8_t len);
 static void setOpRX(struct ldl_radio *self);
 static void setOpTX(struct ldl_radio *self);
+#ifdef LDL_ENABLE_CAD
+static void setOpCAD(struct ldl_radio *self);
+#endif
 static void setOpRXContinuous(struct ldl_radio *self);
 static void setOpStandby(struct ldl_radio *self);
 static void setOpSleep(struct ldl_radio *self);
 static void setOp(struct ldl_radio *self, uint8_t op);
 static void enableLora(struct ldl_radio *self);
-static uint8_t crSetting(const struct ldl_radio *self, enum ldl_coding_rate cr);
-static uint8_t bwSetting(const struct ldl_radio *self, enum ldl_signal_bandwidth bw);
-static uint8_t sfSetting(const struct ldl_radio *self, enum ldl_spreading_factor sf);
+static void transmitLora(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len);
+static void receiveLora(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
+static enum ldl_radio_event signalLora(struct ldl_radio *self, uint8_t n);
+static void collectLora(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
+#ifdef LDL_ENABLE_FSK
+static void transmitFSK(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len);
+static void receiveFSK(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
+static void setModem(struct ldl_radio *self, bool lora);
+static void setModemConfigFSK(struct ldl_radio *self);
+static void serviceFIFO(struct ldl_radio *self);
+static void writeFIFOFSK(struct ldl_radio *self, uint8_t space);
+static uint8_t readFIFOFSK(struct ldl_radio *self, uint16_t n);
+static void collectFSK(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
+static enum ldl_radio_event signalFSK(struct ldl_radio *self, uint8_t n);
+#endif
+static uint16_t bwKHz(enum ldl_signal_bandwidth bw);
+static uint8_t sfSetting(enum ldl_spreading_factor sf);
+#endif
+#ifdef LDL_ENABLE_SX1272
+static void entropyBeginSX1272(struct ldl_radio *self);
+static void setModemConfigSX1272(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit);
+static void setPowerSX1272(struct ldl_radio *self, int16_t dbm);
+#endif
+#ifdef LDL_ENABLE_SX1276
+static void entropyBeginSX1276(struct ldl_radio *self);
+static void setModemConfigSX1276(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit);
+static void setPowerSX1276(struct ldl_radio *self, int16_t dbm);
+#endif
+#ifdef LDL_ENABLE_SX126X
+static void transmitSX126X(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len);
+static void receiveSX126X(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings);
+#ifdef LDL_ENABLE_CAD
+static void cadSX126X(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings);
+static bool cadDetectedSX126X(struct ldl_radio *self);
+#endif
+static void collectBeginSX126X(struct ldl_radio *self);
+static bool collectResumeSX126X(struct ldl_radio *self);
+static void collectSX126X(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta);
+static enum ldl_radio_event signalSX126X(struct ldl_radio *self, uint8_t n);
+static void entropyBeginSX126X(struct ldl_radio *self);
+static unsigned int entropyEndSX126X(struct ldl_radio *self);
+static void clearInterruptSX126X(struct ldl_radio *self);
+static void sleepSX126X(struct ldl_radio *self);
+static void standbySX126X(struct ldl_radio *self);
+static void setModeSX126X(struct ldl_radio *self, uint8_t opcode, const uint8_t *param, uint8_t size);
+static void setupSX126X(struct ldl_radio *self);
+static void enableLoraSX126X(struct ldl_radio *self);
+static void setFreqSX126X(struct ldl_radio *self, uint32_t freq);
+static void setModemConfigSX126X(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit);
+static void setPacketSX126X(struct ldl_radio *self, uint8_t preamble, bool implicit, uint8_t len, bool crc, bool invertIQ);
+static void setPowerSX126X(struct ldl_radio *self, int16_t power, const uint8_t *pa);
+static void setIrqSX126X(struct ldl_radio *self, uint16_t mask, uint16_t dio1);
+static void clearIrqSX126X(struct ldl_radio *self);
+static void transmitRestSX126X(struct ldl_radio *self, const uint8_t *data, uint8_t len, uint8_t pos);
+static bool writeBufferSX126X(struct ldl_radio *self, const uint8_t *data, uint8_t len, uint8_t pos);
+static bool commandSX126X(struct ldl_radio *self, enum ldl_radio_sx126x_slot slot, const uint8_t *param);
+#endif
+#ifdef LDL_ENABLE_SX1261
+static void setPowerSX1261(struct ldl_radio *self, int16_t dbm);
+#endif
+#ifdef LDL_ENABLE_SX1262
+static void setPowerSX1262(struct ldl_radio *self, int16_t dbm);
+#endif
+static void batchBegin(struct ldl_radio *self);
+static void batchEnd(struct ldl_radio *self);
+static void chipWrite(struct ldl_radio *self, uint8_t reg, const uint8_t *data, uint8_t size);
+static void chipRead(struct ldl_radio *self, uint8_t reg, uint8_t *data, uint8_t size);
+static void chipTransfer(struct ldl_radio *self, uint8_t reg, const uint8_t *out, uint8_t *in, uint8_t size);
+#ifdef LDL_ENABLE_CHIP_ASYNC
+static void batchSubmit(struct ldl_radio *self);
+static uint8_t batchSpace(const struct ldl_radio *self, uint8_t count);
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+static void setState(struct ldl_radio *self, enum ldl_radio_state state);
+static uint32_t stateCurrent(const struct ldl_radio *self, enum ldl_radio_state state);
+static uint32_t txCurrent(const struct ldl_radio *self, int16_t dbm);
+#endif
+
+#ifdef LDL_ENABLE_SX1272
+static const struct ldl_radio_ops sx1272_ops = {
+    .transmit = transmitSX127X,
+    .receive = receiveSX127X,
+#ifdef LDL_ENABLE_CAD
+    .cad = cadSX127X,
+    .cadDetected = cadDetectedSX127X,
+#endif
+    .collectBegin = collectBeginSX127X,
+    .collectResume = collectResumeSX127X,
+    .collect = collectSX127X,
+    .signal = signalSX127X,
+    .entropyBegin = entropyBeginSX1272,
+    .entropyEnd = entropyEndSX127X,
+    .sleep = enableLora,
+    .clearInterrupt = clearInterruptSX127X,
+    .setModemConfig = setModemConfigSX1272,
+    .setPower = setPowerSX1272,
+#ifdef LDL_ENABLE_FSK
+    .fsk = true,
+#endif
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    .wait = false,
+#endif
+#ifdef LDL_ENABLE_RADIO_TEST
+    .setFreq = setFreqSX127X,
+    .enableLora = enableLora,
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    .current = &sx1272_current,
+#endif
+};
+#endif
+
+#ifdef LDL_ENABLE_SX1276
+static const struct ldl_radio_ops sx1276_ops = {
+    .transmit = transmitSX127X,
+    .receive = receiveSX127X,
+#ifdef LDL_ENABLE_CAD
+    .cad = cadSX127X,
+    .cadDetected = cadDetectedSX127X,
+#endif
+    .collectBegin = collectBeginSX127X,
+    .collectResume = collectResumeSX127X,
+    .collect = collectSX127X,
+    .signal = signalSX127X,
+    .entropyBegin = entropyBeginSX1276,
+    .entropyEnd = entropyEndSX127X,
+    .sleep = enableLora,
+    .clearInterrupt = clearInterruptSX127X,
+    .setModemConfig = setModemConfigSX1276,
+    .setPower = setPowerSX1276,
+#ifdef LDL_ENABLE_FSK
+    .fsk = true,
+#endif
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    .wait = false,
+#endif
+#ifdef LDL_ENABLE_RADIO_TEST
+    .setFreq = setFreqSX127X,
+    .enableLora = enableLora,
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    .current = &sx1276_current,
+#endif
+};
+#endif
+
+#ifdef LDL_ENABLE_SX1261
+static const struct ldl_radio_ops sx1261_ops = {
+    .transmit = transmitSX126X,
+    .receive = receiveSX126X,
+#ifdef LDL_ENABLE_CAD
+    .cad = cadSX126X,
+    .cadDetected = cadDetectedSX126X,
+#endif
+    .collectBegin = collectBeginSX126X,
+    .collectResume = collectResumeSX126X,
+    .collect = collectSX126X,
+    .signal = signalSX126X,
+    .entropyBegin = entropyBeginSX126X,
+    .entropyEnd = entropyEndSX126X,
+    .sleep = sleepSX126X,
+    .clearInterrupt = clearInterruptSX126X,
+    .setModemConfig = setModemConfigSX126X,
+    .setPower = setPowerSX1261,
+#ifdef LDL_ENABLE_FSK
+    .fsk = false,
+#endif
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    .wait = true,
+#endif
+#ifdef LDL_ENABLE_RADIO_TEST
+    .setFreq = setFreqSX126X,
+    .enableLora = enableLoraSX126X,
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    .current = &sx1261_current,
+#endif
+};
+#endif
+
+#ifdef LDL_ENABLE_SX1262
+static const struct ldl_radio_ops sx1262_ops = {
+    .transmit = transmitSX126X,
+    .receive = receiveSX126X,
+#ifdef LDL_ENABLE_CAD
+    .cad = cadSX126X,
+    .cadDetected = cadDetectedSX126X,
+#endif
+    .collectBegin = collectBeginSX126X,
+    .collectResume = collectResumeSX126X,
+    .collect = collectSX126X,
+    .signal = signalSX126X,
+    .entropyBegin = entropyBeginSX126X,
+    .entropyEnd = entropyEndSX126X,
+    .sleep = sleepSX126X,
+    .clearInterrupt = clearInterruptSX126X,
+    .setModemConfig = setModemConfigSX126X,
+    .setPower = setPowerSX1262,
+#ifdef LDL_ENABLE_FSK
+    .fsk = false,
+#endif
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    .wait = true,
+#endif
+#ifdef LDL_ENABLE_RADIO_TEST
+    .setFreq = setFreqSX126X,
+    .enableLora = enableLoraSX126X,
+#endif
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    .current = &sx1262_current,
+#endif
+};
+#endif
 
 /* functions **********************************************************/
 
 void LDL_Radio_init(struct ldl_radio *self, enum ldl_radio_type type, void *board)
 {
+    const struct ldl_radio_ops *ops = NULL;
+    
     LDL_PEDANTIC(self != NULL)
     
     (void)memset(self, 0, sizeof(*self));
     self->board = board;
 
     self->type = type;
+    
+    switch(type){
+    default:
+        break;
+#ifdef LDL_ENABLE_SX1272        
+    case LDL_RADIO_SX1272:
+        ops = &sx1272_ops;
+        break;
+#endif        
+#ifdef LDL_ENABLE_SX1276        
+    case LDL_RADIO_SX1276:
+        ops = &sx1276_ops;
+        break;
+#endif        
+#ifdef LDL_ENABLE_SX1261
+    case LDL_RADIO_SX1261:
+        ops = &sx1261_ops;
+        break;
+#endif        
+#ifdef LDL_ENABLE_SX1262
+    case LDL_RADIO_SX1262:
+        ops = &sx1262_ops;
+        break;
+#endif        
+    }
+    
+    LDL_PEDANTIC(ops != NULL)
+    
+#ifdef LDL_ENABLE_RADIO_OPS
+    self->ops = ops;
+#endif
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    self->current = (ops != NULL) ? ops->current : NULL;
+#else
+    (void)ops;
+#endif    
 }
 
 void LDL_Radio_setPA(struct ldl_radio *self, enum ldl_radio_pa pa)
@@ -189,217 +736,357 @@ void LDL_Radio_setHandler(struct ldl_radio *self, struct ldl_mac *mac, ldl_radio
     self->mac = mac;
 }
 
-void LDL_Radio_interrupt(struct ldl_radio *self, uint8_t n)
+#ifdef LDL_ENABLE_RADIO_ENERGY
+void LDL_Radio_enableEnergy(struct ldl_radio *self, void *app)
 {
     LDL_PEDANTIC(self != NULL)
     
-    if(self->handler != NULL){
-        
-        self->handler(self->mac, LDL_Radio_signal(self, n));
-    }
+    self->app = app;
+    self->counting = true;
+    self->state_since = LDL_System_ticks(app);
 }
 
-void LDL_Radio_reset(struct ldl_radio *self, bool state)
+void LDL_Radio_setCurrentTable(struct ldl_radio *self, const struct ldl_radio_current_table *table)
 {
     LDL_PEDANTIC(self != NULL)
     
-    LDL_Chip_reset(self->board, state);
+    self->current = table;
 }
 
-void LDL_Radio_transmit(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const void *data, uint8_t len)
+void LDL_Radio_getEnergy(struct ldl_radio *self, struct ldl_radio_energy *energy)
 {
     LDL_PEDANTIC(self != NULL)
-    LDL_PEDANTIC(settings != NULL)
-    LDL_PEDANTIC((data != NULL) || (len == 0U))
-    LDL_PEDANTIC(settings->freq != 0U)
+    LDL_PEDANTIC(energy != NULL)
     
-    self->dio_mapping1 = 0x40U;
+    LDL_SYSTEM_ENTER_CRITICAL(self->app)
     
-    setOpStandby(self);
+    /* bring counters up to date */
+    setState(self, self->state);
     
-    setModemConfig(self, settings->bw, settings->sf);    
-
-    setFreq(self, settings->freq);
-    setPower(self, settings->dbm);
+    (void)memcpy(energy->time, self->time, sizeof(energy->time));
+    energy->charge = (uint32_t)(self->charge / LDL_System_tps());
     
-    writeReg(self, RegSyncWord, 0x34);                                               // set sync word
-    writeReg(self, RegPaRamp, (readReg(self, RegPaRamp) & 0xf0U) | 0x08U);    // 50us PA ramp
-    writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) & ~(0x40U));       // non-invert IQ    
-    writeReg(self, RegDioMapping1, self->dio_mapping1);                              // DIO0 (TX_COMPLETE) DIO1 (RX_DONE)
-    writeReg(self, RegIrqFlags, 0xff);                                               // clear all interrupts
-    writeReg(self, RegIrqFlagsMask, 0xf7U);                                          // unmask TX_DONE interrupt                    
+    LDL_SYSTEM_LEAVE_CRITICAL(self->app)
+}
+#endif
+
+void LDL_Radio_interrupt(struct ldl_radio *self, uint8_t n)
+{
+    LDL_PEDANTIC(self != NULL)
     
-    writeFIFO(self, data, len);
+    enum ldl_radio_event event;
     
-    setOpTX(self);    
+    if(self->handler != NULL){
+        
+        event = LDL_Radio_signal(self, n);
+        
+#ifdef LDL_ENABLE_RADIO_ENERGY
+        /* TX, RX single and CAD return to standby by themselves,
+         * RX continuous keeps listening */
+        switch(event){
+        case LDL_RADIO_EVENT_TX_COMPLETE:
+#ifdef LDL_ENABLE_CAD
+        case LDL_RADIO_EVENT_CAD_DONE:
+#endif        
+            setState(self, LDL_RADIO_STATE_STANDBY);
+            break;
+        case LDL_RADIO_EVENT_RX_READY:
+        case LDL_RADIO_EVENT_RX_TIMEOUT:
+            if(!self->continuous){
+                
+                setState(self, LDL_RADIO_STATE_STANDBY);
+            }
+            break;
+        default:
+            /* do nothing */
+            break;
+        }
+#endif        
+        self->handler(self->mac, event);
+    }
 }
 
-void LDL_Radio_receive(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
+#ifdef LDL_ENABLE_CHIP_ASYNC
+void LDL_Radio_chipComplete(struct ldl_radio *self)
 {
     LDL_PEDANTIC(self != NULL)
-    LDL_PEDANTIC(settings != NULL)
-    LDL_PEDANTIC(settings->freq != 0U)
-    
-    self->dio_mapping1 = 0U;
     
-    setOpStandby(self);
+    self->busy = false;
     
-    setModemConfig(self, settings->bw, settings->sf);
+    if(self->handler != NULL){
+        
+        self->handler(self->mac, LDL_RADIO_EVENT_CHIP_COMPLETE);
+    }
+}
+
+void LDL_Radio_resume(struct ldl_radio *self)
+{
+    enum ldl_radio_next next;
     
-    setFreq(self, settings->freq);                                                  // set carrier frequency        
+    LDL_PEDANTIC(self != NULL)
     
-    writeReg(self, RegSymbTimeoutLsb, settings->timeout);                    // set symbol timeout
-    writeReg(self, RegSyncWord, 0x34);                                       // set sync word
-    writeReg(self, RegLna, 0x23U);                                           // LNA gain to max, LNA boost enable    
-    writeReg(self, RegPayloadMaxLength, settings->max);                      // max payload
-    writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) | 0x40U);  // invert IQ    
-    writeReg(self, RegDioMapping1, self->dio_mapping1);                      // DIO0 (RX_TIMEOUT) DIO1 (RX_DONE)    
-    writeReg(self, RegIrqFlags, 0xff);                                       // clear all interrupts
-    writeReg(self, RegIrqFlagsMask, 0x3fU);                                  // unmask RX_TIMEOUT and RX_DONE interrupt                    
+    if(!self->busy){
+        
+        next = self->next;
+        self->next = LDL_RADIO_NEXT_NONE;
+        
+        switch(next){
+        default:
+        case LDL_RADIO_NEXT_NONE:
+            break;
+        case LDL_RADIO_NEXT_TRANSMIT:
+            RADIO_OPS(self)->transmit(self, &self->next_setting.tx, self->next_data, self->next_len);
+            break;
+        case LDL_RADIO_NEXT_RECEIVE:
+            RADIO_OPS(self)->receive(self, &self->next_setting.rx);
+            break;
+#ifdef LDL_ENABLE_CAD
+        case LDL_RADIO_NEXT_CAD:
+            RADIO_OPS(self)->cad(self, &self->next_setting.cad);
+            break;
+#endif
+        case LDL_RADIO_NEXT_CLEAR_INTERRUPT:
+            RADIO_OPS(self)->clearInterrupt(self);
+            break;
+        case LDL_RADIO_NEXT_SLEEP:
+            batchBegin(self);
+            RADIO_OPS(self)->sleep(self);
+            batchEnd(self);
+            break;
+#ifdef LDL_ENABLE_SX126X
+        case LDL_RADIO_NEXT_WRITE_BUFFER:
+            batchBegin(self);
+            transmitRestSX126X(self, self->next_data, self->next_len, self->next_pos);
+            batchEnd(self);
+            break;
+#endif
+        }
+    }
+}
+
+bool LDL_Radio_busy(const struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
     
-    setOpRX(self);
+    return self->busy;
 }
 
-uint8_t LDL_Radio_collect(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta, void *data, uint8_t max)
-{   
+bool LDL_Radio_pending(const struct ldl_radio *self)
+{
     LDL_PEDANTIC(self != NULL)
-    LDL_PEDANTIC((data != NULL) || (max == 0U))
     
-    uint8_t retval;
+    return (self->next != LDL_RADIO_NEXT_NONE);
+}
+#endif
+
+void LDL_Radio_reset(struct ldl_radio *self, bool state)
+{
+    LDL_PEDANTIC(self != NULL)
     
-    (void)memset(meta, 0, sizeof(*meta));
+    LDL_Chip_reset(self->board, state);
     
-    retval = readFIFO(self, data, max);
+    self->shadow_valid = 0U;
     
-    meta->rssi = (int16_t)readReg(self, RegPktRssiValue) - 157;
-    meta->snr = ((int16_t)readReg(self, RegPktSnrValue)) * 100 / 4;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    /* the connector abandons a batch in progress */
+    self->busy = false;
+    self->batch = false;
+    self->next = LDL_RADIO_NEXT_NONE;
+    self->asleep = false;
+#endif
     
-    return retval;
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    /* the chip comes out of reset in standby */
+    setState(self, state ? LDL_RADIO_STATE_SLEEP : LDL_RADIO_STATE_STANDBY);
+#endif    
 }
 
-enum ldl_radio_event LDL_Radio_signal(struct ldl_radio *self, uint8_t n)
-{    
+void LDL_Radio_transmit(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const void *data, uint8_t len)
+{
     LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC(settings != NULL)
+    LDL_PEDANTIC((data != NULL) || (len == 0U))
+    LDL_PEDANTIC(settings->freq != 0U)
     
-    enum ldl_radio_event retval = LDL_RADIO_EVENT_NONE;
-    
-    switch(n){
-    case 0U:  
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->next = LDL_RADIO_NEXT_TRANSMIT;
+    self->next_setting.tx = *settings;
+    self->next_data = (const uint8_t *)data;
+    self->next_len = len;
     
-        switch(self->dio_mapping1){
-        case 0U:
-            retval = LDL_RADIO_EVENT_RX_READY;
-            break;
-        case 0x40U:
-            retval = LDL_RADIO_EVENT_TX_COMPLETE;
-            break;
-        default:
-            /* do nothing */
-            break;
-        }         
-        break;
-        
-    case 1U:
+    LDL_Radio_resume(self);
+#else
+    RADIO_OPS(self)->transmit(self, settings, (const uint8_t *)data, len);
+#endif
+}
+
+void LDL_Radio_receive(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
+{
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC(settings != NULL)
+    LDL_PEDANTIC(settings->freq != 0U)
     
-        switch(self->dio_mapping1){
-        case 0U:
-            retval = LDL_RADIO_EVENT_RX_TIMEOUT;
-            break;
-        default:
-            /* do nothing */
-            break;
-        }         
-        break;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->next = LDL_RADIO_NEXT_RECEIVE;
+    self->next_setting.rx = *settings;
     
-    default:
-        /* do nothing */
-        break;
+    LDL_Radio_resume(self);
+#else
+    RADIO_OPS(self)->receive(self, settings);
+#endif
+}
+
+#ifdef LDL_ENABLE_CAD
+void LDL_Radio_cad(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings)
+{
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC(settings != NULL)
+    LDL_PEDANTIC(settings->freq != 0U)
+    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->next = LDL_RADIO_NEXT_CAD;
+    self->next_setting.cad = *settings;
+    
+    LDL_Radio_resume(self);
+#else
+    RADIO_OPS(self)->cad(self, settings);
+#endif
+}
+
+bool LDL_Radio_cadDetected(struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    return RADIO_OPS(self)->cadDetected(self);
+}
+#endif
+
+#ifndef LDL_ENABLE_CHIP_ASYNC
+uint8_t LDL_Radio_collect(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta, void *data, uint8_t max)
+{   
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC((data != NULL) || (max == 0U))
+    
+    LDL_Radio_collectBegin(self, data, max);
+    
+    while(!LDL_Radio_collectResume(self)){
+        
+        /* each step is performed as it is made */
     }
     
-    return retval;
+    return LDL_Radio_collectEnd(self, meta);
 }
+#endif
 
-void LDL_Radio_entropyBegin(struct ldl_radio *self)
+void LDL_Radio_collectBegin(struct ldl_radio *self, void *data, uint8_t max)
 {
-    enableLora(self);
-    setOpStandby(self);
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC((data != NULL) || (max == 0U))
     
-    writeReg(self, RegIrqFlags, 0xff);         // clear all interrupts
-    writeReg(self, RegIrqFlagsMask, 0xffU);    // mask all interrupts
+    self->rx_data = (uint8_t *)data;
+    self->rx_max = max;
+    self->rx_len = 0U;
+    self->rx_step = 0U;
     
-    /* application note instructions */
-    switch(self->type){
-    default:
-        break;
-#ifdef LDL_ENABLE_SX1272        
-    case LDL_RADIO_SX1272:
-        writeReg(self, RegModemConfig1, 0x0aU);
-        writeReg(self, RegModemConfig2, 0x74U);    
-        break;
-#endif    
-#ifdef LDL_ENABLE_SX1276
-    case LDL_RADIO_SX1276:
-        writeReg(self, RegModemConfig1, 0x72U);
-        writeReg(self, RegModemConfig2, 0x70U);
-        break;
-#endif    
-    }   
+    RADIO_OPS(self)->collectBegin(self);
+}
+
+bool LDL_Radio_collectResume(struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
     
-    setOpRXContinuous(self);
+    return RADIO_OPS(self)->collectResume(self);
 }
 
-unsigned int LDL_Radio_entropyEnd(struct ldl_radio *self)
+uint8_t LDL_Radio_collectEnd(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta)
 {
-    unsigned int retval = 0U;
-    size_t i;
+    LDL_PEDANTIC(self != NULL)
+    LDL_PEDANTIC(meta != NULL)
     
-    for(i=0U; i < (sizeof(unsigned int)*8U); i++){
-        
-        retval <<= 1;
-        retval |= readReg(self, RegRssiWideband) & 0x1U;
-    }
+    (void)memset(meta, 0, sizeof(*meta));
     
-    setOpSleep(self);
+    RADIO_OPS(self)->collect(self, meta);
     
-    return retval;
+    return self->rx_len;
+}
+
+enum ldl_radio_event LDL_Radio_signal(struct ldl_radio *self, uint8_t n)
+{    
+    LDL_PEDANTIC(self != NULL)
+    
+    return RADIO_OPS(self)->signal(self, n);
+}
+
+void LDL_Radio_entropyBegin(struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    RADIO_OPS(self)->entropyBegin(self);
+}
+
+unsigned int LDL_Radio_entropyEnd(struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    return RADIO_OPS(self)->entropyEnd(self);
 }
 
 void LDL_Radio_sleep(struct ldl_radio *self)
 {
     LDL_PEDANTIC(self != NULL)    
     
-    enableLora(self);
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->next = LDL_RADIO_NEXT_SLEEP;
+    
+    LDL_Radio_resume(self);
+#else
+    RADIO_OPS(self)->sleep(self);
+#endif
 }
 
 void LDL_Radio_clearInterrupt(struct ldl_radio *self)
 {
     LDL_PEDANTIC(self != NULL)
     
-    writeReg(self, RegIrqFlags, 0xff);         // clear all interrupts
-    writeReg(self, RegIrqFlagsMask, 0xffU);    // mask all interrupts
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->next = LDL_RADIO_NEXT_CLEAR_INTERRUPT;
     
-    setOpSleep(self);
+    LDL_Radio_resume(self);
+#else
+    RADIO_OPS(self)->clearInterrupt(self);
+#endif
 }
 
 #ifdef LDL_ENABLE_RADIO_TEST
 void LDL_Radio_setFreq(struct ldl_radio *self, uint32_t freq)
 {
-    setFreq(self, freq);
+    RADIO_OPS(self)->setFreq(self, freq);
 }
 
 void LDL_Radio_setModemConfig(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf)
 {
-    setModemConfig(self, bw, sf);
+    RADIO_OPS(self)->setModemConfig(self, bw, sf, false);
 }
 
 void LDL_Radio_setPower(struct ldl_radio *self, int16_t dbm)
 {
-    setPower(self, dbm);
+    RADIO_OPS(self)->setPower(self, dbm);
 }
 
 void LDL_Radio_enableLora(struct ldl_radio *self)
 {   
-    enableLora(self);
+    RADIO_OPS(self)->enableLora(self);
+}
+#endif
+
+#ifdef LDL_ENABLE_FSK
+bool LDL_Radio_supportsFSK(const struct ldl_radio *self)
+{
+    LDL_PEDANTIC(self != NULL)
+    
+    (void)self;
+    
+    return RADIO_OPS(self)->fsk;
 }
 #endif
 
@@ -409,7 +1096,7 @@ int16_t LDL_Radio_minSNR(const struct ldl_radio *self, enum ldl_spreading_factor
     
     (void)self;
     
-    /* applicable to 1272 and 1276 */
+    /* applicable to 1272, 1276, 1261 and 1262 */
     switch(sf){
     default:
     case LDL_SF_7:
@@ -430,6 +1117,10 @@ int16_t LDL_Radio_minSNR(const struct ldl_radio *self, enum ldl_spreading_factor
     case LDL_SF_12:
         retval = -2000;
         break;
+    case LDL_SF_FSK:
+        /* not measured */
+        retval = 0;
+        break;
     }
     
     return retval;
@@ -437,353 +1128,2150 @@ int16_t LDL_Radio_minSNR(const struct ldl_radio *self, enum ldl_spreading_factor
     
 /* static functions ***************************************************/
 
-static void enableLora(struct ldl_radio *self)
+#ifdef LDL_ENABLE_SX127X
+static void transmitSX127X(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len)
 {
-    setOpSleep(self);    
-    writeReg(self, RegOpMode, readReg(self, RegOpMode) | 0x80U);      
+#ifdef LDL_ENABLE_FSK
+    self->fsk = (settings->sf == LDL_SF_FSK);
+    
+    if(self->fsk){
+        
+        transmitFSK(self, settings, data, len);
+    }
+    else{
+        
+        transmitLora(self, settings, data, len);
+    }
+#else
+    transmitLora(self, settings, data, len);
+#endif
 }
 
-static void setOp(struct ldl_radio *self, uint8_t op)
+static void receiveSX127X(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
 {
-    writeReg(self, RegOpMode, (readReg(self, RegOpMode) & ~(0x7U)) | (op & 0x7U));    
+#ifdef LDL_ENABLE_FSK
+    self->fsk = (settings->sf == LDL_SF_FSK);
+    
+    if(self->fsk){
+        
+        receiveFSK(self, settings);
+    }
+    else{
+        
+        receiveLora(self, settings);
+    }
+#else
+    receiveLora(self, settings);
+#endif
 }
 
-static void setOpSleep(struct ldl_radio *self)
+#ifdef LDL_ENABLE_CAD
+static void cadSX127X(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings)
 {
-    setOp(self, 0U);
-}
-
-static void setOpStandby(struct ldl_radio *self)
-{   
-    setOp(self, 1U);    
-}
-
-static void setOpRX(struct ldl_radio *self)
-{   
-    setOp(self, 6U);
-}
-
-static void setOpRXContinuous(struct ldl_radio *self)
-{   
-    setOp(self, 5U);    
+    struct ldl_radio_plan plan;
+    
+    self->dio_mapping1 = 0x80U;
+    
+#ifdef LDL_ENABLE_FSK
+    self->fsk = false;
+#endif
+    
+    batchBegin(self);
+    
+#ifdef LDL_ENABLE_FSK
+    setModem(self, true);
+#endif
+    
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    RADIO_OPS(self)->setModemConfig(self, settings->bw, settings->sf, false);
+    
+    setFreq(self, settings->freq);                                           // set carrier frequency
+    
+    writeReg(self, RegSyncWord, 0x34);                                       // set sync word
+    writeReg(self, RegLna, 0x23U);                                           // LNA gain to max, LNA boost enable    
+    writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) & ~(0x40U));      // non-invert IQ (listening for uplinks)
+    writeReg(self, RegDioMapping1, self->dio_mapping1);                      // DIO0 (CAD_DONE)
+    writeReg(self, RegIrqFlags, 0xff);                                       // clear all interrupts
+    writeReg(self, RegIrqFlagsMask, 0xfaU);                                  // unmask CAD_DONE and CAD_DETECTED interrupt
+    
+    planEnd(self);
+    
+    setOpCAD(self);
+    
+    batchEnd(self);
 }
 
-static void setOpTX(struct ldl_radio *self)
-{   
-    setOp(self, 3U);    
+static bool cadDetectedSX127X(struct ldl_radio *self)
+{
+    uint8_t flags;
+    
+    chipRead(self, RegIrqFlags, &flags, sizeof(flags));
+    
+    return ((flags & 0x01U) > 0U);
 }
+#endif
 
-static void setModemConfig(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf)
+static void collectBeginSX127X(struct ldl_radio *self)
 {
-    bool low_rate = ((bw == LDL_BW_125) && ((sf == LDL_SF_11) || (sf == LDL_SF_12))) ? true : false;
+    batchBegin(self);
     
-    switch(self->type){
-    default:
-        break;
-#ifdef LDL_ENABLE_SX1272          
-    case LDL_RADIO_SX1272:
-        /* bandwidth            (2bit)
-         * codingRate           (3bit)
-         * implicitHeaderModeOn (1bit) (0)
-         * rxPayloadCrcOn       (1bit) (1)
-         * lowDataRateOptimize  (1bit)      */
-        writeReg(self, RegModemConfig1, bwSetting(self, bw) | crSetting(self, CR_5) | 0U | 2U | (low_rate ? 1U : 0U));
-        
-        /* spreadingFactor      (4bit)
-         * txContinuousMode     (1bit) (0)
-         * agcAutoOn            (1bit) (1)
-         * symbTimeout(9:8)     (2bit) (0)  */
-        writeReg(self, RegModemConfig2, sfSetting(self, sf) | 0U | 4U | 0U);    
-        break;
-#endif
-#ifdef LDL_ENABLE_SX1276
-    case LDL_RADIO_SX1276:
-        /* bandwidth            (4bit)
-         * codingRate           (3bit)
-         * implicitHeaderModeOn (1bit) (0)  */
-        writeReg(self, RegModemConfig1, bwSetting(self, bw) | crSetting(self, CR_5) | 0U);
-        
-        /* spreadingFactor      (4bit)
-         * txContinuousMode     (1bit) (0)
-         * rxPayloadCrcOn       (1bit) (1)
-         * symbTimeout(9:8)     (2bit) (0)  */
-        writeReg(self, RegModemConfig2, sfSetting(self, sf) | 0U | 4U | 0U);
-        
-        /* unused               (4bit) (0)
-         * lowDataRateOptimize  (1bit) 
-         * agcAutoOn            (1bit) (1)
-         * unused               (2bit) (0)  */
-        writeReg(self, RegModemConfig3, 0U | (low_rate ? 8U : 0U) | 4U | 0U);        
-        break;
-#endif    
-    }
+    /* RegFifoRxCurrentAddr through LoraRegFeiLsb in one read */
+    chipTransfer(self, RegFifoRxCurrentAddr, NULL, self->rx_status, sizeof(self->rx_status));
+    
+    batchEnd(self);
 }
 
-static void setPower(struct ldl_radio *self, int16_t dbm)
+static bool collectResumeSX127X(struct ldl_radio *self)
 {
-    /* Todo: 
-     * 
-     * - compensate for output gains/losses here
-     * - adjust current limit trim
-     * 
-     * */
-     
-     dbm /= 100;
-
-    switch(self->type){
-#ifdef LDL_ENABLE_SX1272        
-    case LDL_RADIO_SX1272:
-    {
-        uint8_t paConfig;
-        uint8_t paDac;    
+    bool retval = true;
+    bool lora = true;
+    
+#ifdef LDL_ENABLE_FSK
+    lora = !self->fsk;
+    
+    /* PayloadReady means the CRC was good and the end of the frame is in the FIFO */
+    if(self->fsk && (self->rx_step == 0U)){
         
-        paConfig = readReg(self, RegPaConfig);         
-        paConfig &= ~(0xfU);
-
-        switch(self->pa){
-        case LDL_RADIO_PA_RFO:
+        batchBegin(self);
         
-            /* -1 to 14dbm */
-            paConfig &= ~(0x80U);
-            paConfig |= (dbm > 14) ? 0xf : (uint8_t)( (dbm < -1) ? 0 : (dbm + 1) );
+        /* the rest of the frame cannot be sized until the length has been read */
+        if(self->fsk_pos == 0U){
             
-            writeReg(self, RegPaConfig, paConfig);            
-            break;
-        
-        case LDL_RADIO_PA_BOOST:
-        
-            paDac = readReg(self, RegPaDac); 
-                
-            paConfig |= 0x80U;
-            paDac &= ~(7U);
-
-            /* fixed 20dbm */
-            if(dbm >= 20){
-                
-                paDac |= 7U;                
-                paConfig |= 0xfU;
-            }
-            /* 2 dbm to 17dbm */
-            else{
+            chipTransfer(self, RegFifo, NULL, &self->fsk_len, sizeof(self->fsk_len));
+            
+            self->fsk_pos = 1U;
+            
+            retval = false;
+        }
+        else{
+            
+            self->rx_step = 1U;
+            
+            if(readFIFOFSK(self, UINT8_MAX + 1U) > 0U){
                 
-                paDac |= 4U;
-                paConfig |= (dbm > 17) ? 0xf : ( (dbm < 2) ? 0 : (dbm - 2) ); 
+                retval = false;
             }
-            
-            writeReg(self, RegPaDac, paDac);
-            writeReg(self, RegPaConfig, paConfig);            
-            break;
-        default:
-            break;        
         }
-    }
-        break;
-#endif              
-#ifdef LDL_ENABLE_SX1276
-    case LDL_RADIO_SX1276:
-    {
-        uint8_t paConfig;
-        uint8_t paDac;    
         
-        paConfig = readReg(self, RegPaConfig);         
-        paConfig &= ~(0xfU);
+        batchEnd(self);
+    }
+#endif
     
-        switch(self->pa){
-        case LDL_RADIO_PA_RFO:
+    if(lora && (self->rx_step == 0U)){
         
-            /* todo */
-            paConfig |= 0x7eU;
-            writeReg(self, RegPaConfig, paConfig);            
-            break;
+        self->rx_step = 1U;
         
-        case LDL_RADIO_PA_BOOST:
+        /* a frame that failed CRC is collected as zero length */
+        if((self->rx_status[RegIrqFlags - RegFifoRxCurrentAddr] & 0x60U) == 0x40U){
         
-            /* regpadac address == 0x4d */
-            paDac = readReg(self, 0x4d); 
-                
-            paConfig |= 0x80U;
-            paConfig &= ~0x70U;
-            paDac &= ~(7U);
-
-            /* fixed 20dbm */
-            if(dbm >= 20){
-                
-                paDac |= 7U;                
-                paConfig |= 0xfU;
-            }
-            /* 2 dbm to 17dbm */
-            else{
-                
-                paDac |= 4U;
-                paConfig |= (dbm > 17) ? 0xf : ( (dbm < 2) ? 0 : (dbm - 2) ); 
-            }
+            self->rx_len = self->rx_status[RegRxNbBytes - RegFifoRxCurrentAddr];
+            self->rx_len = (self->rx_len > self->rx_max) ? self->rx_max : self->rx_len;
+        }
+        
+        if(self->rx_len > 0U){
             
-            /* regpadac address == 0x4d */
-            writeReg(self, 0x4d, paDac);
-            writeReg(self, RegPaConfig, paConfig);   
-            break;
-        default:
-            break;        
+            batchBegin(self);
+            
+            writeReg(self, RegFifoAddrPtr, self->rx_status[0]);
+            chipTransfer(self, RegFifo, NULL, self->rx_data, self->rx_len);
+            
+            batchEnd(self);
+            
+            retval = false;
         }
     }
-        break;
-#endif    
-    default:
-        break;
-    }
+    
+    return retval;
 }
 
-static uint8_t bwSetting(const struct ldl_radio *self, enum ldl_signal_bandwidth bw)
+static void collectSX127X(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta)
 {
-    uint8_t retval = 0U;
-    
-    switch(self->type){
-    default:
-        break;
-#ifdef LDL_ENABLE_SX1272          
-    case LDL_RADIO_SX1272:    
-        switch(bw){
+#ifdef LDL_ENABLE_FSK
+    if(self->fsk){
+        
+        collectFSK(self, meta);
+    }
+    else{
+        
+        collectLora(self, meta);
+    }
+#else
+    collectLora(self, meta);
+#endif
+}
+
+static enum ldl_radio_event signalSX127X(struct ldl_radio *self, uint8_t n)
+{
+    enum ldl_radio_event retval;
+    
+#ifdef LDL_ENABLE_FSK
+    if(self->fsk){
+        
+        retval = signalFSK(self, n);
+    }
+    else{
+        
+        retval = signalLora(self, n);
+    }
+#else
+    retval = signalLora(self, n);
+#endif
+    
+    return retval;
+}
+
+/* config1 and config2 are RegModemConfig1 and RegModemConfig2 */
+static void entropyBeginSX127X(struct ldl_radio *self, uint8_t config1, uint8_t config2)
+{
+    struct ldl_radio_plan plan;
+    
+    enableLora(self);
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    writeReg(self, RegIrqFlags, 0xff);         // clear all interrupts
+    writeReg(self, RegIrqFlagsMask, 0xffU);    // mask all interrupts
+    
+    writeReg(self, RegModemConfig1, config1);
+    writeReg(self, RegModemConfig2, config2);
+    
+    planEnd(self);
+    
+    setOpRXContinuous(self);
+}
+
+static unsigned int entropyEndSX127X(struct ldl_radio *self)
+{
+    unsigned int retval = 0U;
+    size_t i;
+    
+    for(i=0U; i < (sizeof(unsigned int)*8U); i++){
+        
+        retval <<= 1;
+        retval |= readReg(self, RegRssiWideband) & 0x1U;
+    }
+    
+    setOpSleep(self);
+    
+    return retval;
+}
+
+static void clearInterruptSX127X(struct ldl_radio *self)
+{
+    struct ldl_radio_plan plan;
+    
+    batchBegin(self);
+    
+#ifdef LDL_ENABLE_FSK
+    /* FSK flags clear on leaving RX or TX */
+    setModem(self, true);
+#endif
+    
+    planBegin(self, &plan);
+    
+    writeReg(self, RegIrqFlags, 0xff);         // clear all interrupts
+    writeReg(self, RegIrqFlagsMask, 0xffU);    // mask all interrupts
+    
+    planEnd(self);
+    
+    setOpSleep(self);
+    
+    batchEnd(self);
+}
+
+#ifdef LDL_ENABLE_RADIO_TEST
+static void setFreqSX127X(struct ldl_radio *self, uint32_t freq)
+{
+    struct ldl_radio_plan plan;
+    
+    planBegin(self, &plan);
+    setFreq(self, freq);
+    planEnd(self);
+}
+#endif
+
+static void enableLora(struct ldl_radio *self)
+{
+    uint8_t opMode;
+    
+    setOpSleep(self);    
+    
+    opMode = readReg(self, RegOpMode);
+    
+    writeReg(self, RegOpMode, opMode | 0x80U);      
+    
+    /* register map changes with LongRangeMode */
+    if((opMode & 0x80U) == 0U){
+    
+        self->shadow_valid = 0U;
+    }
+}
+
+static void transmitLora(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len)
+{
+    struct ldl_radio_plan plan;
+    
+    self->dio_mapping1 = 0x40U;
+    
+    batchBegin(self);
+    
+#ifdef LDL_ENABLE_FSK
+    setModem(self, true);
+#endif
+    
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    RADIO_OPS(self)->setModemConfig(self, settings->bw, settings->sf, false);
+
+    setFreq(self, settings->freq);
+    RADIO_OPS(self)->setPower(self, settings->dbm);
+    
+    writeReg(self, RegSyncWord, 0x34);                                               // set sync word
+    writeReg(self, RegPaRamp, (readReg(self, RegPaRamp) & 0xf0U) | 0x08U);    // 50us PA ramp
+    writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) & ~(0x40U));       // non-invert IQ    
+    writeReg(self, RegDioMapping1, self->dio_mapping1);                              // DIO0 (TX_COMPLETE) DIO1 (RX_DONE)
+    writeReg(self, RegIrqFlags, 0xff);                                               // clear all interrupts
+    writeReg(self, RegIrqFlagsMask, 0xf7U);                                          // unmask TX_DONE interrupt                    
+    
+    writeFIFO(self, data, len);
+    
+    planEnd(self);
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    self->tx_current = txCurrent(self, settings->dbm / 100);
+#endif
+    
+    setOpTX(self);    
+    
+    batchEnd(self);
+}
+
+static void receiveLora(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
+{
+    struct ldl_radio_plan plan;
+    
+    self->dio_mapping1 = 0U;
+    self->rx_bw = settings->bw;
+    
+    batchBegin(self);
+    
+#ifdef LDL_ENABLE_FSK
+    setModem(self, true);
+#endif
+    
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    RADIO_OPS(self)->setModemConfig(self, settings->bw, settings->sf, settings->beacon);
+    
+    setFreq(self, settings->freq);                                                  // set carrier frequency        
+    
+    writeReg(self, RegSymbTimeoutLsb, settings->timeout);                    // set symbol timeout
+    writeReg(self, RegSyncWord, 0x34);                                       // set sync word
+    writeReg(self, RegLna, 0x23U);                                           // LNA gain to max, LNA boost enable    
+    writeReg(self, RegPayloadMaxLength, settings->max);                      // max payload
+    
+    if(settings->beacon){
+        
+        writeReg(self, LoraRegPayloadLength, settings->max);                    // implicit header length
+        writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) & ~(0x40U));  // non-invert IQ (beacon)
+    }
+    else{
+        
+        writeReg(self, RegInvertIQ, readReg(self, RegInvertIQ) | 0x40U);     // invert IQ    
+    }
+    
+    writeReg(self, RegDioMapping1, self->dio_mapping1);                      // DIO0 (RX_TIMEOUT) DIO1 (RX_DONE)    
+    writeReg(self, RegIrqFlags, 0xff);                                       // clear all interrupts
+    writeReg(self, RegIrqFlagsMask, 0x3fU);                                  // unmask RX_TIMEOUT and RX_DONE interrupt                    
+    
+    planEnd(self);
+    
+    if(settings->continuous){
+        
+        setOpRXContinuous(self);
+    }
+    else{
+        
+        setOpRX(self);
+    }
+    
+    batchEnd(self);
+}
+
+static enum ldl_radio_event signalLora(struct ldl_radio *self, uint8_t n)
+{
+    enum ldl_radio_event retval = LDL_RADIO_EVENT_NONE;
+    
+    switch(n){
+    case 0U:  
+    
+        switch(self->dio_mapping1){
+        case 0U:
+            retval = LDL_RADIO_EVENT_RX_READY;
+            break;
+        case 0x40U:
+            retval = LDL_RADIO_EVENT_TX_COMPLETE;
+            break;
+#ifdef LDL_ENABLE_CAD
+        case 0x80U:
+            retval = LDL_RADIO_EVENT_CAD_DONE;
+            break;
+#endif            
         default:
-        case LDL_BW_125:
-            retval = 0x00U;
+            /* do nothing */
             break;
-        case LDL_BW_250:
-            retval = 0x40U;
+        }         
+        break;
+        
+    case 1U:
+    
+        switch(self->dio_mapping1){
+        case 0U:
+            retval = LDL_RADIO_EVENT_RX_TIMEOUT;
             break;
-        case LDL_BW_500:
-            retval = 0x80U;
+        default:
+            /* do nothing */
             break;
+        }         
+        break;
+    
+    default:
+        /* do nothing */
+        break;
+    }
+    
+    return retval;
+}
+
+static void collectLora(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta)
+{
+    const uint8_t *status = self->rx_status;
+    int32_t fei;
+    
+    meta->rssi = (int16_t)status[RegPktRssiValue - RegFifoRxCurrentAddr] - 157;
+    meta->snr = ((int16_t)(int8_t)status[RegPktSnrValue - RegFifoRxCurrentAddr]) * 100 / 4;
+    
+    /* RxTimeout without RxDone */
+    meta->timeout = ((status[RegIrqFlags - RegFifoRxCurrentAddr] & 0xc0U) == 0x80U);
+    
+    /* 20 bit two's complement */
+    fei = (int32_t)(((uint32_t)status[LoraRegFeiMsb - RegFifoRxCurrentAddr] << 16) | ((uint32_t)status[LoraFeiMib - RegFifoRxCurrentAddr] << 8) | status[LoraRegFeiLsb - RegFifoRxCurrentAddr]);    
+    fei = ((fei & 0x80000L) != 0) ? (fei | (int32_t)0xfff00000UL) : (fei & 0xfffffL);
+    
+    /* FError = FreqError x 2^24 / Fxtal x BW / 500kHz */
+    meta->freqError = (int32_t)(((int64_t)fei * (int64_t)(1UL << 24) * (int64_t)bwKHz(self->rx_bw)) / (32000000LL * 500LL));
+}
+
+#ifdef LDL_ENABLE_FSK
+static void transmitFSK(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len)
+{
+    struct ldl_radio_plan plan;
+    
+    self->dio_mapping1 = 0x00U;
+    
+    self->fsk_tx = data;
+    self->fsk_len = len;
+    self->fsk_pos = 0U;
+    
+    batchBegin(self);
+    
+    setModem(self, false);
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    setModemConfigFSK(self);
+    
+    setFreq(self, settings->freq);
+    RADIO_OPS(self)->setPower(self, settings->dbm);
+    
+    writeReg(self, RegPaRamp, (readReg(self, RegPaRamp) & 0xf0U) | 0x08U);    // 50us PA ramp
+    writeReg(self, RegDioMapping1, self->dio_mapping1);                       // DIO0 (PacketSent) DIO1 (FifoLevel)
+    writeReg(self, RegIrqFlags2, 0x10U);                                      // clear FIFO
+    
+    /* the rest is written as FifoLevel falls */
+    writeFIFOFSK(self, FifoSize);
+    
+    planEnd(self);
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    self->tx_current = txCurrent(self, settings->dbm / 100);
+#endif
+    
+    setOpTX(self);
+    
+    batchEnd(self);
+}
+
+static void receiveFSK(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
+{
+    struct ldl_radio_plan plan;
+    
+    LDL_PEDANTIC(settings->buffer != NULL)
+    
+    self->dio_mapping1 = 0x08U;
+    
+    self->fsk_rx = settings->buffer;
+    self->fsk_max = settings->max;
+    self->fsk_len = 0U;
+    self->fsk_pos = 0U;
+    
+    batchBegin(self);
+    
+    setModem(self, false);
+    setOpStandby(self);
+    
+    planBegin(self, &plan);
+    
+    setModemConfigFSK(self);
+    
+    setFreq(self, settings->freq);                                          // set carrier frequency
+    
+    writeReg(self, RegLna, 0x23U);                                           // LNA gain to max, LNA boost enable
+    writeReg(self, RegPayloadLength, self->fsk_max);                         // max payload
+    
+    /* TimeoutRxPreamble is in units of 16 bits (two symbols) */
+    writeReg(self, RegRxTimeout2, settings->continuous ? 0U : (uint8_t)(((uint16_t)settings->timeout + 1U) / 2U));
+    
+    writeReg(self, RegDioMapping1, self->dio_mapping1);                      // DIO0 (PayloadReady) DIO1 (FifoLevel) DIO2 (Timeout)
+    writeReg(self, RegIrqFlags2, 0x10U);                                     // clear FIFO
+    
+    planEnd(self);
+    
+    /* there is no RX single mode, the timeout leaves the receiver on */
+    setOpRXContinuous(self);
+    
+    batchEnd(self);
+}
+
+/* LongRangeMode can only be changed in sleep */
+static void setModem(struct ldl_radio *self, bool lora)
+{
+    uint8_t opMode = readReg(self, RegOpMode);
+    
+    if(((opMode & 0x80U) != 0U) != lora){
+        
+        setOpSleep(self);
+        
+        /* keep LowFrequencyModeOn, FSK ModulationType */
+        opMode = (opMode & 0x08U) | (lora ? 0x80U : 0U);
+        
+        writeReg(self, RegOpMode, opMode);
+        
+        /* register map changes with LongRangeMode but RegOpMode 
+         * must stay known since the writes may be queued */
+        self->shadow_valid = 0U;
+        shadowUpdate(self, RegOpMode, opMode);
+    }
+}
+
+static void setModemConfigFSK(struct ldl_radio *self)
+{
+    writeReg(self, RegBitrateMsb, 0x02U);           // 50kbps (FXOSC / 640)
+    writeReg(self, RegBitrateLsb, 0x80U);
+    writeReg(self, RegFdevMsb, 0x01U);              // 25kHz deviation (410 x Fstep)
+    writeReg(self, RegFdevLsb, 0x9aU);
+    writeReg(self, RegRxConfig, 0x1eU);             // AFC and AGC on, receiver triggered by preamble detect
+    writeReg(self, RegRxBw, 0x0bU);                 // 50kHz
+    writeReg(self, RegAfcBw, 0x12U);                // 83.3kHz
+    writeReg(self, RegPreambleDetect, 0xaaU);       // detector on, 2 bytes, 10 chip errors
+    writeReg(self, RegPreambleMsb, 0x00U);          // 5 byte preamble
+    writeReg(self, RegPreambleLsb, 0x05U);
+    writeReg(self, RegSyncConfig, 0x12U);           // sync word on, 3 bytes
+    writeReg(self, RegSyncValue1, 0xc1U);
+    writeReg(self, RegSyncValue2, 0x94U);
+    writeReg(self, RegSyncValue3, 0xc1U);
+    writeReg(self, RegPacketConfig1, 0xd0U);        // variable length, whitening, CRC on
+    writeReg(self, RegPacketConfig2, 0x40U);        // packet mode
+    writeReg(self, RegFifoThresh, 0x80U | FifoThreshold);   // TX starts when the FIFO is not empty
+}
+
+/* called on both edges of FifoLevel */
+static void serviceFIFO(struct ldl_radio *self)
+{
+    uint8_t flags;
+    
+    chipRead(self, RegIrqFlags2, &flags, sizeof(flags));
+    
+    if(self->dio_mapping1 == 0x00U){
+        
+        /* at least FifoSize - FifoThreshold bytes are free */
+        if((flags & 0x20U) == 0U){
+            
+            writeFIFOFSK(self, FifoSize - FifoThreshold);
+        }
+    }
+    else{
+        
+        /* at least FifoThreshold + 1 bytes are waiting */
+        if((flags & 0x20U) != 0U){
+            
+            (void)readFIFOFSK(self, FifoThreshold + 1U);
         }
+    }
+}
+
+/* move up to space bytes of the frame (starting with the length) into the FIFO */
+static void writeFIFOFSK(struct ldl_radio *self, uint8_t space)
+{
+    uint16_t remaining;
+    uint8_t n = space;
+    
+    if((n > 0U) && (self->fsk_pos == 0U)){
+        
+        burstWrite(self, RegFifo, &self->fsk_len, sizeof(self->fsk_len));
+        
+        self->fsk_pos = 1U;
+        n--;
+    }
+    
+    remaining = ((uint16_t)self->fsk_len + 1U) - self->fsk_pos;
+    n = (remaining < n) ? (uint8_t)remaining : n;
+    
+    if(n > 0U){
+        
+        burstWrite(self, RegFifo, &self->fsk_tx[self->fsk_pos - 1U], n);
+        
+        self->fsk_pos += n;
+    }
+}
+
+/* move up to n bytes of the frame (starting with the length) out of the FIFO 
+ * 
+ * The length is read immediately, the rest may be queued. Collecting
+ * reads the length in a batch of its own so that it is never read
+ * from here within a batch.
+ * 
+ * */
+static uint8_t readFIFOFSK(struct ldl_radio *self, uint16_t n)
+{
+    uint16_t remaining;
+    uint16_t room;
+    uint16_t size = n;
+    
+    if((size > 0U) && (self->fsk_pos == 0U)){
+        
+        chipRead(self, RegFifo, &self->fsk_len, sizeof(self->fsk_len));
+        
+        self->fsk_pos = 1U;
+        size--;
+    }
+    
+    remaining = ((uint16_t)self->fsk_len + 1U) - self->fsk_pos;
+    room = ((uint16_t)self->fsk_max + 1U) - self->fsk_pos;
+    
+    size = (remaining < size) ? remaining : size;
+    
+    /* a frame longer than the buffer is left in the FIFO */
+    size = (room < size) ? room : size;
+    
+    if(size > 0U){
+        
+        chipTransfer(self, RegFifo, NULL, &self->fsk_rx[self->fsk_pos - 1U], (uint8_t)size);
+        
+        self->fsk_pos += size;
+    }
+    
+    return (uint8_t)size;
+}
+
+static void collectFSK(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta)
+{
+    const uint8_t *status = self->rx_status;
+    int32_t fei;
+    
+    /* RssiValue is -2 x dBm */
+    meta->rssi = -((int16_t)status[RegRssiValue - RegFifoRxCurrentAddr]) / 2;
+    
+    /* FeiValue x Fstep */
+    fei = (int32_t)(int16_t)(((uint16_t)status[RegFeiMsb - RegFifoRxCurrentAddr] << 8) | status[RegFeiLsb - RegFifoRxCurrentAddr]);
+    meta->freqError = (int32_t)(((int64_t)fei * 32000000LL) / (int64_t)(1UL << 19));
+    
+    self->rx_len = (self->fsk_len > self->fsk_max) ? self->fsk_max : self->fsk_len;
+    self->rx_len = (self->rx_len > self->rx_max) ? self->rx_max : self->rx_len;
+    
+    if(self->rx_data != self->fsk_rx){
+        
+        (void)memmove(self->rx_data, self->fsk_rx, self->rx_len);
+    }
+}
+
+static enum ldl_radio_event signalFSK(struct ldl_radio *self, uint8_t n)
+{
+    enum ldl_radio_event retval = LDL_RADIO_EVENT_NONE;
+    
+    switch(n){
+    case 0U:
+        retval = (self->dio_mapping1 == 0x00U) ? LDL_RADIO_EVENT_TX_COMPLETE : LDL_RADIO_EVENT_RX_READY;
+        break;
+    case 1U:
+        serviceFIFO(self);
+        break;
+    case 2U:
+        retval = (self->dio_mapping1 == 0x08U) ? LDL_RADIO_EVENT_RX_TIMEOUT : LDL_RADIO_EVENT_NONE;
+        break;
+    default:
+        /* do nothing */
+        break;
+    }
+    
+    return retval;
+}
+#endif
+
+
+static void setOp(struct ldl_radio *self, uint8_t op)
+{
+    writeReg(self, RegOpMode, (readReg(self, RegOpMode) & ~(0x7U)) | (op & 0x7U));    
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    /* RXCONTINUOUS (LoRa) and RX (FSK) */
+    self->continuous = (op == 5U);
+    
+    switch(op){
+    case 0U:
+        setState(self, LDL_RADIO_STATE_SLEEP);
+        break;
+    case 3U:
+        setState(self, LDL_RADIO_STATE_TX);
+        break;
+    case 5U:
+    case 6U:
+    case 7U:
+        setState(self, LDL_RADIO_STATE_RX);
+        break;
+    default:
+        setState(self, LDL_RADIO_STATE_STANDBY);
+        break;
+    }
+#endif    
+}
+
+static void setOpSleep(struct ldl_radio *self)
+{
+    setOp(self, 0U);
+}
+
+static void setOpStandby(struct ldl_radio *self)
+{   
+    setOp(self, 1U);    
+}
+
+static void setOpRX(struct ldl_radio *self)
+{   
+    setOp(self, 6U);
+}
+
+static void setOpRXContinuous(struct ldl_radio *self)
+{   
+    setOp(self, 5U);    
+}
+
+static void setOpTX(struct ldl_radio *self)
+{   
+    setOp(self, 3U);    
+}
+
+#ifdef LDL_ENABLE_CAD
+static void setOpCAD(struct ldl_radio *self)
+{   
+    setOp(self, 7U);    
+}
+#endif
+
+#ifdef LDL_ENABLE_SX1272
+static void entropyBeginSX1272(struct ldl_radio *self)
+{
+    /* application note instructions */
+    entropyBeginSX127X(self, 0x0aU, 0x74U);
+}
+
+static void setModemConfigSX1272(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit)
+{
+    bool low_rate = ((bw == LDL_BW_125) && ((sf == LDL_SF_11) || (sf == LDL_SF_12))) ? true : false;
+    uint8_t bw_setting;
+    
+    switch(bw){
+    default:
+    case LDL_BW_125:
+        bw_setting = 0x00U;
+        break;
+    case LDL_BW_250:
+        bw_setting = 0x40U;
+        break;
+    case LDL_BW_500:
+        bw_setting = 0x80U;
+        break;
+    }
+    
+    /* bandwidth            (2bit)
+     * codingRate           (3bit) (4/5)
+     * implicitHeaderModeOn (1bit)
+     * rxPayloadCrcOn       (1bit)
+     * lowDataRateOptimize  (1bit)      */
+    writeReg(self, RegModemConfig1, bw_setting | 8U | (implicit ? 4U : 2U) | (low_rate ? 1U : 0U));
+    
+    /* spreadingFactor      (4bit)
+     * txContinuousMode     (1bit) (0)
+     * agcAutoOn            (1bit) (1)
+     * symbTimeout(9:8)     (2bit) (0)  */
+    writeReg(self, RegModemConfig2, sfSetting(sf) | 0U | 4U | 0U);    
+}
+
+static void setPowerSX1272(struct ldl_radio *self, int16_t dbm)
+{
+    /* Todo: 
+     * 
+     * - compensate for output gains/losses here
+     * - adjust current limit trim
+     * 
+     * */
+    uint8_t paConfig;
+    uint8_t paDac;    
+    
+    dbm /= 100;
+    
+    paConfig = readReg(self, RegPaConfig);         
+    paConfig &= ~(0xfU);
+
+    switch(self->pa){
+    case LDL_RADIO_PA_RFO:
+    
+        /* -1 to 14dbm */
+        paConfig &= ~(0x80U);
+        paConfig |= (dbm > 14) ? 0xf : (uint8_t)( (dbm < -1) ? 0 : (dbm + 1) );
+        
+        writeReg(self, RegPaConfig, paConfig);            
+        break;
+    
+    case LDL_RADIO_PA_BOOST:
+    
+        paDac = readReg(self, RegPaDac); 
+            
+        paConfig |= 0x80U;
+        paDac &= ~(7U);
+
+        /* fixed 20dbm */
+        if(dbm >= 20){
+            
+            paDac |= 7U;                
+            paConfig |= 0xfU;
+        }
+        /* 2 dbm to 17dbm */
+        else{
+            
+            paDac |= 4U;
+            paConfig |= (dbm > 17) ? 0xf : ( (dbm < 2) ? 0 : (dbm - 2) ); 
+        }
+        
+        writeReg(self, RegPaDac, paDac);
+        writeReg(self, RegPaConfig, paConfig);            
+        break;
+    default:
+        break;        
+    }
+}
+#endif
+
+#ifdef LDL_ENABLE_SX1276
+static void entropyBeginSX1276(struct ldl_radio *self)
+{
+    /* application note instructions */
+    entropyBeginSX127X(self, 0x72U, 0x70U);
+}
+
+static void setModemConfigSX1276(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit)
+{
+    bool low_rate = ((bw == LDL_BW_125) && ((sf == LDL_SF_11) || (sf == LDL_SF_12))) ? true : false;
+    uint8_t bw_setting;
+    
+    switch(bw){
+    default:
+    case LDL_BW_125:
+        bw_setting = 0x70U;
+        break;
+    case LDL_BW_250:
+        bw_setting = 0x80U;
+        break;
+    case LDL_BW_500:
+        bw_setting = 0x90U;
+        break;
+    }
+    
+    /* bandwidth            (4bit)
+     * codingRate           (3bit) (4/5)
+     * implicitHeaderModeOn (1bit)      */
+    writeReg(self, RegModemConfig1, bw_setting | 2U | (implicit ? 1U : 0U));
+    
+    /* spreadingFactor      (4bit)
+     * txContinuousMode     (1bit) (0)
+     * rxPayloadCrcOn       (1bit)
+     * symbTimeout(9:8)     (2bit) (0)  */
+    writeReg(self, RegModemConfig2, sfSetting(sf) | 0U | (implicit ? 0U : 4U) | 0U);
+    
+    /* unused               (4bit) (0)
+     * lowDataRateOptimize  (1bit) 
+     * agcAutoOn            (1bit) (1)
+     * unused               (2bit) (0)  */
+    writeReg(self, RegModemConfig3, 0U | (low_rate ? 8U : 0U) | 4U | 0U);        
+}
+
+static void setPowerSX1276(struct ldl_radio *self, int16_t dbm)
+{
+    /* Todo: 
+     * 
+     * - compensate for output gains/losses here
+     * - adjust current limit trim
+     * 
+     * */
+    uint8_t paConfig;
+    uint8_t paDac;    
+    
+    dbm /= 100;
+    
+    paConfig = readReg(self, RegPaConfig);         
+    paConfig &= ~(0xfU);
+
+    switch(self->pa){
+    case LDL_RADIO_PA_RFO:
+    
+        /* todo */
+        paConfig |= 0x7eU;
+        writeReg(self, RegPaConfig, paConfig);            
+        break;
+    
+    case LDL_RADIO_PA_BOOST:
+    
+        /* regpadac address == 0x4d */
+        paDac = readReg(self, 0x4d); 
+            
+        paConfig |= 0x80U;
+        paConfig &= ~0x70U;
+        paDac &= ~(7U);
+
+        /* fixed 20dbm */
+        if(dbm >= 20){
+            
+            paDac |= 7U;                
+            paConfig |= 0xfU;
+        }
+        /* 2 dbm to 17dbm */
+        else{
+            
+            paDac |= 4U;
+            paConfig |= (dbm > 17) ? 0xf : ( (dbm < 2) ? 0 : (dbm - 2) ); 
+        }
+        
+        /* regpadac address == 0x4d */
+        writeReg(self, 0x4d, paDac);
+        writeReg(self, RegPaConfig, paConfig);   
+        break;
+    default:
+        break;        
+    }
+}
+#endif
+
+static uint16_t bwKHz(enum ldl_signal_bandwidth bw)
+{
+    uint16_t retval;
+    
+    switch(bw){
+    default:
+    case LDL_BW_125:
+        retval = 125U;
+        break;
+    case LDL_BW_250:
+        retval = 250U;
+        break;
+    case LDL_BW_500:
+        retval = 500U;
+        break;
+    }
+    
+    return retval;
+}
+
+static uint8_t sfSetting(enum ldl_spreading_factor sf)
+{
+    uint8_t retval = 0U;
+    
+    switch(sf){
+    default:
+    case LDL_SF_7:
+        retval = 0x70U;
+        break;
+    case LDL_SF_8:
+        retval = 0x80U;
+        break;
+    case LDL_SF_9:
+        retval = 0x90U;
+        break;
+    case LDL_SF_10:
+        retval = 0xa0U;
+        break;
+    case LDL_SF_11:
+        retval = 0xb0U;
+        break;
+    case LDL_SF_12:
+        retval = 0xc0U;
+        break;
+    }
+    return retval;
+}
+
+static void setFreq(struct ldl_radio *self, uint32_t freq)
+{
+    uint32_t f = (uint32_t)(((uint64_t)freq << 19U) / 32000000UL);
+    uint8_t frf[3];
+    
+    frf[0] = (uint8_t)(f >> 16);
+    frf[1] = (uint8_t)(f >> 8);
+    frf[2] = (uint8_t)f;
+    
+    /* a new frequency only takes effect when RegFrfLsb is written */
+    if(!shadowHit(self, RegFrfMsb, frf[0]) || !shadowHit(self, RegFrfMid, frf[1]) || !shadowHit(self, RegFrfLsb, frf[2])){
+        
+        putReg(self, RegFrfMsb, frf[0]);
+        putReg(self, RegFrfMid, frf[1]);
+        putReg(self, RegFrfLsb, frf[2]);
+    }
+}
+
+static void writeFIFO(struct ldl_radio *self, const uint8_t *data, uint8_t len)
+{
+    writeReg(self, RegFifoTxBaseAddr, 0x00U);    // set tx base
+    writeReg(self, RegFifoAddrPtr, 0x00U);       // set address pointer
+    writeReg(self, LoraRegPayloadLength, len);
+    burstWrite(self, RegFifo, data, len);        // write into fifo
+}
+
+static uint8_t readReg(struct ldl_radio *self, uint8_t reg)
+{
+    uint8_t data;
+    uint8_t slot = shadowSlot(reg);
+    
+    if((slot != UINT8_MAX) && ((self->shadow_valid & (1UL << slot)) != 0U)){
+        
+        data = self->shadow[slot];
+    }
+    else{
+        
+        planFlush(self);
+        
+        chipRead(self, reg, &data, sizeof(data));
+        shadowUpdate(self, reg, data);
+    }
+    
+    return data;
+}
+
+static void writeReg(struct ldl_radio *self, uint8_t reg, uint8_t data)
+{
+    /* the chip changes mode by itself so RegOpMode is always written */
+    if((reg == RegOpMode) || !shadowHit(self, reg, data)){
+    
+        putReg(self, reg, data);
+    }
+}
+
+/* write without checking the shadow */
+static void putReg(struct ldl_radio *self, uint8_t reg, uint8_t data)
+{
+    struct ldl_radio_plan *plan = self->plan;
+    uint8_t i;
+    
+    /* mode changes are never staged */
+    if((plan != NULL) && (reg != RegOpMode)){
+        
+        for(i=0U; i < plan->len; i++){
+            
+            if(plan->reg[i] == reg){
+                
+                break;
+            }
+        }
+        
+        if(i == sizeof(plan->reg)){
+            
+            planFlush(self);
+            i = 0U;
+        }
+        
+        plan->reg[i] = reg;
+        plan->data[i] = data;
+        plan->len = (i == plan->len) ? (plan->len + 1U) : plan->len;
+    }
+    else{
+        
+        planFlush(self);
+        
+        chipWrite(self, reg, &data, sizeof(data));
+    }
+    
+    shadowUpdate(self, reg, data);
+}
+
+static void planBegin(struct ldl_radio *self, struct ldl_radio_plan *plan)
+{
+    plan->len = 0U;
+    self->plan = plan;
+}
+
+static void planEnd(struct ldl_radio *self)
+{
+    planFlush(self);
+    self->plan = NULL;
+}
+
+static void planFlush(struct ldl_radio *self)
+{
+    struct ldl_radio_plan *plan = self->plan;
+    uint8_t buf[sizeof(plan->data) * 2U];
+    uint8_t reg;
+    uint8_t data;
+    uint8_t slot;
+    uint8_t len;
+    uint8_t i;
+    uint8_t j;
+    
+    if((plan != NULL) && (plan->len > 0U)){
+        
+        /* sort by address */
+        for(i=1U; i < plan->len; i++){
+            
+            reg = plan->reg[i];
+            data = plan->data[i];
+            
+            for(j=i; (j > 0U) && (plan->reg[j-1U] > reg); j--){
+                
+                plan->reg[j] = plan->reg[j-1U];
+                plan->data[j] = plan->data[j-1U];
+            }
+            
+            plan->reg[j] = reg;
+            plan->data[j] = data;
+        }
+        
+        i = 0U;
+        
+        while(i < plan->len){
+            
+            reg = plan->reg[i];
+            buf[0] = plan->data[i];
+            len = 1U;
+            i++;
+            
+            while(i < plan->len){
+                
+                /* contiguous */
+                if(plan->reg[i] == (reg + len)){
+                    
+                    buf[len] = plan->data[i];
+                    len++;
+                    i++;
+                }
+                else{
+                    
+                    /* bridge a single register gap if the shadow knows its value */
+                    slot = shadowSlot(reg + len);
+                    
+                    if((plan->reg[i] == (reg + len + 1U)) && (slot != UINT8_MAX) && (slot != 0U) && ((self->shadow_valid & (1UL << slot)) != 0U)){
+                        
+                        buf[len] = self->shadow[slot];
+                        buf[len + 1U] = plan->data[i];
+                        len += 2U;
+                        i++;
+                    }
+                    else{
+                        
+                        break;
+                    }
+                }
+            }
+            
+            chipWrite(self, reg, buf, len);
+        }
+        
+        plan->len = 0U;
+    }
+}
+
+/* Configuration registers which only change when written by the driver.
+ * 
+ * RegOpMode is included so that read-modify-write of the mode bits
+ * does not need a read. The mode bits in the shadow may be stale.
+ * 
+ * */
+static uint8_t shadowSlot(uint8_t reg)
+{
+    uint8_t retval;
+    
+    switch(reg){
+    case RegOpMode:
+        retval = 0U;
+        break;
+    case RegFrfMsb:
+        retval = 1U;
+        break;
+    case RegFrfMid:
+        retval = 2U;
+        break;
+    case RegFrfLsb:
+        retval = 3U;
+        break;
+    case RegPaConfig:
+        retval = 4U;
+        break;
+    case RegPaRamp:
+        retval = 5U;
+        break;
+    case RegLna:
+        retval = 6U;
+        break;
+    case RegFifoTxBaseAddr:
+        retval = 7U;
+        break;
+    case RegIrqFlagsMask:
+        retval = 8U;
+        break;
+    case RegModemConfig1:
+        retval = 9U;
+        break;
+    case RegModemConfig2:
+        retval = 10U;
+        break;
+    case RegSymbTimeoutLsb:
+        retval = 11U;
+        break;
+    case RegPayloadMaxLength:
+        retval = 12U;
+        break;
+    case RegModemConfig3:
+        retval = 13U;
+        break;
+    case RegInvertIQ:
+        retval = 14U;
+        break;
+    case RegSyncWord:
+        retval = 15U;
+        break;
+    case RegDioMapping1:
+        retval = 16U;
+        break;
+    case 0x4dU:     /* SX1276 RegPaDac */
+        retval = 17U;
+        break;
+    case RegPaDac:  /* SX1272 RegPaDac */
+        retval = 18U;
+        break;
+    default:
+        retval = UINT8_MAX;
+        break;
+    }
+    
+    return retval;
+}
+
+static bool shadowHit(const struct ldl_radio *self, uint8_t reg, uint8_t data)
+{
+    uint8_t slot = shadowSlot(reg);
+    
+    return ((slot != UINT8_MAX) && ((self->shadow_valid & (1UL << slot)) != 0U) && (self->shadow[slot] == data));
+}
+
+static void shadowUpdate(struct ldl_radio *self, uint8_t reg, uint8_t data)
+{
+    uint8_t slot = shadowSlot(reg);
+    
+    if(slot != UINT8_MAX){
+        
+        self->shadow[slot] = data;
+        self->shadow_valid |= (1UL << slot);
+    }
+}
+
+/* data must remain valid until the batch completes */
+static void burstWrite(struct ldl_radio *self, uint8_t reg, const uint8_t *data, uint8_t len)
+{
+    planFlush(self);
+    
+    chipTransfer(self, reg, data, NULL, len);
+}
+
+#endif
+
+#ifdef LDL_ENABLE_SX126X
+static void transmitSX126X(struct ldl_radio *self, const struct ldl_radio_tx_setting *settings, const uint8_t *data, uint8_t len)
+{
+    LDL_PEDANTIC(settings->sf != LDL_SF_FSK)
+    
+    batchBegin(self);
+    
+    standbySX126X(self);
+    setupSX126X(self);
+    
+    setFreqSX126X(self, settings->freq);
+    setModemConfigSX126X(self, settings->bw, settings->sf, false);
+    setPacketSX126X(self, 8U, false, len, true, false);
+    RADIO_OPS(self)->setPower(self, settings->dbm);
+    setIrqSX126X(self, IrqTxDone, IrqTxDone);
+    clearIrqSX126X(self);
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    self->tx_current = txCurrent(self, settings->dbm / 100);
+#endif
+    
+    transmitRestSX126X(self, data, len, 0U);
+    
+    batchEnd(self);
+}
+
+static void receiveSX126X(struct ldl_radio *self, const struct ldl_radio_rx_setting *settings)
+{
+    /* single mode ends at LoRaSymbNumTimeout instead of a timer */
+    static const uint8_t single[] = {0U, 0U, 0U};
+    static const uint8_t continuous[] = {0xffU, 0xffU, 0xffU};
+    
+    LDL_PEDANTIC(settings->sf != LDL_SF_FSK)
+    
+    batchBegin(self);
+    
+    standbySX126X(self);
+    setupSX126X(self);
+    
+    setFreqSX126X(self, settings->freq);
+    setModemConfigSX126X(self, settings->bw, settings->sf, false);
+    
+    if(settings->beacon){
+        
+        setPacketSX126X(self, 10U, true, settings->max, false, false);
+    }
+    else{
+        
+        setPacketSX126X(self, 8U, false, settings->max, false, true);
+    }
+    
+    (void)commandSX126X(self, SlotSymbNumTimeout, &settings->timeout);
+    
+    /* a header error ends the reception without RxDone */
+    setIrqSX126X(self, IrqRxDone | IrqTimeout | IrqHeaderErr | IrqCrcErr, IrqRxDone | IrqTimeout | IrqHeaderErr);
+    clearIrqSX126X(self);
+    
+    setModeSX126X(self, SetRx, settings->continuous ? continuous : single, sizeof(single));
+    
+    batchEnd(self);
+}
+
+#ifdef LDL_ENABLE_CAD
+static void cadSX126X(struct ldl_radio *self, const struct ldl_radio_cad_setting *settings)
+{
+    /* detection peak for two symbols (SF7 to SF12) */
+    static const uint8_t peak[] = {22U, 22U, 23U, 24U, 25U, 28U};
+    uint8_t param[7U];
+    
+    batchBegin(self);
+    
+    standbySX126X(self);
+    setupSX126X(self);
+    
+    setFreqSX126X(self, settings->freq);
+    setModemConfigSX126X(self, settings->bw, settings->sf, false);
+    
+    /* listening for uplinks */
+    setPacketSX126X(self, 8U, false, UINT8_MAX, true, false);
+    
+    param[0] = 0x01U;                                   // two symbols
+    param[1] = peak[((settings->sf >= LDL_SF_7) && (settings->sf <= LDL_SF_12)) ? (settings->sf - LDL_SF_7) : 0U];
+    param[2] = 10U;                                     // detection minimum
+    param[3] = 0x00U;                                   // CAD only
+    param[4] = 0x00U;                                   // timeout (not used)
+    param[5] = 0x00U;
+    param[6] = 0x00U;
+    
+    (void)commandSX126X(self, SlotCadParams, param);
+    
+    setIrqSX126X(self, IrqCadDone | IrqCadDetected, IrqCadDone);
+    clearIrqSX126X(self);
+    
+    /* SetCad has no parameters */
+    setModeSX126X(self, SetCad, peak, 0U);
+    
+    batchEnd(self);
+}
+
+static bool cadDetectedSX126X(struct ldl_radio *self)
+{
+    uint8_t status[3U] = {0U};
+    
+    chipRead(self, GetIrqStatus, status, sizeof(status));
+    
+    return ((status[1] & (uint8_t)(IrqCadDetected >> 8)) != 0U);
+}
+#endif
+
+static void collectBeginSX126X(struct ldl_radio *self)
+{
+    /* reads clock out what is in the buffer */
+    (void)memset(self->rx_status, 0, sizeof(self->rx_status));
+    
+    batchBegin(self);
+    
+    chipTransfer(self, GetIrqStatus, NULL, &self->rx_status[RxIrqStatus], 3U);
+    chipTransfer(self, GetRxBufferStatus, NULL, &self->rx_status[RxBufferStatus], 3U);
+    chipTransfer(self, GetPacketStatus, NULL, &self->rx_status[RxPacketStatus], 4U);
+    
+    batchEnd(self);
+}
+
+static bool collectResumeSX126X(struct ldl_radio *self)
+{
+    bool retval = true;
+    uint16_t irq;
+    uint8_t start;
+    
+    if(self->rx_step == 0U){
+        
+        self->rx_step = 1U;
+        
+        irq = ((uint16_t)self->rx_status[RxIrqStatus + 1U] << 8) | self->rx_status[RxIrqStatus + 2U];
+        
+        /* a frame that failed CRC is collected as zero length */
+        if((irq & (IrqRxDone | IrqCrcErr | IrqHeaderErr)) == IrqRxDone){
+            
+            self->rx_len = self->rx_status[RxBufferStatus + 1U];
+            self->rx_len = (self->rx_len > self->rx_max) ? self->rx_max : self->rx_len;
+        }
+        
+        /* ReadBuffer returns two status bytes while the offset and NOP 
+         * are clocked out. The first two bytes of the frame are read into 
+         * scratch so that the rest can be read in place from two bytes 
+         * further on. */
+        if(self->rx_len > 0U){
+            
+            start = self->rx_status[RxBufferStatus + 2U];
+            
+            self->rx_status[RxHead] = start;
+            
+            batchBegin(self);
+            
+            chipTransfer(self, ReadBuffer, NULL, &self->rx_status[RxHead], (self->rx_len > 2U) ? 4U : (self->rx_len + 2U));
+            
+            if(self->rx_len > 2U){
+                
+                (void)memset(self->rx_data, 0, self->rx_len);
+                
+                self->rx_data[0] = (uint8_t)(start + 2U);
+                
+                chipTransfer(self, ReadBuffer, NULL, self->rx_data, self->rx_len);
+            }
+            
+            batchEnd(self);
+            
+            retval = false;
+        }
+    }
+    
+    return retval;
+}
+
+static void collectSX126X(struct ldl_radio *self, struct ldl_radio_packet_metadata *meta)
+{
+    const uint8_t *status = &self->rx_status[RxPacketStatus];
+    
+    meta->timeout = ((self->rx_status[RxIrqStatus + 1U] & (uint8_t)(IrqTimeout >> 8)) != 0U);
+    
+    /* RssiPkt is -2 x dBm, SnrPkt is 4 x dB, frequency error is not reported */
+    meta->rssi = -((int16_t)status[1]) / 2;
+    meta->snr = ((int16_t)(int8_t)status[2]) * 100 / 4;
+    
+    (void)memcpy(self->rx_data, &self->rx_status[RxHead + 2U], (self->rx_len > 2U) ? 2U : self->rx_len);
+}
+
+static enum ldl_radio_event signalSX126X(struct ldl_radio *self, uint8_t n)
+{
+    enum ldl_radio_event retval = LDL_RADIO_EVENT_NONE;
+    
+    /* everything is routed to DIO1 */
+    if(n == 1U){
+        
+        if((self->irq_mask & IrqTxDone) != 0U){
+            
+            retval = LDL_RADIO_EVENT_TX_COMPLETE;
+        }
+#ifdef LDL_ENABLE_CAD
+        else if((self->irq_mask & IrqCadDone) != 0U){
+            
+            retval = LDL_RADIO_EVENT_CAD_DONE;
+        }
+#endif
+        else if((self->irq_mask & IrqRxDone) != 0U){
+            
+            /* may be a timeout; collectSX126X() tells from the IRQ status */
+            retval = LDL_RADIO_EVENT_RX_READY;
+        }
+        else{
+            
+            /* not expected */
+        }
+    }
+    
+    return retval;
+}
+
+static void entropyBeginSX126X(struct ldl_radio *self)
+{
+    static const uint8_t continuous[] = {0xffU, 0xffU, 0xffU};
+    
+    batchBegin(self);
+    
+    standbySX126X(self);
+    setupSX126X(self);
+    
+    setIrqSX126X(self, 0U, 0U);
+    
+    setModeSX126X(self, SetRx, continuous, sizeof(continuous));
+    
+    batchEnd(self);
+}
+
+static unsigned int entropyEndSX126X(struct ldl_radio *self)
+{
+    unsigned int retval = 0U;
+    uint8_t rssi[2U];
+    size_t i;
+    
+    for(i=0U; i < (sizeof(unsigned int)*8U); i++){
+        
+        (void)memset(rssi, 0, sizeof(rssi));
+        
+        chipRead(self, GetRssiInst, rssi, sizeof(rssi));
+        
+        retval <<= 1;
+        retval |= rssi[1] & 0x1U;
+    }
+    
+    sleepSX126X(self);
+    
+    return retval;
+}
+
+static void clearInterruptSX126X(struct ldl_radio *self)
+{
+    batchBegin(self);
+    
+    clearIrqSX126X(self);
+    sleepSX126X(self);
+    
+    batchEnd(self);
+}
+
+/* warm start retains the configuration, and so the shadow */
+static void sleepSX126X(struct ldl_radio *self)
+{
+    static const uint8_t warm[] = {0x04U};
+    
+    setModeSX126X(self, SetSleep, warm, sizeof(warm));
+}
+
+/* also wakes the chip from sleep */
+static void standbySX126X(struct ldl_radio *self)
+{
+    static const uint8_t rc[] = {0x00U};
+    
+    setModeSX126X(self, SetStandby, rc, sizeof(rc));
+}
+
+/* param must remain valid until the batch completes */
+static void setModeSX126X(struct ldl_radio *self, uint8_t opcode, const uint8_t *param, uint8_t size)
+{
+    chipTransfer(self, opcode, param, NULL, size);
+    
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    /* BUSY stays high until the transfer that wakes the chip */
+    self->asleep = (opcode == SetSleep);
+#endif
+    
+#ifdef LDL_ENABLE_RADIO_ENERGY
+    /* SetRx with the 0xffffff timeout */
+    self->continuous = (opcode == SetRx) && (size == 3U) && ((param[0] & param[1] & param[2]) == 0xffU);
+    
+    switch(opcode){
+    case SetSleep:
+        setState(self, LDL_RADIO_STATE_SLEEP);
         break;
-#endif
-#ifdef LDL_ENABLE_SX1276          
-    case LDL_RADIO_SX1276:    
-        switch(bw){
-        default:
-        case LDL_BW_125:
-            retval = 0x70U;
-            break;
-        case LDL_BW_250:
-            retval = 0x80U;
-            break;
-        case LDL_BW_500:
-            retval = 0x90U;
-            break;
-        }
+    case SetTx:
+        setState(self, LDL_RADIO_STATE_TX);
+        break;
+    case SetRx:
+    case SetCad:
+        setState(self, LDL_RADIO_STATE_RX);
+        break;
+    default:
+        setState(self, LDL_RADIO_STATE_STANDBY);
         break;
+    }
+#endif    
+}
+
+/* configuration that only needs to be sent after reset (in standby) */
+static void setupSX126X(struct ldl_radio *self)
+{
+#ifdef LDL_DISABLE_SX126X_DCDC
+    static const uint8_t regulator[] = {0x00U};
+#else
+    static const uint8_t regulator[] = {0x01U};
+#endif
+#ifdef LDL_ENABLE_SX126X_TCXO
+    /* 5ms startup */
+    static const uint8_t tcxo[] = {LDL_SX126X_TCXO_VOLTAGE, 0x00U, 0x01U, 0x40U};
+    static const uint8_t all[] = {0x7fU};
+#endif
+#ifdef LDL_ENABLE_SX126X_DIO2_RF_SWITCH
+    static const uint8_t rf_switch[] = {0x01U};
 #endif
+    static const uint8_t base[] = {0x00U, 0x00U};
+    static const uint8_t sync[] = {0x07U, 0x40U, 0x34U, 0x44U};      // 0x3444 (public network)
+    
+    (void)commandSX126X(self, SlotRegulatorMode, regulator);
+    
+#ifdef LDL_ENABLE_SX126X_TCXO
+    /* calibration at reset failed without the TCXO running */
+    if(commandSX126X(self, SlotTcxo, tcxo)){
+        
+        chipTransfer(self, Calibrate, all, NULL, sizeof(all));
     }
+#endif
+#ifdef LDL_ENABLE_SX126X_DIO2_RF_SWITCH
+    (void)commandSX126X(self, SlotRfSwitch, rf_switch);
+#endif
+    
+    enableLoraSX126X(self);
     
-    return retval;    
+    (void)commandSX126X(self, SlotBufferBaseAddress, base);
+    (void)commandSX126X(self, SlotSyncWord, sync);
 }
 
-static uint8_t sfSetting(const struct ldl_radio *self, enum ldl_spreading_factor sf)
+static void enableLoraSX126X(struct ldl_radio *self)
 {
-    uint8_t retval = 0U;
+    static const uint8_t lora[] = {0x01U};
     
-    (void)self;
+    /* parameters are interpreted by packet type */
+    if(commandSX126X(self, SlotPacketType, lora)){
+        
+        self->shadow_valid &= ~((1UL << SlotModulationParams) | (1UL << SlotPacketParams) | (1UL << SlotCadParams));
+    }
+}
+
+static void setFreqSX126X(struct ldl_radio *self, uint32_t freq)
+{
+    uint32_t f = (uint32_t)(((uint64_t)freq << 25U) / 32000000UL);
+    uint8_t band[2U];
+    uint8_t param[4U];
     
-    switch(sf){
+    /* image calibration for the band */
+    if(freq < 446000000UL){
+        
+        band[0] = 0x6bU;
+        band[1] = 0x6fU;
+    }
+    else if(freq < 600000000UL){
+        
+        band[0] = 0x75U;
+        band[1] = 0x81U;
+    }
+    else if(freq < 800000000UL){
+        
+        band[0] = 0xc1U;
+        band[1] = 0xc5U;
+    }
+    else if(freq < 900000000UL){
+        
+        band[0] = 0xd7U;
+        band[1] = 0xdbU;
+    }
+    else{
+        
+        band[0] = 0xe1U;
+        band[1] = 0xe9U;
+    }
+    
+    (void)commandSX126X(self, SlotCalibrateImage, band);
+    
+    param[0] = (uint8_t)(f >> 24);
+    param[1] = (uint8_t)(f >> 16);
+    param[2] = (uint8_t)(f >> 8);
+    param[3] = (uint8_t)f;
+    
+    (void)commandSX126X(self, SlotRfFrequency, param);
+}
+
+/* header mode is a packet parameter on the SX126x (see setPacketSX126X()) */
+static void setModemConfigSX126X(struct ldl_radio *self, enum ldl_signal_bandwidth bw, enum ldl_spreading_factor sf, bool implicit)
+{
+    uint8_t param[4U];
+    
+    (void)implicit;
+    
+    param[0] = (uint8_t)sf;
+    
+    switch(bw){
     default:
-    case LDL_SF_7:
-        retval = 0x70U;
-        break;
-    case LDL_SF_8:
-        retval = 0x80U;
-        break;
-    case LDL_SF_9:
-        retval = 0x90U;
-        break;
-    case LDL_SF_10:
-        retval = 0xa0U;
+    case LDL_BW_125:
+        param[1] = 0x04U;
         break;
-    case LDL_SF_11:
-        retval = 0xb0U;
+    case LDL_BW_250:
+        param[1] = 0x05U;
         break;
-    case LDL_SF_12:
-        retval = 0xc0U;
+    case LDL_BW_500:
+        param[1] = 0x06U;
         break;
     }
-    return retval;
+    
+    param[2] = 0x01U;                                                           // 4/5
+    param[3] = ((bw == LDL_BW_125) && ((sf == LDL_SF_11) || (sf == LDL_SF_12))) ? 1U : 0U;    // low data rate optimize
+    
+    (void)commandSX126X(self, SlotModulationParams, param);
 }
 
-static uint8_t crSetting(const struct ldl_radio *self, enum ldl_coding_rate cr)
+static void setPacketSX126X(struct ldl_radio *self, uint8_t preamble, bool implicit, uint8_t len, bool crc, bool invertIQ)
 {
-    uint8_t retval = 0U;
+    uint8_t param[6U];
+    uint8_t iq[3U];
     
-    (void)cr;
+    param[0] = 0x00U;
+    param[1] = preamble;
+    param[2] = implicit ? 1U : 0U;
+    param[3] = len;                     // payload length (maximum in explicit header RX)
+    param[4] = crc ? 1U : 0U;
+    param[5] = invertIQ ? 1U : 0U;
     
-    switch(self->type){
-    default:
-        break;
-#ifdef LDL_ENABLE_SX1272
-    case LDL_RADIO_SX1272:
-        retval = 8U;    // CR_5
-        break;
+    (void)commandSX126X(self, SlotPacketParams, param);
+    
+    /* IQ polarity errata: bit 2 of 0x0736 is cleared for inverted IQ */
+    iq[0] = 0x07U;
+    iq[1] = 0x36U;
+    iq[2] = invertIQ ? 0x09U : 0x0dU;
+    
+    (void)commandSX126X(self, SlotIQ, iq);
+}
+
+/* power is dBm and pa the SetPaConfig parameters */
+static void setPowerSX126X(struct ldl_radio *self, int16_t power, const uint8_t *pa)
+{
+    uint8_t param[2U];
+    
+    param[0] = (uint8_t)(int8_t)power;
+    param[1] = 0x02U;                                   // 40us ramp
+    
+    (void)commandSX126X(self, SlotPaConfig, pa);
+    (void)commandSX126X(self, SlotTxParams, param);
+}
+
+static void setIrqSX126X(struct ldl_radio *self, uint16_t mask, uint16_t dio1)
+{
+    uint8_t param[8U];
+    
+    self->irq_mask = dio1;
+    
+    param[0] = (uint8_t)(mask >> 8);
+    param[1] = (uint8_t)mask;
+    param[2] = (uint8_t)(dio1 >> 8);
+    param[3] = (uint8_t)dio1;
+    param[4] = 0x00U;                   // DIO2
+    param[5] = 0x00U;
+    param[6] = 0x00U;                   // DIO3
+    param[7] = 0x00U;
+    
+    (void)commandSX126X(self, SlotDioIrqParams, param);
+}
+
+static void clearIrqSX126X(struct ldl_radio *self)
+{
+    static const uint8_t all[] = {0xffU, 0xffU};
+    
+    chipTransfer(self, ClearIrqStatus, all, NULL, sizeof(all));
+}
+
+/* write the frame from pos and transmit once all of it is in the buffer */
+static void transmitRestSX126X(struct ldl_radio *self, const uint8_t *data, uint8_t len, uint8_t pos)
+{
+    static const uint8_t timeout[] = {0U, 0U, 0U};
+    
+    if(writeBufferSX126X(self, data, len, pos)){
+    
+        setModeSX126X(self, SetTx, timeout, sizeof(timeout));
+    }
+}
+
+/* WriteBuffer takes the offset as its first parameter so the frame
+ * is copied in behind it, in as few pieces as the stack allows.
+ * 
+ * With #LDL_ENABLE_CHIP_ASYNC the pieces are copied into the batch
+ * and what does not fit is written by the next batch from 
+ * LDL_Radio_resume().
+ * 
+ * @retval true the frame is in the buffer
+ * 
+ * */
+static bool writeBufferSX126X(struct ldl_radio *self, const uint8_t *data, uint8_t len, uint8_t pos)
+{
+    uint8_t buf[64U];
+    uint8_t at = pos;
+    uint8_t n;
+    bool retval = true;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    uint8_t space;
 #endif
-#ifdef LDL_ENABLE_SX1276
-    case LDL_RADIO_SX1276:
-        retval = 2U;    // CR_5
-        break;
+    
+    while(retval && (at < len)){
+        
+        n = len - at;
+        n = (n > (sizeof(buf) - 1U)) ? (uint8_t)(sizeof(buf) - 1U) : n;
+        
+#ifdef LDL_ENABLE_CHIP_ASYNC
+        /* SetTx is queued after the last piece */
+        space = batchSpace(self, 2U);
+        
+        if(space < 2U){
+            
+            self->next = LDL_RADIO_NEXT_WRITE_BUFFER;
+            self->next_data = data;
+            self->next_len = len;
+            self->next_pos = at;
+            
+            retval = false;
+        }
+        else{
+            
+            n = (n > (space - 1U)) ? (uint8_t)(space - 1U) : n;
+        }
+        
+        if(retval){
+#endif
+            buf[0] = at;
+            (void)memcpy(&buf[1], &data[at], n);
+            
+            chipWrite(self, WriteBuffer, buf, n + 1U);
+            
+            at += n;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+        }
 #endif
     }
     
     return retval;
 }
 
-static void setFreq(struct ldl_radio *self, uint32_t freq)
+/* Send a configuration command unless the chip already has these 
+ * parameters.
+ * 
+ * The parameters are sent from the shadow which is not changed again
+ * until the next batch, so they are not copied when queued.
+ * 
+ * */
+static bool commandSX126X(struct ldl_radio *self, enum ldl_radio_sx126x_slot slot, const uint8_t *param)
 {
-    uint32_t f = (uint32_t)(((uint64_t)freq << 19U) / 32000000UL);
+    const struct ldl_radio_sx126x_command *cmd = &sx126x_command[slot];
+    uint8_t *shadow = &self->cmd_shadow[cmd->offset];
+    bool retval = false;
+    
+    if(((self->shadow_valid & (1UL << slot)) == 0U) || (memcmp(shadow, param, cmd->size) != 0)){
+        
+        (void)memcpy(shadow, param, cmd->size);
+        self->shadow_valid |= (1UL << slot);
+        
+        chipTransfer(self, cmd->opcode, shadow, NULL, cmd->size);
         
-    writeReg(self, RegFrfMsb, f >> 16);
-    writeReg(self, RegFrfMid, f >> 8);
-    writeReg(self, RegFrfLsb, f);    
+        retval = true;
+    }
+    
+    return retval;
 }
+#endif
 
-static uint8_t readFIFO(struct ldl_radio *self, uint8_t *data, uint8_t max)
+#ifdef LDL_ENABLE_SX1261
+static void setPowerSX1261(struct ldl_radio *self, int16_t dbm)
 {
-    uint8_t size = readReg(self, RegRxNbBytes);
+    static const uint8_t pa_14[] = {0x04U, 0x00U, 0x01U, 0x01U};
+    static const uint8_t pa_15[] = {0x06U, 0x00U, 0x01U, 0x01U};
+    int16_t power = dbm / 100;
     
-    size = (size > max) ? max : size;
+    power = (power < -17) ? -17 : power;
+    power = (power > 15) ? 15 : power;
     
-    if(size > 0U){
+    /* +15dBm is +14dBm with a longer duty cycle */
+    if(power > 14){
+        
+        setPowerSX126X(self, 14, pa_15);
+    }
+    else{
+        
+        setPowerSX126X(self, power, pa_14);
+    }
+}
+#endif
+
+#ifdef LDL_ENABLE_SX1262
+static void setPowerSX1262(struct ldl_radio *self, int16_t dbm)
+{
+    static const uint8_t pa_22[] = {0x04U, 0x07U, 0x00U, 0x01U};
+    int16_t power = dbm / 100;
+    
+    power = (power < -9) ? -9 : power;
+    power = (power > 22) ? 22 : power;
+    
+    setPowerSX126X(self, power, pa_22);
+}
+#endif
+
+/* Transfers between batchBegin() and batchEnd() are submitted
+ * together with LDL_Chip_submit() if #LDL_ENABLE_CHIP_ASYNC is
+ * defined, otherwise they are performed as they are made.
+ * 
+ * A batch is only begun once the last has completed, so reads made
+ * with chipRead() are performed immediately without waiting. This 
+ * is only safe within a batch for registers that the queued writes
+ * do not change, anything else is read with a queued transfer.
+ * 
+ * */
+static void batchBegin(struct ldl_radio *self)
+{
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    LDL_PEDANTIC(!self->busy)
+    
+    self->xfer_len = 0U;
+    self->xfer_data_len = 0U;
+    self->batch = true;
+#else
+    (void)self;
+#endif    
+}
+
+static void batchEnd(struct ldl_radio *self)
+{
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    self->batch = false;
     
-        writeReg(self, RegFifoAddrPtr, readReg(self, RegFifoRxCurrentAddr));
+    if(self->xfer_len > 0U){
         
-        burstRead(self, RegFifo, data, size);
+        batchSubmit(self);
     }
+#else
+    (void)self;
+#endif    
+}
 
-    return size;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+static void batchSubmit(struct ldl_radio *self)
+{
+    self->busy = true;
+    
+    LDL_Chip_submit(self->board, self->xfer, self->xfer_len);
 }
+#endif
 
-static void writeFIFO(struct ldl_radio *self, const uint8_t *data, uint8_t len)
+/* data is copied if queued */
+static void chipWrite(struct ldl_radio *self, uint8_t reg, const uint8_t *data, uint8_t size)
 {
-    writeReg(self, RegFifoTxBaseAddr, 0x00U);    // set tx base
-    writeReg(self, RegFifoAddrPtr, 0x00U);       // set address pointer
-    writeReg(self, LoraRegPayloadLength, len);
-    burstWrite(self, RegFifo, data, len);        // write into fifo
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    uint8_t *copy;
+    
+    if(self->batch){
+        
+        /* the queue is sized for the largest batch */
+        LDL_PEDANTIC(batchSpace(self, 1U) >= size)
+        
+        if(batchSpace(self, 1U) >= size){
+        
+            copy = &self->xfer_data[self->xfer_data_len];
+            
+            (void)memcpy(copy, data, size);
+            
+            self->xfer_data_len += size;
+            
+            chipTransfer(self, reg, copy, NULL, size);
+        }
+    }
+    else{
+        
+        chipTransfer(self, reg, data, NULL, size);
+    }
+#else
+    chipTransfer(self, reg, data, NULL, size);
+#endif    
 }
 
-static uint8_t readReg(struct ldl_radio *self, uint8_t reg)
+static void chipRead(struct ldl_radio *self, uint8_t reg, uint8_t *data, uint8_t size)
 {
-    uint8_t data;
-    LDL_Chip_read(self->board, reg, &data, sizeof(data));
-    return data;
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    LDL_PEDANTIC(!self->busy)
+    
+    self->asleep = false;
+#endif
+    
+    LDL_Chip_read(self->board, reg, data, size);
 }
 
-static void writeReg(struct ldl_radio *self, uint8_t reg, uint8_t data)
+/* buffers must remain valid until the batch completes */
+static void chipTransfer(struct ldl_radio *self, uint8_t reg, const uint8_t *out, uint8_t *in, uint8_t size)
+{
+#ifdef LDL_ENABLE_CHIP_ASYNC
+    struct ldl_chip_xfer *xfer;
+    
+    if(self->batch){
+        
+        /* the queue is sized for the largest batch */
+        LDL_PEDANTIC(self->xfer_len < (sizeof(self->xfer)/sizeof(*self->xfer)))
+        
+        if(self->xfer_len < (sizeof(self->xfer)/sizeof(*self->xfer))){
+        
+            xfer = &self->xfer[self->xfer_len];
+            
+            xfer->addr = reg;
+            xfer->write = out;
+            xfer->read = in;
+            xfer->size = size;
+            xfer->wait = RADIO_OPS(self)->wait && !self->asleep;
+            
+            self->xfer_len++;
+        }
+    }
+    else{
+        
+        LDL_PEDANTIC(!self->busy)
+        
+        if(out != NULL){
+            
+            LDL_Chip_write(self->board, reg, out, size);
+        }
+        else{
+            
+            LDL_Chip_read(self->board, reg, in, size);
+        }
+    }
+    
+    /* any transfer wakes the chip */
+    self->asleep = false;
+#else
+    if(out != NULL){
+        
+        LDL_Chip_write(self->board, reg, out, size);
+    }
+    else{
+        
+        LDL_Chip_read(self->board, reg, in, size);
+    }
+#endif    
+}
+
+#ifdef LDL_ENABLE_CHIP_ASYNC
+/* bytes that can still be copied into the batch if another
+ * count transfers can be queued */
+static uint8_t batchSpace(const struct ldl_radio *self, uint8_t count)
 {
-    LDL_Chip_write(self->board, reg, &data, sizeof(data));
+    uint8_t retval = 0U;
+    
+    if(((uint16_t)self->xfer_len + count) <= (sizeof(self->xfer)/sizeof(*self->xfer))){
+        
+        retval = (uint8_t)(sizeof(self->xfer_data) - self->xfer_data_len);
+    }
+    
+    return retval;
 }
+#endif
 
-static void burstWrite(struct ldl_radio *self, uint8_t reg, const uint8_t *data, uint8_t len)
+#ifdef LDL_ENABLE_RADIO_ENERGY
+static void setState(struct ldl_radio *self, enum ldl_radio_state state)
+{
+    uint32_t now;
+    uint32_t elapsed;
+    
+    LDL_SYSTEM_ENTER_CRITICAL(self->app)
+    
+    if(self->counting){
+        
+        now = LDL_System_ticks(self->app);
+        elapsed = now - self->state_since;
+        
+        self->time[self->state] += elapsed;
+        self->charge += (uint64_t)elapsed * stateCurrent(self, self->state);
+        
+        self->state_since = now;
+    }
+    
+    self->state = state;
+    
+    LDL_SYSTEM_LEAVE_CRITICAL(self->app)
+}
+
+static uint32_t stateCurrent(const struct ldl_radio *self, enum ldl_radio_state state)
 {
-    LDL_Chip_write(self->board, reg, data, len);    
+    uint32_t retval = 0U;
+    
+    if(self->current != NULL){
+        
+        switch(state){
+        default:
+        case LDL_RADIO_STATE_SLEEP:
+            retval = self->current->sleep;
+            break;
+        case LDL_RADIO_STATE_STANDBY:
+            retval = self->current->standby;
+            break;
+        case LDL_RADIO_STATE_RX:
+            retval = self->current->rx;
+            break;
+        case LDL_RADIO_STATE_TX:
+            retval = self->tx_current;
+            break;
+        }
+    }
+    
+    return retval;
 }
 
-static void burstRead(struct ldl_radio *self, uint8_t reg, uint8_t *data, uint8_t len)
+static uint32_t txCurrent(const struct ldl_radio *self, int16_t dbm)
 {
-    LDL_Chip_read(self->board, reg, data, len);    
+    uint32_t retval = 0U;
+    const struct ldl_radio_tx_current *table;
+    uint8_t len;
+    uint8_t i;
+    
+    if(self->current != NULL){
+        
+        if(self->pa == LDL_RADIO_PA_BOOST){
+            
+            table = self->current->boost;
+            len = self->current->boostLen;
+        }
+        else{
+            
+            table = self->current->rfo;
+            len = self->current->rfoLen;
+        }
+        
+        for(i=0U; i < len; i++){
+            
+            retval = table[i].current;
+            
+            if(table[i].dbm >= dbm){
+                
+                break;
+            }
+        }
+    }
+    
+    return retval;
 }
+#endif
 
 #endif
@@ -37,10 +37,321 @@
 #endif
 
 #include <stddef.h>
+
+/* A region is described by a const descriptor kept in flash. The
+ * descriptors are indexed by enum ldl_region so every lookup is a
+ * single index followed by a read from a small table.
+ * 
+ * To add a region: add it to enum ldl_region, add its LDL_ENABLE_*
+ * option, and add a descriptor to the regions table. Only regions
+ * that do not fit these tables need new code.
+ * 
+ * When only one region is included the region argument is ignored
+ * and the descriptor is a compile time constant. Code for channel
+ * plans and CFList types that no included region uses is left out.
+ * 
+ * */
+
+#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)
+#   define REGION_DYNAMIC_PLAN
+#endif
+#if defined(LDL_ENABLE_US_902_928) || defined(LDL_ENABLE_AU_915_928)
+#   define REGION_FIXED_PLAN
+#endif
+
+#define MAX_RATES 16U
+#define MAX_BANDS 5U
+#define MAX_RX1_RATES 48U
+
+/* cfList[15] */
+#define CFLIST_FREQ 0U
+#define CFLIST_MASK 1U
+#define CFLIST_NONE UINT8_MAX
+
+struct ldl_region_rate {
+    
+    uint8_t sf;         /* enum ldl_spreading_factor */
+    uint8_t bw;         /* enum ldl_signal_bandwidth */
+    uint8_t mtu;        /* zero if the rate is not defined */
+};
+
+struct ldl_region_band {
+    
+    uint32_t min;       /* Hz (inclusive) */
+    uint32_t max;       /* Hz (inclusive) */
+    uint16_t offTimeFactor;
+};
+
+/* evenly spaced channels that share an uplink rate range */
+struct ldl_region_block {
+    
+    uint32_t freq;      /* Hz of first channel (zero if not fixed) */
+    uint32_t step;      /* Hz */
+    uint8_t minRate;
+    uint8_t maxRate;
+};
+
+struct ldl_region_desc {
+    
+    struct ldl_region_rate rate[MAX_RATES];
+    
+    struct ldl_region_band band[MAX_BANDS];
+    uint8_t numBands;
+    
+    /* channels below split are in block[0] */
+    uint8_t numChannels;
+    uint8_t split;
+    bool dynamic;    
+    struct ldl_region_block block[2U];
     
+    uint8_t cfListType;
+    
+    /* RX1 rate is rx1Rate[(tx_rate * rx1Cols) + rx1_offset] */
+    uint8_t rx1Rate[MAX_RX1_RATES];
+    uint8_t rx1Size;
+    uint8_t rx1Cols;
+    
+    /* RX1 is on the uplink frequency if rx1Freq is zero */
+    uint32_t rx1Freq;
+    uint32_t rx1Step;
+    uint8_t rx1Channels;
+    
+    uint32_t rx2Freq;
+    uint8_t rx2Rate;
+    
+    int16_t maxEIRP;    /* dBm x 10^-2 */
+    uint8_t maxPower;
+    
+    /* join trials alternate with joinAltRate unless it is UINT8_MAX */
+    uint8_t joinRate;
+    uint8_t joinAltRate;
+    
+    /* no beacon if beaconFreq is zero */
+    uint32_t beaconFreq;
+    uint8_t beaconRate;
+};
+
 /* static function prototypes *****************************************/
 
+static const struct ldl_region_desc *regionDesc(enum ldl_region region);
 static bool upRateRange(enum ldl_region region, uint8_t chIndex, uint8_t *minRate, uint8_t *maxRate);
+#ifdef REGION_DYNAMIC_PLAN
+static uint8_t unpackCFListFreq(const uint8_t *cfList, uint32_t *freq);
+#endif
+#ifdef REGION_FIXED_PLAN
+static uint8_t unpackCFListMask(const uint8_t *cfList, uint16_t *mask);
+#endif
+
+/* static variables ***************************************************/
+
+#ifdef REGION_DYNAMIC_PLAN
+    #define EU_RATES \
+        {LDL_SF_12, LDL_BW_125, 59U},\
+        {LDL_SF_11, LDL_BW_125, 59U},\
+        {LDL_SF_10, LDL_BW_125, 59U},\
+        {LDL_SF_9, LDL_BW_125, 123U},\
+        {LDL_SF_8, LDL_BW_125, 250U},\
+        {LDL_SF_7, LDL_BW_125, 250U},\
+        {LDL_SF_7, LDL_BW_250, 250U}
+        
+    #ifdef LDL_ENABLE_FSK
+        #define EU_FSK_RATE {LDL_SF_FSK, LDL_BW_125, 250U}
+        #define EU_MAX_RATE 7U
+    #else
+        #define EU_FSK_RATE {0U, 0U, 0U}
+        #define EU_MAX_RATE 5U
+    #endif
+    
+    #define EU_RX1_RATES \
+        0U, 0U, 0U, 0U, 0U, 0U,\
+        1U, 0U, 0U, 0U, 0U, 0U,\
+        2U, 1U, 0U, 0U, 0U, 0U,\
+        3U, 2U, 1U, 0U, 0U, 0U,\
+        4U, 3U, 2U, 1U, 0U, 0U,\
+        5U, 4U, 3U, 2U, 1U, 0U,\
+        6U, 5U, 4U, 3U, 2U, 1U,\
+        7U, 6U, 5U, 4U, 3U, 2U
+#endif
+
+#ifdef REGION_FIXED_PLAN
+    #define US_AU_RATES_8_13 \
+        {LDL_SF_12, LDL_BW_500, 61U},\
+        {LDL_SF_11, LDL_BW_500, 137U},\
+        {LDL_SF_10, LDL_BW_500, 250U},\
+        {LDL_SF_9, LDL_BW_500, 250U},\
+        {LDL_SF_8, LDL_BW_500, 250U},\
+        {LDL_SF_7, LDL_BW_500, 250U}
+#endif
+
+static const struct ldl_region_desc regions[] PROGMEM = {
+#ifdef LDL_ENABLE_EU_863_870
+    [LDL_EU_863_870] = {
+        .rate = {
+            EU_RATES,
+            EU_FSK_RATE
+        },
+        .band = {
+            {863000000UL, 868000000UL, 100U},   /* 1.0% */
+            {868000000UL, 868600000UL, 100U},   /* 1.0% */
+            {868700000UL, 869200000UL, 1000U},  /* 0.1% */
+            {869400000UL, 869650000UL, 10U},    /* 10.0% */
+            {869700000UL, 869999999UL, 100U}    /* 1.0% */
+        },
+        .numBands = 5U,
+        .numChannels = 16U,
+        .split = 3U,
+        .dynamic = true,
+        .block = {
+            {868100000UL, 200000UL, 0U, 5U},
+            {0UL, 0UL, 0U, EU_MAX_RATE}
+        },
+        .cfListType = CFLIST_FREQ,
+        .rx1Rate = {
+            EU_RX1_RATES
+        },
+        .rx1Size = 48U,
+        .rx1Cols = 6U,
+        .rx1Freq = 0UL,
+        .rx2Freq = 869525000UL,
+        .rx2Rate = 0U,
+        .maxEIRP = 1600,
+        .maxPower = 7U,
+        .joinRate = 5U,
+        .joinAltRate = UINT8_MAX,
+        .beaconFreq = 869525000UL,
+        .beaconRate = 3U
+    },
+#endif
+#ifdef LDL_ENABLE_US_902_928
+    [LDL_US_902_928] = {
+        .rate = {
+            {LDL_SF_10, LDL_BW_125, 19U},
+            {LDL_SF_9, LDL_BW_125, 61U},
+            {LDL_SF_8, LDL_BW_125, 133U},
+            {LDL_SF_7, LDL_BW_125, 250U},
+            {LDL_SF_8, LDL_BW_500, 250U},
+            {0U, 0U, 0U},
+            {0U, 0U, 0U},
+            {0U, 0U, 0U},
+            US_AU_RATES_8_13
+        },
+        .band = {
+            {0UL, UINT32_MAX, 0U}
+        },
+        .numBands = 1U,
+        .numChannels = 72U,
+        .split = 64U,
+        .dynamic = false,
+        .block = {
+            {902300000UL, 200000UL, 0U, 3U},
+            {903000000UL, 200000UL, 4U, 4U}
+        },
+        /* ignored */
+        .cfListType = CFLIST_NONE,
+        .rx1Rate = {
+            10U, 9U,  8U,  8U,
+            11U, 10U, 9U,  8U,
+            12U, 11U, 10U, 9U,
+            13U, 12U, 11U, 10U,
+            13U, 13U, 12U, 11U
+        },
+        .rx1Size = 20U,
+        .rx1Cols = 4U,
+        .rx1Freq = 923300000UL,
+        .rx1Step = 600000UL,
+        .rx1Channels = 8U,
+        .rx2Freq = 923300000UL,
+        .rx2Rate = 8U,
+        .maxEIRP = 3000,
+        .maxPower = 10U,
+        .joinRate = 3U,
+        .joinAltRate = 4U,
+        .beaconFreq = 0UL
+    },
+#endif
+#ifdef LDL_ENABLE_AU_915_928
+    [LDL_AU_915_928] = {
+        .rate = {
+            {LDL_SF_12, LDL_BW_125, 59U},
+            {LDL_SF_11, LDL_BW_125, 59U},
+            {LDL_SF_10, LDL_BW_125, 59U},
+            {LDL_SF_9, LDL_BW_125, 123U},
+            {LDL_SF_8, LDL_BW_125, 250U},
+            {LDL_SF_7, LDL_BW_125, 250U},
+            {LDL_SF_8, LDL_BW_500, 250U},
+            {0U, 0U, 0U},
+            US_AU_RATES_8_13
+        },
+        .band = {
+            {0UL, UINT32_MAX, 0U}
+        },
+        .numBands = 1U,
+        .numChannels = 72U,
+        .split = 64U,
+        .dynamic = false,
+        .block = {
+            {915200000UL, 200000UL, 0U, 5U},
+            {915900000UL, 200000UL, 6U, 6U}
+        },
+        .cfListType = CFLIST_MASK,
+        .rx1Rate = {
+            8U,  8U,  8U,  8U,  8U,  8U,
+            9U,  8U,  8U,  8U,  8U,  8U,
+            10U, 9U,  8U,  8U,  8U,  8U,
+            11U, 10U, 9U,  8U,  8U,  8U,
+            12U, 11U, 10U, 9U,  8U,  8U,
+            13U, 12U, 11U, 10U, 9U,  8U,
+            13U, 13U, 12U, 11U, 10U, 9U
+        },
+        .rx1Size = 42U,
+        .rx1Cols = 6U,
+        .rx1Freq = 923300000UL,
+        .rx1Step = 600000UL,
+        .rx1Channels = 8U,
+        .rx2Freq = 923300000UL,
+        .rx2Rate = 8U,
+        .maxEIRP = 3000,
+        .maxPower = 10U,
+        .joinRate = 4U,
+        .joinAltRate = 0U,
+        .beaconFreq = 0UL
+    },
+#endif
+#ifdef LDL_ENABLE_EU_433
+    [LDL_EU_433] = {
+        .rate = {
+            EU_RATES,
+            EU_FSK_RATE
+        },
+        .band = {
+            {0UL, UINT32_MAX, 100U}
+        },
+        .numBands = 1U,
+        .numChannels = 16U,
+        .split = 3U,
+        .dynamic = true,
+        .block = {
+            {433175000UL, 200000UL, 0U, 5U},
+            {0UL, 0UL, 0U, EU_MAX_RATE}
+        },
+        .cfListType = CFLIST_FREQ,
+        .rx1Rate = {
+            EU_RX1_RATES
+        },
+        .rx1Size = 48U,
+        .rx1Cols = 6U,
+        .rx1Freq = 0UL,
+        .rx2Freq = 434665000UL,
+        .rx2Rate = 0U,
+        .maxEIRP = 1215,
+        .maxPower = 5U,
+        .joinRate = 5U,
+        .joinAltRate = UINT8_MAX,
+        .beaconFreq = 434665000UL,
+        .beaconRate = 3U
+    },
+#endif
+};
 
 /* functions **********************************************************/
 
@@ -50,199 +361,25 @@ void LDL_Region_convertRate(enum ldl_region region, uint8_t rate, enum ldl_sprea
     LDL_PEDANTIC(bw != NULL)
     LDL_PEDANTIC(mtu != NULL)
     
-    switch(region){ 
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)                              
-#   ifdef LDL_ENABLE_EU_863_870    
-    case LDL_EU_863_870:
-#   endif    
-#   ifdef LDL_ENABLE_EU_433    
-    case LDL_EU_433:
-#   endif        
-        switch(rate){
-        case 0U:
-            *sf = LDL_SF_12;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 1U:
-            *sf = LDL_SF_11;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 2U:
-            *sf = LDL_SF_10;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 3U:
-            *sf = LDL_SF_9;
-            *bw = LDL_BW_125;
-            *mtu = 123U;
-            break;
-        case 4U:
-            *sf = LDL_SF_8;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            break;
-        case 5U:        
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            break;
-        case 6U:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_250;
-            *mtu = 250U;
-            break;                        
-        default:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            LDL_INFO(NULL,"invalid rate")
-            break;
-        }
-        break;
-#endif        
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
+    struct ldl_region_rate setting = {0U, 0U, 0U};
     
-        switch(rate){
-        case 0U:
-            *sf = LDL_SF_10;
-            *bw = LDL_BW_125;
-            *mtu = 19U;
-            break;
-        case 1U:
-            *sf = LDL_SF_9;
-            *bw = LDL_BW_125;
-            *mtu = 61U;
-            break;
-        case 2U:
-            *sf = LDL_SF_8;
-            *bw = LDL_BW_125;
-            *mtu = 133U;
-            break;
-        case 3U:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            break;
-        case 4U:
-        case 12U:
-            *sf = LDL_SF_8;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;
-        case 8U:
-            *sf = LDL_SF_12;
-            *bw = LDL_BW_500;
-            *mtu = 61U;
-            break;
-        case 9U:
-            *sf = LDL_SF_11;
-            *bw = LDL_BW_500;
-            *mtu = 137U;
-            break;
-        case 10U:
-            *sf = LDL_SF_10;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;
-        case 11U:
-            *sf = LDL_SF_9;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;        
-        case 13U:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;
-        default:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            LDL_INFO(NULL,"invalid rate")
-            break;
-        }    
-        break;
-#endif                
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
+    if(rate < MAX_RATES){
+        
+        (void)memcpy_P(&setting, &regionDesc(region)->rate[rate], sizeof(setting));
+    }
     
-        switch(rate){
-        case 0U:
-            *sf = LDL_SF_12;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 1U:
-            *sf = LDL_SF_11;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 2U:
-            *sf = LDL_SF_10;
-            *bw = LDL_BW_125;
-            *mtu = 59U;
-            break;
-        case 3U:
-            *sf = LDL_SF_9;
-            *bw = LDL_BW_125;
-            *mtu = 123U;
-            break;
-        case 4U:
-            *sf = LDL_SF_8;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            break;
-        case 5U:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            break;
-        case 6U:
-        case 12U:
-            *sf = LDL_SF_8;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;
-        case 8U:
-            *sf = LDL_SF_12;
-            *bw = LDL_BW_500;
-            *mtu = 61U;
-            break;
-        case 9U:
-            *sf = LDL_SF_11;
-            *bw = LDL_BW_500;
-            *mtu = 137U;
-            break;
-        case 10U:
-            *sf = LDL_SF_10;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;
-        case 11U:
-            *sf = LDL_SF_9;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;        
-        case 13U:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_500;
-            *mtu = 250U;
-            break;        
-        default:
-            *sf = LDL_SF_7;
-            *bw = LDL_BW_125;
-            *mtu = 250U;
-            LDL_INFO(NULL,"invalid rate")
-            break;
-        }    
-        break;
-#endif                
-    default:
-        break;
+    if(setting.mtu > 0U){
+        
+        *sf = (enum ldl_spreading_factor)setting.sf;
+        *bw = (enum ldl_signal_bandwidth)setting.bw;
+        *mtu = setting.mtu;
+    }
+    else{
+        
+        *sf = LDL_SF_7;
+        *bw = LDL_BW_125;
+        *mtu = 250U;
+        LDL_INFO(NULL,"invalid rate")
     }
 }
 
@@ -251,43 +388,23 @@ bool LDL_Region_getBand(enum ldl_region region, uint32_t freq, uint8_t *band)
     LDL_PEDANTIC(band != NULL)
 
     bool retval = false;
-
-    switch(region){
-#ifdef LDL_ENABLE_EU_863_870        
-    case LDL_EU_863_870:
+    const struct ldl_region_desc *desc = regionDesc(region);
+    struct ldl_region_band b;
+    uint8_t numBands;
+    uint8_t i;
     
-        retval = true;
+    (void)memcpy_P(&numBands, &desc->numBands, sizeof(numBands));
     
-        if((freq >= 863000000UL) && (freq <= 868000000UL)){
-            
-            *band = 0U;
-        }
-        else if((freq >= 868000000UL) && (freq <= 868600000UL)){
-            
-            *band = 1U;
-        }
-        else if((freq >= 868700000UL) && (freq <= 869200000UL)){
-            
-            *band = 2U;
-        }
-        else if((freq >= 869400000UL) && (freq <= 869650000UL)){
-            
-            *band = 3U;
-        }
-        else if((freq >= 869700000UL) && (freq < 870000000UL)){
+    for(i=0U; i < numBands; i++){
+        
+        (void)memcpy_P(&b, &desc->band[i], sizeof(b));
+        
+        if((freq >= b.min) && (freq <= b.max)){
             
-            *band = 4U;
+            *band = i;
+            retval = true;
+            break;
         }
-        else{
-            
-            retval = false;
-        }        
-        break;
-#endif    
-    default:
-        *band = 0U;
-        retval = true;
-        break;        
     }
     
     return retval;
@@ -297,21 +414,7 @@ bool LDL_Region_isDynamic(enum ldl_region region)
 {
     bool retval;
     
-    switch(region){
-    default:
-        retval = true;
-        break;        
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:         
-        retval = false;
-        break;
-#endif
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-        retval = false;                    
-        break;
-#endif        
-    }
+    (void)memcpy_P(&retval, &regionDesc(region)->dynamic, sizeof(retval));
     
     return retval;
 }
@@ -319,63 +422,39 @@ bool LDL_Region_isDynamic(enum ldl_region region)
 bool LDL_Region_getChannel(enum ldl_region region, uint8_t chIndex, uint32_t *freq, uint8_t *minRate, uint8_t *maxRate)
 {
     bool retval = false;
+#ifdef REGION_FIXED_PLAN    
+    const struct ldl_region_desc *desc = regionDesc(region);
+    struct ldl_region_block block;
+    uint8_t split;
     
-    (void)chIndex;
-    (void)freq;
-    (void)minRate;
-    (void)maxRate;
-    
-    switch(region){
-    default:
-        break;    
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:         
-
-        retval = true;
+    /* channels in a dynamic region are kept by the MAC */
+    if(!LDL_Region_isDynamic(region) && (chIndex < LDL_Region_numChannels(region))){
         
-        if(chIndex < 64U){
-
-            *freq = 902300000UL + ( 200000UL * chIndex);
-            *minRate = 0U;
-            *maxRate = 3U;
-        }
-        else if(chIndex < 72U){
-            
-            *freq = 903000000UL + ( 200000UL * (chIndex - 64U));
-            *minRate = 4U;
-            *maxRate = 4U;
-        }
-        else{
-            
-            retval = false;
-        }
-        break;
-#endif
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-    
-        retval = true;
+        (void)memcpy_P(&split, &desc->split, sizeof(split));
         
-        if(chIndex < 64U){
-
-            *freq = 915200000UL + ( 200000UL * chIndex);
-            *minRate = 0U;
-            *maxRate = 5U;
-        }
-        else if(chIndex < 72U){
+        if(chIndex < split){
             
-            *freq = 915900000UL + ( 200000UL * (chIndex - 64U));
-            *minRate = 6U;
-            *maxRate = 6U;
+            (void)memcpy_P(&block, &desc->block[0], sizeof(block));
         }
         else{
             
-            retval = false;
+            (void)memcpy_P(&block, &desc->block[1], sizeof(block));
+            chIndex -= split;
         }
-        break;
-#endif        
+        
+        *freq = block.freq + (block.step * chIndex);
+        *minRate = block.minRate;
+        *maxRate = block.maxRate;
+        
+        retval = true;
     }
-    
+#else
+    (void)region;
+    (void)chIndex;
+    (void)freq;
+    (void)minRate;
+    (void)maxRate;
+#endif    
     return retval;
 }
 
@@ -383,22 +462,7 @@ uint8_t LDL_Region_numChannels(enum ldl_region region)
 {
     uint8_t retval;
     
-    switch(region){
-    default:
-        retval = 16U;    
-        break;
-#if defined(LDL_ENABLE_US_902_928)  || defined(LDL_ENABLE_AU_915_928)              
-#   ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-#   endif                 
-#   ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-#   endif     
-           
-        retval = 72U;
-        break;                
-#endif        
-    }
+    (void)memcpy_P(&retval, &regionDesc(region)->numChannels, sizeof(retval));
     
     return retval;    
 }
@@ -407,166 +471,107 @@ void LDL_Region_getDefaultChannels(enum ldl_region region, struct ldl_mac *mac)
 {
     LDL_PEDANTIC(mac != NULL)
     
-    uint8_t minRate;
-    uint8_t maxRate;
+#ifdef REGION_DYNAMIC_PLAN    
+    const struct ldl_region_desc *desc = regionDesc(region);
+    struct ldl_region_block block;
+    uint8_t split;
+    uint8_t i;
     
-    switch(region){
-    default:
-        break;    
-#ifdef LDL_ENABLE_EU_863_870
-    case LDL_EU_863_870:
+    if(LDL_Region_isDynamic(region)){
     
-        (void)upRateRange(region, 0U, &minRate, &maxRate);
-        
-        LDL_MAC_addChannel(mac, 0U, 868100000UL, minRate, maxRate);
-        LDL_MAC_addChannel(mac, 1U, 868300000UL, minRate, maxRate);
-        LDL_MAC_addChannel(mac, 2U, 868500000UL, minRate, maxRate);        
-        break;
-#endif        
-#ifdef LDL_ENABLE_EU_433    
-    case LDL_EU_433:
-    
-        (void)upRateRange(region, 0U, &minRate, &maxRate);
+        (void)memcpy_P(&split, &desc->split, sizeof(split));
+        (void)memcpy_P(&block, &desc->block[0], sizeof(block));
         
-        LDL_MAC_addChannel(mac, 0U, 433175000UL, minRate, maxRate);
-        LDL_MAC_addChannel(mac, 1U, 433375000UL, minRate, maxRate);
-        LDL_MAC_addChannel(mac, 2U, 433575000UL, minRate, maxRate);        
-        break;
-#endif        
+        for(i=0U; i < split; i++){
+            
+            (void)LDL_MAC_setChannel(mac, i, block.freq + (block.step * i), block.minRate, block.maxRate);
+        }
     }
+#else
+    (void)region;
+    (void)mac;
+#endif    
 }
 
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)         
-static uint8_t unpackCFListFreq(const uint8_t *cfList, uint32_t *freq)
+void LDL_Region_processCFList(enum ldl_region region, struct ldl_mac *mac, const uint8_t *cfList, uint8_t cfListLen)
 {
-    *freq = cfList[2];
-    *freq <<= 8;
-    *freq |= cfList[1];
-    *freq <<= 8;
-    *freq |= cfList[0];
+    const struct ldl_region_desc *desc = regionDesc(region);
+    uint8_t type;
+    uint8_t i;
+    uint8_t pos;
     
-    *freq *= 100UL;
-    
-    return 3U;
-}
-#endif
-
-#if defined(LDL_ENABLE_US_902_928) || defined(LDL_ENABLE_AU_915_928)
-static uint8_t unpackCFListMask(const uint8_t *cfList, uint16_t *mask)
-{
-    *mask = cfList[1];
-    *mask <<= 8;
-    *mask |= cfList[0];
+    (void)memcpy_P(&type, &desc->cfListType, sizeof(type));
     
-    return 2U;    
-}
-#endif
-
-void LDL_Region_processCFList(enum ldl_region region, struct ldl_mac *mac, const uint8_t *cfList, uint8_t cfListLen)
-{
-    if(cfListLen == 16U){
+    if((cfListLen == 16U) && (cfList[15] == type)){
     
-        switch(region){
+        switch(type){
         default:
             break;
-
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)
-
-#   ifdef LDL_ENABLE_EU_863_870        
-        case LDL_EU_863_870:
-#   endif
-#   ifdef LDL_ENABLE_EU_433
-        case LDL_EU_433:
-#   endif        
-           /* 0 means frequency list */
-           if(cfList[15] == 0U){
-               
-                uint8_t minRate;
-                uint8_t maxRate;
-                uint32_t freq;
-                uint8_t i;
-                uint8_t pos;
-                
-                for(i=3U,pos=0U; i < 8U; i++){
-                
-                     pos += unpackCFListFreq(&cfList[pos], &freq);
-                     
-                     (void)upRateRange(region, i, &minRate, &maxRate);                 
-                     
-                     (void)LDL_MAC_addChannel(mac, i, freq, minRate, maxRate);
-                }            
-            }        
-            break;
-#endif  
-
-#if defined(LDL_ENABLE_US_902_928) || defined(LDL_ENABLE_AU_915_928)
-      
-#   ifdef LDL_ENABLE_US_902_928
-        case LDL_US_902_928:
+#ifdef REGION_DYNAMIC_PLAN            
+        case CFLIST_FREQ:
+        {
+            struct ldl_region_block block;
+            uint8_t split;
+            uint32_t freq;
+            
+            /* same range as the default channels */
+            (void)memcpy_P(&split, &desc->split, sizeof(split));
+            (void)memcpy_P(&block, &desc->block[0], sizeof(block));
+            
+            for(i=split,pos=0U; i < (split + 5U); i++){
+            
+                pos += unpackCFListFreq(&cfList[pos], &freq);
+                 
+                (void)LDL_MAC_setChannel(mac, i, freq, block.minRate, block.maxRate);
+            }            
+        }
             break;
-#   endif
-#   ifdef LDL_ENABLE_AU_915_928
-        case LDL_AU_915_928:        
-#   endif
-            /* 1 means mask list */
-           if(cfList[15] == 1U){
-                
-                uint16_t mask;
-                uint8_t i;
-                uint8_t b;
-                uint8_t pos;
-                
-                for(i=0U,pos=0U; i < 5U; i++){
-                
-                    pos += unpackCFListMask(&cfList[pos], &mask);
-                     
-                     for(b=0U; b < 16U; b++){
-                                        
-                        if((mask & (1 << b)) > 0U){ 
-                        
-                            (void)LDL_MAC_unmaskChannel(mac, (i * 16U) + b);
-                        }
-                    }                 
-                }            
-            }        
+#endif
+#ifdef REGION_FIXED_PLAN            
+        case CFLIST_MASK:
+        {
+            uint16_t mask;
+            uint8_t b;
+            
+            for(i=0U,pos=0U; i < 5U; i++){
+            
+                pos += unpackCFListMask(&cfList[pos], &mask);
+                 
+                for(b=0U; b < 16U; b++){
+                                    
+                    if((mask & (1 << b)) > 0U){ 
+                    
+                        (void)LDL_MAC_enableChannel(mac, (i * 16U) + b);
+                    }
+                }                 
+            }            
+        }
             break;
-#endif        
+#endif            
         }
     }    
 }
 
 uint32_t LDL_Region_getOffTimeFactor(enum ldl_region region, uint8_t band)
 {
-    uint32_t retval = 0UL;
-    
-    switch(region){
-    default:
-        break;    
-#ifdef LDL_ENABLE_EU_863_870    
-    case LDL_EU_863_870:
-    
-        switch(band){
-        case 0U:
-        case 1U:
-        case 4U:
-            retval = 100UL;      // 1.0%
-            break;
-        case 2U:
-            retval = 1000UL;     // 0.1%
-            break;
-        case 3U:        
-            retval = 10UL;       // 10.0%
-            break;                    
-        default:
-            break;
-        }
-        break;
-#endif        
-#ifdef LDL_ENABLE_EU_433    
-    case LDL_EU_433:        
-        retval = 100UL;
-        break;    
-#endif
+    const struct ldl_region_desc *desc = regionDesc(region);
+    uint16_t retval = 0U;
+    uint8_t numBands;
+    
+    (void)memcpy_P(&numBands, &desc->numBands, sizeof(numBands));
+    
+    /* a region without sub-bands puts every channel in its one band */
+    if(numBands == 1U){
+        
+        (void)memcpy_P(&retval, &desc->band[0].offTimeFactor, sizeof(retval));
+    }
+    else if(band < numBands){
+    
+        (void)memcpy_P(&retval, &desc->band[band].offTimeFactor, sizeof(retval));
+    }
+    else{
+        
+        /* no such band */
     }
     
     return retval;    
@@ -602,109 +607,54 @@ void LDL_Region_getRX1DataRate(enum ldl_region region, uint8_t tx_rate, uint8_t
 {
     LDL_PEDANTIC(rx1_rate != NULL)
 
-    const uint8_t *ptr = NULL;
-    uint16_t i = 0U;
-    size_t size = 0U;
-    
-    switch(region){
-    default:
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)        
-#   ifdef LDL_ENABLE_EU_863_870
-    case LDL_EU_863_870:
-#   endif
-#   ifdef LDL_ENABLE_EU_433
-    case LDL_EU_433:
-#   endif    
-    {
-        static const uint8_t rates[] PROGMEM = {
-            0U, 0U, 0U, 0U, 0U, 0U,
-            1U, 0U, 0U, 0U, 0U, 0U,
-            2U, 1U, 0U, 0U, 0U, 0U,
-            3U, 2U, 1U, 0U, 0U, 0U,
-            4U, 3U, 2U, 1U, 0U, 0U,
-            5U, 4U, 3U, 2U, 1U, 0U,
-            6U, 5U, 4U, 3U, 2U, 1U,
-            7U, 6U, 5U, 4U, 3U, 2U,
-        };
-
-        i = (tx_rate * 6U) + rx1_offset;
-        ptr = rates;
-        size = sizeof(rates);
-    }
-        break;                   
-#endif        
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:        
-    {
-        static const uint8_t rates[] PROGMEM = {
-            10U, 9U,  8U,  8U,
-            11U, 10U, 9U,  8U,
-            12U, 11U, 10U, 9U,
-            13U, 12U, 11U, 10U,
-            13U, 13U, 12U, 11U,
-        };
-        
-        i = (tx_rate * 4U) + rx1_offset;
-        ptr = rates;
-        size = sizeof(rates);
-    }
-        break;
-#endif        
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:        
-    {
-        static const uint8_t rates[] PROGMEM = {
-            8U,  8U,  8U,  8U,  8U,  8U,
-            9U,  8U,  8U,  8U,  8U,  8U,
-            10U, 9U,  8U,  8U,  8U,  8U,
-            11U, 10U, 9U,  8U,  8U,  8U,
-            12U, 11U, 10U, 9U,  8U,  8U,
-            13U, 12U, 11U, 10U, 9U,  8U,
-            13U, 13U, 12U, 11U, 10U, 9U,
-        };
-        
-        i = (tx_rate * 6U) + rx1_offset;
-        ptr = rates;
-        size = sizeof(rates);
-    }
-        break;
-#endif        
-    }
+    const struct ldl_region_desc *desc = regionDesc(region);
+    uint8_t size;
+    uint8_t cols;
+    uint16_t i;
     
-    if(ptr != NULL){
+    (void)memcpy_P(&size, &desc->rx1Size, sizeof(size));
+    (void)memcpy_P(&cols, &desc->rx1Cols, sizeof(cols));
     
-        if(i < size){
-        
-            (void)memcpy_P(rx1_rate, &ptr[i], sizeof(*rx1_rate));
-        }
-        else{
-                        
-            *rx1_rate = tx_rate;
-            LDL_INFO(NULL,"out of range error")
-        }
-    }        
+    i = ((uint16_t)tx_rate * cols) + rx1_offset;
+    
+    if(i < size){
+    
+        (void)memcpy_P(rx1_rate, &desc->rx1Rate[i], sizeof(*rx1_rate));
+    }
+    else{
+                    
+        *rx1_rate = tx_rate;
+        LDL_INFO(NULL,"out of range error")
+    }
 }
 
 void LDL_Region_getRX1Freq(enum ldl_region region, uint32_t txFreq, uint8_t chIndex, uint32_t *freq)
 {
-    (void)chIndex;
+#ifdef REGION_FIXED_PLAN    
+    const struct ldl_region_desc *desc = regionDesc(region);
+    uint32_t base;
+    uint32_t step;
+    uint8_t channels;
+    
+    (void)memcpy_P(&base, &desc->rx1Freq, sizeof(base));
     
-    switch(region){
-    default:
+    if(base > 0U){
+        
+        (void)memcpy_P(&step, &desc->rx1Step, sizeof(step));
+        (void)memcpy_P(&channels, &desc->rx1Channels, sizeof(channels));
+        
+        *freq = base + ((uint32_t)(chIndex % channels) * step);       
+    }
+    else{
+        
         *freq = txFreq;
-        break;        
-#if defined(LDL_ENABLE_US_902_928)  || defined(LDL_ENABLE_AU_915_928)              
-#   ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-#   endif                 
-#   ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-#   endif     
-               
-        *freq = 923300000UL + ((uint32_t)(chIndex % 8U) * 600000UL);       
-        break;    
-#endif        
     }
+#else
+    (void)region;
+    (void)chIndex;
+    
+    *freq = txFreq;
+#endif    
 }
 
 uint8_t LDL_Region_getRX1Delay(enum ldl_region region)
@@ -732,29 +682,7 @@ uint32_t LDL_Region_getRX2Freq(enum ldl_region region)
 {
     uint32_t retval;
     
-    switch(region){
-    default:
-#ifdef LDL_ENABLE_EU_863_870    
-    case LDL_EU_863_870:
-        retval = 869525000UL;
-        break;    
-#endif
-#ifdef LDL_ENABLE_EU_433        
-    case LDL_EU_433:
-        retval = 434665000UL;
-        break;    
-#endif
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:         
-        retval = 923300000UL;
-        break;        
-#endif
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:        
-        retval = 923300000UL;
-        break;        
-#endif        
-    }
+    (void)memcpy_P(&retval, &regionDesc(region)->rx2Freq, sizeof(retval));
     
     return retval; 
 }
@@ -763,178 +691,60 @@ uint8_t LDL_Region_getRX2Rate(enum ldl_region region)
 {
     uint8_t retval;
     
-    switch(region){
-    default:
-#ifdef LDL_ENABLE_EU_863_870
-    case LDL_EU_863_870:
-        retval = 0U;
-        break;
-#endif
-#ifdef LDL_ENABLE_EU_433
-    case LDL_EU_433:
-        retval = 0U;
-        break;
-#endif        
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:     
-        retval = 8U;
-        break;
-#endif
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-        retval = 8U;
-        break;
-#endif                
-    }
+    (void)memcpy_P(&retval, &regionDesc(region)->rx2Rate, sizeof(retval));
     
     return retval; 
 }
 
 bool LDL_Region_validateTXPower(enum ldl_region region, uint8_t power)
 {
-    bool retval = false;
-    
-    switch(region){ 
-#ifdef LDL_ENABLE_EU_863_870               
-    case LDL_EU_863_870:
-        
-        if(power <= 7U){
-            
-            retval = true;            
-        }
-        break;
-#endif
-#ifdef LDL_ENABLE_EU_433        
-    case LDL_EU_433:
+    uint8_t maxPower;
     
-        if(power <= 5U){
-            
-            retval = true;
-        }
-        break;
-#endif            
-#if defined(LDL_ENABLE_US_902_928)  || defined(LDL_ENABLE_AU_915_928)              
-#   ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-#   endif                 
-#   ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-#   endif     
-        
-        if(power <= 10U){
-            
-            retval = true;
-        }
-        break;
-#endif    
-    default:
-        break;      
-    }
+    (void)memcpy_P(&maxPower, &regionDesc(region)->maxPower, sizeof(maxPower));
     
-    return retval;
+    return (power <= maxPower);
 }
 
 int16_t LDL_Region_getTXPower(enum ldl_region region, uint8_t power)
 {
-    int16_t retval = 0;
+    const struct ldl_region_desc *desc = regionDesc(region);
+    int16_t maxEIRP;
+    uint8_t maxPower;
     
-    switch(region){ 
-#ifdef LDL_ENABLE_EU_863_870               
-    case LDL_EU_863_870:
-        
-        if(power <= 7U){
-            
-            retval = 1600 - (power * 200);
-        }
-        else{
-            
-            retval = 1600 - (7U * 200);
-        }
-        break;
-#endif
-#ifdef LDL_ENABLE_EU_433        
-    case LDL_EU_433:
+    (void)memcpy_P(&maxEIRP, &desc->maxEIRP, sizeof(maxEIRP));
+    (void)memcpy_P(&maxPower, &desc->maxPower, sizeof(maxPower));
     
-        if(power <= 5U){
-            
-            retval = 1215 - (power * 200);
-        }
-        else{
-            
-            retval = 1215 - (5U * 200);
-        }
-        break;
-#endif            
-#if defined(LDL_ENABLE_US_902_928)  || defined(LDL_ENABLE_AU_915_928)              
-#   ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-#   endif                 
-#   ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-#   endif     
+    if(power > maxPower){
         
-        if(power <= 10U){
-            
-            retval = 3000 - (power * 200);
-        }
-        else{
-            
-            retval = 3000 - (10U * 200);
-        }
-        break;
-#endif    
-    default:
-        break;      
+        power = maxPower;
     }
     
-    return retval;
+    return maxEIRP - ((int16_t)power * 200);
 }
 
 uint8_t LDL_Region_getJoinRate(enum ldl_region region, uint32_t trial)
 {
-    uint8_t retval = 0U;
-    
-    switch(region){    
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)                      
-#   ifdef LDL_ENABLE_EU_863_870    
-    case LDL_EU_863_870:
-#   endif    
-#   ifdef LDL_ENABLE_EU_433    
-    case LDL_EU_433:
-#   endif       
-        retval = 5U - (trial % (6U - LDL_DEFAULT_RATE));
-        break;
-#endif        
-#if defined(LDL_ENABLE_US_902_928)        
-#   ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-#   endif           
-        if((trial & 1U) > 0U){
-            
-            retval = 4U;
-        }
-        else{
-            
-            retval = 3U - ((trial >> 1U) % (4U - LDL_DEFAULT_RATE));
-        }
-        break;
-#endif
-#if defined(LDL_ENABLE_AU_915_928)              
-#   ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-#   endif                
+    const struct ldl_region_desc *desc = regionDesc(region);
+    uint8_t retval;
+    uint8_t alt;
+    
+    (void)memcpy_P(&retval, &desc->joinRate, sizeof(retval));
+    (void)memcpy_P(&alt, &desc->joinAltRate, sizeof(alt));
+    
+    if(alt != UINT8_MAX){
+        
         if((trial & 1U) > 0U){
             
-            retval = 0U;
+            retval = alt;
         }
         else{
             
-            retval = 4U - ((trial >> 1U) % (5U - LDL_DEFAULT_RATE));
+            retval -= (uint8_t)((trial >> 1U) % (retval + 1U - LDL_DEFAULT_RATE));
         }
-        break;
-#endif        
-    default:
-        break;
+    }
+    else{
+        
+        retval -= (uint8_t)(trial % (retval + 1U - LDL_DEFAULT_RATE));
     }
     
     return retval;
@@ -954,79 +764,103 @@ uint32_t LDL_Region_getMaxDCycleOffLimit(enum ldl_region region)
     return (60UL*60UL*1000UL);
 }
 
+#ifdef LDL_ENABLE_CLASS_B
+bool LDL_Region_getBeaconChannel(enum ldl_region region, uint32_t *freq, uint8_t *rate)
+{
+    const struct ldl_region_desc *desc = regionDesc(region);
+    bool retval = false;
+    uint32_t beaconFreq;
+    
+    /* the default ping slot channel is the beacon channel in these regions 
+     * 
+     * zero means the beacon hops or class B is not defined
+     * 
+     * */
+    (void)memcpy_P(&beaconFreq, &desc->beaconFreq, sizeof(beaconFreq));
+    
+    if(beaconFreq > 0U){
+        
+        *freq = beaconFreq;
+        (void)memcpy_P(rate, &desc->beaconRate, sizeof(*rate));
+        retval = true;
+    }
+    
+    return retval;
+}
+#endif
+
 /* static functions ***************************************************/
 
-static bool upRateRange(enum ldl_region region, uint8_t chIndex, uint8_t *minRate, uint8_t *maxRate)
+static const struct ldl_region_desc *regionDesc(enum ldl_region region)
 {
-    bool retval = false;
+#ifdef LDL_ENABLE_REGION_SELECT
+    LDL_PEDANTIC((size_t)region < (sizeof(regions)/sizeof(*regions)))
     
-    switch(region){    
-#if defined(LDL_ENABLE_EU_863_870) || defined(LDL_ENABLE_EU_433)                      
-#   ifdef LDL_ENABLE_EU_863_870    
-    case LDL_EU_863_870:
-#   endif    
-#   ifdef LDL_ENABLE_EU_433    
-    case LDL_EU_433:
-#   endif       
+    return &regions[region];
+#else
+    (void)region;
     
-        if(chIndex < 16U){
+    return regions;
+#endif    
+}
+
+static bool upRateRange(enum ldl_region region, uint8_t chIndex, uint8_t *minRate, uint8_t *maxRate)
+{
+    const struct ldl_region_desc *desc = regionDesc(region);
+    bool retval = false;
+    uint8_t split;
     
-            *minRate = 0U;
-            *maxRate = 5U;
-            retval = true;
-        }
-        break;
-#endif        
-#ifdef LDL_ENABLE_US_902_928
-    case LDL_US_902_928:
-    
-        if(chIndex <= 71U){
-    
-            if(chIndex <= 63U){
-                
-                *minRate = 0U;
-                *maxRate = 3U;
-            }
-            else{ 
-                
-                *minRate = 4U;
-                *maxRate = 4U;                
-            }            
-            
-            retval = true;
+    if(chIndex < LDL_Region_numChannels(region)){
+        
+        (void)memcpy_P(&split, &desc->split, sizeof(split));
+        
+        if(chIndex < split){
+        
+            (void)memcpy_P(minRate, &desc->block[0].minRate, sizeof(*minRate));
+            (void)memcpy_P(maxRate, &desc->block[0].maxRate, sizeof(*maxRate));
         }
-        break;        
-#endif    
-#ifdef LDL_ENABLE_AU_915_928
-    case LDL_AU_915_928:
-    
-        if(chIndex <= 71U){
-    
-            if(chIndex <= 63U){
-                
-                *minRate = 0U;
-                *maxRate = 5U;
-            }
-            else{ 
-                
-                *minRate = 6U;
-                *maxRate = 6U;                
-            }            
+        else{
             
-            retval = true;
+            (void)memcpy_P(minRate, &desc->block[1].minRate, sizeof(*minRate));
+            (void)memcpy_P(maxRate, &desc->block[1].maxRate, sizeof(*maxRate));
         }
-        break;        
-#endif    
-    default:
+        
+        retval = true;
+    }
+    else{
+        
         *minRate = 0U;
         *maxRate = 0U;
-        break;      
     }
     
     return retval;
 }
 
+#ifdef REGION_DYNAMIC_PLAN
+static uint8_t unpackCFListFreq(const uint8_t *cfList, uint32_t *freq)
+{
+    *freq = cfList[2];
+    *freq <<= 8;
+    *freq |= cfList[1];
+    *freq <<= 8;
+    *freq |= cfList[0];
+    
+    *freq *= 100UL;
+    
+    return 3U;
+}
+#endif
 
+#ifdef REGION_FIXED_PLAN
+static uint8_t unpackCFListMask(const uint8_t *cfList, uint16_t *mask)
+{
+    *mask = cfList[1];
+    *mask <<= 8;
+    *mask |= cfList[0];
+    
+    return 2U;    
+}
+#endif
 
 #ifndef LDL_ENABLE_AVR
     #undef memcpy_P
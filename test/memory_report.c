@@ -0,0 +1,36 @@
+/* Print the size of the structures an application allocates
+ *
+ * Built and run by `make memory_report` once per option set. Sizes
+ * are for the host compiler, so structures holding pointers will be
+ * larger than on a 32 bit target.
+ *
+ * */
+
+#include "ldl_mac.h"
+#include "ldl_radio.h"
+#include "ldl_sm.h"
+#include "ldl_frame.h"
+#include "ldl_mac_commands.h"
+
+#include <stdio.h>
+#include <stddef.h>
+
+#define REPORT(TYPE) (void)printf("%-32s %6u\n", #TYPE, (unsigned)sizeof(TYPE));
+
+int main(void)
+{
+    REPORT(struct ldl_mac)
+    REPORT(struct ldl_mac_session)
+    REPORT(struct ldl_mac_channel)
+    REPORT(struct ldl_mac_init_arg)
+    REPORT(struct ldl_mac_data_opts)
+    REPORT(struct ldl_radio)
+    REPORT(struct ldl_sm)
+    REPORT(struct ldl_frame_down)
+    REPORT(struct ldl_downstream_cmd)
+    
+    (void)printf("%-32s %6u\n", "ldl_mac.ctx offset", (unsigned)offsetof(struct ldl_mac, ctx));
+    (void)printf("%-32s %6u\n", "ldl_mac.buffer offset", (unsigned)offsetof(struct ldl_mac, buffer));
+    
+    return 0;
+}
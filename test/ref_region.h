@@ -0,0 +1,25 @@
+#ifndef REF_REGION_H
+#define REF_REGION_H
+
+/* Reference copy of the region functions as they were before the
+ * region descriptor tables replaced the per-function switches
+ *
+ * Used to check that the tables give the same answers for every
+ * region and every rate, channel and band.
+ *
+ * */
+
+#include "ldl_region.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+void ref_region_convertRate(enum ldl_region region, uint8_t rate, enum ldl_spreading_factor *sf, enum ldl_signal_bandwidth *bw, uint8_t *mtu);
+bool ref_region_getBand(enum ldl_region region, uint32_t freq, uint8_t *band);
+bool ref_region_getChannel(enum ldl_region region, uint8_t chIndex, uint32_t *freq, uint8_t *minRate, uint8_t *maxRate);
+void ref_region_processCFList(enum ldl_region region, struct ldl_mac *mac, const uint8_t *cfList, uint8_t cfListLen);
+uint32_t ref_region_getOffTimeFactor(enum ldl_region region, uint8_t band);
+void ref_region_getRX1DataRate(enum ldl_region region, uint8_t tx_rate, uint8_t rx1_offset, uint8_t *rx1_rate);
+void ref_region_getRX1Freq(enum ldl_region region, uint32_t txFreq, uint8_t chIndex, uint32_t *freq);
+
+#endif
@@ -0,0 +1,198 @@
+#include "sim_async.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/* static function prototypes *****************************************/
+
+static void *worker(void *arg);
+static struct sim_async **slot(const void *board);
+
+/* static variables ***************************************************/
+
+/* workers by board */
+static struct sim_async *workers[4U];
+
+/* functions **********************************************************/
+
+void sim_async_init(struct sim_async *self, void *board, struct ldl_radio *driver)
+{
+    struct sim_async **ptr = slot(NULL);
+
+    if(ptr == NULL){
+
+        abort();
+    }
+
+    (void)memset(self, 0, sizeof(*self));
+
+    self->board = board;
+    self->driver = driver;
+
+    *ptr = self;
+
+    (void)pthread_mutex_init(&self->lock, NULL);
+    (void)pthread_cond_init(&self->cond, NULL);
+    (void)pthread_create(&self->thread, NULL, worker, self);
+}
+
+void sim_async_deinit(struct sim_async *self)
+{
+    (void)pthread_mutex_lock(&self->lock);
+
+    self->stop = true;
+    self->hold = false;
+
+    (void)pthread_cond_broadcast(&self->cond);
+    (void)pthread_mutex_unlock(&self->lock);
+
+    (void)pthread_join(self->thread, NULL);
+
+    (void)pthread_cond_destroy(&self->cond);
+    (void)pthread_mutex_destroy(&self->lock);
+
+    *slot(self->board) = NULL;
+}
+
+void sim_async_hold(struct sim_async *self, bool hold)
+{
+    (void)pthread_mutex_lock(&self->lock);
+
+    self->hold = hold;
+
+    (void)pthread_cond_broadcast(&self->cond);
+    (void)pthread_mutex_unlock(&self->lock);
+}
+
+void sim_async_wait(struct sim_async *self)
+{
+    (void)pthread_mutex_lock(&self->lock);
+
+    while(self->batches != self->submitted){
+
+        (void)pthread_cond_wait(&self->cond, &self->lock);
+    }
+
+    (void)pthread_mutex_unlock(&self->lock);
+}
+
+bool sim_async_pending(struct sim_async *self)
+{
+    bool retval;
+
+    (void)pthread_mutex_lock(&self->lock);
+
+    retval = (self->batches != self->submitted);
+
+    (void)pthread_mutex_unlock(&self->lock);
+
+    return retval;
+}
+
+void LDL_Chip_submit(void *self, const struct ldl_chip_xfer *xfer, uint8_t count)
+{
+    struct sim_async **ptr = slot(self);
+    struct sim_async *async;
+
+    if(ptr == NULL){
+
+        abort();
+    }
+
+    async = *ptr;
+
+    (void)pthread_mutex_lock(&async->lock);
+
+    /* the driver must wait for completion before submitting again */
+    if(async->started != async->submitted){
+
+        abort();
+    }
+
+    async->xfer = xfer;
+    async->count = count;
+    async->submitted++;
+
+    (void)pthread_cond_broadcast(&async->cond);
+    (void)pthread_mutex_unlock(&async->lock);
+}
+
+/* static functions ***************************************************/
+
+static void *worker(void *arg)
+{
+    struct sim_async *self = (struct sim_async *)arg;
+    const struct ldl_chip_xfer *xfer;
+    uint8_t count;
+    uint8_t i;
+
+    (void)pthread_mutex_lock(&self->lock);
+
+    for(;;){
+
+        while(!self->stop && (self->hold || (self->started == self->submitted))){
+
+            (void)pthread_cond_wait(&self->cond, &self->lock);
+        }
+
+        if(self->stop){
+
+            break;
+        }
+
+        xfer = self->xfer;
+        count = self->count;
+
+        self->started++;
+
+        (void)pthread_mutex_unlock(&self->lock);
+
+        for(i=0U; i < count; i++){
+
+            if(xfer[i].wait && (self->ready != NULL)){
+
+                self->ready(self->board);
+            }
+
+            if(xfer[i].write != NULL){
+
+                LDL_Chip_write(self->board, xfer[i].addr, xfer[i].write, xfer[i].size);
+            }
+            else{
+
+                LDL_Chip_read(self->board, xfer[i].addr, xfer[i].read, xfer[i].size);
+            }
+        }
+
+        LDL_Radio_chipComplete(self->driver);
+
+        (void)pthread_mutex_lock(&self->lock);
+
+        self->transfers += count;
+        self->batches++;
+
+        (void)pthread_cond_broadcast(&self->cond);
+    }
+
+    (void)pthread_mutex_unlock(&self->lock);
+
+    return NULL;
+}
+
+/* find the worker for a board (or a free slot if board is NULL) */
+static struct sim_async **slot(const void *board)
+{
+    struct sim_async **retval = NULL;
+    uint8_t i;
+
+    for(i=0U; i < (sizeof(workers)/sizeof(*workers)); i++){
+
+        if((board == NULL) ? (workers[i] == NULL) : ((workers[i] != NULL) && (workers[i]->board == board))){
+
+            retval = &workers[i];
+            break;
+        }
+    }
+
+    return retval;
+}
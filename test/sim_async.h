@@ -0,0 +1,79 @@
+#ifndef SIM_ASYNC_H
+#define SIM_ASYNC_H
+
+/* Worker thread implementation of LDL_Chip_submit() for the host simulator
+ *
+ * Stands in for a DMA capable SPI peripheral. Batches are performed
+ * on a worker thread through LDL_Chip_write() and LDL_Chip_read() of
+ * the board (sim_radio or sim_sx126x), then LDL_Radio_chipComplete()
+ * is called from the worker. A transfer that waits for the chip to be
+ * ready is preceded by a call to the ready hook, which stands in for
+ * the interrupt on the falling edge of BUSY.
+ *
+ * The test keeps the simulation deterministic by calling
+ * sim_async_wait() after anything that may have submitted a batch.
+ * sim_async_hold() stops the worker from starting a batch so that
+ * a test can observe the driver returning before the transfers
+ * have been made.
+ *
+ * Requires LDL_ENABLE_CHIP_ASYNC.
+ *
+ * */
+
+#include "ldl_radio.h"
+#include "ldl_chip.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+struct sim_async {
+
+    void *board;
+    struct ldl_radio *driver;
+
+    /* called before a transfer with ldl_chip_xfer.wait set (may be NULL) */
+    void (*ready)(void *board);
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+
+    const struct ldl_chip_xfer *xfer;
+    uint8_t count;
+
+    bool hold;              /**< do not start a batch */
+    bool stop;
+
+    uint32_t submitted;     /**< batches submitted */
+    uint32_t started;       /**< batches started by the worker */
+    uint32_t batches;       /**< batches completed */
+    uint32_t transfers;     /**< transfers made by the worker */
+};
+
+/** start the worker
+ *
+ * @param[in] self
+ * @param[in] board     board passed to LDL_Radio_init()
+ * @param[in] driver    notified when a batch completes
+ *
+ * */
+void sim_async_init(struct sim_async *self, void *board, struct ldl_radio *driver);
+
+/** stop the worker */
+void sim_async_deinit(struct sim_async *self);
+
+/** stop or allow the worker starting a batch */
+void sim_async_hold(struct sim_async *self, bool hold);
+
+/** block until no batch is pending
+ *
+ * @warning never returns while held with a batch pending
+ *
+ * */
+void sim_async_wait(struct sim_async *self);
+
+/** find out if a batch is pending */
+bool sim_async_pending(struct sim_async *self);
+
+#endif
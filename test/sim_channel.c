@@ -0,0 +1,174 @@
+#include "sim_channel.h"
+#include "ldl_mac.h"
+
+#include <string.h>
+#include <math.h>
+
+/* static function prototypes *****************************************/
+
+static bool overlaps(const struct sim_channel_record *a, const struct sim_channel_record *b);
+static double toMilliWatts(int16_t dbm);
+static int16_t fromMilliWatts(double mw);
+
+/* functions **********************************************************/
+
+void sim_channel_init(struct sim_channel *self, const struct sim_channel_param *param)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    if(param != NULL){
+
+        self->param = *param;
+    }
+    else{
+
+        /* suburban, roughly Okumura-Hata for a 15m gateway at 868MHz */
+        self->param.ref_distance = 1000U;
+        self->param.ref_loss = 12800;
+        self->param.exponent = 350U;
+        self->param.noise_figure = 600;
+        self->param.capture = 600;
+        self->param.rejection = 1600;
+    }
+}
+
+bool sim_channel_transmit(struct sim_channel *self, const struct sim_channel_tx *tx, uint8_t *handle)
+{
+    bool retval = false;
+    struct sim_channel_record *rec;
+
+    if(self->count < SIM_CHANNEL_MAX){
+
+        rec = &self->record[self->count];
+
+        rec->tx = *tx;
+        rec->end = tx->start + LDL_MAC_transmitTimeUp(tx->bw, tx->sf, tx->size);
+        rec->rssi = sim_channel_rssi(self, tx->dbm, tx->distance);
+
+        *handle = self->count;
+        self->count++;
+        self->stats.sent++;
+
+        retval = true;
+    }
+
+    return retval;
+}
+
+bool sim_channel_receive(struct sim_channel *self, uint8_t handle, struct ldl_radio_packet_metadata *meta)
+{
+    bool retval = false;
+    const struct sim_channel_record *wanted;
+    const struct sim_channel_record *other;
+    double interference;
+    int16_t noise;
+    int16_t snr;
+    uint8_t i;
+
+    if(handle < self->count){
+
+        wanted = &self->record[handle];
+
+        noise = sim_channel_noise(self, wanted->tx.bw);
+        snr = wanted->rssi - noise;
+
+        interference = 0.0;
+
+        for(i=0U; i < self->count; i++){
+
+            other = &self->record[i];
+
+            if((i != handle) && (other->tx.freq == wanted->tx.freq) && overlaps(wanted, other)){
+
+                if(other->tx.sf == wanted->tx.sf){
+
+                    interference += toMilliWatts(other->rssi);
+                }
+                else if((other->rssi - wanted->rssi) > self->param.rejection){
+
+                    interference += toMilliWatts(other->rssi - self->param.rejection);
+                }
+                else{
+
+                    /* orthogonal */
+                }
+            }
+        }
+
+        if(snr < LDL_Radio_minSNR(NULL, wanted->tx.sf)){
+
+            self->stats.weak++;
+        }
+        else if((interference > 0.0) && ((wanted->rssi - fromMilliWatts(interference)) < self->param.capture)){
+
+            self->stats.collided++;
+        }
+        else{
+
+            self->stats.delivered++;
+
+            if(meta != NULL){
+
+                meta->rssi = wanted->rssi / 100;
+                meta->snr = snr;
+            }
+
+            retval = true;
+        }
+    }
+
+    return retval;
+}
+
+void sim_channel_expire(struct sim_channel *self, uint32_t time)
+{
+    uint8_t i;
+    uint8_t n;
+
+    for(i=0U, n=0U; i < self->count; i++){
+
+        if((int32_t)(self->record[i].end - time) > 0){
+
+            self->record[n] = self->record[i];
+            n++;
+        }
+    }
+
+    self->count = n;
+}
+
+int16_t sim_channel_rssi(const struct sim_channel *self, int16_t dbm, uint32_t distance)
+{
+    double loss;
+
+    loss = (double)self->param.ref_loss;
+
+    if(distance > 0U){
+
+        loss += 10.0 * (double)self->param.exponent * log10((double)distance / (double)self->param.ref_distance);
+    }
+
+    return (int16_t)lround((double)dbm - loss);
+}
+
+int16_t sim_channel_noise(const struct sim_channel *self, enum ldl_signal_bandwidth bw)
+{
+    return (int16_t)lround(-17400.0 + (1000.0 * log10((double)LDL_MAC_bwToNumber(bw))) + (double)self->param.noise_figure);
+}
+
+/* static functions ***************************************************/
+
+static bool overlaps(const struct sim_channel_record *a, const struct sim_channel_record *b)
+{
+    return ((int32_t)(a->tx.start - b->end) < 0) && ((int32_t)(b->tx.start - a->end) < 0);
+}
+
+static double toMilliWatts(int16_t dbm)
+{
+    return pow(10.0, (double)dbm / 1000.0);
+}
+
+static int16_t fromMilliWatts(double mw)
+{
+    return (int16_t)lround(1000.0 * log10(mw));
+}
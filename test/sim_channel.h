@@ -0,0 +1,125 @@
+#ifndef SIM_CHANNEL_H
+#define SIM_CHANNEL_H
+
+/* A shared radio channel for the host simulator
+ *
+ * Every transmission is registered with the channel. When a receiver
+ * later asks for a transmission the channel decides if it survived:
+ *
+ * - received power follows a log-distance path loss model
+ * - SNR is received power above the thermal noise floor for the bandwidth
+ * - packets below the demodulator floor (LDL_Radio_minSNR) are lost
+ * - packets overlapping in time on the same frequency and spreading
+ *   factor collide unless the wanted signal exceeds the sum of the
+ *   interferers by the capture threshold
+ * - packets on different spreading factors are treated as orthogonal
+ *   unless the interferer exceeds the wanted signal by the
+ *   co-channel rejection figure
+ *
+ * All power values are in dB/dBm x 10^-2 to match the library.
+ *
+ * */
+
+#include "ldl_radio.h"
+#include "ldl_radio_defs.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SIM_CHANNEL_MAX
+#define SIM_CHANNEL_MAX 64U
+#endif
+
+struct sim_channel_param {
+
+    uint32_t ref_distance;      /**< reference distance (m) */
+    int16_t ref_loss;           /**< path loss at reference distance (dB x 10^-2) */
+    uint16_t exponent;          /**< path loss exponent (x 10^-2) */
+    int16_t noise_figure;       /**< receiver noise figure (dB x 10^-2) */
+    int16_t capture;            /**< capture threshold (dB x 10^-2) */
+    int16_t rejection;          /**< inter-SF rejection (dB x 10^-2) */
+};
+
+struct sim_channel_tx {
+
+    uint32_t start;     /**< ticks */
+    uint32_t freq;      /**< Hz */
+    enum ldl_signal_bandwidth bw;
+    enum ldl_spreading_factor sf;
+    uint8_t size;       /**< PHYPayload size */
+    int16_t dbm;        /**< transmit power (dBm x 10^-2) */
+    uint32_t distance;  /**< distance from receiver (m) */
+};
+
+struct sim_channel_record {
+
+    struct sim_channel_tx tx;
+    uint32_t end;       /**< ticks */
+    int16_t rssi;       /**< dBm x 10^-2 */
+};
+
+struct sim_channel_stats {
+
+    uint32_t sent;
+    uint32_t delivered;
+    uint32_t collided;
+    uint32_t weak;
+};
+
+struct sim_channel {
+
+    struct sim_channel_param param;
+    struct sim_channel_record record[SIM_CHANNEL_MAX];
+    uint8_t count;
+    struct sim_channel_stats stats;
+};
+
+/** initialise a channel
+ *
+ * @param[in] self
+ * @param[in] param     NULL to use defaults
+ *
+ * */
+void sim_channel_init(struct sim_channel *self, const struct sim_channel_param *param);
+
+/** register a transmission
+ *
+ * @param[in] self
+ * @param[in] tx
+ * @param[out] handle   used to refer to this transmission on receive
+ *
+ * @retval true     registered
+ * @retval false    channel record is full
+ *
+ * */
+bool sim_channel_transmit(struct sim_channel *self, const struct sim_channel_tx *tx, uint8_t *handle);
+
+/** find out if a transmission survived
+ *
+ * @param[in] self
+ * @param[in] handle
+ * @param[out] meta     RSSI and SNR as seen by the receiver
+ *
+ * @retval true     delivered
+ * @retval false    lost to collision or path loss
+ *
+ * */
+bool sim_channel_receive(struct sim_channel *self, uint8_t handle, struct ldl_radio_packet_metadata *meta);
+
+/** forget transmissions that finished before time
+ *
+ * Handles are not stable across this call.
+ *
+ * @param[in] self
+ * @param[in] time  ticks
+ *
+ * */
+void sim_channel_expire(struct sim_channel *self, uint32_t time);
+
+/** received power (dBm x 10^-2) at distance */
+int16_t sim_channel_rssi(const struct sim_channel *self, int16_t dbm, uint32_t distance);
+
+/** noise floor (dBm x 10^-2) for bandwidth */
+int16_t sim_channel_noise(const struct sim_channel *self, enum ldl_signal_bandwidth bw);
+
+#endif
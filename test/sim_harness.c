@@ -0,0 +1,152 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* static variables ***************************************************/
+
+static const uint8_t eui[] = "\x00\x00\x00\x00\x00\x00\x00\x01";
+
+/* variables **********************************************************/
+
+const uint8_t sim_harness_key[16U] = {0x00U, 0x01U, 0x02U, 0x03U, 0x04U, 0x05U, 0x06U, 0x07U, 0x08U, 0x09U, 0x0aU, 0x0bU, 0x0cU, 0x0dU, 0x0eU, 0x0fU};
+
+/* static function prototypes *****************************************/
+
+static void handler(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg);
+
+/* functions **********************************************************/
+
+void sim_harness_init(struct sim_harness *self, uint32_t seed)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, seed);
+    self->sys.user = self;
+
+    sim_radio_init(&self->radio, &self->sys.time);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1276, &self->radio);
+    LDL_Radio_setPA(&self->driver, LDL_RADIO_PA_BOOST);
+
+    LDL_SM_init(&self->sm, sim_harness_key, sim_harness_key);
+}
+
+void sim_harness_start(struct sim_harness *self, enum ldl_region region, bool joined)
+{
+    static struct ldl_mac_session session;
+    struct ldl_mac_init_arg arg;
+
+    (void)memset(&arg, 0, sizeof(arg));
+
+    arg.app = &self->sys;
+    arg.radio = &self->driver;
+    arg.sm = &self->sm;
+    arg.handler = handler;
+    arg.joinEUI = eui;
+    arg.devEUI = eui;
+
+    LDL_MAC_init(&self->mac, region, &arg);
+
+    if(joined){
+
+        /* start from the default session for the region, as if joined */
+        session = self->mac.ctx;
+        session.joined = true;
+        session.devAddr = 0x01020304UL;
+
+        arg.session = &session;
+
+        LDL_MAC_init(&self->mac, region, &arg);
+    }
+
+    sim_harness_run_until(self, LDL_MAC_STARTUP, 10U);
+}
+
+void sim_harness_step(struct sim_harness *self, uint32_t until)
+{
+    uint32_t next;
+    uint32_t when = 0U;
+    bool pending;
+
+    if(self->on_step != NULL){
+
+        self->on_step(self);
+    }
+
+    LDL_MAC_process(&self->mac);
+
+    /* the device clock may run fast or slow */
+    next = sim_system_to_true(&self->sys, LDL_MAC_ticksUntilNextEvent(&self->mac));
+    next = (next < (until - self->sys.time)) ? next : (until - self->sys.time);
+
+    pending = sim_radio_pending(&self->radio, &when);
+
+    when += self->jitter;
+
+    if(pending && ((int32_t)(when - self->sys.time) <= (int32_t)next)){
+
+        if((int32_t)(when - self->sys.time) > 0){
+
+            self->sys.time = when;
+        }
+
+        LDL_Radio_interrupt(&self->driver, sim_radio_fire(&self->radio));
+    }
+    else{
+
+        self->sys.time += next + self->latency;
+    }
+}
+
+void sim_harness_run_until(struct sim_harness *self, enum ldl_mac_response_type type, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    self->events = 0U;
+
+    while(((self->events & (1UL << type)) == 0U) && ((int32_t)(until - self->sys.time) > 0)){
+
+        sim_harness_step(self, until);
+    }
+
+    assert_true((self->events & (1UL << type)) != 0U);
+}
+
+void sim_harness_run_for(struct sim_harness *self, uint32_t seconds)
+{
+    uint32_t until = self->sys.time + (seconds * LDL_System_tps());
+
+    while((int32_t)(until - self->sys.time) > 0){
+
+        sim_harness_step(self, until);
+    }
+}
+
+/* static functions ***************************************************/
+
+static void handler(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct sim_harness *self = (struct sim_harness *)((struct sim_system *)app)->user;
+
+    self->events |= (1UL << type);
+
+    if(type == LDL_MAC_RX){
+
+        self->rx_time = self->sys.time;
+        self->rx_port = arg->rx.port;
+        self->rx_size = arg->rx.size;
+        (void)memcpy(self->rx_data, arg->rx.data, self->rx_size);
+    }
+
+    if(self->on_event != NULL){
+
+        self->on_event(self, type, arg);
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef SIM_HARNESS_H
+#define SIM_HARNESS_H
+
+/* MAC test fixture for the host simulator
+ *
+ * Connects an #ldl_mac to a sim_system and a sim_radio (SX1276 with
+ * PA_BOOST) and steps them together: the MAC is processed, then true
+ * time advances to whichever comes first of the next MAC event and the
+ * next radio interrupt.
+ *
+ * Every event the MAC raises is recorded in `events` and the last
+ * LDL_MAC_RX is copied out. A test that needs more embeds sim_harness
+ * as the first member of its own harness and sets `on_event`.
+ *
+ * `on_step` may disturb the device by setting `latency` (process runs
+ * late when woken by a timer) and `jitter` (a radio interrupt is
+ * delivered late) for the step about to be taken.
+ *
+ * Typical use:
+ *
+ * sim_harness_init(&self->sim, 1U);
+ * (adjust radio, system or hooks)
+ * sim_harness_start(&self->sim, LDL_EU_863_870, true);
+ *
+ * */
+
+#include "sim_system.h"
+#include "sim_radio.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct sim_harness;
+
+/** called for each MAC event after the harness has recorded it */
+typedef void (*sim_harness_event_fn)(struct sim_harness *self, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg);
+
+/** called at the start of each step */
+typedef void (*sim_harness_step_fn)(struct sim_harness *self);
+
+struct sim_harness {
+
+    struct sim_system sys;
+    struct sim_radio radio;
+    struct ldl_radio driver;
+    struct ldl_sm sm;
+    struct ldl_mac mac;
+
+    uint32_t events;        /**< (1 << type) for each event since sim_harness_run_until() began */
+
+    /* last LDL_MAC_RX */
+    uint32_t rx_time;
+    uint8_t rx_port;
+    uint8_t rx_data[UINT8_MAX];
+    uint8_t rx_size;
+
+    sim_harness_event_fn on_event;
+    sim_harness_step_fn on_step;
+
+    uint32_t latency;       /**< ticks added when advancing to the next MAC event */
+    uint32_t jitter;        /**< ticks added to the time of a radio interrupt */
+};
+
+/** root and application key used by sim_harness_start() */
+extern const uint8_t sim_harness_key[16U];
+
+/** set up the system, radio and security module
+ *
+ * @param[in] self
+ * @param[in] seed      for sim_system_init()
+ *
+ * */
+void sim_harness_init(struct sim_harness *self, uint32_t seed);
+
+/** initialise the MAC and run until LDL_MAC_STARTUP
+ *
+ * @param[in] self
+ * @param[in] region
+ * @param[in] joined    start from the default session for the region
+ *                      as if already joined with devAddr 0x01020304
+ *
+ * */
+void sim_harness_start(struct sim_harness *self, enum ldl_region region, bool joined);
+
+/** process the MAC then advance to the next event (no later than until) */
+void sim_harness_step(struct sim_harness *self, uint32_t until);
+
+/** step until the MAC raises type, failing the test after limit seconds */
+void sim_harness_run_until(struct sim_harness *self, enum ldl_mac_response_type type, uint32_t limit);
+
+/** step for a number of seconds */
+void sim_harness_run_for(struct sim_harness *self, uint32_t seconds);
+
+#endif
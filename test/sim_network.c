@@ -0,0 +1,243 @@
+#include "sim_network.h"
+#include "ldl_aes.h"
+#include "ldl_sm.h"
+#include "ldl_frame.h"
+
+#include <string.h>
+#include <stdbool.h>
+
+/* static function prototypes *****************************************/
+
+static uint8_t gmul(uint8_t a, uint8_t b);
+static void initInverseSbox(uint8_t *rsbox);
+static uint16_t crc16(const uint8_t *in, uint8_t len);
+
+/* functions **********************************************************/
+
+uint8_t sim_network_join_accept(const void *nwkKey, uint32_t joinNonce, uint32_t netID, uint32_t devAddr, uint8_t dlSettings, uint8_t rxDelay, uint8_t *out)
+{
+    struct ldl_sm sm;
+    uint8_t len = 17U;
+
+    out[0] = 0x20U;
+    out[1] = (uint8_t)joinNonce;
+    out[2] = (uint8_t)(joinNonce >> 8);
+    out[3] = (uint8_t)(joinNonce >> 16);
+    out[4] = (uint8_t)netID;
+    out[5] = (uint8_t)(netID >> 8);
+    out[6] = (uint8_t)(netID >> 16);
+    out[7] = (uint8_t)devAddr;
+    out[8] = (uint8_t)(devAddr >> 8);
+    out[9] = (uint8_t)(devAddr >> 16);
+    out[10] = (uint8_t)(devAddr >> 24);
+    out[11] = dlSettings;
+    out[12] = rxDelay;
+
+    (void)memset(&sm, 0, sizeof(sm));
+    LDL_SM_init(&sm, nwkKey, nwkKey);
+
+    LDL_Frame_updateMIC(out, len, LDL_SM_mic(&sm, LDL_SM_KEY_NWK, NULL, 0U, out, len - 4U));
+
+    /* the device recovers the frame with the forward cipher */
+    sim_network_decrypt(nwkKey, &out[1]);
+
+    return len;
+}
+
+uint8_t sim_network_data_down(struct ldl_sm *sm, uint32_t devAddr, uint16_t counter, const void *opts, uint8_t optsLen, uint8_t port, const void *data, uint8_t len, uint8_t *out)
+{
+    struct ldl_frame_data f;
+    struct ldl_frame_data_offset off;
+    uint8_t block[16U];
+    uint8_t retval;
+
+    (void)memset(&f, 0, sizeof(f));
+
+    f.type = FRAME_TYPE_DATA_UNCONFIRMED_DOWN;
+    f.devAddr = devAddr;
+    f.counter = counter;
+    f.opts = (const uint8_t *)opts;
+    f.optsLen = optsLen;
+    f.port = port;
+    f.data = (const uint8_t *)data;
+    f.dataLen = len;
+
+    retval = LDL_Frame_putData(&f, out, len + optsLen + 13U, &off);
+
+    /* A block */
+    (void)memset(block, 0, sizeof(block));
+    block[0] = 1U;
+    block[5] = 1U;
+    block[6] = (uint8_t)devAddr;
+    block[7] = (uint8_t)(devAddr >> 8);
+    block[8] = (uint8_t)(devAddr >> 16);
+    block[9] = (uint8_t)(devAddr >> 24);
+    block[10] = (uint8_t)counter;
+    block[11] = (uint8_t)(counter >> 8);
+    block[15] = 1U;
+
+    if(data != NULL){
+
+        LDL_SM_ctr(sm, LDL_SM_KEY_APPS, block, &out[off.data], len);
+    }
+
+    /* B0 block */
+    block[0] = 0x49U;
+    block[15] = retval - 4U;
+
+    LDL_Frame_updateMIC(out, retval, LDL_SM_mic(sm, LDL_SM_KEY_SNWKSINT, block, sizeof(block), out, retval - 4U));
+
+    return retval;
+}
+
+uint8_t sim_network_beacon(uint32_t time, uint8_t *out)
+{
+    uint16_t crc;
+
+    /* RFU | Time | CRC | GwSpecific (no location) | CRC */
+    (void)memset(out, 0, 17U);
+
+    out[2] = (uint8_t)time;
+    out[3] = (uint8_t)(time >> 8);
+    out[4] = (uint8_t)(time >> 16);
+    out[5] = (uint8_t)(time >> 24);
+
+    crc = crc16(out, 6U);
+
+    out[6] = (uint8_t)crc;
+    out[7] = (uint8_t)(crc >> 8);
+
+    crc = crc16(&out[8], 7U);
+
+    out[15] = (uint8_t)crc;
+    out[16] = (uint8_t)(crc >> 8);
+
+    return 17U;
+}
+
+void sim_network_decrypt(const void *key, void *s)
+{
+    static uint8_t rsbox[256];
+    static bool init = false;
+    struct ldl_aes_ctx ctx;
+    uint8_t *b = (uint8_t *)s;
+    uint8_t t[16];
+    uint8_t r;
+    uint8_t c;
+    uint8_t i;
+
+    if(!init){
+
+        initInverseSbox(rsbox);
+        init = true;
+    }
+
+    LDL_AES_init(&ctx, key);
+
+    for(i=0U; i < 16U; i++){
+
+        b[i] ^= ctx.k[160U + i];
+    }
+
+    for(r=10U; r > 0U; r--){
+
+        /* inverse shift rows and sub bytes */
+        for(c=0U; c < 4U; c++){
+
+            for(i=0U; i < 4U; i++){
+
+                t[i + (c * 4U)] = rsbox[b[i + (((c + 4U - i) & 3U) * 4U)]];
+            }
+        }
+
+        for(i=0U; i < 16U; i++){
+
+            b[i] = t[i] ^ ctx.k[((r - 1U) * 16U) + i];
+        }
+
+        /* inverse mix columns */
+        if(r > 1U){
+
+            for(c=0U; c < 16U; c += 4U){
+
+                (void)memcpy(t, &b[c], 4U);
+
+                b[c     ] = gmul(t[0], 14U) ^ gmul(t[1], 11U) ^ gmul(t[2], 13U) ^ gmul(t[3],  9U);
+                b[c + 1U] = gmul(t[0],  9U) ^ gmul(t[1], 14U) ^ gmul(t[2], 11U) ^ gmul(t[3], 13U);
+                b[c + 2U] = gmul(t[0], 13U) ^ gmul(t[1],  9U) ^ gmul(t[2], 14U) ^ gmul(t[3], 11U);
+                b[c + 3U] = gmul(t[0], 11U) ^ gmul(t[1], 13U) ^ gmul(t[2],  9U) ^ gmul(t[3], 14U);
+            }
+        }
+    }
+}
+
+/* static functions ***************************************************/
+
+static uint8_t gmul(uint8_t a, uint8_t b)
+{
+    uint8_t retval = 0U;
+
+    while(b != 0U){
+
+        if((b & 1U) != 0U){
+
+            retval ^= a;
+        }
+
+        a = ((a & 0x80U) != 0U) ? (uint8_t)((a << 1) ^ 0x1bU) : (uint8_t)(a << 1);
+        b >>= 1;
+    }
+
+    return retval;
+}
+
+static void initInverseSbox(uint8_t *rsbox)
+{
+    uint16_t x;
+    uint16_t y;
+    uint8_t inv;
+    uint8_t s;
+
+    for(x=0U; x < 256U; x++){
+
+        inv = 0U;
+
+        for(y=1U; (x != 0U) && (y < 256U); y++){
+
+            if(gmul((uint8_t)x, (uint8_t)y) == 1U){
+
+                inv = (uint8_t)y;
+                break;
+            }
+        }
+
+        s = inv;
+        s ^= (uint8_t)((inv << 1) | (inv >> 7));
+        s ^= (uint8_t)((inv << 2) | (inv >> 6));
+        s ^= (uint8_t)((inv << 3) | (inv >> 5));
+        s ^= (uint8_t)((inv << 4) | (inv >> 4));
+        s ^= 0x63U;
+
+        rsbox[s] = (uint8_t)x;
+    }
+}
+
+static uint16_t crc16(const uint8_t *in, uint8_t len)
+{
+    uint16_t retval = 0U;
+    uint8_t i;
+    uint8_t j;
+
+    /* CRC-16/CCITT (poly 0x1021, init 0) */
+    for(i=0U; i < len; i++){
+
+        retval ^= (uint16_t)((uint16_t)in[i] << 8);
+
+        for(j=0U; j < 8U; j++){
+
+            retval = ((retval & 0x8000U) != 0U) ? (uint16_t)((retval << 1) ^ 0x1021U) : (uint16_t)(retval << 1);
+        }
+    }
+
+    return retval;
+}
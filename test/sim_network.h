@@ -0,0 +1,65 @@
+#ifndef SIM_NETWORK_H
+#define SIM_NETWORK_H
+
+/* Network server side encoders for the host simulator
+ *
+ * The library only needs the AES forward cipher so the inverse
+ * cipher a network server uses to encrypt a join accept lives here.
+ *
+ * */
+
+#include <stdint.h>
+
+struct ldl_sm;
+
+/** encode a LoRaWAN 1.0 join accept (without CFList)
+ *
+ * @param[in] nwkKey    pointer to 16 byte key
+ * @param[in] joinNonce
+ * @param[in] netID
+ * @param[in] devAddr
+ * @param[in] dlSettings
+ * @param[in] rxDelay
+ * @param[out] out      at least 17 bytes
+ *
+ * @return size of frame
+ *
+ * */
+uint8_t sim_network_join_accept(const void *nwkKey, uint32_t joinNonce, uint32_t netID, uint32_t devAddr, uint8_t dlSettings, uint8_t rxDelay, uint8_t *out);
+
+/** encode a LoRaWAN 1.0 unconfirmed data down frame
+ *
+ * @param[in] sm        session keys shared with the device
+ * @param[in] devAddr
+ * @param[in] counter   FCntDown
+ * @param[in] opts      FOpts (may be NULL)
+ * @param[in] optsLen   0..15
+ * @param[in] port      1..223
+ * @param[in] data      FRMPayload (NULL for a frame without port)
+ * @param[in] len
+ * @param[out] out      at least len + optsLen + 13 bytes
+ *
+ * @return size of frame
+ *
+ * */
+uint8_t sim_network_data_down(struct ldl_sm *sm, uint32_t devAddr, uint16_t counter, const void *opts, uint8_t optsLen, uint8_t port, const void *data, uint8_t len, uint8_t *out);
+
+/** encode a class B beacon (EU_863_870 layout)
+ *
+ * @param[in] time      GPS seconds
+ * @param[out] out      at least 17 bytes
+ *
+ * @return size of frame
+ *
+ * */
+uint8_t sim_network_beacon(uint32_t time, uint8_t *out);
+
+/** AES-128 inverse cipher
+ *
+ * @param[in] key   pointer to 16 byte key
+ * @param[in] s     pointer to 16 byte block
+ *
+ * */
+void sim_network_decrypt(const void *key, void *s);
+
+#endif
@@ -0,0 +1,1126 @@
+#include "sim_radio.h"
+#include "sim_channel.h"
+#include "ldl_chip.h"
+#include "ldl_mac.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+enum {
+    RegFifo = 0x00,
+    RegOpMode = 0x01,
+    RegFrfMsb = 0x06,
+    RegFrfLsb = 0x08,
+    RegPaConfig = 0x09,
+    RegFifoAddrPtr = 0x0D,
+    RegFifoTxBaseAddr = 0x0E,
+    RegFifoRxBaseAddr = 0x0F,
+    RegFifoRxCurrentAddr = 0x10,
+    RegIrqFlags = 0x12,
+    RegRxNbBytes = 0x13,
+    RegPktSnrValue = 0x19,
+    RegPktRssiValue = 0x1A,
+    RegModemConfig1 = 0x1D,
+    RegModemConfig2 = 0x1E,
+    RegSymbTimeoutLsb = 0x1F,
+    RegPayloadLength = 0x22,
+    RegFeiMsb = 0x28,
+    RegRssiWideband = 0x2C,
+    RegVersion = 0x42,
+    RegPaDac = 0x4D
+};
+
+/* FSK page */
+enum {
+    RegBitrateMsb = 0x02,
+    RegBitrateLsb = 0x03,
+    RegFskFirst = 0x0D,
+    RegRssiValue = 0x11,
+    RegFskFeiMsb = 0x1D,
+    RegFskFeiLsb = 0x1E,
+    RegPreambleDetect = 0x1F,
+    RegRxTimeout2 = 0x21,
+    RegPreambleMsb = 0x25,
+    RegPreambleLsb = 0x26,
+    RegSyncConfig = 0x27,
+    RegPacketConfig1 = 0x30,
+    RegPacketConfig2 = 0x31,
+    RegFskPayloadLength = 0x32,
+    RegFifoThresh = 0x35,
+    RegIrqFlags1 = 0x3E,
+    RegIrqFlags2 = 0x3F,
+    RegFskLast = 0x3F
+};
+
+enum {
+    FifoSize = 64
+};
+
+/* static function prototypes *****************************************/
+
+static void writeByte(struct sim_radio *self, uint8_t addr, uint8_t data);
+static uint8_t readByte(struct sim_radio *self, uint8_t addr);
+static void setMode(struct sim_radio *self, uint8_t mode);
+static uint32_t getFreq(const struct sim_radio *self);
+static enum ldl_signal_bandwidth getBW(const struct sim_radio *self);
+static enum ldl_spreading_factor getSF(const struct sim_radio *self);
+static int16_t getPower(const struct sim_radio *self);
+static uint32_t bwKHz(enum ldl_signal_bandwidth bw);
+static void schedule(struct sim_radio *self, uint32_t delay, uint8_t dio);
+static void resetRegisters(struct sim_radio *self);
+static void enterMode(struct sim_radio *self, uint8_t mode, uint32_t time);
+static bool isActive(const struct sim_radio *self, uint32_t freq);
+static uint32_t symbolPeriod(const struct sim_radio *self);
+static uint32_t downlinkTime(const struct sim_radio *self);
+static bool catchDownlink(const struct sim_radio *self);
+static void trackReceiver(struct sim_radio *self, uint8_t mode);
+static void returnToStandby(struct sim_radio *self);
+static bool receiveChannel(struct sim_radio *self);
+static bool isFSK(const struct sim_radio *self, uint8_t addr);
+static void writeFSK(struct sim_radio *self, uint8_t addr, uint8_t data);
+static uint8_t readFSK(struct sim_radio *self, uint8_t addr);
+static void setModeFSK(struct sim_radio *self, uint8_t mode);
+static uint8_t fireFSK(struct sim_radio *self);
+static void scheduleFSK(struct sim_radio *self);
+static void startFrameFSK(struct sim_radio *self, uint32_t time);
+static bool catchDownlinkFSK(const struct sim_radio *self);
+static uint32_t byteTime(const struct sim_radio *self, uint32_t bytes);
+static uint32_t headerBytes(const struct sim_radio *self);
+static uint16_t frameBytes(const struct sim_radio *self);
+static uint16_t fifoLevel(struct sim_radio *self);
+
+/* functions **********************************************************/
+
+void sim_radio_init(struct sim_radio *self, const uint32_t *time)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    self->time = time;
+    self->mode_since = *time;
+    self->tx_handle = UINT8_MAX;
+
+    resetRegisters(self);
+}
+
+void sim_radio_attach(struct sim_radio *self, struct sim_channel *channel, uint32_t distance, int16_t downlink_dbm)
+{
+    self->channel = channel;
+    self->distance = distance;
+    self->downlink_dbm = downlink_dbm;
+}
+
+void sim_radio_queue(struct sim_radio *self, const void *data, uint8_t len, int16_t rssi, int16_t snr)
+{
+    (void)memcpy(self->downlink.data, data, len);
+    self->downlink.len = len;
+    self->rssi = rssi;
+    self->snr = snr;
+    self->armed = true;
+    self->timed = false;
+
+    /* already receiving continuously */
+    if(((self->reg[RegOpMode] & 7U) == 5U) && isFSK(self, RegFifo)){
+
+        startFrameFSK(self, *self->time);
+        scheduleFSK(self);
+    }
+    else if((self->reg[RegOpMode] & 7U) == 5U){
+
+        self->downlink.time = *self->time;
+        schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), 0U);
+    }
+}
+
+void sim_radio_queue_at(struct sim_radio *self, uint32_t time, uint32_t freq, const void *data, uint8_t len, int16_t rssi, int16_t snr)
+{
+    (void)memcpy(self->downlink.data, data, len);
+    self->downlink.len = len;
+    self->downlink.time = time;
+    self->downlink.freq = freq;
+    self->rssi = rssi;
+    self->snr = snr;
+    self->armed = true;
+    self->timed = true;
+}
+
+void sim_radio_load(struct sim_radio *self, const void *data, uint8_t len, int16_t rssi, int16_t snr)
+{
+    uint8_t base = self->reg[RegFifoRxBaseAddr];
+    uint16_t i;
+    int32_t fei;
+
+    for(i=0U; i < len; i++){
+
+        self->fifo[(uint8_t)(base + i)] = ((const uint8_t *)data)[i];
+    }
+
+    self->reg[RegFifoRxCurrentAddr] = base;
+    self->reg[RegRxNbBytes] = len;
+    self->reg[RegPktRssiValue] = (uint8_t)(rssi + 157);
+    self->reg[RegPktSnrValue] = (uint8_t)(int8_t)(snr * 4 / 100);
+    self->reg[RegIrqFlags] |= 0x40U;
+
+    /* FreqError = FError x Fxtal / 2^24 x 500kHz / BW */
+    fei = (int32_t)(((int64_t)self->freq_error * 32000000LL * 500LL) / ((int64_t)(1UL << 24) * bwKHz(getBW(self))));
+
+    self->reg[RegFeiMsb] = (uint8_t)(((uint32_t)fei >> 16) & 0xfU);
+    self->reg[RegFeiMsb + 1U] = (uint8_t)((uint32_t)fei >> 8);
+    self->reg[RegFeiMsb + 2U] = (uint8_t)fei;
+
+    self->rx_count++;
+}
+
+void sim_radio_set_activity(struct sim_radio *self, uint32_t freq, bool active)
+{
+    uint8_t i;
+
+    for(i=0U; i < self->active_len; i++){
+
+        if(self->active[i] == freq){
+
+            break;
+        }
+    }
+
+    if(active){
+
+        if((i == self->active_len) && (self->active_len < (sizeof(self->active)/sizeof(*self->active)))){
+
+            self->active[self->active_len] = freq;
+            self->active_len++;
+        }
+    }
+    else if(i < self->active_len){
+
+        self->active_len--;
+        self->active[i] = self->active[self->active_len];
+    }
+    else{
+
+        /* not active */
+    }
+}
+
+void sim_radio_set_cad(struct sim_radio *self, bool detected)
+{
+    self->reg[RegIrqFlags] |= (detected ? 0x05U : 0x04U);
+}
+
+void sim_radio_set_timeout(struct sim_radio *self)
+{
+    self->reg[RegRxNbBytes] = 0U;
+    self->reg[RegIrqFlags] = (self->reg[RegIrqFlags] & ~0x40U) | 0x80U;
+}
+
+void sim_radio_set_entropy(struct sim_radio *self, uint32_t entropy)
+{
+    self->entropy = entropy;
+    self->entropy_bit = 0U;
+}
+
+bool sim_radio_pending(const struct sim_radio *self, uint32_t *time)
+{
+    *time = self->pending_time;
+
+    return self->pending;
+}
+
+void sim_radio_update(struct sim_radio *self)
+{
+    enterMode(self, self->mode, *self->time);
+}
+
+uint8_t sim_radio_fire(struct sim_radio *self)
+{
+    uint8_t retval = UINT8_MAX;
+
+    if(self->pending && isFSK(self, RegFifo)){
+
+        retval = fireFSK(self);
+    }
+    else if(self->pending){
+
+        self->pending = false;
+        retval = self->pending_dio;
+
+        switch(self->reg[RegOpMode] & 7U){
+        case 5U:
+            if(receiveChannel(self)){
+
+                sim_radio_load(self, self->downlink.data, self->downlink.len, self->rssi, self->snr);
+            }
+            else{
+
+                retval = UINT8_MAX;
+            }
+            self->armed = false;
+            break;
+        case 3U:
+            self->reg[RegIrqFlags] |= 0x08U;
+            break;
+        case 7U:
+            sim_radio_set_cad(self, isActive(self, getFreq(self)));
+            break;
+        case 6U:
+            if((retval == 0U) && receiveChannel(self)){
+
+                sim_radio_load(self, self->downlink.data, self->downlink.len, self->rssi, self->snr);
+                self->armed = false;
+            }
+            else if(retval == 0U){
+
+                /* lost on the channel */
+                self->reg[RegIrqFlags] |= 0x80U;
+                self->armed = false;
+                retval = 1U;
+            }
+            else{
+
+                self->reg[RegIrqFlags] |= 0x80U;
+            }
+            break;
+        default:
+            break;
+        }
+
+        /* TX, RX single and CAD return to standby */
+        if((self->reg[RegOpMode] & 7U) != 5U){
+
+            returnToStandby(self);
+        }
+    }
+
+    return retval;
+}
+
+void LDL_Chip_reset(void *self, bool state)
+{
+    struct sim_radio *radio = (struct sim_radio *)self;
+
+    if(state){
+
+        resetRegisters(radio);
+        radio->pending = false;
+
+        if(radio->rx){
+
+            radio->rx_on += *radio->time - radio->rx_open;
+            radio->rx = false;
+        }
+        radio->reset = true;
+        enterMode(radio, 0U, *radio->time);
+    }
+    else{
+
+        radio->reset = false;
+        enterMode(radio, radio->reg[RegOpMode] & 7U, *radio->time);
+    }
+}
+
+void LDL_Chip_write(void *self, uint8_t addr, const void *data, uint8_t size)
+{
+    struct sim_radio *radio = (struct sim_radio *)self;
+    const uint8_t *ptr = (const uint8_t *)data;
+    uint8_t i;
+
+    radio->spi_transactions++;
+    radio->spi_bytes += 1U + size;
+
+    for(i=0U; i < size; i++){
+
+        if(isFSK(radio, addr)){
+
+            writeFSK(radio, addr, ptr[i]);
+        }
+        else{
+
+            writeByte(radio, addr, ptr[i]);
+        }
+
+        addr = (addr == RegFifo) ? addr : ((addr + 1U) & 0x7fU);
+    }
+}
+
+void LDL_Chip_read(void *self, uint8_t addr, void *data, uint8_t size)
+{
+    struct sim_radio *radio = (struct sim_radio *)self;
+    uint8_t *ptr = (uint8_t *)data;
+    uint8_t i;
+
+    radio->spi_transactions++;
+    radio->spi_bytes += 1U + size;
+
+    for(i=0U; i < size; i++){
+
+        ptr[i] = isFSK(radio, addr) ? readFSK(radio, addr) : readByte(radio, addr);
+
+        addr = (addr == RegFifo) ? addr : ((addr + 1U) & 0x7fU);
+    }
+}
+
+/* static functions ***************************************************/
+
+static void writeByte(struct sim_radio *self, uint8_t addr, uint8_t data)
+{
+    switch(addr){
+    case RegFifo:
+        self->fifo[self->reg[RegFifoAddrPtr]] = data;
+        self->reg[RegFifoAddrPtr]++;
+        break;
+    case RegOpMode:
+        self->reg[RegOpMode] = data;
+        enterMode(self, data & 7U, *self->time);
+        if((data & 0x80U) == 0U){
+
+            setModeFSK(self, data & 7U);
+        }
+        else{
+
+            setMode(self, data & 7U);
+        }
+        break;
+    case RegIrqFlags:
+        self->reg[RegIrqFlags] &= ~data;
+        break;
+    case RegFrfLsb:
+        self->reg[addr] = data;
+        self->frf = ((uint32_t)self->reg[RegFrfMsb] << 16) | ((uint32_t)self->reg[RegFrfMsb + 1U] << 8) | data;
+        break;
+    case RegVersion:
+        break;
+    default:
+        self->reg[addr] = data;
+        break;
+    }
+}
+
+static uint8_t readByte(struct sim_radio *self, uint8_t addr)
+{
+    uint8_t retval;
+
+    switch(addr){
+    case RegFifo:
+        retval = self->fifo[self->reg[RegFifoAddrPtr]];
+        self->reg[RegFifoAddrPtr]++;
+        break;
+    case RegRssiWideband:
+        retval = (self->reg[addr] & 0xfeU) | (uint8_t)((self->entropy >> (31U - (self->entropy_bit & 31U))) & 1U);
+        self->entropy_bit++;
+        break;
+    default:
+        retval = self->reg[addr];
+        break;
+    }
+
+    return retval;
+}
+
+static void setMode(struct sim_radio *self, uint8_t mode)
+{
+    uint8_t i;
+    uint32_t symbols;
+    struct sim_channel_tx air;
+
+    trackReceiver(self, mode);
+
+    switch(mode){
+    case 3U:
+
+        self->tx.time = *self->time;
+        self->tx.freq = getFreq(self);
+        self->tx.bw = getBW(self);
+        self->tx.sf = getSF(self);
+        self->tx.len = self->reg[RegPayloadLength];
+
+        for(i=0U; i < self->tx.len; i++){
+
+            self->tx.data[i] = self->fifo[(uint8_t)(self->reg[RegFifoTxBaseAddr] + i)];
+        }
+
+        self->tx_count++;
+
+        if(self->channel != NULL){
+
+            (void)memset(&air, 0, sizeof(air));
+
+            air.start = self->tx.time;
+            air.freq = self->tx.freq;
+            air.bw = self->tx.bw;
+            air.sf = self->tx.sf;
+            air.size = self->tx.len;
+            air.dbm = getPower(self);
+            air.distance = self->distance;
+
+            if(!sim_channel_transmit(self->channel, &air, &self->tx_handle)){
+
+                self->tx_handle = UINT8_MAX;
+            }
+        }
+
+        schedule(self, LDL_MAC_transmitTimeUp(self->tx.bw, self->tx.sf, self->tx.len), 0U);
+        break;
+
+    case 5U:
+
+        self->entropy_bit = 0U;
+        self->pending = false;
+
+        if(self->armed && !self->timed){
+
+            self->downlink.time = *self->time;
+            schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), 0U);
+        }
+        break;
+
+    case 6U:
+
+        if(self->armed && !self->timed){
+
+            self->downlink.time = *self->time;
+            schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), 0U);
+        }
+        else if(self->armed && catchDownlink(self)){
+
+            schedule(self, self->downlink.time + downlinkTime(self) - *self->time, 0U);
+        }
+        else{
+
+            symbols = ((uint32_t)(self->reg[RegModemConfig2] & 3U) << 8) | self->reg[RegSymbTimeoutLsb];
+
+            schedule(self, symbols * symbolPeriod(self), 1U);
+        }
+        break;
+
+    case 7U:
+
+        self->cad_count++;
+
+        schedule(self, 2U * (((uint32_t)1U << getSF(self)) * LDL_System_tps() / LDL_MAC_bwToNumber(getBW(self))), 0U);
+        break;
+
+    default:
+
+        self->pending = false;
+        break;
+    }
+}
+
+static uint32_t getFreq(const struct sim_radio *self)
+{
+    return (uint32_t)(((uint64_t)self->frf * 32000000ULL) >> 19);
+}
+
+static enum ldl_signal_bandwidth getBW(const struct sim_radio *self)
+{
+    enum ldl_signal_bandwidth retval;
+
+    switch(self->reg[RegModemConfig1] >> 4){
+    default:
+    case 7U:
+        retval = LDL_BW_125;
+        break;
+    case 8U:
+        retval = LDL_BW_250;
+        break;
+    case 9U:
+        retval = LDL_BW_500;
+        break;
+    }
+
+    return retval;
+}
+
+static uint32_t bwKHz(enum ldl_signal_bandwidth bw)
+{
+    return (bw == LDL_BW_500) ? 500U : ((bw == LDL_BW_250) ? 250U : 125U);
+}
+
+static enum ldl_spreading_factor getSF(const struct sim_radio *self)
+{
+    uint8_t sf = self->reg[RegModemConfig2] >> 4;
+
+    return (enum ldl_spreading_factor)(((sf < 7U) || (sf > 12U)) ? 7U : sf);
+}
+
+/* dBm x 10^-2 */
+static int16_t getPower(const struct sim_radio *self)
+{
+    uint8_t config = self->reg[RegPaConfig];
+    int16_t retval;
+
+    if((config & 0x80U) != 0U){
+
+        /* PA_BOOST: 17 - (15 - OutputPower), 3dB more with the high power DAC */
+        retval = (int16_t)(200 + ((config & 0xfU) * 100));
+
+        if((self->reg[RegPaDac] & 7U) == 7U){
+
+            retval += 300;
+        }
+    }
+    else{
+
+        /* RFO: 10.8 + 0.6 x MaxPower - (15 - OutputPower) */
+        retval = (int16_t)(1080 + (((config >> 4) & 7U) * 60) - ((15 - (config & 0xfU)) * 100));
+    }
+
+    return retval;
+}
+
+static void schedule(struct sim_radio *self, uint32_t delay, uint8_t dio)
+{
+    self->pending = true;
+    self->pending_time = *self->time + delay;
+    self->pending_dio = dio;
+}
+
+static void resetRegisters(struct sim_radio *self)
+{
+    (void)memset(self->reg, 0, sizeof(self->reg));
+    self->frf = 0U;
+
+    /* reset values that matter to the driver */
+    self->reg[RegOpMode] = 0x09U;
+    self->reg[RegModemConfig1] = 0x72U;
+    self->reg[RegModemConfig2] = 0x70U;
+    self->reg[RegSymbTimeoutLsb] = 0x64U;
+    self->reg[RegPayloadLength] = 0x01U;
+    self->reg[RegVersion] = 0x12U;
+
+    (void)memset(self->fsk_reg, 0, sizeof(self->fsk_reg));
+
+    self->reg[RegBitrateMsb] = 0x1aU;
+    self->reg[RegBitrateLsb] = 0x0bU;
+    self->fsk_reg[RegPreambleDetect] = 0x40U;
+    self->fsk_reg[RegPreambleLsb] = 0x03U;
+    self->fsk_reg[RegSyncConfig] = 0x93U;
+    self->fsk_reg[RegPacketConfig1] = 0x90U;
+    self->fsk_reg[RegPacketConfig2] = 0x40U;
+    self->fsk_reg[RegFskPayloadLength] = 0x40U;
+    self->fsk_reg[RegFifoThresh] = 0x0fU;
+}
+
+static void enterMode(struct sim_radio *self, uint8_t mode, uint32_t time)
+{
+    self->mode_time[self->mode] += time - self->mode_since;
+    self->mode_since = time;
+    self->mode = mode;
+}
+
+static bool isActive(const struct sim_radio *self, uint32_t freq)
+{
+    bool retval = false;
+    uint8_t i;
+
+    /* within one step of the synthesizer (61Hz) */
+    for(i=0U; i < self->active_len; i++){
+
+        if(((self->active[i] > freq) ? (self->active[i] - freq) : (freq - self->active[i])) < 62U){
+
+            retval = true;
+            break;
+        }
+    }
+
+    return retval;
+}
+
+static uint32_t symbolPeriod(const struct sim_radio *self)
+{
+    return ((uint32_t)1U << getSF(self)) * LDL_System_tps() / LDL_MAC_bwToNumber(getBW(self));
+}
+
+static uint32_t downlinkTime(const struct sim_radio *self)
+{
+    uint32_t retval = LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len);
+
+    /* implicit header mode is used for beacons which have a 10 symbol preamble */
+    if((self->reg[RegModemConfig1] & 1U) != 0U){
+
+        retval += 2U * symbolPeriod(self);
+    }
+
+    return retval;
+}
+
+static bool catchDownlink(const struct sim_radio *self)
+{
+    uint32_t period = symbolPeriod(self);
+    int32_t preamble = ((self->reg[RegModemConfig1] & 1U) != 0U) ? 10 : 8;
+    int32_t open = (int32_t)(*self->time - self->downlink.time);
+    uint32_t timeout = ((uint32_t)(self->reg[RegModemConfig2] & 3U) << 8) | self->reg[RegSymbTimeoutLsb];
+    uint32_t freq = getFreq(self);
+
+    return ((((self->downlink.freq > freq) ? (self->downlink.freq - freq) : (freq - self->downlink.freq)) < 62U) &&
+        (open <= ((preamble - SIM_RADIO_PREAMBLE_DETECT) * (int32_t)period)) &&
+        ((open + (int32_t)(timeout * period)) >= (SIM_RADIO_PREAMBLE_DETECT * (int32_t)period)));
+}
+
+static void trackReceiver(struct sim_radio *self, uint8_t mode)
+{
+    if((mode == 5U) || (mode == 6U) || (mode == 7U)){
+
+        if(!self->rx){
+
+            self->rx_open = *self->time;
+            self->rx = true;
+        }
+    }
+    else if(self->rx){
+
+        self->rx_on += *self->time - self->rx_open;
+        self->rx = false;
+    }
+    else{
+
+        /* receiver stays off */
+    }
+}
+
+static void returnToStandby(struct sim_radio *self)
+{
+    if(self->rx){
+
+        self->rx_on += self->pending_time - self->rx_open;
+        self->rx = false;
+    }
+
+    self->reg[RegOpMode] = (self->reg[RegOpMode] & ~7U) | 1U;
+    enterMode(self, 1U, self->pending_time);
+}
+
+/* register the downlink that has just ended with the channel and find out if it survived */
+static bool receiveChannel(struct sim_radio *self)
+{
+    struct sim_channel_tx tx;
+    struct ldl_radio_packet_metadata meta;
+    uint8_t handle;
+    bool retval = true;
+
+    if(self->channel != NULL){
+
+        (void)memset(&tx, 0, sizeof(tx));
+        (void)memset(&meta, 0, sizeof(meta));
+
+        tx.start = self->downlink.time;
+        tx.freq = getFreq(self);
+        tx.bw = getBW(self);
+        tx.sf = getSF(self);
+        tx.size = self->downlink.len;
+        tx.dbm = self->downlink_dbm;
+        tx.distance = self->distance;
+
+        retval = sim_channel_transmit(self->channel, &tx, &handle) && sim_channel_receive(self->channel, handle, &meta);
+
+        if(retval){
+
+            self->rssi = meta.rssi;
+            self->snr = meta.snr;
+        }
+    }
+
+    return retval;
+}
+
+static bool isFSK(const struct sim_radio *self, uint8_t addr)
+{
+    return ((self->reg[RegOpMode] & 0x80U) == 0U) && ((addr == RegFifo) || ((addr >= RegFskFirst) && (addr <= RegFskLast)));
+}
+
+static void writeFSK(struct sim_radio *self, uint8_t addr, uint8_t data)
+{
+    switch(addr){
+    case RegFifo:
+
+        if(fifoLevel(self) >= FifoSize){
+
+            if((self->fsk_reg[RegIrqFlags2] & 0x10U) == 0U){
+
+                self->fifo_overrun++;
+            }
+
+            self->fsk_reg[RegIrqFlags2] |= 0x10U;
+        }
+        else if(self->fsk_in < sizeof(self->fsk_stream)){
+
+            /* byte was due to be sent already */
+            if(((self->reg[RegOpMode] & 7U) == 3U) && ((int32_t)(*self->time - (self->fsk_start + byteTime(self, headerBytes(self) + self->fsk_in))) > 0)){
+
+                self->fifo_underrun++;
+            }
+
+            self->fsk_stream[self->fsk_in] = data;
+            self->fsk_in++;
+        }
+        else{
+
+            /* stream is full */
+        }
+
+        if((self->reg[RegOpMode] & 7U) == 3U){
+
+            scheduleFSK(self);
+        }
+        break;
+
+    case RegIrqFlags2:
+
+        /* writing FifoOverrun clears the FIFO */
+        if((data & 0x10U) != 0U){
+
+            self->fsk_in = 0U;
+            self->fsk_out = 0U;
+            self->fsk_reg[RegIrqFlags2] = 0U;
+        }
+        break;
+
+    case RegIrqFlags1:
+        break;
+
+    default:
+        self->fsk_reg[addr] = data;
+        break;
+    }
+}
+
+static uint8_t readFSK(struct sim_radio *self, uint8_t addr)
+{
+    uint8_t retval;
+    uint16_t level;
+
+    switch(addr){
+    case RegFifo:
+
+        level = fifoLevel(self);
+
+        if(level > FifoSize){
+
+            if((self->fsk_reg[RegIrqFlags2] & 0x10U) == 0U){
+
+                self->fifo_overrun++;
+            }
+
+            self->fsk_reg[RegIrqFlags2] |= 0x10U;
+        }
+
+        if(level > 0U){
+
+            retval = self->fsk_stream[self->fsk_out];
+            self->fsk_out++;
+        }
+        else{
+
+            retval = 0U;
+            self->fifo_underrun++;
+        }
+
+        if((self->reg[RegOpMode] & 7U) == 5U){
+
+            scheduleFSK(self);
+        }
+        break;
+
+    case RegIrqFlags2:
+
+        level = fifoLevel(self);
+
+        retval = self->fsk_reg[RegIrqFlags2] & 0x1fU;
+        retval |= (level >= FifoSize) ? 0x80U : 0U;
+        retval |= (level == 0U) ? 0x40U : 0U;
+        retval |= (level > (self->fsk_reg[RegFifoThresh] & 0x3fU)) ? 0x20U : 0U;
+        break;
+
+    default:
+        retval = self->fsk_reg[addr];
+        break;
+    }
+
+    return retval;
+}
+
+static void setModeFSK(struct sim_radio *self, uint8_t mode)
+{
+    trackReceiver(self, mode);
+
+    self->pending = false;
+
+    switch(mode){
+    case 3U:
+
+        self->fsk_start = *self->time;
+        self->fsk_out = 0U;
+
+        self->tx.time = *self->time;
+        self->tx.freq = getFreq(self);
+        self->tx.bw = LDL_BW_125;
+        self->tx.sf = LDL_SF_FSK;
+        self->tx.len = 0U;
+
+        self->tx_count++;
+
+        scheduleFSK(self);
+        break;
+
+    case 5U:
+
+        self->fsk_start = *self->time;
+        self->fsk_frame = false;
+        self->fsk_reg[RegIrqFlags1] = 0U;
+        self->fsk_reg[RegIrqFlags2] = 0U;
+
+        if(self->armed && !self->timed){
+
+            startFrameFSK(self, *self->time);
+        }
+        else if(self->armed && catchDownlinkFSK(self)){
+
+            startFrameFSK(self, self->downlink.time);
+        }
+        else{
+
+            /* wait for timeout */
+        }
+
+        scheduleFSK(self);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static uint8_t fireFSK(struct sim_radio *self)
+{
+    uint8_t retval = self->pending_dio;
+    uint16_t i;
+    int16_t fei;
+
+    self->pending = false;
+
+    switch(retval){
+    case 0U:
+
+        if((self->reg[RegOpMode] & 7U) == 3U){
+
+            self->tx.len = (self->fsk_in > 0U) ? self->fsk_stream[0] : 0U;
+
+            for(i=0U; i < self->tx.len; i++){
+
+                self->tx.data[i] = self->fsk_stream[i + 1U];
+            }
+
+            /* frame was cut short */
+            if(self->fsk_in < frameBytes(self)){
+
+                self->fifo_underrun++;
+            }
+
+            self->fsk_reg[RegIrqFlags2] |= 0x08U;
+
+            returnToStandby(self);
+        }
+        else{
+
+            if(fifoLevel(self) > FifoSize){
+
+                self->fifo_overrun++;
+                self->fsk_reg[RegIrqFlags2] |= 0x10U;
+            }
+
+            /* PayloadReady and CrcOk */
+            self->fsk_reg[RegIrqFlags2] |= 0x06U;
+
+            self->fsk_reg[RegRssiValue] = (uint8_t)(-self->rssi * 2);
+
+            /* FeiValue = FreqError / Fstep */
+            fei = (int16_t)(((int64_t)self->freq_error * (int64_t)(1UL << 19)) / 32000000LL);
+
+            self->fsk_reg[RegFskFeiMsb] = (uint8_t)((uint16_t)fei >> 8);
+            self->fsk_reg[RegFskFeiLsb] = (uint8_t)fei;
+
+            self->armed = false;
+            self->rx_count++;
+        }
+        break;
+
+    case 1U:
+        scheduleFSK(self);
+        break;
+
+    case 2U:
+        self->fsk_reg[RegIrqFlags1] |= 0x04U;
+        break;
+
+    default:
+        break;
+    }
+
+    return retval;
+}
+
+/* schedule the next FifoLevel edge or the end of the frame */
+static void scheduleFSK(struct sim_radio *self)
+{
+    uint32_t now = *self->time;
+    uint32_t when;
+    uint16_t total = frameBytes(self);
+    uint16_t threshold = self->fsk_reg[RegFifoThresh] & 0x3fU;
+
+    self->pending = false;
+
+    switch(self->reg[RegOpMode] & 7U){
+    case 3U:
+
+        if((self->fsk_in < total) && (self->fsk_in > threshold)){
+
+            /* level falls to threshold as this byte is sent */
+            when = self->fsk_start + byteTime(self, headerBytes(self) + self->fsk_in - threshold - 1U);
+
+            if((int32_t)(when - now) > 0){
+
+                schedule(self, when - now, 1U);
+            }
+        }
+
+        if(!self->pending){
+
+            /* PacketSent after the CRC */
+            when = self->fsk_start + byteTime(self, headerBytes(self) + total + 2U);
+
+            schedule(self, ((int32_t)(when - now) > 0) ? (when - now) : 0U, 0U);
+        }
+        break;
+
+    case 5U:
+
+        if(self->fsk_frame && ((self->fsk_reg[RegIrqFlags2] & 0x04U) == 0U)){
+
+            if((self->fsk_out + threshold) < total){
+
+                /* level rises above threshold as this byte arrives */
+                when = self->fsk_start + byteTime(self, headerBytes(self) + self->fsk_out + threshold + 1U);
+
+                if((int32_t)(when - now) > 0){
+
+                    schedule(self, when - now, 1U);
+                }
+            }
+
+            if(!self->pending){
+
+                when = self->fsk_start + byteTime(self, headerBytes(self) + total + 2U);
+
+                schedule(self, ((int32_t)(when - now) > 0) ? (when - now) : 0U, 0U);
+            }
+        }
+        else if(!self->fsk_frame && (self->fsk_reg[RegRxTimeout2] > 0U) && ((self->fsk_reg[RegIrqFlags1] & 0x04U) == 0U)){
+
+            /* TimeoutRxPreamble is in units of 16 bits */
+            when = self->fsk_start + byteTime(self, 2UL * self->fsk_reg[RegRxTimeout2]);
+
+            schedule(self, ((int32_t)(when - now) > 0) ? (when - now) : 0U, 2U);
+        }
+        else{
+
+            /* nothing to signal */
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+static void startFrameFSK(struct sim_radio *self, uint32_t time)
+{
+    self->fsk_stream[0] = self->downlink.len;
+    (void)memcpy(&self->fsk_stream[1], self->downlink.data, self->downlink.len);
+
+    self->fsk_start = time;
+    self->fsk_in = 0U;
+    self->fsk_out = 0U;
+    self->fsk_frame = true;
+}
+
+static bool catchDownlinkFSK(const struct sim_radio *self)
+{
+    uint32_t preamble = ((uint32_t)self->fsk_reg[RegPreambleMsb] << 8) | self->fsk_reg[RegPreambleLsb];
+    uint32_t detect = ((self->fsk_reg[RegPreambleDetect] >> 5) & 3U) + 1U;
+    uint32_t timeout = 2UL * self->fsk_reg[RegRxTimeout2];
+    int32_t open = (int32_t)(*self->time - self->downlink.time);
+    uint32_t freq = getFreq(self);
+
+    return ((((self->downlink.freq > freq) ? (self->downlink.freq - freq) : (freq - self->downlink.freq)) < 62U) &&
+        (preamble >= detect) &&
+        (open <= (int32_t)byteTime(self, preamble - detect)) &&
+        ((timeout == 0U) || ((open + (int32_t)byteTime(self, timeout)) >= (int32_t)byteTime(self, detect))));
+}
+
+static uint32_t byteTime(const struct sim_radio *self, uint32_t bytes)
+{
+    uint32_t bitrate = ((uint32_t)self->reg[RegBitrateMsb] << 8) | self->reg[RegBitrateLsb];
+
+    /* bitrate = FXOSC / BitRate(15:0) */
+    return (uint32_t)(((uint64_t)bytes * 8ULL * bitrate * LDL_System_tps()) / 32000000ULL);
+}
+
+/* preamble and sync word */
+static uint32_t headerBytes(const struct sim_radio *self)
+{
+    uint32_t retval = ((uint32_t)self->fsk_reg[RegPreambleMsb] << 8) | self->fsk_reg[RegPreambleLsb];
+
+    if((self->fsk_reg[RegSyncConfig] & 0x10U) != 0U){
+
+        retval += (self->fsk_reg[RegSyncConfig] & 7U) + 1U;
+    }
+
+    return retval;
+}
+
+/* length and payload */
+static uint16_t frameBytes(const struct sim_radio *self)
+{
+    uint16_t retval = 0U;
+
+    if(((self->reg[RegOpMode] & 7U) == 5U) ? self->fsk_frame : (self->fsk_in > 0U)){
+
+        retval = (uint16_t)self->fsk_stream[0] + 1U;
+    }
+
+    return retval;
+}
+
+static uint16_t fifoLevel(struct sim_radio *self)
+{
+    uint32_t now = *self->time;
+    uint16_t total = frameBytes(self);
+    uint16_t arrived = 0U;
+    uint16_t retval;
+
+    if((self->reg[RegOpMode] & 7U) == 5U){
+
+        if(self->fsk_frame){
+
+            while((arrived < total) && ((int32_t)(now - (self->fsk_start + byteTime(self, headerBytes(self) + arrived + 1U))) >= 0)){
+
+                arrived++;
+            }
+        }
+
+        retval = arrived - self->fsk_out;
+    }
+    else{
+
+        if((self->reg[RegOpMode] & 7U) == 3U){
+
+            while((self->fsk_out < self->fsk_in) && ((int32_t)(now - (self->fsk_start + byteTime(self, headerBytes(self) + self->fsk_out))) >= 0)){
+
+                self->fsk_out++;
+            }
+        }
+
+        retval = self->fsk_in - self->fsk_out;
+    }
+
+    return retval;
+}
@@ -0,0 +1,247 @@
+#ifndef SIM_RADIO_H
+#define SIM_RADIO_H
+
+/* Register level model of an SX1276 in LoRa mode for the host simulator
+ *
+ * Implements the LDL_Chip_* interface so that the real radio driver
+ * can be exercised without hardware. Pass a sim_radio as the board
+ * pointer to LDL_Radio_init().
+ *
+ * - the register file and FIFO behave as on the chip (FIFO access
+ *   through RegFifo and RegFifoAddrPtr, auto-increment on bursts)
+ * - a new carrier frequency takes effect when RegFrfLsb is written
+ * - entering TX captures the frame and schedules TxDone after airtime
+ * - entering RX single schedules RxDone for a queued downlink or
+ *   RxTimeout after RegSymbTimeout symbols
+ * - a downlink queued for a given time and frequency is only caught by
+ *   an RX single window that opens no later than preamble - 
+ *   SIM_RADIO_PREAMBLE_DETECT symbols after the preamble starts and stays 
+ *   open for SIM_RADIO_PREAMBLE_DETECT symbols of preamble (the preamble 
+ *   is 10 symbols in implicit header mode and 8 otherwise)
+ * - RX continuous schedules RxDone for a downlink queued before or
+ *   during reception and stays in RX continuous after
+ * - entering sleep or standby cancels the pending event
+ * - a received frame sets RxDone and reports freq_error in RegFei
+ * - entering CAD schedules CadDone after two symbols, with CadDetected
+ *   set if the frequency has been marked active
+ * - RegRssiWideband returns the bits of a configurable entropy word
+ * - time spent with the receiver on is accumulated
+ * - time spent in each operating mode is accumulated (mode 0 while
+ *   held in reset)
+ * - with LongRangeMode clear, registers 0x0D to 0x3F are the FSK page
+ *   and the FSK packet engine is modelled in variable length mode:
+ *   bytes move through the 64 byte FIFO at the programmed bitrate,
+ *   FifoLevel is signalled on DIO1 (only the falling edge in TX and the
+ *   rising edge in RX), PacketSent/PayloadReady on DIO0 and the
+ *   preamble timeout (RegRxTimeout2) on DIO2
+ * - an FSK downlink uses the programmed preamble and sync word and is
+ *   only caught by an RX continuous window that opens before the last
+ *   detector-size bytes of preamble and does not time out first
+ * - FSK FIFO bytes written after they were due to be sent or read
+ *   before they arrived are counted as underruns, frames that overflow
+ *   the FIFO are counted as overruns
+ * - once attached to a sim_channel, each LoRa frame transmitted is
+ *   registered with the channel at the power set in RegPaConfig and
+ *   RegPaDac, and each LoRa downlink is registered as it is received
+ *   and only delivered if sim_channel_receive() says it survived (with
+ *   the RSSI and SNR it reports); a lost frame ends RX single with
+ *   RxTimeout and is dropped in RX continuous
+ *
+ * The model never raises a DIO line by itself. The test asks for the
+ * pending event with sim_radio_pending(), advances its clock and then
+ * calls sim_radio_fire() followed by LDL_Radio_interrupt().
+ *
+ * SPI transactions and bytes are counted to measure driver overhead.
+ *
+ * */
+
+#include "ldl_radio.h"
+#include "ldl_radio_defs.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef SIM_RADIO_PREAMBLE_DETECT
+#define SIM_RADIO_PREAMBLE_DETECT 5
+#endif
+
+struct sim_channel;
+
+struct sim_radio_frame {
+
+    uint32_t time;          /**< ticks at start */
+    uint32_t freq;          /**< Hz */
+    enum ldl_signal_bandwidth bw;
+    enum ldl_spreading_factor sf;
+    uint8_t data[UINT8_MAX];
+    uint8_t len;
+};
+
+struct sim_radio {
+
+    uint8_t reg[0x80];
+    uint8_t fsk_reg[0x80];  /**< FSK page (0x0D to 0x3F) */
+    uint8_t fifo[0x100];
+    bool reset;
+    uint32_t frf;           /**< frequency latched by writing RegFrfLsb */
+
+    const uint32_t *time;   /**< clock used to schedule events */
+
+    /* pending DIO event */
+    bool pending;
+    uint32_t pending_time;
+    uint8_t pending_dio;
+
+    /* delivered in the next RX single window */
+    bool armed;
+    bool timed;             /**< downlink.time and downlink.freq must be met */
+    struct sim_radio_frame downlink;
+    int16_t rssi;           /**< dBm */
+    int16_t snr;            /**< dB x 10^-2 */
+    int32_t freq_error;     /**< Hz, reported in RegFei for each frame received */
+
+    /* frequencies where CAD detects activity */
+    uint32_t active[8];
+    uint8_t active_len;
+    uint32_t cad_count;
+
+    uint32_t entropy;
+    uint8_t entropy_bit;
+
+    /* receiver on time */
+    bool rx;                /**< receiver is on */
+    uint32_t rx_open;       /**< ticks when receiver was last turned on */
+    uint32_t rx_on;         /**< ticks accumulated with receiver on */
+
+    /* operating mode time */
+    uint8_t mode;           /**< current mode (RegOpMode[2:0]) */
+    uint32_t mode_since;    /**< ticks when mode was entered */
+    uint32_t mode_time[8];  /**< ticks accumulated in each mode */
+
+    /* FSK packet engine */
+    uint8_t fsk_stream[UINT8_MAX + 1U]; /**< length followed by payload */
+    uint16_t fsk_in;        /**< TX bytes written to the FIFO */
+    uint16_t fsk_out;       /**< TX bytes sent or RX bytes read from the FIFO */
+    uint32_t fsk_start;     /**< ticks at start of preamble (or RX window) */
+    bool fsk_frame;         /**< RX frame is arriving */
+    uint32_t fifo_underrun;
+    uint32_t fifo_overrun;
+
+    /* shared channel (see sim_radio_attach()) */
+    struct sim_channel *channel;
+    uint32_t distance;      /**< m from the gateway */
+    int16_t downlink_dbm;   /**< gateway transmit power (dBm x 10^-2) */
+    uint8_t tx_handle;      /**< channel handle of the last frame transmitted (UINT8_MAX if not registered) */
+
+    /* last transmitted frame */
+    struct sim_radio_frame tx;
+    uint32_t tx_count;
+    uint32_t rx_count;
+
+    uint32_t spi_transactions;
+    uint32_t spi_bytes;
+};
+
+/** initialise
+ *
+ * @param[in] self
+ * @param[in] time  pointer to the clock (ticks)
+ *
+ * */
+void sim_radio_init(struct sim_radio *self, const uint32_t *time);
+
+/** put the radio on a shared channel
+ *
+ * The rssi and snr given to sim_radio_queue() and sim_radio_queue_at()
+ * are ignored for LoRa frames from now on.
+ *
+ * @param[in] self
+ * @param[in] channel
+ * @param[in] distance      m from the gateway
+ * @param[in] downlink_dbm  gateway transmit power (dBm x 10^-2)
+ *
+ * */
+void sim_radio_attach(struct sim_radio *self, struct sim_channel *channel, uint32_t distance, int16_t downlink_dbm);
+
+/** queue a frame for the next RX single window (or deliver it now if
+ * receiving continuously)
+ *
+ * @param[in] self
+ * @param[in] data
+ * @param[in] len
+ * @param[in] rssi  dBm
+ * @param[in] snr   dB x 10^-2
+ *
+ * */
+void sim_radio_queue(struct sim_radio *self, const void *data, uint8_t len, int16_t rssi, int16_t snr);
+
+/** queue a frame that starts at a given time on a given frequency
+ *
+ * The frame stays queued until an RX single window catches it.
+ *
+ * @param[in] self
+ * @param[in] time  ticks at start of preamble
+ * @param[in] freq  Hz
+ * @param[in] data
+ * @param[in] len
+ * @param[in] rssi  dBm
+ * @param[in] snr   dB x 10^-2
+ *
+ * */
+void sim_radio_queue_at(struct sim_radio *self, uint32_t time, uint32_t freq, const void *data, uint8_t len, int16_t rssi, int16_t snr);
+
+/** put a received frame into the FIFO and packet status registers now
+ *
+ * Used by replay where reception timing is not modelled.
+ *
+ * */
+void sim_radio_load(struct sim_radio *self, const void *data, uint8_t len, int16_t rssi, int16_t snr);
+
+/** mark a frequency as active (or clear) for CAD
+ *
+ * @param[in] self
+ * @param[in] freq      Hz
+ * @param[in] active
+ *
+ * */
+void sim_radio_set_activity(struct sim_radio *self, uint32_t freq, bool active);
+
+/** set the CAD flags now
+ *
+ * Used by replay where CAD timing is not modelled.
+ *
+ * */
+void sim_radio_set_cad(struct sim_radio *self, bool detected);
+
+/** set RxTimeout now
+ *
+ * Used by replay where reception timing is not modelled.
+ *
+ * */
+void sim_radio_set_timeout(struct sim_radio *self);
+
+/** set the word returned (MSB first) by successive RegRssiWideband reads */
+void sim_radio_set_entropy(struct sim_radio *self, uint32_t entropy);
+
+/** find out if an event is pending
+ *
+ * @param[in] self
+ * @param[out] time  when the event will fire
+ *
+ * @retval true     pending
+ *
+ * */
+bool sim_radio_pending(const struct sim_radio *self, uint32_t *time);
+
+/** bring mode_time up to date with the clock */
+void sim_radio_update(struct sim_radio *self);
+
+/** complete the pending event
+ *
+ * @param[in] self
+ * @return DIO line to pass to LDL_Radio_interrupt()
+ *
+ * */
+uint8_t sim_radio_fire(struct sim_radio *self);
+
+#endif
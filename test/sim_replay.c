@@ -0,0 +1,203 @@
+#include "sim_replay.h"
+
+#include <string.h>
+
+/* static function prototypes *****************************************/
+
+static bool isCall(enum ldl_mac_trace_type type);
+static void preload(const struct sim_system *sys, struct sim_radio *radio);
+static bool dispatch(struct ldl_mac *mac, const struct sim_trace_record *rec);
+
+/* functions **********************************************************/
+
+bool sim_replay_run(struct ldl_mac *mac, struct sim_system *sys, struct sim_radio *radio)
+{
+    struct sim_trace_record rec;
+
+    while(!sys->diverged && (sys->replay_pos < sys->replay_len)){
+
+        if(!sim_system_parse(sys->replay, sys->replay_len, &sys->replay_pos, &rec)){
+
+            sys->diverged = true;
+        }
+        else if(isCall(rec.type)){
+
+            preload(sys, radio);
+
+            if(!dispatch(mac, &rec)){
+
+                sys->diverged = true;
+            }
+        }
+        else if((rec.type == LDL_TRACE_ENTROPY) || (rec.type == LDL_TRACE_RX) || (rec.type == LDL_TRACE_CAD)){
+
+            /* already loaded */
+        }
+        else{
+
+            /* a system input that was not consumed by a call */
+            sys->diverged = true;
+        }
+    }
+
+    return !sys->diverged;
+}
+
+/* static functions ***************************************************/
+
+static bool isCall(enum ldl_mac_trace_type type)
+{
+    return (type >= LDL_TRACE_RADIO_EVENT);
+}
+
+static void preload(const struct sim_system *sys, struct sim_radio *radio)
+{
+    struct sim_trace_record rec;
+    size_t pos = sys->replay_pos;
+
+    while(sim_system_parse(sys->replay, sys->replay_len, &pos, &rec) && !isCall(rec.type)){
+
+        if((rec.type == LDL_TRACE_ENTROPY) && (rec.hdrLen == 4U)){
+
+            sim_radio_set_entropy(radio, sim_system_u32(rec.hdr));
+        }
+        else if((rec.type == LDL_TRACE_RX) && (rec.hdrLen == 5U) && (rec.hdr[4] != 0U)){
+
+            sim_radio_set_timeout(radio);
+        }
+        else if((rec.type == LDL_TRACE_RX) && (rec.hdrLen == 5U)){
+
+            sim_radio_load(radio, rec.data, rec.dataLen,
+                (int16_t)((uint16_t)rec.hdr[0] | ((uint16_t)rec.hdr[1] << 8)),
+                (int16_t)((uint16_t)rec.hdr[2] | ((uint16_t)rec.hdr[3] << 8))
+            );
+        }
+        else if((rec.type == LDL_TRACE_CAD) && (rec.hdrLen == 1U)){
+
+            sim_radio_set_cad(radio, rec.hdr[0] != 0U);
+        }
+        else{
+
+            /* consumed by the call */
+        }
+    }
+}
+
+static bool dispatch(struct ldl_mac *mac, const struct sim_trace_record *rec)
+{
+    bool retval = true;
+    struct ldl_mac_data_opts opts;
+
+    switch(rec->type){
+    case LDL_TRACE_RADIO_EVENT:
+        LDL_MAC_radioEvent(mac, (enum ldl_radio_event)rec->hdr[0]);
+        break;
+    case LDL_TRACE_PROCESS:
+        LDL_MAC_process(mac);
+        break;
+    case LDL_TRACE_OTAA:
+        (void)LDL_MAC_otaa(mac);
+        break;
+    case LDL_TRACE_DATA:
+
+        if(rec->hdrLen == 7U){
+
+            (void)memset(&opts, 0, sizeof(opts));
+
+            opts.nbTrans = rec->hdr[3];
+            opts.check = (rec->hdr[4] != 0U);
+            opts.getTime = (rec->hdr[5] != 0U);
+            opts.dither = rec->hdr[6];
+
+            if(rec->hdr[0] != 0U){
+
+                (void)LDL_MAC_confirmedData(mac, rec->hdr[1], rec->data, rec->dataLen, (rec->hdr[2] != 0U) ? &opts : NULL);
+            }
+            else{
+
+                (void)LDL_MAC_unconfirmedData(mac, rec->hdr[1], rec->data, rec->dataLen, (rec->hdr[2] != 0U) ? &opts : NULL);
+            }
+        }
+        else{
+
+            retval = false;
+        }
+        break;
+    case LDL_TRACE_FORGET:
+        LDL_MAC_forget(mac);
+        break;
+    case LDL_TRACE_CANCEL:
+        LDL_MAC_cancel(mac);
+        break;
+    case LDL_TRACE_SET_RATE:
+        (void)LDL_MAC_setRate(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_SET_POWER:
+        (void)LDL_MAC_setPower(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_ENABLE_ADR:
+        LDL_MAC_enableADR(mac);
+        break;
+    case LDL_TRACE_DISABLE_ADR:
+        LDL_MAC_disableADR(mac);
+        break;
+    case LDL_TRACE_SET_MAX_DCYCLE:
+        LDL_MAC_setMaxDCycle(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_ADD_CHANNEL:
+
+        if(rec->hdrLen == 7U){
+
+            (void)LDL_MAC_addChannel(mac, rec->hdr[0], sim_system_u32(&rec->hdr[1]), rec->hdr[5], rec->hdr[6]);
+        }
+        else{
+
+            retval = false;
+        }
+        break;
+    case LDL_TRACE_MASK_CHANNEL:
+        (void)LDL_MAC_maskChannel(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_UNMASK_CHANNEL:
+        (void)LDL_MAC_unmaskChannel(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_TICKS_UNTIL_NEXT_EVENT:
+        (void)LDL_MAC_ticksUntilNextEvent(mac);
+        break;
+    case LDL_TRACE_TIME_SINCE_VALID_DOWNLINK:
+        (void)LDL_MAC_timeSinceValidDownlink(mac);
+        break;
+    case LDL_TRACE_PRIORITY:
+        (void)LDL_MAC_priority(mac, rec->hdr[0]);
+        break;
+#ifdef LDL_ENABLE_CLASS_C
+    case LDL_TRACE_ENABLE_CLASS_C:
+        LDL_MAC_enableClassC(mac);
+        break;
+    case LDL_TRACE_DISABLE_CLASS_C:
+        LDL_MAC_disableClassC(mac);
+        break;
+#endif
+#ifdef LDL_ENABLE_CLASS_B
+    case LDL_TRACE_ENABLE_CLASS_B:
+        (void)LDL_MAC_enableClassB(mac, rec->hdr[0]);
+        break;
+    case LDL_TRACE_DISABLE_CLASS_B:
+        LDL_MAC_disableClassB(mac);
+        break;
+#endif
+#ifdef LDL_ENABLE_CAD
+    case LDL_TRACE_ENABLE_CAD:
+        LDL_MAC_enableCAD(mac, (uint16_t)sim_system_u32(rec->hdr));
+        break;
+    case LDL_TRACE_DISABLE_CAD:
+        LDL_MAC_disableCAD(mac);
+        break;
+#endif
+    default:
+        retval = false;
+        break;
+    }
+
+    return retval;
+}
@@ -0,0 +1,42 @@
+#ifndef SIM_REPLAY_H
+#define SIM_REPLAY_H
+
+/* Replay a recorded MAC session
+ *
+ * The calls in the trace are made again in the order they were
+ * recorded. Ticks, random numbers and battery readings are supplied by
+ * sim_system. Received frames and entropy are loaded into sim_radio
+ * just before the call that consumed them.
+ *
+ * To replay:
+ *
+ * 1. sim_system_replay() with the recorded trace
+ * 2. sim_radio_init()
+ * 3. LDL_Radio_init() and LDL_MAC_init() with the same arguments as the
+ *    recording
+ * 4. sim_replay_run()
+ *
+ * The application must not call into #ldl_mac from its response handler
+ * since those calls are already in the trace.
+ *
+ * */
+
+#include "sim_system.h"
+#include "sim_radio.h"
+#include "ldl_mac.h"
+
+#include <stdbool.h>
+
+/** run a replay to completion
+ *
+ * @param[in] mac
+ * @param[in] sys     in replay mode
+ * @param[in] radio   board of the radio driver used by mac
+ *
+ * @retval true     trace was consumed exactly
+ * @retval false    session diverged from the trace
+ *
+ * */
+bool sim_replay_run(struct ldl_mac *mac, struct sim_system *sys, struct sim_radio *radio);
+
+#endif
@@ -0,0 +1,850 @@
+#include "sim_sx126x.h"
+#include "ldl_chip.h"
+#include "ldl_mac.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+enum {
+    SetSleep = 0x84,
+    SetStandby = 0x80,
+    SetTx = 0x83,
+    SetRx = 0x82,
+    SetCad = 0xC5,
+    SetRegulatorMode = 0x96,
+    Calibrate = 0x89,
+    CalibrateImage = 0x98,
+    SetPaConfig = 0x95,
+    WriteRegister = 0x0D,
+    WriteBuffer = 0x0E,
+    ReadBuffer = 0x1E,
+    SetDioIrqParams = 0x08,
+    GetIrqStatus = 0x12,
+    ClearIrqStatus = 0x02,
+    SetDIO2AsRfSwitchCtrl = 0x9D,
+    SetDIO3AsTcxoCtrl = 0x97,
+    SetRfFrequency = 0x86,
+    SetPacketType = 0x8A,
+    SetTxParams = 0x8E,
+    SetModulationParams = 0x8B,
+    SetPacketParams = 0x8C,
+    SetCadParams = 0x88,
+    SetBufferBaseAddress = 0x8F,
+    SetLoRaSymbNumTimeout = 0xA0,
+    GetStatus = 0xC0,
+    GetRssiInst = 0x15,
+    GetRxBufferStatus = 0x13,
+    GetPacketStatus = 0x14
+};
+
+enum {
+    IrqTxDone = 0x0001,
+    IrqRxDone = 0x0002,
+    IrqCadDone = 0x0080,
+    IrqCadDetected = 0x0100,
+    IrqTimeout = 0x0200
+};
+
+/* registers in the 0x07xx window */
+enum {
+    RegIQPolarity = 0x36,
+    RegSyncWordMsb = 0x40,
+    RegSyncWordLsb = 0x41
+};
+
+/* static function prototypes *****************************************/
+
+static void command(struct sim_sx126x *self, uint8_t opcode, const uint8_t *param, uint8_t size);
+static uint8_t response(struct sim_sx126x *self, uint8_t opcode, uint8_t i);
+static bool configure(struct sim_sx126x *self, uint8_t opcode, uint8_t size, uint8_t expected);
+static void setMode(struct sim_sx126x *self, enum sim_sx126x_mode mode);
+static uint8_t status(const struct sim_sx126x *self);
+static void resetConfig(struct sim_sx126x *self);
+static enum ldl_signal_bandwidth getBW(const struct sim_sx126x *self);
+static enum ldl_spreading_factor getSF(const struct sim_sx126x *self);
+static bool isImplicit(const struct sim_sx126x *self);
+static void schedule(struct sim_sx126x *self, uint32_t delay, uint16_t irq);
+static void load(struct sim_sx126x *self);
+static bool isActive(const struct sim_sx126x *self, uint32_t freq);
+static uint32_t symbolPeriod(const struct sim_sx126x *self);
+static uint32_t downlinkTime(const struct sim_sx126x *self);
+static bool catchDownlink(const struct sim_sx126x *self);
+static void selectChip(struct sim_sx126x *self);
+
+/* functions **********************************************************/
+
+void sim_sx126x_init(struct sim_sx126x *self, const uint32_t *time)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    self->time = time;
+    self->mode = SIM_SX126X_STANDBY;
+    self->busy = true;
+
+    resetConfig(self);
+}
+
+void sim_sx126x_queue(struct sim_sx126x *self, const void *data, uint8_t len, int16_t rssi, int16_t snr)
+{
+    (void)memcpy(self->downlink.data, data, len);
+    self->downlink.len = len;
+    self->rssi = rssi;
+    self->snr = snr;
+    self->armed = true;
+    self->timed = false;
+
+    /* already receiving continuously */
+    if(self->mode == SIM_SX126X_RX_CONTINUOUS){
+
+        schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), IrqRxDone);
+    }
+}
+
+void sim_sx126x_queue_at(struct sim_sx126x *self, uint32_t time, uint32_t freq, const void *data, uint8_t len, int16_t rssi, int16_t snr)
+{
+    (void)memcpy(self->downlink.data, data, len);
+    self->downlink.len = len;
+    self->downlink.time = time;
+    self->downlink.freq = freq;
+    self->rssi = rssi;
+    self->snr = snr;
+    self->armed = true;
+    self->timed = true;
+}
+
+void sim_sx126x_set_activity(struct sim_sx126x *self, uint32_t freq, bool active)
+{
+    uint8_t i;
+
+    for(i=0U; i < self->active_len; i++){
+
+        if(self->active[i] == freq){
+
+            break;
+        }
+    }
+
+    if(active){
+
+        if((i == self->active_len) && (self->active_len < (sizeof(self->active)/sizeof(*self->active)))){
+
+            self->active[self->active_len] = freq;
+            self->active_len++;
+        }
+    }
+    else if(i < self->active_len){
+
+        self->active_len--;
+        self->active[i] = self->active[self->active_len];
+    }
+    else{
+
+        /* not active */
+    }
+}
+
+void sim_sx126x_set_entropy(struct sim_sx126x *self, uint32_t entropy)
+{
+    self->entropy = entropy;
+    self->entropy_bit = 0U;
+}
+
+uint32_t sim_sx126x_freq(const struct sim_sx126x *self)
+{
+    return (uint32_t)(((uint64_t)self->rf_freq * 32000000ULL) >> 25);
+}
+
+bool sim_sx126x_pending(const struct sim_sx126x *self, uint32_t *time)
+{
+    *time = self->pending_time;
+
+    return self->pending;
+}
+
+uint8_t sim_sx126x_fire(struct sim_sx126x *self)
+{
+    uint8_t retval = UINT8_MAX;
+    uint16_t irq;
+
+    if(self->pending){
+
+        self->pending = false;
+
+        irq = self->pending_irq;
+
+        if((irq & IrqRxDone) != 0U){
+
+            load(self);
+        }
+
+        if((irq & IrqCadDone) != 0U){
+
+            irq |= isActive(self, sim_sx126x_freq(self)) ? IrqCadDetected : 0U;
+        }
+
+        /* only enabled interrupts are latched */
+        self->irq |= irq & self->irq_mask;
+
+        /* TX, RX single and CAD return to standby */
+        if(self->mode != SIM_SX126X_RX_CONTINUOUS){
+
+            self->mode = SIM_SX126X_STANDBY;
+        }
+
+        if((self->irq & self->dio1_mask) != 0U){
+
+            retval = 1U;
+        }
+    }
+
+    return retval;
+}
+
+void LDL_Chip_reset(void *self, bool state)
+{
+    struct sim_sx126x *radio = (struct sim_sx126x *)self;
+
+    if(state){
+
+        resetConfig(radio);
+        (void)memset(radio->buffer, 0, sizeof(radio->buffer));
+        radio->pending = false;
+        radio->reset = true;
+    }
+    else{
+
+        radio->reset = false;
+    }
+
+    radio->mode = SIM_SX126X_STANDBY;
+    radio->busy = true;
+}
+
+void sim_sx126x_wait_busy(struct sim_sx126x *self)
+{
+    if(self->reset || (self->mode == SIM_SX126X_SLEEP)){
+
+        self->errors++;
+    }
+    else{
+
+        self->busy = false;
+        self->busy_waits++;
+    }
+}
+
+void LDL_Chip_write(void *self, uint8_t addr, const void *data, uint8_t size)
+{
+    struct sim_sx126x *radio = (struct sim_sx126x *)self;
+
+    radio->spi_transactions++;
+    radio->spi_bytes += 1U + size;
+
+    selectChip(radio);
+
+    if(radio->reset){
+
+        radio->errors++;
+    }
+    else if(radio->mode == SIM_SX126X_SLEEP){
+
+        /* NSS wakes the chip but the command is not executed */
+        radio->wakes++;
+        radio->mode = SIM_SX126X_STANDBY;
+    }
+    else{
+
+        radio->opcode_count[addr]++;
+
+        command(radio, addr, (const uint8_t *)data, size);
+    }
+}
+
+void LDL_Chip_read(void *self, uint8_t addr, void *data, uint8_t size)
+{
+    struct sim_sx126x *radio = (struct sim_sx126x *)self;
+    uint8_t *ptr = (uint8_t *)data;
+    uint8_t i;
+
+    radio->spi_transactions++;
+    radio->spi_bytes += 1U + size;
+
+    /* the driver clocks out the ReadBuffer offset and otherwise NOPs */
+    for(i=0U; i < size; i++){
+
+        if((ptr[i] != 0U) && ((addr != ReadBuffer) || (i > 0U))){
+
+            radio->errors++;
+        }
+    }
+
+    radio->read_offset = (size > 0U) ? ptr[0] : 0U;
+
+    (void)memset(ptr, 0, size);
+
+    selectChip(radio);
+
+    if(radio->reset){
+
+        radio->errors++;
+    }
+    else if(radio->mode == SIM_SX126X_SLEEP){
+
+        radio->wakes++;
+        radio->mode = SIM_SX126X_STANDBY;
+    }
+    else{
+
+        radio->opcode_count[addr]++;
+
+        for(i=0U; i < size; i++){
+
+            ptr[i] = response(radio, addr, i);
+        }
+    }
+}
+
+/* static functions ***************************************************/
+
+static void command(struct sim_sx126x *self, uint8_t opcode, const uint8_t *param, uint8_t size)
+{
+    uint32_t timeout;
+    uint16_t i;
+
+    switch(opcode){
+    case SetSleep:
+
+        if(size == 1U){
+
+            self->warm = ((param[0] & 0x04U) != 0U);
+
+            if(!self->warm){
+
+                resetConfig(self);
+            }
+
+            /* the data buffer is not retained */
+            (void)memset(self->buffer, 0, sizeof(self->buffer));
+
+            setMode(self, SIM_SX126X_SLEEP);
+        }
+        else{
+
+            self->errors++;
+        }
+        break;
+
+    case SetStandby:
+
+        if(size == 1U){
+
+            setMode(self, SIM_SX126X_STANDBY);
+        }
+        else{
+
+            self->errors++;
+        }
+        break;
+
+    case ClearIrqStatus:
+
+        if(size == 2U){
+
+            self->irq &= ~(((uint16_t)param[0] << 8) | param[1]);
+        }
+        else{
+
+            self->errors++;
+        }
+        break;
+
+    case SetRegulatorMode:
+    case SetDIO2AsRfSwitchCtrl:
+
+        (void)configure(self, opcode, size, 1U);
+        break;
+
+    case SetDIO3AsTcxoCtrl:
+
+        (void)configure(self, opcode, size, 4U);
+        break;
+
+    case Calibrate:
+
+        (void)configure(self, opcode, size, 1U);
+        break;
+
+    case CalibrateImage:
+
+        (void)configure(self, opcode, size, 2U);
+        break;
+
+    case SetPacketType:
+
+        if(configure(self, opcode, size, 1U)){
+
+            self->packet_type = param[0];
+        }
+        break;
+
+    case SetRfFrequency:
+
+        if(configure(self, opcode, size, 4U)){
+
+            self->rf_freq = ((uint32_t)param[0] << 24) | ((uint32_t)param[1] << 16) | ((uint32_t)param[2] << 8) | param[3];
+        }
+        break;
+
+    case SetModulationParams:
+
+        if(configure(self, opcode, size, sizeof(self->mod))){
+
+            (void)memcpy(self->mod, param, sizeof(self->mod));
+        }
+        break;
+
+    case SetPacketParams:
+
+        if(configure(self, opcode, size, sizeof(self->pkt))){
+
+            (void)memcpy(self->pkt, param, sizeof(self->pkt));
+        }
+        break;
+
+    case SetCadParams:
+
+        if(configure(self, opcode, size, sizeof(self->cad))){
+
+            (void)memcpy(self->cad, param, sizeof(self->cad));
+        }
+        break;
+
+    case SetDioIrqParams:
+
+        if(configure(self, opcode, size, 8U)){
+
+            self->irq_mask = ((uint16_t)param[0] << 8) | param[1];
+            self->dio1_mask = ((uint16_t)param[2] << 8) | param[3];
+        }
+        break;
+
+    case SetTxParams:
+
+        if(configure(self, opcode, size, 2U)){
+
+            self->power = (int8_t)param[0];
+        }
+        break;
+
+    case SetPaConfig:
+
+        if(configure(self, opcode, size, sizeof(self->pa))){
+
+            (void)memcpy(self->pa, param, sizeof(self->pa));
+        }
+        break;
+
+    case SetBufferBaseAddress:
+
+        if(configure(self, opcode, size, 2U)){
+
+            self->tx_base = param[0];
+            self->rx_base = param[1];
+        }
+        break;
+
+    case SetLoRaSymbNumTimeout:
+
+        if(configure(self, opcode, size, 1U)){
+
+            self->symb_timeout = param[0];
+        }
+        break;
+
+    case WriteRegister:
+
+        /* only the 0x07xx window is modelled */
+        if((size < 3U) || (param[0] != 0x07U)){
+
+            self->errors++;
+        }
+        else if(configure(self, opcode, size, size)){
+
+            for(i=0U; i < (size - 2U); i++){
+
+                self->reg[(uint8_t)(param[1] + i)] = param[2U + i];
+            }
+        }
+        else{
+
+            /* not accepted */
+        }
+        break;
+
+    case WriteBuffer:
+
+        if(size < 1U){
+
+            self->errors++;
+        }
+        else if(configure(self, opcode, size, size)){
+
+            for(i=0U; i < (size - 1U); i++){
+
+                self->buffer[(uint8_t)(param[0] + i)] = param[1U + i];
+            }
+        }
+        else{
+
+            /* not accepted */
+        }
+        break;
+
+    case SetTx:
+
+        if(configure(self, opcode, size, 3U)){
+
+            self->tx.time = *self->time;
+            self->tx.freq = sim_sx126x_freq(self);
+            self->tx.bw = getBW(self);
+            self->tx.sf = getSF(self);
+            self->tx.len = self->pkt[3];
+
+            for(i=0U; i < self->tx.len; i++){
+
+                self->tx.data[i] = self->buffer[(uint8_t)(self->tx_base + i)];
+            }
+
+            self->tx_count++;
+
+            setMode(self, SIM_SX126X_TX);
+
+            schedule(self, LDL_MAC_transmitTimeUp(self->tx.bw, self->tx.sf, self->tx.len), IrqTxDone);
+        }
+        break;
+
+    case SetRx:
+
+        if(configure(self, opcode, size, 3U)){
+
+            timeout = ((uint32_t)param[0] << 16) | ((uint32_t)param[1] << 8) | param[2];
+
+            if(timeout == 0xffffffUL){
+
+                setMode(self, SIM_SX126X_RX_CONTINUOUS);
+
+                self->entropy_bit = 0U;
+
+                if(self->armed && !self->timed){
+
+                    schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), IrqRxDone);
+                }
+            }
+            else{
+
+                setMode(self, SIM_SX126X_RX);
+
+                if(self->armed && !self->timed){
+
+                    schedule(self, LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len), IrqRxDone);
+                }
+                else if(self->armed && catchDownlink(self)){
+
+                    schedule(self, self->downlink.time + downlinkTime(self) - *self->time, IrqRxDone);
+                }
+                else if(timeout > 0U){
+
+                    /* timer steps are 15.625us */
+                    schedule(self, (uint32_t)(((uint64_t)timeout * LDL_System_tps()) / 64000ULL), IrqTimeout);
+                }
+                else if(self->symb_timeout > 0U){
+
+                    schedule(self, self->symb_timeout * symbolPeriod(self), IrqTimeout);
+                }
+                else{
+
+                    /* waits for a frame */
+                }
+            }
+        }
+        break;
+
+    case SetCad:
+
+        if(configure(self, opcode, size, 0U)){
+
+            self->cad_count++;
+
+            setMode(self, SIM_SX126X_CAD);
+
+            schedule(self, 2U * symbolPeriod(self), IrqCadDone);
+        }
+        break;
+
+    default:
+
+        self->errors++;
+        break;
+    }
+}
+
+static uint8_t response(struct sim_sx126x *self, uint8_t opcode, uint8_t i)
+{
+    uint8_t retval = status(self);
+
+    switch(opcode){
+    case GetStatus:
+        break;
+
+    case GetIrqStatus:
+
+        retval = (i == 1U) ? (uint8_t)(self->irq >> 8) : ((i == 2U) ? (uint8_t)self->irq : retval);
+        break;
+
+    case GetRxBufferStatus:
+
+        retval = (i == 1U) ? self->rx_len : ((i == 2U) ? self->rx_start : retval);
+        break;
+
+    case GetPacketStatus:
+
+        retval = ((i == 1U) || (i == 3U)) ? self->pkt_rssi : ((i == 2U) ? self->pkt_snr : retval);
+        break;
+
+    case GetRssiInst:
+
+        if((i == 1U) && (self->mode == SIM_SX126X_RX_CONTINUOUS)){
+
+            /* -64dBm with the next entropy bit as the LSB */
+            retval = 0x80U | (uint8_t)((self->entropy >> (31U - (self->entropy_bit & 31U))) & 1U);
+            self->entropy_bit++;
+        }
+        else if(i == 1U){
+
+            self->errors++;
+        }
+        else{
+
+            /* status */
+        }
+        break;
+
+    case ReadBuffer:
+
+        retval = (i < 2U) ? retval : self->buffer[(uint8_t)(self->read_offset + i - 2U)];
+        break;
+
+    default:
+
+        self->errors++;
+        break;
+    }
+
+    return retval;
+}
+
+/* configuration and operating commands are only accepted in standby
+ * (and LoRa parameters only after SetPacketType LoRa) */
+static bool configure(struct sim_sx126x *self, uint8_t opcode, uint8_t size, uint8_t expected)
+{
+    bool retval = true;
+
+    if((size != expected) || (self->mode != SIM_SX126X_STANDBY)){
+
+        retval = false;
+    }
+    else{
+
+        switch(opcode){
+        case SetModulationParams:
+        case SetPacketParams:
+        case SetCadParams:
+        case SetTx:
+        case SetRx:
+        case SetCad:
+            retval = (self->packet_type == 0x01U);
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(!retval){
+
+        self->errors++;
+    }
+
+    return retval;
+}
+
+static void setMode(struct sim_sx126x *self, enum sim_sx126x_mode mode)
+{
+    self->mode = mode;
+
+    if((mode == SIM_SX126X_SLEEP) || (mode == SIM_SX126X_STANDBY)){
+
+        self->pending = false;
+    }
+}
+
+static uint8_t status(const struct sim_sx126x *self)
+{
+    uint8_t chip_mode;
+
+    switch(self->mode){
+    default:
+    case SIM_SX126X_STANDBY:
+        chip_mode = 2U;
+        break;
+    case SIM_SX126X_TX:
+        chip_mode = 6U;
+        break;
+    case SIM_SX126X_RX:
+    case SIM_SX126X_RX_CONTINUOUS:
+    case SIM_SX126X_CAD:
+        chip_mode = 5U;
+        break;
+    }
+
+    return (uint8_t)(chip_mode << 4);
+}
+
+static void resetConfig(struct sim_sx126x *self)
+{
+    self->packet_type = 0U;
+    self->rf_freq = 0U;
+    (void)memset(self->mod, 0, sizeof(self->mod));
+    (void)memset(self->pkt, 0, sizeof(self->pkt));
+    (void)memset(self->cad, 0, sizeof(self->cad));
+    (void)memset(self->pa, 0, sizeof(self->pa));
+    (void)memset(self->reg, 0, sizeof(self->reg));
+    self->irq_mask = 0U;
+    self->dio1_mask = 0U;
+    self->irq = 0U;
+    self->tx_base = 0U;
+    self->rx_base = 0U;
+    self->symb_timeout = 0U;
+    self->power = 0;
+
+    /* reset values that matter to the driver */
+    self->reg[RegIQPolarity] = 0x0dU;
+    self->reg[RegSyncWordMsb] = 0x14U;
+    self->reg[RegSyncWordLsb] = 0x24U;
+}
+
+static enum ldl_signal_bandwidth getBW(const struct sim_sx126x *self)
+{
+    enum ldl_signal_bandwidth retval;
+
+    switch(self->mod[1]){
+    default:
+    case 0x04U:
+        retval = LDL_BW_125;
+        break;
+    case 0x05U:
+        retval = LDL_BW_250;
+        break;
+    case 0x06U:
+        retval = LDL_BW_500;
+        break;
+    }
+
+    return retval;
+}
+
+static enum ldl_spreading_factor getSF(const struct sim_sx126x *self)
+{
+    uint8_t sf = self->mod[0];
+
+    return (enum ldl_spreading_factor)(((sf < 7U) || (sf > 12U)) ? 7U : sf);
+}
+
+static bool isImplicit(const struct sim_sx126x *self)
+{
+    return (self->pkt[2] != 0U);
+}
+
+static void schedule(struct sim_sx126x *self, uint32_t delay, uint16_t irq)
+{
+    self->pending = true;
+    self->pending_time = *self->time + delay;
+    self->pending_irq = irq;
+}
+
+static void load(struct sim_sx126x *self)
+{
+    uint16_t i;
+
+    for(i=0U; i < self->downlink.len; i++){
+
+        self->buffer[(uint8_t)(self->rx_base + i)] = self->downlink.data[i];
+    }
+
+    self->rx_start = self->rx_base;
+    self->rx_len = self->downlink.len;
+    self->pkt_rssi = (uint8_t)(-2 * self->rssi);
+    self->pkt_snr = (uint8_t)(int8_t)(self->snr * 4 / 100);
+
+    self->armed = false;
+    self->rx_count++;
+}
+
+static bool isActive(const struct sim_sx126x *self, uint32_t freq)
+{
+    bool retval = false;
+    uint8_t i;
+
+    /* same tolerance as sim_radio */
+    for(i=0U; i < self->active_len; i++){
+
+        if(((self->active[i] > freq) ? (self->active[i] - freq) : (freq - self->active[i])) < 62U){
+
+            retval = true;
+            break;
+        }
+    }
+
+    return retval;
+}
+
+static uint32_t symbolPeriod(const struct sim_sx126x *self)
+{
+    return ((uint32_t)1U << getSF(self)) * LDL_System_tps() / LDL_MAC_bwToNumber(getBW(self));
+}
+
+static uint32_t downlinkTime(const struct sim_sx126x *self)
+{
+    uint32_t retval = LDL_MAC_transmitTimeDown(getBW(self), getSF(self), self->downlink.len);
+
+    /* implicit header mode is used for beacons which have a 10 symbol preamble */
+    if(isImplicit(self)){
+
+        retval += 2U * symbolPeriod(self);
+    }
+
+    return retval;
+}
+
+static bool catchDownlink(const struct sim_sx126x *self)
+{
+    uint32_t period = symbolPeriod(self);
+    int32_t preamble = isImplicit(self) ? 10 : 8;
+    int32_t open = (int32_t)(*self->time - self->downlink.time);
+    uint32_t freq = sim_sx126x_freq(self);
+
+    return ((((self->downlink.freq > freq) ? (self->downlink.freq - freq) : (freq - self->downlink.freq)) < 62U) &&
+        (open <= ((preamble - SIM_RADIO_PREAMBLE_DETECT) * (int32_t)period)) &&
+        ((open + (int32_t)(self->symb_timeout * period)) >= (SIM_RADIO_PREAMBLE_DETECT * (int32_t)period)));
+}
+
+/* NSS asserted */
+static void selectChip(struct sim_sx126x *self)
+{
+    if(self->busy && (self->mode != SIM_SX126X_SLEEP) && self->check_busy){
+
+        self->errors++;
+    }
+
+    /* BUSY goes high again once the transaction completes */
+    self->busy = true;
+}
@@ -0,0 +1,204 @@
+#ifndef SIM_SX126X_H
+#define SIM_SX126X_H
+
+/* Command level model of an SX1261/2 in LoRa mode for the host simulator
+ *
+ * Implements the LDL_Chip_* interface using the SX126x command protocol
+ * (addr is the opcode) so that the real radio driver can be exercised
+ * without hardware. Pass a sim_sx126x as the board pointer to
+ * LDL_Radio_init() with LDL_RADIO_SX1261 or LDL_RADIO_SX1262.
+ *
+ * - reads return the status byte ahead of each response byte that the
+ *   chip clocks out in place of NOP (and offset) bytes
+ * - the 256 byte data buffer is written at the given offset and read
+ *   from the offset clocked out with ReadBuffer; any other byte clocked
+ *   out by a read that is not 0x00 counts as an error
+ * - SetTx captures the frame at the TX base address and raises TxDone
+ *   after airtime
+ * - SetRx single raises RxDone for a queued downlink or Timeout after
+ *   LoRaSymbNumTimeout symbols, with the same catch rules as sim_radio
+ * - SetRx continuous raises RxDone for a downlink queued before or
+ *   during reception and stays in RX
+ * - SetCad raises CadDone after two symbols, with CadDetected if the
+ *   frequency has been marked active
+ * - GetRssiInst returns the bits of a configurable entropy word in
+ *   the LSB
+ * - the transaction that wakes the chip from sleep is not executed,
+ *   warm start sleep keeps the configuration while cold start and
+ *   reset clear it, and the data buffer is lost in sleep
+ * - configuration and mode commands that the chip would not accept in
+ *   the current mode, before SetPacketType LoRa, or with the wrong
+ *   number of parameters are counted as errors
+ * - interrupts only assert DIO1 if routed there by SetDioIrqParams
+ * - BUSY goes high after each transaction, after reset and in sleep.
+ *   By default a transaction waits for it as a blocking connector
+ *   would. With check_busy set a transaction made while BUSY is high
+ *   counts as an error (except the one that wakes the chip) unless
+ *   sim_sx126x_wait_busy() was called first.
+ *
+ * The model never raises DIO1 by itself. The test asks for the
+ * pending event with sim_sx126x_pending(), advances its clock and then
+ * calls sim_sx126x_fire() followed by LDL_Radio_interrupt().
+ *
+ * SPI transactions and the use of each opcode are counted to measure
+ * driver overhead.
+ *
+ * */
+
+#include "sim_radio.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+enum sim_sx126x_mode {
+
+    SIM_SX126X_SLEEP,
+    SIM_SX126X_STANDBY,
+    SIM_SX126X_TX,
+    SIM_SX126X_RX,
+    SIM_SX126X_RX_CONTINUOUS,
+    SIM_SX126X_CAD
+};
+
+struct sim_sx126x {
+
+    const uint32_t *time;   /**< clock used to schedule events */
+
+    bool reset;
+    enum sim_sx126x_mode mode;
+    bool warm;              /**< configuration kept through sleep */
+    uint32_t wakes;
+
+    bool busy;              /**< BUSY line */
+    bool check_busy;        /**< transactions do not wait for BUSY */
+    uint32_t busy_waits;
+
+    /* configuration */
+    uint8_t packet_type;
+    uint32_t rf_freq;       /**< SetRfFrequency setting */
+    uint8_t mod[4];         /**< SetModulationParams */
+    uint8_t pkt[6];         /**< SetPacketParams */
+    uint16_t irq_mask;
+    uint16_t dio1_mask;
+    uint8_t tx_base;
+    uint8_t rx_base;
+    uint8_t symb_timeout;
+    uint8_t cad[7];         /**< SetCadParams */
+    int8_t power;
+    uint8_t pa[4];          /**< SetPaConfig */
+    uint8_t reg[0x100];     /**< registers 0x0700 to 0x07FF */
+
+    uint8_t buffer[0x100];
+    uint8_t read_offset;    /**< clocked out with the last ReadBuffer */
+    uint16_t irq;
+
+    /* last frame received */
+    uint8_t rx_len;
+    uint8_t rx_start;
+    uint8_t pkt_rssi;       /**< -2 x dBm */
+    uint8_t pkt_snr;        /**< 4 x dB */
+
+    /* pending event */
+    bool pending;
+    uint32_t pending_time;
+    uint16_t pending_irq;
+
+    /* delivered in the next RX window */
+    bool armed;
+    bool timed;             /**< downlink.time and downlink.freq must be met */
+    struct sim_radio_frame downlink;
+    int16_t rssi;           /**< dBm */
+    int16_t snr;            /**< dB x 10^-2 */
+
+    /* frequencies where CAD detects activity */
+    uint32_t active[8];
+    uint8_t active_len;
+    uint32_t cad_count;
+
+    uint32_t entropy;
+    uint8_t entropy_bit;
+
+    /* last transmitted frame */
+    struct sim_radio_frame tx;
+    uint32_t tx_count;
+    uint32_t rx_count;
+
+    uint32_t spi_transactions;
+    uint32_t spi_bytes;
+    uint32_t opcode_count[0x100];
+    uint32_t errors;
+};
+
+/** initialise
+ *
+ * @param[in] self
+ * @param[in] time  pointer to the clock (ticks)
+ *
+ * */
+void sim_sx126x_init(struct sim_sx126x *self, const uint32_t *time);
+
+/** queue a frame for the next RX single window (or deliver it now if
+ * receiving continuously)
+ *
+ * @param[in] self
+ * @param[in] data
+ * @param[in] len
+ * @param[in] rssi  dBm
+ * @param[in] snr   dB x 10^-2
+ *
+ * */
+void sim_sx126x_queue(struct sim_sx126x *self, const void *data, uint8_t len, int16_t rssi, int16_t snr);
+
+/** queue a frame that starts at a given time on a given frequency
+ *
+ * The frame stays queued until an RX single window catches it.
+ *
+ * @param[in] self
+ * @param[in] time  ticks at start of preamble
+ * @param[in] freq  Hz
+ * @param[in] data
+ * @param[in] len
+ * @param[in] rssi  dBm
+ * @param[in] snr   dB x 10^-2
+ *
+ * */
+void sim_sx126x_queue_at(struct sim_sx126x *self, uint32_t time, uint32_t freq, const void *data, uint8_t len, int16_t rssi, int16_t snr);
+
+/** mark a frequency as active (or clear) for CAD */
+void sim_sx126x_set_activity(struct sim_sx126x *self, uint32_t freq, bool active);
+
+/** set the word returned (MSB first) by successive GetRssiInst commands */
+void sim_sx126x_set_entropy(struct sim_sx126x *self, uint32_t entropy);
+
+/** wait for BUSY to fall
+ *
+ * Counts an error if BUSY would never fall (sleep or reset).
+ *
+ * @param[in] self
+ *
+ * */
+void sim_sx126x_wait_busy(struct sim_sx126x *self);
+
+/** carrier frequency (Hz) */
+uint32_t sim_sx126x_freq(const struct sim_sx126x *self);
+
+/** find out if an event is pending
+ *
+ * @param[in] self
+ * @param[out] time  when the event will fire
+ *
+ * @retval true     pending
+ *
+ * */
+bool sim_sx126x_pending(const struct sim_sx126x *self, uint32_t *time);
+
+/** complete the pending event
+ *
+ * @param[in] self
+ * @return DIO line to pass to LDL_Radio_interrupt() (UINT8_MAX if the
+ * interrupt is not routed to DIO1)
+ *
+ * */
+uint8_t sim_sx126x_fire(struct sim_sx126x *self);
+
+#endif
@@ -0,0 +1,233 @@
+#include "sim_system.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* static variables ***************************************************/
+
+static uint32_t eps;
+static uint32_t advance;
+
+/* static function prototypes *****************************************/
+
+static const uint8_t *pop(struct sim_system *self, enum ldl_mac_trace_type type, uint8_t len);
+static uint32_t xorshift(uint32_t *state);
+
+/* functions **********************************************************/
+
+void sim_system_init(struct sim_system *self, uint32_t seed)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    self->seed = (seed == 0U) ? 1U : seed;
+    self->battery = 255U;
+}
+
+void sim_system_record(struct sim_system *self, uint8_t *buf, size_t max)
+{
+    self->log = buf;
+    self->log_max = max;
+    self->log_len = 0U;
+    self->overflow = false;
+}
+
+void sim_system_replay(struct sim_system *self, const uint8_t *buf, size_t len)
+{
+    self->replay = buf;
+    self->replay_len = len;
+    self->replay_pos = 0U;
+    self->diverged = false;
+}
+
+void sim_system_set_eps(uint32_t value)
+{
+    eps = value;
+}
+
+void sim_system_set_advance(uint32_t value)
+{
+    advance = value;
+}
+
+uint32_t sim_system_to_true(const struct sim_system *self, uint32_t ticks)
+{
+    uint32_t retval;
+
+    retval = (uint32_t)(((uint64_t)ticks * 1000000ULL) / (uint64_t)(1000000L + self->ppm));
+
+    /* never stall the caller on a non-zero interval */
+    return ((retval == 0U) && (ticks > 0U)) ? 1U : retval;
+}
+
+void sim_system_trace(void *app, enum ldl_mac_trace_type type, const void *hdr, uint8_t hdrLen, const void *data, uint8_t dataLen)
+{
+    struct sim_system *self = (struct sim_system *)app;
+    uint8_t *out;
+
+    if(self->log != NULL){
+
+        if((self->log_len + 3U + hdrLen + dataLen) <= self->log_max){
+
+            out = &self->log[self->log_len];
+
+            out[0] = (uint8_t)type;
+            out[1] = hdrLen;
+            out[2] = dataLen;
+
+            (void)memcpy(&out[3], hdr, hdrLen);
+            (void)memcpy(&out[3U + hdrLen], data, dataLen);
+
+            self->log_len += 3U + hdrLen + dataLen;
+        }
+        else{
+
+            self->overflow = true;
+        }
+    }
+}
+
+bool sim_system_parse(const uint8_t *buf, size_t len, size_t *pos, struct sim_trace_record *rec)
+{
+    bool retval = false;
+
+    if((*pos + 3U) <= len){
+
+        rec->type = (enum ldl_mac_trace_type)buf[*pos];
+        rec->hdrLen = buf[*pos + 1U];
+        rec->dataLen = buf[*pos + 2U];
+
+        if((*pos + 3U + rec->hdrLen + rec->dataLen) <= len){
+
+            rec->hdr = &buf[*pos + 3U];
+            rec->data = &buf[*pos + 3U + rec->hdrLen];
+
+            *pos += 3U + rec->hdrLen + rec->dataLen;
+
+            retval = true;
+        }
+    }
+
+    return retval;
+}
+
+uint32_t sim_system_u32(const uint8_t *in)
+{
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+uint32_t LDL_System_ticks(void *app)
+{
+    struct sim_system *self = (struct sim_system *)app;
+    const uint8_t *in;
+    uint32_t retval;
+
+    if(self->replay != NULL){
+
+        in = pop(self, LDL_TRACE_TICKS, 4U);
+        retval = (in != NULL) ? sim_system_u32(in) : 0U;
+    }
+    else{
+
+        retval = self->time + (uint32_t)(((int64_t)self->time * self->ppm) / 1000000L);
+    }
+
+    return retval;
+}
+
+uint32_t LDL_System_tps(void)
+{
+    return SIM_SYSTEM_TPS;
+}
+
+uint32_t LDL_System_eps(void)
+{
+    return eps;
+}
+
+uint32_t LDL_System_advance(void)
+{
+    return advance;
+}
+
+uint8_t LDL_System_rand(void *app)
+{
+    struct sim_system *self = (struct sim_system *)app;
+    const uint8_t *in;
+    uint8_t retval;
+
+    if(self->replay != NULL){
+
+        in = pop(self, LDL_TRACE_RAND, 1U);
+        retval = (in != NULL) ? *in : 0U;
+    }
+    else{
+
+        retval = (uint8_t)(xorshift(&self->seed) >> 24);
+    }
+
+    return retval;
+}
+
+uint8_t LDL_System_getBatteryLevel(void *app)
+{
+    struct sim_system *self = (struct sim_system *)app;
+    const uint8_t *in;
+    uint8_t retval;
+
+    if(self->replay != NULL){
+
+        in = pop(self, LDL_TRACE_BATTERY, 1U);
+        retval = (in != NULL) ? *in : 0U;
+    }
+    else{
+
+        retval = self->battery;
+    }
+
+    return retval;
+}
+
+/* static functions ***************************************************/
+
+static const uint8_t *pop(struct sim_system *self, enum ldl_mac_trace_type type, uint8_t len)
+{
+    const uint8_t *retval = NULL;
+    struct sim_trace_record rec;
+
+    while(!self->diverged){
+
+        if(!sim_system_parse(self->replay, self->replay_len, &self->replay_pos, &rec)){
+
+            self->diverged = true;
+        }
+        /* radio inputs are loaded into the radio by the replay driver */
+        else if((rec.type == LDL_TRACE_ENTROPY) || (rec.type == LDL_TRACE_RX)){
+
+            continue;
+        }
+        else if((rec.type != type) || (rec.hdrLen != len)){
+
+            self->diverged = true;
+        }
+        else{
+
+            retval = rec.hdr;
+            break;
+        }
+    }
+
+    return retval;
+}
+
+static uint32_t xorshift(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    *state = x;
+
+    return x;
+}
@@ -0,0 +1,123 @@
+#ifndef SIM_SYSTEM_H
+#define SIM_SYSTEM_H
+
+/* System interface for the host simulator
+ *
+ * Implements the LDL_System_* interface on a virtual clock that the
+ * test advances explicitly. Random numbers come from a seeded PRNG
+ * so that a session is repeatable.
+ *
+ * A sim_system can also record the trace emitted by #ldl_mac
+ * (LDL_ENABLE_TRACE) and act as the source of inputs when that
+ * trace is replayed. During replay ticks, random numbers and battery
+ * readings are taken from the trace instead of the clock and PRNG.
+ *
+ * The device clock seen through LDL_System_ticks() can be made to run
+ * fast or slow against the true time kept by the test (ppm). The
+ * error budget and timing advance reported to the MAC through
+ * LDL_System_eps() and LDL_System_advance() are global since those
+ * interfaces have no app pointer.
+ *
+ * Trace records are serialised as:
+ *
+ * [type u8][hdrLen u8][dataLen u8][hdr][data]
+ *
+ * */
+
+#include "ldl_mac.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef SIM_SYSTEM_TPS
+#define SIM_SYSTEM_TPS 1000000UL
+#endif
+
+struct sim_trace_record {
+
+    enum ldl_mac_trace_type type;
+    const uint8_t *hdr;
+    uint8_t hdrLen;
+    const uint8_t *data;
+    uint8_t dataLen;
+};
+
+struct sim_system {
+
+    uint32_t time;          /**< ticks (true time) */
+    int32_t ppm;            /**< error of the device clock against true time */
+    uint32_t seed;          /**< PRNG state */
+    uint8_t battery;
+
+    /* recording */
+    uint8_t *log;
+    size_t log_max;
+    size_t log_len;
+    bool overflow;
+
+    /* replay */
+    const uint8_t *replay;
+    size_t replay_len;
+    size_t replay_pos;
+    bool diverged;
+
+    /** passed through to the test's response handler */
+    void *user;
+};
+
+/** initialise
+ *
+ * @param[in] self
+ * @param[in] seed  PRNG seed
+ *
+ * */
+void sim_system_init(struct sim_system *self, uint32_t seed);
+
+/** record trace into buffer
+ *
+ * @param[in] self
+ * @param[in] buf
+ * @param[in] max
+ *
+ * */
+void sim_system_record(struct sim_system *self, uint8_t *buf, size_t max);
+
+/** take system inputs from a recorded trace
+ *
+ * @param[in] self
+ * @param[in] buf
+ * @param[in] len
+ *
+ * */
+void sim_system_replay(struct sim_system *self, const uint8_t *buf, size_t len);
+
+/** set the value returned by LDL_System_eps() */
+void sim_system_set_eps(uint32_t eps);
+
+/** set the value returned by LDL_System_advance() */
+void sim_system_set_advance(uint32_t advance);
+
+/** convert a duration on the device clock to true time */
+uint32_t sim_system_to_true(const struct sim_system *self, uint32_t ticks);
+
+/** #ldl_mac_trace_fn for ldl_mac_init_arg.trace (app must be a sim_system) */
+void sim_system_trace(void *app, enum ldl_mac_trace_type type, const void *hdr, uint8_t hdrLen, const void *data, uint8_t dataLen);
+
+/** parse the record at *pos in a trace buffer
+ *
+ * @param[in] buf
+ * @param[in] len
+ * @param[in/out] pos   advanced to the next record
+ * @param[out] rec
+ *
+ * @retval true     record parsed
+ * @retval false    end of buffer or malformed record
+ *
+ * */
+bool sim_system_parse(const uint8_t *buf, size_t len, size_t *pos, struct sim_trace_record *rec);
+
+/** read a u32 from a record header field */
+uint32_t sim_system_u32(const uint8_t *in);
+
+#endif
@@ -0,0 +1,183 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* EU_863_870 default channels */
+static const uint32_t channels[] = {868100000UL, 868300000UL, 868500000UL};
+
+/* helpers */
+
+static int setup(void **user)
+{
+    static struct sim_harness h;
+
+    sim_harness_init(&h, 1U);
+    sim_harness_start(&h, LDL_EU_863_870, true);
+
+    LDL_MAC_disableADR(&h.mac);
+
+    *user = &h;
+
+    return 0;
+}
+
+static uint8_t channel_of(uint32_t freq)
+{
+    uint8_t retval = UINT8_MAX;
+    uint8_t i;
+
+    for(i=0U; i < (sizeof(channels)/sizeof(*channels)); i++){
+
+        /* the radio reports the frequency synthesized */
+        if((channels[i] - freq) < 62U){
+
+            retval = i;
+            break;
+        }
+    }
+
+    return retval;
+}
+
+/* tests */
+
+static void disabled_shall_transmit_without_cad(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(0U, self->radio.cad_count);
+    assert_int_equal(1U, self->radio.tx_count);
+}
+
+static void clear_channel_shall_be_counted(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    struct ldl_mac_channel_activity activity;
+    uint8_t chIndex;
+
+    LDL_MAC_enableCAD(&self->mac, 100U);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(1U, self->radio.cad_count);
+    assert_int_equal(1U, self->radio.tx_count);
+
+    chIndex = channel_of(self->radio.tx.freq);
+
+    assert_true(LDL_MAC_getChannelActivity(&self->mac, chIndex, &activity));
+    assert_int_equal(1U, activity.clear);
+    assert_int_equal(0U, activity.busy);
+}
+
+static void busy_channel_shall_be_avoided(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    struct ldl_mac_channel_activity activity;
+    uint32_t busy;
+
+    LDL_MAC_enableCAD(&self->mac, 100U);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    /* the channel chosen for this frame is occupied */
+    busy = self->mac.tx.freq;
+    sim_radio_set_activity(&self->radio, busy, true);
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(2U, self->radio.cad_count);
+    assert_int_equal(1U, self->radio.tx_count);
+    assert_true(self->radio.tx.freq != busy);
+
+    assert_true(LDL_MAC_getChannelActivity(&self->mac, channel_of(busy), &activity));
+    assert_int_equal(0U, activity.clear);
+    assert_int_equal(1U, activity.busy);
+
+    assert_true(LDL_MAC_getChannelActivity(&self->mac, channel_of(self->radio.tx.freq), &activity));
+    assert_int_equal(1U, activity.clear);
+    assert_int_equal(0U, activity.busy);
+
+    /* there is no such channel */
+    assert_false(LDL_MAC_getChannelActivity(&self->mac, UINT8_MAX, &activity));
+}
+
+static void busy_band_shall_transmit_after_max_attempts(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    struct ldl_mac_channel_activity activity;
+    uint32_t busy = 0U;
+    uint32_t until;
+    uint8_t i;
+
+    LDL_MAC_enableCAD(&self->mac, 100U);
+
+    for(i=0U; i < (sizeof(channels)/sizeof(*channels)); i++){
+
+        sim_radio_set_activity(&self->radio, channels[i], true);
+    }
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(LDL_CAD_MAX_ATTEMPTS, self->radio.cad_count);
+    assert_int_equal(1U, self->radio.tx_count);
+
+    for(i=0U; i < (sizeof(channels)/sizeof(*channels)); i++){
+
+        assert_true(LDL_MAC_getChannelActivity(&self->mac, i, &activity));
+        assert_int_equal(0U, activity.clear);
+        busy += activity.busy;
+    }
+
+    assert_int_equal(LDL_CAD_MAX_ATTEMPTS, busy);
+
+    /* the next frame gets a full set of attempts */
+    sim_radio_set_activity(&self->radio, channels[channel_of(self->radio.tx.freq)], false);
+
+    self->radio.cad_count = 0U;
+
+    /* wait out the duty cycle */
+    until = self->sys.time + (60UL * LDL_System_tps());
+
+    while((int32_t)(until - self->sys.time) > 0){
+
+        sim_harness_step(self, until);
+    }
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_true(self->radio.cad_count > 0U);
+    assert_int_equal(2U, self->radio.tx_count);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(disabled_shall_transmit_without_cad, setup),
+        cmocka_unit_test_setup(clear_channel_shall_be_counted, setup),
+        cmocka_unit_test_setup(busy_channel_shall_be_avoided, setup),
+        cmocka_unit_test_setup(busy_band_shall_transmit_after_max_attempts, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,241 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_channel.h"
+#include "ldl_mac.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/* setups */
+
+static int setup(void **user)
+{
+    static struct sim_channel state;
+
+    sim_channel_init(&state, NULL);
+    *user = (void *)&state;
+
+    return 0;
+}
+
+/* helpers */
+
+static struct sim_channel_tx make_tx(uint32_t start, enum ldl_spreading_factor sf, int16_t dbm, uint32_t distance)
+{
+    struct sim_channel_tx retval;
+
+    (void)memset(&retval, 0, sizeof(retval));
+
+    retval.start = start;
+    retval.freq = 868100000UL;
+    retval.bw = LDL_BW_125;
+    retval.sf = sf;
+    retval.size = 20U;
+    retval.dbm = dbm;
+    retval.distance = distance;
+
+    return retval;
+}
+
+/* tests */
+
+static void isolated_packet_shall_be_delivered(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx tx = make_tx(0U, LDL_SF_7, 1400, 1000U);
+    struct ldl_radio_packet_metadata meta;
+    uint8_t h;
+
+    assert_true(sim_channel_transmit(self, &tx, &h));
+    assert_true(sim_channel_receive(self, h, &meta));
+
+    /* 14dBm less reference loss */
+    assert_int_equal(-114, meta.rssi);
+    assert_int_equal(sim_channel_rssi(self, 1400, 1000U) - sim_channel_noise(self, LDL_BW_125), meta.snr);
+}
+
+static void distant_packet_shall_be_lost_below_demodulator_floor(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx tx = make_tx(0U, LDL_SF_7, 1400, 5000U);
+    uint8_t h;
+
+    assert_true(sim_channel_transmit(self, &tx, &h));
+    assert_false(sim_channel_receive(self, h, NULL));
+    assert_int_equal(1U, self->stats.weak);
+}
+
+static void distant_packet_shall_be_delivered_at_higher_sf(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx tx = make_tx(0U, LDL_SF_10, 1400, 3000U);
+    uint8_t h;
+
+    assert_true(sim_channel_transmit(self, &tx, &h));
+    assert_true(sim_channel_receive(self, h, NULL));
+}
+
+static void overlapping_equal_power_packets_shall_collide(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_7, 1400, 500U);
+    struct sim_channel_tx b = make_tx(1000U, LDL_SF_7, 1400, 500U);
+    uint8_t ha, hb;
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    assert_false(sim_channel_receive(self, ha, NULL));
+    assert_false(sim_channel_receive(self, hb, NULL));
+    assert_int_equal(2U, self->stats.collided);
+}
+
+static void stronger_packet_shall_capture_receiver(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx near = make_tx(0U, LDL_SF_7, 1400, 200U);
+    struct sim_channel_tx far = make_tx(1000U, LDL_SF_7, 1400, 1000U);
+    uint8_t hn, hf;
+
+    assert_true(sim_channel_transmit(self, &near, &hn));
+    assert_true(sim_channel_transmit(self, &far, &hf));
+
+    assert_true(sim_channel_receive(self, hn, NULL));
+    assert_false(sim_channel_receive(self, hf, NULL));
+}
+
+static void overlapping_packets_on_different_sf_shall_not_collide(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_7, 1400, 500U);
+    struct sim_channel_tx b = make_tx(0U, LDL_SF_9, 1400, 500U);
+    uint8_t ha, hb;
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    assert_true(sim_channel_receive(self, ha, NULL));
+    assert_true(sim_channel_receive(self, hb, NULL));
+}
+
+static void overwhelming_packet_on_different_sf_shall_interfere(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_9, 1400, 1500U);
+    struct sim_channel_tx b = make_tx(0U, LDL_SF_7, 1400, 10U);
+    uint8_t ha, hb;
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    assert_false(sim_channel_receive(self, ha, NULL));
+    assert_true(sim_channel_receive(self, hb, NULL));
+}
+
+static void overlapping_packets_on_different_freq_shall_not_collide(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_7, 1400, 500U);
+    struct sim_channel_tx b = make_tx(0U, LDL_SF_7, 1400, 500U);
+    uint8_t ha, hb;
+
+    b.freq = 868300000UL;
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    assert_true(sim_channel_receive(self, ha, NULL));
+    assert_true(sim_channel_receive(self, hb, NULL));
+}
+
+static void sequential_packets_shall_not_collide(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_7, 1400, 500U);
+    struct sim_channel_tx b;
+    uint8_t ha, hb;
+
+    b = make_tx(LDL_MAC_transmitTimeUp(a.bw, a.sf, a.size), LDL_SF_7, 1400, 500U);
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    assert_true(sim_channel_receive(self, ha, NULL));
+    assert_true(sim_channel_receive(self, hb, NULL));
+}
+
+static void expire_shall_forget_finished_transmissions(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx a = make_tx(0U, LDL_SF_7, 1400, 500U);
+    struct sim_channel_tx b = make_tx(10000000UL, LDL_SF_7, 1400, 500U);
+    uint8_t ha, hb;
+
+    assert_true(sim_channel_transmit(self, &a, &ha));
+    assert_true(sim_channel_transmit(self, &b, &hb));
+
+    sim_channel_expire(self, b.start);
+
+    assert_int_equal(1U, self->count);
+    assert_int_equal(b.start, self->record[0].tx.start);
+}
+
+static void delivery_rate_shall_fall_as_offered_load_rises(void **user)
+{
+    struct sim_channel *self = (struct sim_channel *)(*user);
+    struct sim_channel_tx tx;
+    uint32_t airtime;
+    uint32_t rate[2];
+    uint8_t handle[SIM_CHANNEL_MAX];
+    uint8_t load;
+    uint8_t i;
+
+    airtime = LDL_MAC_transmitTimeUp(LDL_BW_125, LDL_SF_7, 20U);
+
+    srand(42);
+
+    /* pure aloha, 32 nodes at 0.1 and 2.0 erlang */
+    for(load=0U; load < 2U; load++){
+
+        sim_channel_init(self, NULL);
+
+        for(i=0U; i < 32U; i++){
+
+            tx = make_tx((uint32_t)rand() % (airtime * ((load == 0U) ? 320UL : 16UL)), LDL_SF_7, 1400, 300U + ((uint32_t)rand() % 400U));
+
+            assert_true(sim_channel_transmit(self, &tx, &handle[i]));
+        }
+
+        for(i=0U; i < 32U; i++){
+
+            (void)sim_channel_receive(self, handle[i], NULL);
+        }
+
+        rate[load] = self->stats.delivered;
+    }
+
+    assert_true(rate[0] > rate[1]);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(isolated_packet_shall_be_delivered, setup),
+        cmocka_unit_test_setup(distant_packet_shall_be_lost_below_demodulator_floor, setup),
+        cmocka_unit_test_setup(distant_packet_shall_be_delivered_at_higher_sf, setup),
+        cmocka_unit_test_setup(overlapping_equal_power_packets_shall_collide, setup),
+        cmocka_unit_test_setup(stronger_packet_shall_capture_receiver, setup),
+        cmocka_unit_test_setup(overlapping_packets_on_different_sf_shall_not_collide, setup),
+        cmocka_unit_test_setup(overwhelming_packet_on_different_sf_shall_interfere, setup),
+        cmocka_unit_test_setup(overlapping_packets_on_different_freq_shall_not_collide, setup),
+        cmocka_unit_test_setup(sequential_packets_shall_not_collide, setup),
+        cmocka_unit_test_setup(expire_shall_forget_finished_transmissions, setup),
+        cmocka_unit_test_setup(delivery_rate_shall_fall_as_offered_load_rises, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
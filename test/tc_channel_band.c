@@ -0,0 +1,185 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "ldl_mac.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* setups */
+
+static int setup_eu(void **user)
+{
+    static struct sim_harness self;
+
+    sim_harness_init(&self, 1U);
+    sim_harness_start(&self, LDL_EU_863_870, true);
+
+    *user = (void *)&self;
+
+    return 0;
+}
+
+static int setup_us(void **user)
+{
+    static struct sim_harness self;
+
+    sim_harness_init(&self, 1U);
+    sim_harness_start(&self, LDL_US_902_928, true);
+
+    *user = (void *)&self;
+
+    return 0;
+}
+
+/* helpers */
+
+/* leave only channel 3 enabled */
+static void only_channel_3(struct sim_harness *self, uint32_t freq)
+{
+    assert_true(LDL_MAC_maskChannel(&self->mac, 0U));
+    assert_true(LDL_MAC_maskChannel(&self->mac, 1U));
+    assert_true(LDL_MAC_maskChannel(&self->mac, 2U));
+
+    assert_true(LDL_MAC_addChannel(&self->mac, 3U, freq, 0U, 5U));
+    assert_true(LDL_MAC_unmaskChannel(&self->mac, 3U));
+}
+
+static void send(struct sim_harness *self)
+{
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 10U);
+}
+
+/* tests */
+
+static void set_channel_shall_cache_band(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    assert_true(LDL_MAC_addChannel(&self->mac, 3U, 863500000UL, 0U, 5U));
+    assert_true(LDL_MAC_addChannel(&self->mac, 4U, 868900000UL, 0U, 5U));
+    assert_true(LDL_MAC_addChannel(&self->mac, 5U, 869525000UL, 0U, 5U));
+    assert_true(LDL_MAC_addChannel(&self->mac, 6U, 869850000UL, 0U, 5U));
+
+    assert_int_equal(LDL_BAND_2, self->mac.ctx.chConfig[0].band);
+    assert_int_equal(LDL_BAND_1, self->mac.ctx.chConfig[3].band);
+    assert_int_equal(LDL_BAND_3, self->mac.ctx.chConfig[4].band);
+    assert_int_equal(LDL_BAND_4, self->mac.ctx.chConfig[5].band);
+    assert_int_equal(LDL_BAND_5, self->mac.ctx.chConfig[6].band);
+
+    /* moving a channel moves its band */
+    assert_true(LDL_MAC_setChannel(&self->mac, 3U, 868900000UL, 0U, 5U));
+
+    assert_int_equal(LDL_BAND_3, self->mac.ctx.chConfig[3].band);
+
+    /* outside every band, or removed */
+    assert_true(LDL_MAC_addChannel(&self->mac, 4U, 870500000UL, 0U, 5U));
+    assert_true(LDL_MAC_addChannel(&self->mac, 5U, 0UL, 0U, 5U));
+
+    assert_int_equal(UINT8_MAX, self->mac.ctx.chConfig[4].band);
+    assert_int_equal(UINT8_MAX, self->mac.ctx.chConfig[5].band);
+
+    /* no such channel */
+    assert_false(LDL_MAC_addChannel(&self->mac, LDL_Region_numChannels(LDL_EU_863_870), 868900000UL, 0U, 5U));
+}
+
+static void uplink_shall_charge_cached_band(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint8_t i;
+
+    only_channel_3(self, 868900000UL);
+
+    send(self);
+
+    assert_int_equal(868900000UL, self->mac.tx.freq);
+
+    /* only the 0.1% band is charged */
+    for(i=LDL_BAND_1; i <= LDL_BAND_5; i++){
+
+        if(i == LDL_BAND_3){
+
+            assert_true(self->mac.band[i] > 0U);
+        }
+        else{
+
+            assert_int_equal(0U, self->mac.band[i]);
+        }
+    }
+}
+
+static void moved_channel_shall_use_new_band(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    only_channel_3(self, 868900000UL);
+
+    send(self);
+
+    /* the 0.1% band is still off */
+    assert_false(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+    assert_int_equal(LDL_ERRNO_NOCHANNEL, LDL_MAC_errno(&self->mac));
+
+    /* the 10% band is not */
+    assert_true(LDL_MAC_setChannel(&self->mac, 3U, 869525000UL, 0U, 5U));
+
+    send(self);
+
+    assert_int_equal(869525000UL, self->mac.tx.freq);
+    assert_true(self->mac.band[LDL_BAND_4] > 0U);
+}
+
+static void channel_outside_bands_shall_not_be_used(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    only_channel_3(self, 870500000UL);
+
+    assert_int_equal(UINT8_MAX, self->mac.ctx.chConfig[3].band);
+
+    assert_false(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+    assert_int_equal(LDL_ERRNO_NOCHANNEL, LDL_MAC_errno(&self->mac));
+
+    /* and is used again once moved into a band */
+    assert_true(LDL_MAC_setChannel(&self->mac, 3U, 868900000UL, 0U, 5U));
+
+    send(self);
+
+    assert_int_equal(868900000UL, self->mac.tx.freq);
+}
+
+static void fixed_channel_band_shall_come_from_region(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint8_t i;
+
+    send(self);
+
+    /* US_902_928 has no duty cycle */
+    for(i=LDL_BAND_1; i <= LDL_BAND_5; i++){
+
+        assert_int_equal(0U, self->mac.band[i]);
+    }
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(set_channel_shall_cache_band, setup_eu),
+        cmocka_unit_test_setup(uplink_shall_charge_cached_band, setup_eu),
+        cmocka_unit_test_setup(moved_channel_shall_use_new_band, setup_eu),
+        cmocka_unit_test_setup(channel_outside_bands_shall_not_be_used, setup_eu),
+        cmocka_unit_test_setup(fixed_channel_band_shall_come_from_region, setup_us)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
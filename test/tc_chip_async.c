@@ -0,0 +1,411 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_system.h"
+#include "sim_radio.h"
+#include "sim_async.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+struct harness {
+
+    struct sim_system sys;
+    struct sim_radio radio;
+    struct sim_async async;
+    struct ldl_radio driver;
+    struct ldl_sm sm;
+    struct ldl_mac mac;
+
+    struct ldl_radio_tx_setting tx;
+    struct ldl_radio_rx_setting rx;
+
+    uint32_t completions;
+    uint32_t events;
+};
+
+static const uint8_t key[] = "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f";
+static const uint8_t eui[] = "\x00\x00\x00\x00\x00\x00\x00\x01";
+
+static struct harness h;
+
+/* helpers */
+
+static void radio_handler(struct ldl_mac *mac, enum ldl_radio_event event)
+{
+    (void)mac;
+
+    if(event == LDL_RADIO_EVENT_CHIP_COMPLETE){
+
+        h.completions++;
+    }
+}
+
+static void mac_handler(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)((struct sim_system *)app)->user;
+    uint8_t buf[UINT8_MAX];
+    uint8_t len;
+
+    (void)arg;
+
+    self->events |= (1UL << type);
+
+    /* answer join requests in RX1 */
+    if((type == LDL_MAC_TX_BEGIN) && (self->radio.tx.data[0] == 0x00U)){
+
+        len = sim_network_join_accept(key, 1U, 0x13U, 0x01020304UL, 0U, 1U, buf);
+        sim_radio_queue(&self->radio, buf, len, -80, 500);
+    }
+}
+
+static int setup_radio(void **user)
+{
+    struct harness *self = &h;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 1U);
+    sim_radio_init(&self->radio, &self->sys.time);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1276, &self->radio);
+    LDL_Radio_setPA(&self->driver, LDL_RADIO_PA_BOOST);
+    LDL_Radio_setHandler(&self->driver, NULL, radio_handler);
+
+    sim_async_init(&self->async, &self->radio, &self->driver);
+
+    self->tx.freq = 868100000UL;
+    self->tx.bw = LDL_BW_125;
+    self->tx.sf = LDL_SF_7;
+    self->tx.dbm = 1400;
+
+    self->rx.freq = 868100000UL;
+    self->rx.bw = LDL_BW_125;
+    self->rx.sf = LDL_SF_7;
+    self->rx.timeout = 8U;
+    self->rx.max = 64U;
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+    LDL_Radio_sleep(&self->driver);
+    sim_async_wait(&self->async);
+
+    *user = self;
+
+    return 0;
+}
+
+static int setup_mac(void **user)
+{
+    struct harness *self = &h;
+    struct ldl_mac_init_arg arg;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 42U);
+    self->sys.user = self;
+
+    sim_radio_init(&self->radio, &self->sys.time);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1276, &self->radio);
+    LDL_Radio_setPA(&self->driver, LDL_RADIO_PA_BOOST);
+
+    sim_async_init(&self->async, &self->radio, &self->driver);
+
+    LDL_SM_init(&self->sm, key, key);
+
+    (void)memset(&arg, 0, sizeof(arg));
+
+    arg.app = &self->sys;
+    arg.radio = &self->driver;
+    arg.sm = &self->sm;
+    arg.handler = mac_handler;
+    arg.joinEUI = eui;
+    arg.devEUI = eui;
+
+    LDL_MAC_init(&self->mac, LDL_EU_863_870, &arg);
+
+    *user = self;
+
+    return 0;
+}
+
+static int teardown(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    sim_async_deinit(&self->async);
+
+    return 0;
+}
+
+/* one uplink as sequenced by the MAC, waiting for each batch */
+static void uplink(struct harness *self)
+{
+    LDL_Radio_transmit(&self->driver, &self->tx, "hello", 5U);
+    sim_async_wait(&self->async);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+    sim_async_wait(&self->async);
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+    sim_async_wait(&self->async);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+    sim_async_wait(&self->async);
+}
+
+/* advance the simulation to the next MAC or radio event (no further than until) */
+static void step(struct harness *self, uint32_t until)
+{
+    uint32_t next;
+    uint32_t when;
+
+    LDL_MAC_process(&self->mac);
+
+    /* completion is delivered before the MAC is asked when to run next */
+    sim_async_wait(&self->async);
+
+    next = LDL_MAC_ticksUntilNextEvent(&self->mac);
+    next = (next < (until - self->sys.time)) ? next : (until - self->sys.time);
+
+    if(sim_radio_pending(&self->radio, &when) && ((int32_t)(when - self->sys.time) <= (int32_t)next)){
+
+        if((int32_t)(when - self->sys.time) > 0){
+
+            self->sys.time = when;
+        }
+
+        LDL_Radio_interrupt(&self->driver, sim_radio_fire(&self->radio));
+    }
+    else{
+
+        self->sys.time += next;
+    }
+}
+
+static void run_until(struct harness *self, enum ldl_mac_response_type type, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    self->events = 0U;
+
+    while(((self->events & (1UL << type)) == 0U) && ((int32_t)(until - self->sys.time) > 0)){
+
+        step(self, until);
+    }
+
+    assert_true((self->events & (1UL << type)) != 0U);
+}
+
+static void run_until_ready(struct harness *self, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    while(!LDL_MAC_ready(&self->mac) && ((int32_t)(until - self->sys.time) > 0)){
+
+        step(self, until);
+    }
+}
+
+/* tests */
+
+static void transmit_shall_return_before_transfers_are_made(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    uplink(self);
+
+    sim_async_hold(&self->async, true);
+
+    self->completions = 0U;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "world", 5U);
+
+    /* submitted but the chip has not been touched */
+    assert_true(sim_async_pending(&self->async));
+    assert_int_equal(1U, self->radio.tx_count);
+    assert_int_equal(0U, self->completions);
+
+    sim_async_hold(&self->async, false);
+    sim_async_wait(&self->async);
+
+    assert_int_equal(2U, self->radio.tx_count);
+    assert_int_equal(1U, self->completions);
+    assert_memory_equal("world", self->radio.tx.data, 5U);
+}
+
+static void uplink_shall_need_one_batch_per_operation(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t batches;
+    uint32_t transfers;
+
+    uplink(self);
+
+    batches = self->async.batches;
+    transfers = self->async.transfers;
+    self->radio.spi_transactions = 0U;
+
+    uplink(self);
+
+    /* transmit, clear, receive, clear */
+    assert_int_equal(4U, self->async.batches - batches);
+
+    /* the CPU made none of the transfers */
+    assert_int_equal(self->radio.spi_transactions, self->async.transfers - transfers);
+}
+
+static void operation_requested_during_batch_shall_wait_for_resume(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t submitted;
+
+    uplink(self);
+
+    sim_async_hold(&self->async, true);
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "world", 5U);
+
+    submitted = self->async.submitted;
+
+    /* neither touches the chip while the transmit batch is in progress */
+    LDL_Radio_receive(&self->driver, &self->rx);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_true(LDL_Radio_busy(&self->driver));
+    assert_true(LDL_Radio_pending(&self->driver));
+    assert_int_equal(submitted, self->async.submitted);
+
+    sim_async_hold(&self->async, false);
+    sim_async_wait(&self->async);
+
+    assert_false(LDL_Radio_busy(&self->driver));
+    assert_true(LDL_Radio_pending(&self->driver));
+
+    LDL_Radio_resume(&self->driver);
+    sim_async_wait(&self->async);
+
+    /* only the last one requested is started */
+    assert_int_equal(submitted + 1U, self->async.submitted);
+    assert_false(LDL_Radio_pending(&self->driver));
+    assert_int_equal(0x00U, self->radio.reg[0x01] & 0x07U);
+}
+
+static void collect_shall_read_frame_in_two_batches(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    uint8_t frame[20U];
+    uint8_t buf[64U];
+    uint32_t batches;
+    size_t i;
+
+    for(i=0U; i < sizeof(frame); i++){
+
+        frame[i] = (uint8_t)i;
+    }
+
+    sim_radio_load(&self->radio, frame, sizeof(frame), -80, 500);
+
+    batches = self->async.batches;
+
+    LDL_Radio_collectBegin(&self->driver, buf, sizeof(buf));
+    sim_async_wait(&self->async);
+
+    assert_false(LDL_Radio_collectResume(&self->driver));
+    sim_async_wait(&self->async);
+
+    assert_true(LDL_Radio_collectResume(&self->driver));
+
+    assert_int_equal(sizeof(frame), LDL_Radio_collectEnd(&self->driver, &meta));
+    assert_memory_equal(frame, buf, sizeof(frame));
+    assert_int_equal(-80, meta.rssi);
+    assert_int_equal(500, meta.snr);
+
+    assert_int_equal(2U, self->async.batches - batches);
+}
+
+static void join_and_send_shall_complete(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    run_until(self, LDL_MAC_STARTUP, 10U);
+
+    assert_true(LDL_MAC_otaa(&self->mac));
+
+    run_until(self, LDL_MAC_JOIN_COMPLETE, 600U);
+
+    assert_true(LDL_MAC_joined(&self->mac));
+    assert_int_equal(1U, self->radio.rx_count);
+
+    run_until_ready(self, 600U);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    run_until(self, LDL_MAC_DATA_COMPLETE, 600U);
+
+    assert_int_equal(2U, self->radio.tx_count);
+    assert_true(self->async.batches > 0U);
+}
+
+static void mac_shall_return_while_a_batch_is_in_progress(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t submitted;
+
+    run_until(self, LDL_MAC_STARTUP, 10U);
+
+    sim_async_hold(&self->async, true);
+
+    assert_true(LDL_MAC_otaa(&self->mac));
+
+    /* run the MAC until it submits the join request */
+    while(!sim_async_pending(&self->async)){
+
+        LDL_MAC_process(&self->mac);
+
+        if(!sim_async_pending(&self->async)){
+
+            self->sys.time += LDL_MAC_ticksUntilNextEvent(&self->mac);
+        }
+    }
+
+    submitted = self->async.submitted;
+
+    /* woken by completion instead of a timer */
+    assert_int_equal(UINT32_MAX, LDL_MAC_ticksUntilNextEvent(&self->mac));
+
+    LDL_MAC_process(&self->mac);
+    LDL_MAC_process(&self->mac);
+
+    assert_int_equal(submitted, self->async.submitted);
+    assert_int_equal(0U, self->radio.tx_count);
+
+    sim_async_hold(&self->async, false);
+    sim_async_wait(&self->async);
+
+    run_until(self, LDL_MAC_JOIN_COMPLETE, 600U);
+
+    assert_true(LDL_MAC_joined(&self->mac));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(transmit_shall_return_before_transfers_are_made, setup_radio, teardown),
+        cmocka_unit_test_setup_teardown(uplink_shall_need_one_batch_per_operation, setup_radio, teardown),
+        cmocka_unit_test_setup_teardown(operation_requested_during_batch_shall_wait_for_resume, setup_radio, teardown),
+        cmocka_unit_test_setup_teardown(collect_shall_read_frame_in_two_batches, setup_radio, teardown),
+        cmocka_unit_test_setup_teardown(join_and_send_shall_complete, setup_mac, teardown),
+        cmocka_unit_test_setup_teardown(mac_shall_return_while_a_batch_is_in_progress, setup_mac, teardown)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
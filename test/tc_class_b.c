@@ -0,0 +1,439 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_ops.h"
+#include "ldl_radio.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* Class B beacon tracking and ping slots
+ *
+ * The network keeps GPS time from a perfect clock that reads EPOCH
+ * seconds at true time zero. A beacon is transmitted at the start of
+ * every 128 second period on 869.525MHz (SF9) for as long as the
+ * harness has beacons enabled.
+ *
+ * The device clock runs PPM fast and the MAC is told to allow EPS
+ * ticks per second. A window catches a frame if the receiver opens
+ * no later than preamble - 5 symbols after the preamble starts and
+ * stays open until 5 symbols of preamble have been seen (see sim_radio).
+ *
+ * */
+
+#define EPOCH 1300000100UL
+#define PPM 20
+#define EPS 30U
+#define PERIODICITY 2U
+#define PREAMBLE_DETECT SIM_RADIO_PREAMBLE_DETECT
+
+
+static const uint32_t beacon_freq = 869525000UL;
+
+struct harness {
+
+    struct sim_harness sim;
+
+    bool beacons;
+    uint16_t down;
+
+    uint32_t tx_end;            /**< true time at end of last uplink */
+
+    uint32_t beacon_time;       /**< GPS time of the current beacon period */
+    uint8_t beacon_timeout;     /**< symbols in last beacon window */
+
+    uint32_t ping_slots;        /**< ping slots opened */
+    uint32_t ping_caught;       /**< would have caught a frame at the slot start */
+};
+
+/* helpers */
+
+static uint32_t symbol_period(enum ldl_spreading_factor sf, enum ldl_signal_bandwidth bw)
+{
+    return (((uint32_t)1U << sf) * LDL_System_tps()) / LDL_MAC_bwToNumber(bw);
+}
+
+/* true time at the start of a beacon period */
+static uint32_t beacon_start(uint32_t gps)
+{
+    return (gps - EPOCH) * LDL_System_tps();
+}
+
+/* true time at the start of a ping slot in a beacon period */
+static uint32_t slot_start(const struct harness *self, uint32_t gps, uint16_t slot)
+{
+    uint16_t period = (uint16_t)(1U << (5U + PERIODICITY));
+    uint16_t offset = LDL_OPS_pingOffset(gps, self->sim.mac.ctx.devAddr, period);
+
+    return beacon_start(gps) + (2120UL * 1000UL) + (((uint32_t)offset + ((uint32_t)slot * period)) * 30UL * 1000UL);
+}
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)sim;
+    uint32_t period;
+    int32_t open;
+    int32_t best = INT32_MAX;
+    uint16_t i;
+
+    switch(type){
+    case LDL_MAC_TX_BEGIN:
+
+        self->tx_end = self->sim.radio.tx.time + LDL_MAC_transmitTimeUp(self->sim.radio.tx.bw, self->sim.radio.tx.sf, self->sim.radio.tx.len);
+        break;
+
+    case LDL_MAC_BEACON:
+
+        self->beacon_time = arg->beacon.time;
+        break;
+
+    case LDL_MAC_BEACON_MISSED:
+
+        self->beacon_time += 128UL;
+        break;
+
+    case LDL_MAC_BEACON_SLOT:
+
+        self->beacon_timeout = arg->rx_slot.timeout;
+        break;
+
+    case LDL_MAC_PING_SLOT:
+
+        self->ping_slots++;
+
+        period = symbol_period(arg->rx_slot.sf, arg->rx_slot.bw);
+
+        /* measure against the nearest slot in this period */
+        for(i=0U; i < (1U << (7U - PERIODICITY)); i++){
+
+            open = (int32_t)(self->sim.radio.rx_open - slot_start(self, self->beacon_time, i));
+
+            if(((open < 0) ? -open : open) < ((best < 0) ? -best : best)){
+
+                best = open;
+            }
+        }
+
+        if((best <= ((8 - PREAMBLE_DETECT) * (int32_t)period)) && ((best + (int32_t)(arg->rx_slot.timeout * period)) >= (PREAMBLE_DETECT * (int32_t)period))){
+
+            self->ping_caught++;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* the gateway always has the next beacon queued */
+static void on_step(struct sim_harness *sim)
+{
+    struct harness *self = (struct harness *)sim;
+    uint32_t gps;
+    uint8_t buf[17U];
+
+    if(self->beacons && !self->sim.radio.armed){
+
+        gps = (((EPOCH + (self->sim.sys.time / LDL_System_tps())) / 128UL) + 1UL) * 128UL;
+
+        sim_radio_queue_at(&self->sim.radio, beacon_start(gps), beacon_freq, buf, sim_network_beacon(gps, buf), -90, 500);
+    }
+}
+
+/* answer DeviceTimeReq and PingSlotInfoReq in RX1 */
+static void queue_answer(struct harness *self)
+{
+    uint8_t opts[7U];
+    uint8_t buf[32U];
+    uint32_t seconds = EPOCH + (self->tx_end / LDL_System_tps());
+    uint8_t len;
+
+    opts[0] = 0x0dU;
+    opts[1] = (uint8_t)seconds;
+    opts[2] = (uint8_t)(seconds >> 8);
+    opts[3] = (uint8_t)(seconds >> 16);
+    opts[4] = (uint8_t)(seconds >> 24);
+    opts[5] = (uint8_t)(((self->tx_end % LDL_System_tps()) * 256UL) / LDL_System_tps());
+    opts[6] = 0x10U;
+
+    self->down++;
+
+    len = sim_network_data_down(&self->sim.sm, self->sim.mac.ctx.devAddr, self->down, opts, sizeof(opts), 0U, NULL, 0U, buf);
+
+    sim_radio_queue(&self->sim.radio, buf, len, -80, 500);
+}
+
+static bool uplink_has_command(const struct harness *self, uint8_t cid)
+{
+    bool retval = false;
+    uint8_t optsLen = self->sim.radio.tx.data[5] & 0xfU;
+    uint8_t i;
+
+    for(i=0U; i < optsLen; i++){
+
+        if(self->sim.radio.tx.data[8U + i] == cid){
+
+            retval = true;
+            break;
+        }
+    }
+
+    return retval;
+}
+
+static void acquire(struct harness *self)
+{
+    assert_true(LDL_MAC_enableClassB(&self->sim.mac, PERIODICITY));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_TX_COMPLETE, 60U);
+
+    queue_answer(self);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 10U);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 150U);
+
+    assert_true(LDL_MAC_beaconLocked(&self->sim.mac));
+}
+
+static int setup(void **user)
+{
+    static struct harness h;
+    struct harness *self = &h;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_harness_init(&self->sim, 1U);
+    sim_system_set_eps(EPS);
+    sim_system_set_advance(0U);
+
+    self->sim.sys.ppm = PPM;
+    self->sim.on_event = on_event;
+    self->sim.on_step = on_step;
+
+    self->beacons = true;
+
+    sim_harness_start(&self->sim, LDL_EU_863_870, true);
+
+    LDL_MAC_disableADR(&self->sim.mac);
+
+    *user = self;
+
+    return 0;
+}
+
+/* tests */
+
+static void unsupported_region_shall_be_refused(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    assert_false(LDL_MAC_enableClassB(&self->sim.mac, 8U));
+    assert_false(LDL_MAC_classB(&self->sim.mac));
+
+    self->sim.mac.region = LDL_US_902_928;
+
+    assert_false(LDL_MAC_enableClassB(&self->sim.mac, PERIODICITY));
+    assert_false(LDL_MAC_classB(&self->sim.mac));
+}
+
+static void uplink_shall_request_time_and_ping_slot_info(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    assert_true(LDL_MAC_enableClassB(&self->sim.mac, PERIODICITY));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_TX_COMPLETE, 60U);
+
+    assert_true(uplink_has_command(self, 0x0dU));
+    assert_true(uplink_has_command(self, 0x10U));
+
+    /* not yet tracking the beacon */
+    assert_int_equal(0U, self->sim.radio.tx.data[5] & 0x10U);
+}
+
+static void beacon_shall_be_acquired_after_device_time(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    acquire(self);
+
+    /* first beacon after the end of the uplink */
+    assert_int_equal(((EPOCH + (self->tx_end / LDL_System_tps())) / 128UL + 1UL) * 128UL, self->beacon_time);
+
+    /* stays locked */
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 130U);
+
+    assert_true(LDL_MAC_beaconLocked(&self->sim.mac));
+}
+
+static void ping_slots_shall_open_on_time(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    acquire(self);
+
+    self->ping_slots = 0U;
+    self->ping_caught = 0U;
+
+    /* a full beacon period of slots */
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 130U);
+
+    assert_int_equal(1U << (7U - PERIODICITY), self->ping_slots);
+    assert_int_equal(self->ping_slots, self->ping_caught);
+}
+
+static void downlink_shall_be_received_in_ping_slot(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t buf[32U];
+    uint32_t start;
+    uint8_t len;
+
+    acquire(self);
+
+    self->beacons = false;
+
+    start = slot_start(self, self->beacon_time, 3U);
+
+    self->down++;
+
+    len = sim_network_data_down(&self->sim.sm, self->sim.mac.ctx.devAddr, self->down, NULL, 0U, 10U, "on", 2U, buf);
+
+    sim_radio_queue_at(&self->sim.radio, start, beacon_freq, buf, len, -80, 500);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_RX, 130U);
+
+    assert_int_equal(10U, self->sim.rx_port);
+    assert_int_equal(2U, self->sim.rx_size);
+    assert_memory_equal("on", self->sim.rx_data, 2U);
+
+    /* in the slot it was sent */
+    assert_true((self->sim.rx_time - start) < LDL_System_tps());
+}
+
+static void uplink_shall_coexist_with_ping_slots(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    acquire(self);
+
+    /* wait out the duty cycle */
+    sim_harness_run_for(&self->sim, 150U);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 60U);
+
+    /* class B is indicated and the answered requests are not repeated */
+    assert_int_equal(0x10U, self->sim.radio.tx.data[5] & 0x10U);
+    assert_false(uplink_has_command(self, 0x0dU));
+    assert_false(uplink_has_command(self, 0x10U));
+
+    self->ping_slots = 0U;
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 130U);
+
+    assert_true(self->ping_slots > 0U);
+}
+
+static void missed_beacon_shall_widen_window(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t timeout;
+
+    acquire(self);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON_SLOT, 130U);
+
+    timeout = self->beacon_timeout;
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 10U);
+
+    /* the gateway misses the next beacon */
+    self->beacons = false;
+    self->sim.radio.armed = false;
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON_MISSED, 130U);
+
+    self->beacons = true;
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON_SLOT, 130U);
+
+    assert_true(self->beacon_timeout > timeout);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON, 10U);
+
+    assert_true(LDL_MAC_beaconLocked(&self->sim.mac));
+}
+
+static void beacon_shall_be_lost_after_missing_too_many(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    acquire(self);
+
+    self->beacons = false;
+    self->sim.radio.armed = false;
+
+    sim_harness_run_until(&self->sim, LDL_MAC_BEACON_LOST, (LDL_BEACON_MISSED_MAX + 2UL) * 128UL);
+
+    assert_false(LDL_MAC_beaconLocked(&self->sim.mac));
+    assert_true(LDL_MAC_classB(&self->sim.mac));
+
+    /* the next uplink asks for the time again */
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_TX_COMPLETE, 60U);
+
+    assert_true(uplink_has_command(self, 0x0dU));
+}
+
+static void disable_shall_stop_windows(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    acquire(self);
+
+    LDL_MAC_disableClassB(&self->sim.mac);
+
+    assert_false(LDL_MAC_classB(&self->sim.mac));
+    assert_false(LDL_MAC_beaconLocked(&self->sim.mac));
+
+    self->ping_slots = 0U;
+    self->sim.events = 0U;
+
+    sim_harness_run_for(&self->sim, 130U);
+
+    assert_int_equal(0U, self->ping_slots);
+    assert_int_equal(0U, self->sim.events & (1UL << LDL_MAC_BEACON_SLOT));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(unsupported_region_shall_be_refused, setup),
+        cmocka_unit_test_setup(uplink_shall_request_time_and_ping_slot_info, setup),
+        cmocka_unit_test_setup(beacon_shall_be_acquired_after_device_time, setup),
+        cmocka_unit_test_setup(ping_slots_shall_open_on_time, setup),
+        cmocka_unit_test_setup(downlink_shall_be_received_in_ping_slot, setup),
+        cmocka_unit_test_setup(uplink_shall_coexist_with_ping_slots, setup),
+        cmocka_unit_test_setup(missed_beacon_shall_widen_window, setup),
+        cmocka_unit_test_setup(beacon_shall_be_lost_after_missing_too_many, setup),
+        cmocka_unit_test_setup(disable_shall_stop_windows, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,243 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* helpers */
+
+static void run_until_listening(struct sim_harness *self, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    while((LDL_MAC_state(&self->mac) != LDL_STATE_RXC) && ((int32_t)(until - self->sys.time) > 0)){
+
+        sim_harness_step(self, until);
+    }
+
+    assert_int_equal(LDL_STATE_RXC, LDL_MAC_state(&self->mac));
+}
+
+static int setup(void **user)
+{
+    static struct sim_harness h;
+
+    sim_harness_init(&h, 1U);
+    sim_harness_start(&h, LDL_EU_863_870, true);
+
+    LDL_MAC_disableADR(&h.mac);
+    LDL_MAC_enableClassC(&h.mac);
+
+    *user = &h;
+
+    return 0;
+}
+
+static void queue_downlink(struct sim_harness *self, uint16_t counter, uint8_t port, const char *data)
+{
+    uint8_t buf[64U];
+    uint8_t len;
+
+    len = sim_network_data_down(&self->sm, self->mac.ctx.devAddr, counter, NULL, 0U, port, data, (uint8_t)strlen(data), buf);
+
+    sim_radio_queue(&self->radio, buf, len, -80, 500);
+}
+
+/* tests */
+
+static void receiver_shall_use_rx2_settings(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    run_until_listening(self, 1U);
+
+    assert_int_equal(5U, self->radio.reg[0x01] & 7U);             /* RX continuous */
+    assert_int_equal(0xd96199UL, self->radio.frf);                  /* 869.525MHz */
+    assert_int_equal(0xc0U, self->radio.reg[0x1E] & 0xf0U);       /* SF12 */
+}
+
+static void downlink_shall_be_received_between_uplinks(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint32_t sent;
+
+    run_until_listening(self, 1U);
+
+    /* some time after the last uplink */
+    self->sys.time += 100UL * LDL_System_tps();
+
+    sent = self->sys.time;
+    queue_downlink(self, 1U, 10U, "on");
+
+    sim_harness_run_until(self, LDL_MAC_RX, 10U);
+
+    assert_int_equal(10U, self->rx_port);
+    assert_int_equal(2U, self->rx_size);
+    assert_memory_equal("on", self->rx_data, 2U);
+
+    /* airtime of the downlink at SF12 */
+    assert_true((self->rx_time - sent) < (2UL * LDL_System_tps()));
+
+    /* and keeps listening */
+    run_until_listening(self, 1U);
+
+    queue_downlink(self, 2U, 11U, "off");
+
+    sim_harness_run_until(self, LDL_MAC_RX, 10U);
+
+    assert_int_equal(11U, self->rx_port);
+    assert_memory_equal("off", self->rx_data, 3U);
+}
+
+static void foreign_downlink_shall_be_ignored(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint8_t buf[64U];
+    uint8_t len;
+
+    run_until_listening(self, 1U);
+
+    /* another device */
+    len = sim_network_data_down(&self->sm, 0x01020305UL, 1U, NULL, 0U, 10U, "on", 2U, buf);
+    sim_radio_queue(&self->radio, buf, len, -80, 500);
+
+    sim_harness_run_until(self, LDL_MAC_DOWNSTREAM, 10U);
+
+    assert_true((self->events & (1UL << LDL_MAC_RX)) == 0U);
+
+    run_until_listening(self, 1U);
+}
+
+static void uplink_shall_interrupt_receiver(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    run_until_listening(self, 1U);
+
+    assert_true(LDL_MAC_ready(&self->mac));
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    assert_int_equal(LDL_STATE_WAIT_TX, LDL_MAC_state(&self->mac));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(1U, self->radio.tx_count);
+
+    run_until_listening(self, 1U);
+}
+
+static void downlink_shall_be_received_while_waiting_to_transmit(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    struct ldl_mac_data_opts opts;
+
+    run_until_listening(self, 1U);
+
+    (void)memset(&opts, 0, sizeof(opts));
+    opts.dither = 60U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, &opts));
+
+    assert_int_equal(LDL_STATE_WAIT_TX, LDL_MAC_state(&self->mac));
+    assert_int_equal(5U, self->radio.reg[0x01] & 7U);             /* RX continuous */
+
+    queue_downlink(self, 1U, 10U, "on");
+
+    sim_harness_run_until(self, LDL_MAC_RX, 10U);
+
+    assert_int_equal(10U, self->rx_port);
+    assert_memory_equal("on", self->rx_data, 2U);
+
+    /* the uplink is still to come */
+    assert_int_equal(0U, self->radio.tx_count);
+    assert_int_equal(LDL_STATE_WAIT_TX, LDL_MAC_state(&self->mac));
+    assert_int_equal(5U, self->radio.reg[0x01] & 7U);
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 120U);
+
+    assert_int_equal(1U, self->radio.tx_count);
+
+    run_until_listening(self, 1U);
+}
+
+static void queue_on_tx_complete(struct sim_harness *self, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    (void)arg;
+
+    if(type == LDL_MAC_TX_COMPLETE){
+
+        assert_int_equal(LDL_STATE_WAIT_RX1, LDL_MAC_state(&self->mac));
+        assert_int_equal(5U, self->radio.reg[0x01] & 7U);         /* RX continuous */
+
+        queue_downlink(self, 1U, 10U, "on");
+    }
+}
+
+static void downlink_shall_be_received_before_rx1(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    run_until_listening(self, 1U);
+
+    /* long enough for a frame at SF12 */
+    self->mac.ctx.rx1Delay = 5U;
+
+    self->on_event = queue_on_tx_complete;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_RX, 60U);
+
+    self->on_event = NULL;
+
+    assert_int_equal(10U, self->rx_port);
+    assert_memory_equal("on", self->rx_data, 2U);
+
+    /* still waiting for the windows of the uplink */
+    assert_true((self->events & (1UL << LDL_MAC_RX1_SLOT)) == 0U);
+    assert_int_equal(LDL_STATE_WAIT_RX1, LDL_MAC_state(&self->mac));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_true((self->events & (1UL << LDL_MAC_RX1_SLOT)) != 0U);
+    assert_true((self->events & (1UL << LDL_MAC_RX2_SLOT)) != 0U);
+
+    run_until_listening(self, 1U);
+}
+
+static void disable_shall_stop_receiver(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    run_until_listening(self, 1U);
+
+    LDL_MAC_disableClassC(&self->mac);
+
+    assert_int_equal(LDL_STATE_IDLE, LDL_MAC_state(&self->mac));
+    assert_int_equal(0U, self->radio.reg[0x01] & 7U);             /* sleep */
+    assert_false(self->radio.rx);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(receiver_shall_use_rx2_settings, setup),
+        cmocka_unit_test_setup(downlink_shall_be_received_between_uplinks, setup),
+        cmocka_unit_test_setup(foreign_downlink_shall_be_ignored, setup),
+        cmocka_unit_test_setup(uplink_shall_interrupt_receiver, setup),
+        cmocka_unit_test_setup(downlink_shall_be_received_while_waiting_to_transmit, setup),
+        cmocka_unit_test_setup(downlink_shall_be_received_before_rx1, setup),
+        cmocka_unit_test_setup(disable_shall_stop_receiver, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
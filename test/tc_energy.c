@@ -0,0 +1,295 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+#include <stdio.h>
+
+static const struct ldl_radio_tx_current rfo[] = {
+    {7, 20000UL},
+    {13, 30000UL}
+};
+
+static const struct ldl_radio_tx_current boost[] = {
+    {17, 90000UL},
+    {20, 120000UL}
+};
+
+static const struct ldl_radio_current_table table = {
+    .sleep = 1UL,
+    .standby = 1000UL,
+    .rx = 10000UL,
+    .rfo = rfo,
+    .rfoLen = sizeof(rfo)/sizeof(*rfo),
+    .boost = boost,
+    .boostLen = sizeof(boost)/sizeof(*boost)
+};
+
+struct harness {
+
+    struct sim_harness sim;
+
+    int16_t dbm;
+};
+
+/* helpers */
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)sim;
+
+    if(type == LDL_MAC_TX_BEGIN){
+
+        self->dbm = LDL_Region_getTXPower(self->sim.mac.region, arg->tx_begin.power);
+    }
+}
+
+static void init_harness(struct harness *self, enum ldl_region region)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_harness_init(&self->sim, 1U);
+    self->sim.on_event = on_event;
+
+    LDL_Radio_setCurrentTable(&self->sim.driver, &table);
+    LDL_Radio_enableEnergy(&self->sim.driver, &self->sim.sys);
+
+    sim_harness_start(&self->sim, region, true);
+}
+
+/* charge drawn over the time the simulated radio spent in each mode */
+static uint32_t expected_charge(const struct harness *self)
+{
+    const uint32_t *t = self->sim.radio.mode_time;
+    uint64_t charge;
+    uint32_t tx = 0U;
+    uint8_t i;
+
+    for(i=0U; i < table.boostLen; i++){
+
+        tx = table.boost[i].current;
+
+        if(table.boost[i].dbm >= (self->dbm / 100)){
+
+            break;
+        }
+    }
+
+    charge = ((uint64_t)t[0] * table.sleep)
+        + ((uint64_t)(t[1] + t[2] + t[4]) * table.standby)
+        + ((uint64_t)(t[5] + t[6] + t[7]) * table.rx)
+        + ((uint64_t)t[3] * tx);
+
+    return (uint32_t)(charge / LDL_System_tps());
+}
+
+/* tests */
+
+static void energy_shall_match_simulated_radio(void **user)
+{
+    static struct harness h;
+    struct ldl_radio_energy energy;
+
+    (void)user;
+
+    init_harness(&h, LDL_EU_863_870);
+
+    LDL_MAC_disableADR(&h.sim.mac);
+
+    assert_true(LDL_MAC_unconfirmedData(&h.sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&h.sim, LDL_MAC_DATA_COMPLETE, 60U);
+
+    /* idle for a while */
+    h.sim.sys.time += 10UL * LDL_System_tps();
+
+    sim_radio_update(&h.sim.radio);
+    LDL_Radio_getEnergy(&h.sim.driver, &energy);
+
+    assert_int_equal(h.sim.radio.mode_time[0], energy.time[LDL_RADIO_STATE_SLEEP]);
+    assert_int_equal(h.sim.radio.mode_time[1], energy.time[LDL_RADIO_STATE_STANDBY]);
+    assert_int_equal(h.sim.radio.mode_time[3], energy.time[LDL_RADIO_STATE_TX]);
+    assert_int_equal(h.sim.radio.mode_time[5] + h.sim.radio.mode_time[6] + h.sim.radio.mode_time[7], energy.time[LDL_RADIO_STATE_RX]);
+
+    assert_int_equal(expected_charge(&h), energy.charge);
+}
+
+static void charge_per_uplink_shall_fall_as_rate_rises(void **user)
+{
+    static struct harness h;
+    struct ldl_radio_energy before;
+    struct ldl_radio_energy after;
+    uint32_t last = UINT32_MAX;
+    uint32_t charge;
+    uint8_t rate;
+
+    (void)user;
+
+    printf("%4s %8s %8s %8s %8s\n", "rate", "tx", "rx", "standby", "charge");
+
+    for(rate=0U; rate <= 5U; rate++){
+
+        init_harness(&h, LDL_EU_863_870);
+
+        LDL_MAC_disableADR(&h.sim.mac);
+        assert_true(LDL_MAC_setRate(&h.sim.mac, rate));
+
+        LDL_Radio_getEnergy(&h.sim.driver, &before);
+
+        assert_true(LDL_MAC_unconfirmedData(&h.sim.mac, 1U, "hello", 5U, NULL));
+
+        sim_harness_run_until(&h.sim, LDL_MAC_DATA_COMPLETE, 60U);
+
+        LDL_Radio_getEnergy(&h.sim.driver, &after);
+
+        charge = after.charge - before.charge;
+
+        printf("%4u %8lu %8lu %8lu %8lu\n",
+            rate,
+            (unsigned long)(after.time[LDL_RADIO_STATE_TX] - before.time[LDL_RADIO_STATE_TX]),
+            (unsigned long)(after.time[LDL_RADIO_STATE_RX] - before.time[LDL_RADIO_STATE_RX]),
+            (unsigned long)(after.time[LDL_RADIO_STATE_STANDBY] - before.time[LDL_RADIO_STATE_STANDBY]),
+            (unsigned long)charge
+        );
+
+        assert_true(charge < last);
+
+        last = charge;
+    }
+}
+
+static void tx_current_shall_follow_pa_and_power(void **user)
+{
+    static const struct {
+        enum ldl_radio_pa pa;
+        int16_t dbm;
+        uint32_t current;
+    } vectors[] = {
+        {LDL_RADIO_PA_RFO, 500, 20000UL},
+        {LDL_RADIO_PA_RFO, 1000, 30000UL},
+        {LDL_RADIO_PA_RFO, 1400, 30000UL},
+        {LDL_RADIO_PA_BOOST, 1400, 90000UL},
+        {LDL_RADIO_PA_BOOST, 2000, 120000UL}
+    };
+
+    static struct sim_system sys;
+    static struct sim_radio radio;
+    struct ldl_radio driver;
+    struct ldl_radio_tx_setting settings;
+    struct ldl_radio_energy before;
+    struct ldl_radio_energy after;
+    size_t i;
+
+    (void)user;
+
+    sim_system_init(&sys, 1U);
+    sim_radio_init(&radio, &sys.time);
+
+    (void)memset(&settings, 0, sizeof(settings));
+
+    settings.freq = 868100000UL;
+    settings.bw = LDL_BW_125;
+    settings.sf = LDL_SF_7;
+
+    for(i=0U; i < (sizeof(vectors)/sizeof(*vectors)); i++){
+
+        LDL_Radio_init(&driver, LDL_RADIO_SX1276, &radio);
+        LDL_Radio_setPA(&driver, vectors[i].pa);
+        LDL_Radio_setCurrentTable(&driver, &table);
+        LDL_Radio_enableEnergy(&driver, &sys);
+
+        settings.dbm = vectors[i].dbm;
+
+        LDL_Radio_getEnergy(&driver, &before);
+
+        LDL_Radio_transmit(&driver, &settings, "hello", 5U);
+
+        /* one second transmitting draws current (uA) x 1s of charge (uC) */
+        sys.time += LDL_System_tps();
+
+        LDL_Radio_getEnergy(&driver, &after);
+
+        assert_int_equal(LDL_System_tps(), after.time[LDL_RADIO_STATE_TX] - before.time[LDL_RADIO_STATE_TX]);
+        assert_int_equal(vectors[i].current, after.charge - before.charge);
+    }
+}
+
+static void handler(struct ldl_mac *self, enum ldl_radio_event event)
+{
+    (void)self;
+    (void)event;
+}
+
+static void receiver_shall_stay_on_after_frame_in_rx_continuous(void **user)
+{
+    static struct sim_system sys;
+    static struct sim_radio radio;
+    struct ldl_radio driver;
+    struct ldl_radio_rx_setting settings;
+    struct ldl_radio_energy before;
+    struct ldl_radio_energy after;
+    bool continuous;
+
+    (void)user;
+
+    sim_system_init(&sys, 1U);
+    sim_radio_init(&radio, &sys.time);
+
+    (void)memset(&settings, 0, sizeof(settings));
+
+    settings.freq = 869525000UL;
+    settings.bw = LDL_BW_125;
+    settings.sf = LDL_SF_9;
+    settings.timeout = 8U;
+    settings.max = UINT8_MAX;
+
+    for(continuous=false; ; continuous=true){
+
+        LDL_Radio_init(&driver, LDL_RADIO_SX1276, &radio);
+        LDL_Radio_setHandler(&driver, NULL, handler);
+        LDL_Radio_setCurrentTable(&driver, &table);
+        LDL_Radio_enableEnergy(&driver, &sys);
+
+        settings.continuous = continuous;
+
+        LDL_Radio_receive(&driver, &settings);
+
+        LDL_Radio_interrupt(&driver, 0U);
+
+        LDL_Radio_getEnergy(&driver, &before);
+
+        sys.time += LDL_System_tps();
+
+        LDL_Radio_getEnergy(&driver, &after);
+
+        /* RX single is back in standby, RX continuous is still listening */
+        assert_int_equal(continuous ? 0U : LDL_System_tps(), after.time[LDL_RADIO_STATE_STANDBY] - before.time[LDL_RADIO_STATE_STANDBY]);
+        assert_int_equal(continuous ? LDL_System_tps() : 0U, after.time[LDL_RADIO_STATE_RX] - before.time[LDL_RADIO_STATE_RX]);
+
+        if(continuous){
+
+            break;
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(energy_shall_match_simulated_radio),
+        cmocka_unit_test(charge_per_uplink_shall_fall_as_rate_rises),
+        cmocka_unit_test(tx_current_shall_follow_pa_and_power),
+        cmocka_unit_test(receiver_shall_stay_on_after_frame_in_rx_continuous)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,246 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_channel.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+struct device {
+
+    struct sim_harness sim;
+
+    /* the network answers each uplink it receives */
+    bool answer;
+
+    /* last uplink survived the channel */
+    bool delivered;
+
+    /* last LDL_MAC_DOWNSTREAM */
+    int16_t rssi;
+};
+
+struct fleet {
+
+    struct sim_channel channel;
+    struct device dev[2U];
+};
+
+/* helpers */
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct device *self = (struct device *)sim;
+    uint8_t buf[UINT8_MAX];
+    uint8_t len;
+
+    switch(type){
+    default:
+        break;
+
+    case LDL_MAC_TX_COMPLETE:
+
+        /* the gateway has the whole frame by now */
+        self->delivered = sim_channel_receive(sim->radio.channel, sim->radio.tx_handle, NULL);
+
+        if(self->delivered && self->answer){
+
+            len = sim_network_data_down(&sim->sm, sim->mac.ctx.devAddr, 1U, NULL, 0U, 1U, "hi", 2U, buf);
+            sim_radio_queue(&sim->radio, buf, len, 0, 0);
+        }
+        break;
+
+    case LDL_MAC_DOWNSTREAM:
+
+        self->rssi = arg->downstream.rssi;
+        break;
+    }
+}
+
+/* devices with the same seed pick the same channel at the same time */
+static void init(struct fleet *self, uint32_t near, uint32_t far, int16_t downlink_dbm)
+{
+    uint8_t i;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_channel_init(&self->channel, NULL);
+
+    for(i=0U; i < (sizeof(self->dev)/sizeof(*self->dev)); i++){
+
+        sim_harness_init(&self->dev[i].sim, 42U);
+        self->dev[i].sim.on_event = on_event;
+
+        sim_radio_attach(&self->dev[i].sim.radio, &self->channel, (i == 0U) ? near : far, downlink_dbm);
+
+        sim_harness_start(&self->dev[i].sim, LDL_EU_863_870, true);
+
+        self->dev[i].sim.events = 0U;
+    }
+}
+
+/* step whichever device is furthest behind, never more than a tick past
+ * the others, so that every frame is on the channel before a receiver
+ * asks about anything that overlaps it */
+static void run_for(struct fleet *self, uint32_t seconds)
+{
+    uint32_t until;
+    uint32_t limit;
+    uint8_t next;
+    uint8_t i;
+
+    next = 0U;
+
+    for(i=1U; i < (sizeof(self->dev)/sizeof(*self->dev)); i++){
+
+        if((int32_t)(self->dev[i].sim.sys.time - self->dev[next].sim.sys.time) < 0){
+
+            next = i;
+        }
+    }
+
+    until = self->dev[next].sim.sys.time + (seconds * LDL_System_tps());
+
+    while((int32_t)(until - self->dev[next].sim.sys.time) > 0){
+
+        limit = until;
+
+        for(i=0U; i < (sizeof(self->dev)/sizeof(*self->dev)); i++){
+
+            if((i != next) && ((int32_t)((self->dev[i].sim.sys.time + 1U) - limit) < 0)){
+
+                limit = self->dev[i].sim.sys.time + 1U;
+            }
+        }
+
+        sim_harness_step(&self->dev[next].sim, limit);
+
+        for(i=0U; i < (sizeof(self->dev)/sizeof(*self->dev)); i++){
+
+            if((int32_t)(self->dev[i].sim.sys.time - self->dev[next].sim.sys.time) < 0){
+
+                next = i;
+            }
+        }
+    }
+}
+
+static void send_all(struct fleet *self)
+{
+    uint8_t i;
+
+    for(i=0U; i < (sizeof(self->dev)/sizeof(*self->dev)); i++){
+
+        assert_true(LDL_MAC_unconfirmedData(&self->dev[i].sim.mac, 1U, "hello", 5U, NULL));
+    }
+
+    run_for(self, 10U);
+}
+
+/* tests */
+
+static void uplinks_on_the_same_channel_shall_collide(void **user)
+{
+    static struct fleet self;
+
+    (void)user;
+
+    init(&self, 1000U, 1000U, 1400);
+
+    send_all(&self);
+
+    assert_int_equal(self.dev[0].sim.radio.tx.time, self.dev[1].sim.radio.tx.time);
+    assert_int_equal(self.dev[0].sim.radio.tx.freq, self.dev[1].sim.radio.tx.freq);
+
+    assert_false(self.dev[0].delivered);
+    assert_false(self.dev[1].delivered);
+
+    assert_int_equal(2U, self.channel.stats.collided);
+}
+
+static void nearer_uplink_shall_capture_the_channel(void **user)
+{
+    static struct fleet self;
+
+    (void)user;
+
+    init(&self, 200U, 1000U, 1400);
+
+    send_all(&self);
+
+    assert_true(self.dev[0].delivered);
+    assert_false(self.dev[1].delivered);
+
+    assert_int_equal(1U, self.channel.stats.delivered);
+    assert_int_equal(1U, self.channel.stats.collided);
+}
+
+static void downlink_shall_be_received_as_the_channel_reports(void **user)
+{
+    static struct fleet self;
+
+    (void)user;
+
+    init(&self, 200U, 1000U, 1400);
+
+    self.dev[0].answer = true;
+    self.dev[1].answer = true;
+
+    send_all(&self);
+
+    /* only the device that was heard is answered */
+    assert_true((self.dev[0].sim.events & (1UL << LDL_MAC_RX)) != 0U);
+    assert_true((self.dev[1].sim.events & (1UL << LDL_MAC_RX)) == 0U);
+
+    assert_int_equal(2U, self.dev[0].sim.rx_size);
+    assert_memory_equal("hi", self.dev[0].sim.rx_data, 2U);
+
+    /* same path loss as a lone frame at this distance */
+    assert_int_equal(sim_channel_rssi(&self.channel, 1400, 200U) / 100, self.dev[0].rssi);
+}
+
+static void downlink_below_the_noise_floor_shall_be_lost(void **user)
+{
+    static struct fleet self;
+
+    (void)user;
+
+    /* a -10dBm gateway is not heard at 1km */
+    init(&self, 1000U, 1000U, -1000);
+
+    /* only the first device sends */
+    self.dev[0].answer = true;
+
+    assert_true(LDL_MAC_unconfirmedData(&self.dev[0].sim.mac, 1U, "hello", 5U, NULL));
+
+    run_for(&self, 10U);
+
+    assert_true(self.dev[0].delivered);
+    assert_true((self.dev[0].sim.events & (1UL << LDL_MAC_RX)) == 0U);
+
+    assert_int_equal(1U, self.channel.stats.weak);
+
+    /* nothing in either window */
+    assert_int_equal(0U, self.dev[0].sim.radio.rx_count);
+    assert_true((self.dev[0].sim.events & (1UL << LDL_MAC_DATA_COMPLETE)) != 0U);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(uplinks_on_the_same_channel_shall_collide),
+        cmocka_unit_test(nearer_uplink_shall_capture_the_channel),
+        cmocka_unit_test(downlink_shall_be_received_as_the_channel_reports),
+        cmocka_unit_test(downlink_below_the_noise_floor_shall_be_lost)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -61,6 +61,71 @@ static void encode_unconfirmed_data_up(void **user)
     assert_memory_equal(expected, out, sizeof(expected)-1U);
 }
 
+static void encode_confirmed_data_up_with_fopts_and_data(void **user)
+{
+    const uint8_t expected[] = "\x80\x33\x22\x11\x00\xa2\x00\x01\xaa\xbb\x01\x01\x02\x03\x77\x66\x55\x44";
+    struct ldl_frame_data input;
+    (void)memset(&input, 0, sizeof(input));
+    uint8_t outLen;
+    uint8_t out[UINT8_MAX];
+    struct ldl_frame_data_offset off;
+
+    input.type = FRAME_TYPE_DATA_CONFIRMED_UP;
+    input.counter = 256;
+    input.devAddr = 0x00112233UL;
+    input.adr = true;
+    input.ack = true;
+    input.opts = (const uint8_t *)"\xaa\xbb";
+    input.optsLen = 2U;
+    input.port = 1U;
+    input.data = (const uint8_t *)"\x01\x02\x03";
+    input.dataLen = 3U;
+    input.mic = 0x44556677UL;
+     
+    outLen = LDL_Frame_putData(&input, out, sizeof(out), &off);
+    
+    assert_int_equal(sizeof(expected)-1U, outLen);
+    assert_memory_equal(expected, out, sizeof(expected)-1U);
+    
+    assert_int_equal(8U, off.opts);
+    assert_int_equal(11U, off.data);
+    
+    assert_int_equal(outLen, LDL_Frame_getPhyPayloadSize(input.dataLen, input.optsLen));
+}
+
+static void encode_shall_reject_frame_larger_than_buffer(void **user)
+{
+    struct ldl_frame_data input;
+    (void)memset(&input, 0, sizeof(input));
+    uint8_t out[UINT8_MAX];
+    struct ldl_frame_data_offset off;
+
+    input.type = FRAME_TYPE_DATA_UNCONFIRMED_UP;
+    input.port = 1U;
+    input.data = (const uint8_t *)"\x01\x02\x03";
+    input.dataLen = 3U;
+    
+    assert_int_equal(16U, LDL_Frame_putData(&input, out, 16U, &off));
+    assert_int_equal(0U, LDL_Frame_putData(&input, out, 15U, &off));
+}
+
+static void get_phy_payload_size_shall_include_port_only_with_data(void **user)
+{
+    assert_int_equal(12U, LDL_Frame_getPhyPayloadSize(0U, 0U));
+    assert_int_equal(27U, LDL_Frame_getPhyPayloadSize(0U, 15U));
+    assert_int_equal(14U, LDL_Frame_getPhyPayloadSize(1U, 0U));
+    assert_int_equal(255U, LDL_Frame_getPhyPayloadSize(242U, 0U));
+}
+
+static void update_mic_shall_replace_last_four_bytes(void **user)
+{
+    uint8_t frame[] = "\x40\x33\x22\x11\x00\x00\x00\x01\x00\x00\x00\x00";
+    
+    LDL_Frame_updateMIC(frame, sizeof(frame)-1U, 0x44556677UL);
+    
+    assert_memory_equal("\x40\x33\x22\x11\x00\x00\x00\x01\x77\x66\x55\x44", frame, sizeof(frame)-1U);
+}
+
 static void decode_shall_accept_empty_unconfirmed_data_down(void **user)
 {
     uint8_t input[] = "\x60\x33\x22\x11\x00\x00\x00\x01\x77\x66\x55\x44";
@@ -342,12 +407,155 @@ static void decode_shall_reject_rejoin_request(void **user)
     assert_false(result);
 }
 
+static void decode_up_shall_accept_unconfirmed_data_up(void **user)
+{
+    uint8_t input[] = "\x40\x33\x22\x11\x00\x00\x00\x01\x77\x66\x55\x44";
+    struct ldl_frame_up output;
+    bool result;
+    
+    result = LDL_Frame_decodeUp(&output, input, sizeof(input)-1U);
+
+    assert_true(result);
+    
+    assert_int_equal(FRAME_TYPE_DATA_UNCONFIRMED_UP, output.type);
+    assert_int_equal(0x00112233, output.devAddr);
+    assert_int_equal(0x0100, output.counter);
+    assert_int_equal(0x44556677, output.mic);
+    assert_false(output.dataPresent);
+    assert_null(output.opts);
+    assert_null(output.data);
+}
+
+static void decode_up_shall_accept_confirmed_data_up_with_fopts_and_data(void **user)
+{
+    uint8_t input[] = "\x80\x33\x22\x11\x00\xf2\x00\x01\xaa\xbb\x01\x01\x02\x03\x77\x66\x55\x44";
+    struct ldl_frame_up output;
+    bool result;
+    
+    result = LDL_Frame_decodeUp(&output, input, sizeof(input)-1U);
+
+    assert_true(result);
+    
+    assert_int_equal(FRAME_TYPE_DATA_CONFIRMED_UP, output.type);
+    assert_true(output.adr);
+    assert_true(output.adrAckReq);
+    assert_true(output.ack);
+    assert_true(output.classB);
+    assert_int_equal(2U, output.optsLen);
+    assert_ptr_equal(&input[8], output.opts);
+    assert_true(output.dataPresent);
+    assert_int_equal(1U, output.port);
+    assert_int_equal(3U, output.dataLen);
+    assert_ptr_equal(&input[11], output.data);
+}
+
+static void decode_up_shall_reject_opts_and_port_zero(void **user)
+{
+    uint8_t input[] = "\x40\x33\x22\x11\x00\x02\x00\x01\xaa\xbb\x00\x01\x77\x66\x55\x44";
+    struct ldl_frame_up output;
+    bool result;
+    
+    result = LDL_Frame_decodeUp(&output, input, sizeof(input)-1U);
+
+    assert_false(result);
+}
+
+static void decode_up_shall_reject_data_down(void **user)
+{
+    uint8_t input[] = "\x60\x33\x22\x11\x00\x00\x00\x01\x77\x66\x55\x44";
+    struct ldl_frame_up output;
+    bool result;
+    
+    result = LDL_Frame_decodeUp(&output, input, sizeof(input)-1U);
+
+    assert_false(result);
+}
+
+static void decode_up_shall_reject_short_data_up(void **user)
+{
+    uint8_t input[] = "\x40\x33\x22\x11\x00\x00\x00\x01\x77\x66\x55";
+    struct ldl_frame_up output;
+    bool result;
+    
+    result = LDL_Frame_decodeUp(&output, input, sizeof(input)-1U);
+
+    assert_false(result);
+}
+
+static void peek_shall_return_type_of_join_accept(void **user)
+{
+    /* still encrypted */
+    uint8_t input[] = "\x20\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff";
+    enum ldl_frame_type type;
+    
+    assert_true(LDL_Frame_peek(input, sizeof(input)-1U, &type));
+    assert_int_equal(FRAME_TYPE_JOIN_ACCEPT, type);
+}
+
+static void peek_shall_reject_data_down_shorter_than_fopts(void **user)
+{
+    uint8_t input[] = "\x60\x33\x22\x11\x00\x03\x00\x01\xaa\xaa\x77\x66\x55\x44";
+    enum ldl_frame_type type;
+    
+    assert_false(LDL_Frame_peek(input, sizeof(input)-1U, &type));
+}
+
+static void peek_shall_reject_join_request(void **user)
+{
+    uint8_t input[] = "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f\x10\x11\x12\x13\x14\x15\x16";
+    enum ldl_frame_type type;
+    
+    assert_false(LDL_Frame_peek(input, sizeof(input)-1U, &type));
+}
+
+static void decode_beacon_shall_accept_eu_beacon(void **user)
+{
+    /* example from the class B specification */
+    const uint8_t input[] = "\x00\x00\x00\x00\x02\xcc\xa2\x7e\x00\x01\x20\x00\x00\x81\x03\xde\x55";
+    struct ldl_frame_beacon output;
+    bool result;
+    
+    result = LDL_Frame_decodeBeacon(&output, input, sizeof(input)-1U);
+
+    assert_true(result);
+    assert_int_equal(0xcc020000UL, output.time);
+    assert_ptr_equal(&input[8], output.gwSpecific);
+}
+
+static void decode_beacon_shall_reject_bad_time_crc(void **user)
+{
+    const uint8_t input[] = "\x00\x00\x00\x00\x02\xcd\xa2\x7e\x00\x01\x20\x00\x00\x81\x03\xde\x55";
+    struct ldl_frame_beacon output;
+    bool result;
+    
+    result = LDL_Frame_decodeBeacon(&output, input, sizeof(input)-1U);
+
+    assert_false(result);
+}
+
+static void decode_beacon_shall_ignore_bad_gateway_crc(void **user)
+{
+    const uint8_t input[] = "\x00\x00\x00\x00\x02\xcc\xa2\x7e\x00\x01\x20\x00\x00\x81\x04\xde\x55";
+    struct ldl_frame_beacon output;
+    bool result;
+    
+    result = LDL_Frame_decodeBeacon(&output, input, sizeof(input)-1U);
+
+    assert_true(result);
+    assert_int_equal(0xcc020000UL, output.time);
+    assert_null(output.gwSpecific);
+}
+
 /* runner *******************************************************/
 
 int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(encode_unconfirmed_data_up),        
+        cmocka_unit_test(encode_confirmed_data_up_with_fopts_and_data),
+        cmocka_unit_test(encode_shall_reject_frame_larger_than_buffer),
+        cmocka_unit_test(get_phy_payload_size_shall_include_port_only_with_data),
+        cmocka_unit_test(update_mic_shall_replace_last_four_bytes),
         cmocka_unit_test(decode_shall_accept_empty_unconfirmed_data_down),        
         cmocka_unit_test(decode_shall_accept_unconfirmed_data_down),        
         cmocka_unit_test(decode_shall_accept_empty_unconfirmed_data_down_with_fopts),        
@@ -364,7 +572,18 @@ int main(void)
         cmocka_unit_test(decode_shall_reject_unconfirmed_data_up),        
         cmocka_unit_test(decode_shall_reject_confirmed_data_up),        
         cmocka_unit_test(decode_shall_reject_join_request),        
-        cmocka_unit_test(decode_shall_reject_rejoin_request)        
+        cmocka_unit_test(decode_shall_reject_rejoin_request),
+        cmocka_unit_test(decode_up_shall_accept_unconfirmed_data_up),
+        cmocka_unit_test(decode_up_shall_accept_confirmed_data_up_with_fopts_and_data),
+        cmocka_unit_test(decode_up_shall_reject_opts_and_port_zero),
+        cmocka_unit_test(decode_up_shall_reject_data_down),
+        cmocka_unit_test(decode_up_shall_reject_short_data_up),
+        cmocka_unit_test(peek_shall_return_type_of_join_accept),
+        cmocka_unit_test(peek_shall_reject_data_down_shorter_than_fopts),
+        cmocka_unit_test(peek_shall_reject_join_request),
+        cmocka_unit_test(decode_beacon_shall_accept_eu_beacon),
+        cmocka_unit_test(decode_beacon_shall_reject_bad_time_crc),
+        cmocka_unit_test(decode_beacon_shall_ignore_bad_gateway_crc)
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
@@ -200,6 +200,69 @@ static void decode_unconfirmed_down(void **user)
     assert_int_equal(FRAME_TYPE_DATA_UNCONFIRMED_DOWN, f.type);    
 }
 
+static bool lookup_croft_session(void *receiver, uint32_t devAddr, struct ldl_ops_session *session)
+{
+    bool retval = false;
+    
+    if(devAddr == 0x07BB778FUL){
+        
+        (void)memset(session, 0, sizeof(*session));
+        session->sm = (struct ldl_sm *)receiver;
+        retval = true;
+    }
+    
+    return retval;
+}
+
+static void verify_uplink_batch(void **user)
+{
+    const uint8_t payload[] = "{\"name\":\"Turiphro\",\"count\":13,\"water\":true}";
+    const uint8_t key[] = {0x2B, 0x7E, 0x15, 0x16, 0x28, 0xAE, 0xD2, 0xA6, 0xAB, 0xF7, 0x15, 0x88, 0x09, 0xCF, 0x4F, 0x3C};
+    const uint8_t croft[] = {0x80, 0x8F, 0x77, 0xBB, 0x07, 0x00, 0x02, 0x00, 0x06, 0xBD, 0x33, 0x42, 0xA1, 0x9F, 0xCC, 0x3C, 0x8D, 0x6B, 0xCB, 0x5F, 0xDB, 0x05, 0x48, 0xDB, 0x4D, 0xC8, 0x50, 0x14, 0xAE, 0xEB, 0xFE, 0x0B, 0x54, 0xB1, 0xC9, 0x98, 0xDE, 0xF5, 0x3E, 0x97, 0x9B, 0x70, 0x1D, 0xAB, 0xB0, 0x45, 0x30, 0x0E, 0xF8, 0x69, 0x9C, 0x38, 0xFC, 0x1A, 0x34, 0xD5};
+    uint8_t good[sizeof(croft)];
+    uint8_t tampered[sizeof(croft)];
+    uint8_t stranger[sizeof(croft)];
+    uint8_t garbage[] = {0x20, 0x00};
+    struct ldl_ops_uplink batch[4];
+    struct ldl_sm sm;
+    size_t i;
+    
+    for(i=0; i < sizeof(sm.keys)/sizeof(*sm.keys); i++){
+        
+        (void)memcpy(sm.keys[i].value, key, sizeof(sm.keys[i].value));
+    }
+    
+    (void)memcpy(good, croft, sizeof(good));
+    (void)memcpy(tampered, croft, sizeof(tampered));
+    (void)memcpy(stranger, croft, sizeof(stranger));
+    
+    tampered[10] ^= 0x01U;
+    stranger[1] = 0x00U;
+    
+    (void)memset(batch, 0, sizeof(batch));
+    
+    batch[0].in = good;
+    batch[0].len = sizeof(good);
+    batch[1].in = tampered;
+    batch[1].len = sizeof(tampered);
+    batch[2].in = stranger;
+    batch[2].len = sizeof(stranger);
+    batch[3].in = garbage;
+    batch[3].len = sizeof(garbage);
+    
+    assert_int_equal(1U, LDL_OPS_receiveUplinks(batch, 4U, lookup_croft_session, &sm));
+    
+    assert_int_equal(LDL_OPS_UPLINK_OK, batch[0].result);
+    assert_int_equal(2U, batch[0].counter);
+    assert_int_equal(6U, batch[0].f.port);
+    assert_int_equal(sizeof(payload)-1U, batch[0].f.dataLen);
+    assert_memory_equal(payload, batch[0].f.data, batch[0].f.dataLen);
+    
+    assert_int_equal(LDL_OPS_UPLINK_MIC, batch[1].result);
+    assert_int_equal(LDL_OPS_UPLINK_UNKNOWN, batch[2].result);
+    assert_int_equal(LDL_OPS_UPLINK_INVALID, batch[3].result);
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
@@ -211,7 +274,9 @@ int main(void)
         
         cmocka_unit_test(decode_join_accept),        
         cmocka_unit_test(decode_join_accept_with_cf_list),
-        cmocka_unit_test(decode_unconfirmed_down)
+        cmocka_unit_test(decode_unconfirmed_down),
+        
+        cmocka_unit_test(verify_uplink_batch)
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
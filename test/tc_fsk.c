@@ -0,0 +1,178 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* channel added by the application for DR7 */
+static const uint32_t fsk_freq = 867100000UL;
+
+/* helpers */
+
+static int setup(void **user)
+{
+    static struct sim_harness h;
+
+    sim_harness_init(&h, 1U);
+    sim_harness_start(&h, LDL_EU_863_870, true);
+
+    LDL_MAC_disableADR(&h.mac);
+
+    assert_true(LDL_MAC_addChannel(&h.mac, 3U, fsk_freq, 0U, 7U));
+
+    *user = &h;
+
+    return 0;
+}
+
+static void send_long_uplink(struct sim_harness *self)
+{
+    uint8_t data[200U];
+    uint8_t i;
+
+    for(i=0U; i < sizeof(data); i++){
+
+        data[i] = i;
+    }
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, data, sizeof(data), NULL));
+}
+
+/* tests */
+
+static void transmit_time_shall_count_fsk_framing(void **user)
+{
+    (void)user;
+
+    /* preamble, sync word, length, payload and CRC at 50kbps */
+    assert_int_equal((5U + 3U + 1U + 20U + 2U) * 8U * (LDL_System_tps() / 50000U), LDL_MAC_transmitTimeUp(LDL_BW_125, LDL_SF_FSK, 20U));
+    assert_int_equal(LDL_MAC_transmitTimeUp(LDL_BW_125, LDL_SF_FSK, 20U), LDL_MAC_transmitTimeDown(LDL_BW_125, LDL_SF_FSK, 20U));
+}
+
+static void rate_7_shall_only_be_valid_on_added_channels(void **user)
+{
+    (void)user;
+
+    /* default channels stop at DR5 */
+    assert_false(LDL_Region_validateRate(LDL_EU_863_870, 0U, 7U, 7U));
+    assert_true(LDL_Region_validateRate(LDL_EU_863_870, 3U, 7U, 7U));
+    assert_true(LDL_Region_validateRate(LDL_EU_863_870, 15U, 0U, 7U));
+}
+
+static void long_uplink_shall_be_fed_through_fifo(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+
+    assert_true(LDL_MAC_setRate(&self->mac, 7U));
+
+    /* CAD cannot detect FSK */
+    LDL_MAC_enableCAD(&self->mac, 100U);
+
+    send_long_uplink(self);
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(0U, self->radio.cad_count);
+    assert_int_equal(1U, self->radio.tx_count);
+    assert_int_equal(LDL_SF_FSK, self->radio.tx.sf);
+    assert_true((fsk_freq - self->radio.tx.freq) < 62U);
+
+    /* more than the FIFO holds went out intact */
+    assert_int_equal(self->mac.bufferLen, self->radio.tx.len);
+    assert_memory_equal(self->mac.buffer, self->radio.tx.data, self->radio.tx.len);
+
+    assert_int_equal(0U, self->radio.fifo_underrun);
+    assert_int_equal(0U, self->radio.fifo_overrun);
+
+    /* the chip is returned to LoRa */
+    assert_int_equal(0x80U, self->radio.reg[0x01] & 0x80U);
+}
+
+static void long_downlink_shall_be_drained_from_fifo(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint8_t data[200U];
+    uint8_t buf[UINT8_MAX];
+    uint8_t len;
+    uint8_t i;
+
+    for(i=0U; i < sizeof(data); i++){
+
+        data[i] = (uint8_t)(0xffU - i);
+    }
+
+    assert_true(LDL_MAC_setRate(&self->mac, 7U));
+
+    send_long_uplink(self);
+
+    sim_harness_run_until(self, LDL_MAC_TX_COMPLETE, 60U);
+
+    /* RX1 at DR7 on the uplink channel, one second after the uplink */
+    len = sim_network_data_down(&self->sm, self->mac.ctx.devAddr, 1U, NULL, 0U, 2U, data, sizeof(data), buf);
+
+    sim_radio_queue_at(&self->radio,
+        self->radio.tx.time + LDL_MAC_transmitTimeUp(LDL_BW_125, LDL_SF_FSK, self->radio.tx.len) + LDL_System_tps(),
+        fsk_freq, buf, len, -60, 0
+    );
+
+    sim_harness_run_until(self, LDL_MAC_RX, 10U);
+
+    assert_int_equal(1U, self->radio.rx_count);
+    assert_int_equal(2U, self->rx_port);
+    assert_int_equal(sizeof(data), self->rx_size);
+    assert_memory_equal(data, self->rx_data, sizeof(data));
+
+    assert_int_equal(0U, self->radio.fifo_underrun);
+    assert_int_equal(0U, self->radio.fifo_overrun);
+}
+
+static void link_adr_req_shall_move_uplink_to_fsk(void **user)
+{
+    struct sim_harness *self = (struct sim_harness *)(*user);
+    uint8_t buf[64U];
+    uint8_t len;
+
+    /* LinkADRReq DR7, channels 0..3, one transmission */
+    const uint8_t opts[] = {0x03U, 0x71U, 0x0fU, 0x00U, 0x01U};
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    len = sim_network_data_down(&self->sm, self->mac.ctx.devAddr, 1U, opts, sizeof(opts), 0U, NULL, 0U, buf);
+
+    sim_radio_queue(&self->radio, buf, len, -60, 500);
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(7U, self->mac.ctx.rate);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_int_equal(2U, self->radio.tx_count);
+    assert_int_equal(LDL_SF_FSK, self->radio.tx.sf);
+    assert_true((fsk_freq - self->radio.tx.freq) < 62U);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(transmit_time_shall_count_fsk_framing),
+        cmocka_unit_test(rate_7_shall_only_be_valid_on_added_channels),
+        cmocka_unit_test_setup(long_uplink_shall_be_fed_through_fifo, setup),
+        cmocka_unit_test_setup(long_downlink_shall_be_drained_from_fifo, setup),
+        cmocka_unit_test_setup(link_adr_req_shall_move_uplink_to_fsk, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -22,10 +22,182 @@ static void test_putLinkCheckReq(void **user)
     assert_memory_equal(expected, buffer, LDL_Stream_tell(&s));    
 }
 
+static void test_putDevStatusAns(void **user)
+{
+    uint8_t buffer[50U];
+    struct ldl_stream s;
+    struct ldl_dev_status_ans value = {.battery = 0xfeU, .margin = -1};
+    LDL_Stream_init(&s, buffer, sizeof(buffer));    
+    
+    uint8_t expected[] = "\x06\xfe\x3f";
+    
+    LDL_MAC_putDevStatusAns(&s, &value);
+    
+    assert_false(LDL_Stream_error(&s));
+    
+    assert_int_equal(sizeof(expected)-1U, LDL_Stream_tell(&s));
+    assert_memory_equal(expected, buffer, LDL_Stream_tell(&s));    
+}
+
+static void test_putCommandShallNotOverflow(void **user)
+{
+    uint8_t buffer[2U];
+    struct ldl_stream s;
+    struct ldl_dev_status_ans value = {.battery = 0xfeU, .margin = -1};
+    LDL_Stream_init(&s, buffer, sizeof(buffer));    
+    
+    LDL_MAC_putDevStatusAns(&s, &value);
+    
+    assert_true(LDL_Stream_error(&s));
+    assert_int_equal(0U, LDL_Stream_tell(&s));
+}
+
+static void test_sizeofCommandUp(void **user)
+{
+    assert_int_equal(1U, LDL_MAC_sizeofCommandUp(LDL_CMD_LINK_CHECK));
+    assert_int_equal(2U, LDL_MAC_sizeofCommandUp(LDL_CMD_LINK_ADR));
+    assert_int_equal(3U, LDL_MAC_sizeofCommandUp(LDL_CMD_DEV_STATUS));
+    assert_int_equal(0U, LDL_MAC_sizeofCommandUp(LDL_CMD_FORCE_REJOIN));
+    assert_int_equal(2U, LDL_MAC_sizeofCommandUp(LDL_CMD_BEACON_FREQ));
+}
+
+static void test_getLinkADRReq(void **user)
+{
+    const uint8_t input[] = "\x03\x53\x07\x00\x61";
+    struct ldl_stream s;
+    struct ldl_downstream_cmd cmd;
+    LDL_Stream_initReadOnly(&s, input, sizeof(input)-1U);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    
+    assert_int_equal(LDL_CMD_LINK_ADR, cmd.type);
+    assert_int_equal(5U, cmd.fields.linkADR.dataRate);
+    assert_int_equal(3U, cmd.fields.linkADR.txPower);
+    assert_int_equal(7U, cmd.fields.linkADR.channelMask);
+    assert_int_equal(6U, cmd.fields.linkADR.channelMaskControl);
+    assert_int_equal(1U, cmd.fields.linkADR.nbTrans);
+    
+    assert_int_equal(sizeof(input)-1U, LDL_Stream_tell(&s));
+    assert_false(LDL_MAC_getDownCommand(&s, &cmd));
+}
+
+static void test_getRXParamSetupReq(void **user)
+{
+    const uint8_t input[] = "\x05\x23\x18\x4f\x84";
+    struct ldl_stream s;
+    struct ldl_downstream_cmd cmd;
+    LDL_Stream_initReadOnly(&s, input, sizeof(input)-1U);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    
+    assert_int_equal(LDL_CMD_RX_PARAM_SETUP, cmd.type);
+    assert_int_equal(2U, cmd.fields.rxParamSetup.rx1DROffset);
+    assert_int_equal(3U, cmd.fields.rxParamSetup.rx2DataRate);
+    assert_int_equal(0x844f18UL, cmd.fields.rxParamSetup.freq);
+}
+
+static void test_getDownCommandShallStopAtUnknownCID(void **user)
+{
+    const uint8_t input[] = "\x06\x80\x02\x01";
+    struct ldl_stream s;
+    struct ldl_downstream_cmd cmd;
+    LDL_Stream_initReadOnly(&s, input, sizeof(input)-1U);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(LDL_CMD_DEV_STATUS, cmd.type);
+    
+    assert_false(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(1U, LDL_Stream_tell(&s));
+}
+
+static void test_getDownCommandShallRejectTruncated(void **user)
+{
+    const uint8_t input[] = "\x0d\x01\x02\x03\x04";
+    struct ldl_stream s;
+    struct ldl_downstream_cmd cmd;
+    LDL_Stream_initReadOnly(&s, input, sizeof(input)-1U);
+    
+    assert_false(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(0U, LDL_Stream_tell(&s));
+}
+
+static void test_getDownCommandBlock(void **user)
+{
+    /* LinkCheckAns, DeviceTimeAns, BeaconFreqReq, PingSlotInfoAns, unknown */
+    const uint8_t input[] = "\x02\x14\x03\x0d\x01\x02\x03\x04\x80\x13\x18\x4f\x84\x10\xff\x00";
+    struct ldl_stream s;
+    struct ldl_downstream_cmd cmd;
+    LDL_Stream_initReadOnly(&s, input, sizeof(input)-1U);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(LDL_CMD_LINK_CHECK, cmd.type);
+    assert_int_equal(0x14U, cmd.fields.linkCheck.margin);
+    assert_int_equal(3U, cmd.fields.linkCheck.gwCount);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(LDL_CMD_DEVICE_TIME, cmd.type);
+    assert_int_equal(0x04030201UL, cmd.fields.deviceTime.seconds);
+    assert_int_equal(0x80U, cmd.fields.deviceTime.fractions);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(LDL_CMD_BEACON_FREQ, cmd.type);
+    assert_int_equal(0x844f18UL, cmd.fields.beaconFreq.freq);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(LDL_CMD_PING_SLOT_INFO, cmd.type);
+    
+    assert_false(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(14U, LDL_Stream_tell(&s));
+    
+    /* truncated DeviceTimeAns */
+    LDL_Stream_initReadOnly(&s, input, 8U);
+    
+    assert_true(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_false(LDL_MAC_getDownCommand(&s, &cmd));
+    assert_int_equal(3U, LDL_Stream_tell(&s));
+}
+
+static void test_getDownCommands(void **user)
+{
+    /* LinkCheckAns, DeviceTimeAns, BeaconFreqReq, PingSlotInfoAns, unknown */
+    const uint8_t input[] = "\x02\x14\x03\x0d\x01\x02\x03\x04\x80\x13\x18\x4f\x84\x10\xff\x00";
+    struct ldl_downstream_cmd cmd[8U];
+    
+    assert_int_equal(4U, LDL_MAC_getDownCommands(input, sizeof(input)-1U, cmd, sizeof(cmd)/sizeof(*cmd)));
+    
+    assert_int_equal(LDL_CMD_LINK_CHECK, cmd[0].type);
+    assert_int_equal(0x14U, cmd[0].fields.linkCheck.margin);
+    assert_int_equal(3U, cmd[0].fields.linkCheck.gwCount);
+    
+    assert_int_equal(LDL_CMD_DEVICE_TIME, cmd[1].type);
+    assert_int_equal(0x04030201UL, cmd[1].fields.deviceTime.seconds);
+    assert_int_equal(0x80U, cmd[1].fields.deviceTime.fractions);
+    
+    assert_int_equal(LDL_CMD_BEACON_FREQ, cmd[2].type);
+    assert_int_equal(0x844f18UL, cmd[2].fields.beaconFreq.freq);
+    
+    assert_int_equal(LDL_CMD_PING_SLOT_INFO, cmd[3].type);
+    
+    /* limited by max */
+    assert_int_equal(2U, LDL_MAC_getDownCommands(input, sizeof(input)-1U, cmd, 2U));
+    
+    /* truncated DeviceTimeAns */
+    assert_int_equal(1U, LDL_MAC_getDownCommands(input, 8U, cmd, sizeof(cmd)/sizeof(*cmd)));
+}
+
 int main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_putLinkCheckReq),
+        cmocka_unit_test(test_putDevStatusAns),
+        cmocka_unit_test(test_putCommandShallNotOverflow),
+        cmocka_unit_test(test_sizeofCommandUp),
+        cmocka_unit_test(test_getLinkADRReq),
+        cmocka_unit_test(test_getRXParamSetupReq),
+        cmocka_unit_test(test_getDownCommandShallStopAtUnknownCID),
+        cmocka_unit_test(test_getDownCommandShallRejectTruncated),
+        cmocka_unit_test(test_getDownCommandBlock),
+        cmocka_unit_test(test_getDownCommands),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);
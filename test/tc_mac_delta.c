@@ -0,0 +1,314 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+struct harness {
+
+    struct sim_harness sim;
+
+    /* LDL_MAC_SESSION_UPDATED count */
+    uint32_t updates;
+
+    /* FOpts to answer the next uplink with */
+    const uint8_t *opts;
+    uint8_t optsLen;
+
+    /* FCntDown of the last answer */
+    uint16_t counter;
+};
+
+/* helpers */
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)sim;
+    uint8_t buf[UINT8_MAX];
+    uint8_t len;
+
+    (void)arg;
+
+    switch(type){
+    default:
+        break;
+
+    case LDL_MAC_SESSION_UPDATED:
+
+        self->updates++;
+        break;
+
+    case LDL_MAC_TX_BEGIN:
+
+        if(self->opts != NULL){
+
+            self->counter++;
+
+            len = sim_network_data_down(&self->sim.sm, self->sim.mac.ctx.devAddr, self->counter, self->opts, self->optsLen, 0U, NULL, 0U, buf);
+            sim_radio_queue(&self->sim.radio, buf, len, -80, 500);
+
+            self->opts = NULL;
+        }
+        break;
+    }
+}
+
+static void wait_ready(struct harness *self, uint32_t limit)
+{
+    uint32_t until = self->sim.sys.time + (limit * LDL_System_tps());
+
+    while(!LDL_MAC_ready(&self->sim.mac) && ((int32_t)(until - self->sim.sys.time) > 0)){
+
+        sim_harness_step(&self->sim, until);
+    }
+
+    assert_true(LDL_MAC_ready(&self->sim.mac));
+}
+
+/* FOptsLen of the last uplink */
+static uint8_t tx_opts_len(const struct harness *self)
+{
+    return self->sim.radio.tx.data[5U] & 0xfU;
+}
+
+static void init(struct harness *self)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_harness_init(&self->sim, 42U);
+    self->sim.on_event = on_event;
+
+    sim_harness_start(&self->sim, LDL_EU_863_870, true);
+
+    LDL_MAC_disableADR(&self->sim.mac);
+
+    self->updates = 0U;
+}
+
+static int setup(void **user)
+{
+    static struct harness h;
+
+    init(&h);
+
+    *user = &h;
+
+    return 0;
+}
+
+/* tests */
+
+static void link_adr_block_shall_be_applied_with_other_commands(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    /* LinkADRReq (DR3, 2, channels 0 and 1, nbTrans 2), DutyCycleReq, RXTimingSetupReq */
+    static const uint8_t opts[] = "\x03\x32\x03\x00\x02\x04\x05\x08\x03";
+
+    self->opts = opts;
+    self->optsLen = sizeof(opts) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_SESSION_UPDATED, 600U);
+
+    assert_int_equal(3U, self->sim.mac.ctx.rate);
+    assert_int_equal(2U, self->sim.mac.ctx.power);
+    assert_int_equal(2U, self->sim.mac.ctx.nbTrans);
+    /* set bits are masked */
+    assert_int_equal(0xfcU, self->sim.mac.ctx.chMask[0]);
+    assert_int_equal(5U, self->sim.mac.ctx.maxDutyCycle);
+    assert_int_equal(3U, self->sim.mac.ctx.rx1Delay);
+
+    assert_true(self->sim.mac.ctx.link_adr_ans.dataRateOK);
+    assert_true(self->sim.mac.ctx.link_adr_ans.powerOK);
+    assert_true(self->sim.mac.ctx.link_adr_ans.channelMaskOK);
+
+    assert_int_equal(1U, self->updates);
+}
+
+static void bad_link_adr_block_shall_not_touch_session(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_mac_session before;
+
+    /* LinkADRReq block (channel 0, then channels 1 and 2 with an invalid power), DutyCycleReq */
+    static const uint8_t opts[] = "\x03\x32\x01\x00\x02\x03\x3e\x06\x00\x02\x04\x05";
+
+    before = self->sim.mac.ctx;
+
+    self->opts = opts;
+    self->optsLen = sizeof(opts) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_SESSION_UPDATED, 600U);
+
+    assert_int_equal(before.rate, self->sim.mac.ctx.rate);
+    assert_int_equal(before.power, self->sim.mac.ctx.power);
+    assert_int_equal(before.nbTrans, self->sim.mac.ctx.nbTrans);
+    assert_memory_equal(before.chMask, self->sim.mac.ctx.chMask, sizeof(before.chMask));
+
+    assert_false(self->sim.mac.ctx.link_adr_ans.powerOK);
+
+    /* other commands are independent of the block */
+    assert_int_equal(5U, self->sim.mac.ctx.maxDutyCycle);
+
+    assert_int_equal(1U, self->updates);
+}
+
+static void answer_shall_wait_to_make_room_for_data(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t data[UINT8_MAX];
+    uint8_t mtu;
+
+    /* DevStatusReq */
+    static const uint8_t opts[] = "\x06";
+
+    (void)memset(data, 0, sizeof(data));
+
+    mtu = LDL_MAC_mtu(&self->sim.mac);
+
+    self->opts = opts;
+    self->optsLen = sizeof(opts) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_SESSION_UPDATED, 600U);
+    wait_ready(self, 600U);
+
+    /* the answer can wait */
+    assert_int_equal(mtu, LDL_MAC_mtu(&self->sim.mac));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, mtu, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(0U, tx_opts_len(self));
+
+    /* but not twice */
+    assert_int_equal(mtu - 3U, LDL_MAC_mtu(&self->sim.mac));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(3U, tx_opts_len(self));
+    assert_int_equal(0x06U, self->sim.radio.tx.data[8U]);
+
+    assert_int_equal(mtu, LDL_MAC_mtu(&self->sim.mac));
+}
+
+static void sticky_answer_shall_not_wait(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t data[UINT8_MAX];
+    uint8_t mtu;
+
+    /* RXTimingSetupReq */
+    static const uint8_t opts[] = "\x08\x01";
+
+    (void)memset(data, 0, sizeof(data));
+
+    mtu = LDL_MAC_mtu(&self->sim.mac);
+
+    self->opts = opts;
+    self->optsLen = sizeof(opts) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_SESSION_UPDATED, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(mtu - 1U, LDL_MAC_mtu(&self->sim.mac));
+
+    assert_false(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, mtu, NULL));
+    assert_int_equal(LDL_ERRNO_MACPRIORITY, LDL_MAC_errno(&self->sim.mac));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(1U, tx_opts_len(self));
+    assert_int_equal(0x08U, self->sim.radio.tx.data[8U]);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, mtu - 1U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+
+    assert_int_equal(1U, tx_opts_len(self));
+}
+
+static void new_answer_shall_not_be_forced_by_a_deferred_one(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t data[UINT8_MAX];
+    uint8_t mtu;
+
+    /* DevStatusReq */
+    static const uint8_t opts[] = "\x06";
+
+    /* DutyCycleReq */
+    static const uint8_t more[] = "\x04\x00";
+
+    (void)memset(data, 0, sizeof(data));
+
+    mtu = LDL_MAC_mtu(&self->sim.mac);
+
+    self->opts = opts;
+    self->optsLen = sizeof(opts) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_SESSION_UPDATED, 600U);
+    wait_ready(self, 600U);
+
+    /* DevStatusAns waits and DutyCycleReq arrives in the meantime */
+    self->opts = more;
+    self->optsLen = sizeof(more) - 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, mtu, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(0U, tx_opts_len(self));
+
+    /* only DevStatusAns has waited */
+    assert_int_equal(mtu - 3U, LDL_MAC_mtu(&self->sim.mac));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, mtu - 3U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(3U, tx_opts_len(self));
+    assert_int_equal(0x06U, self->sim.radio.tx.data[8U]);
+
+    /* now DutyCycleAns has waited */
+    assert_int_equal(mtu - 1U, LDL_MAC_mtu(&self->sim.mac));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+    wait_ready(self, 600U);
+
+    assert_int_equal(1U, tx_opts_len(self));
+    assert_int_equal(0x04U, self->sim.radio.tx.data[8U]);
+
+    assert_int_equal(mtu, LDL_MAC_mtu(&self->sim.mac));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(link_adr_block_shall_be_applied_with_other_commands, setup),
+        cmocka_unit_test_setup(bad_link_adr_block_shall_not_touch_session, setup),
+        cmocka_unit_test_setup(answer_shall_wait_to_make_room_for_data, setup),
+        cmocka_unit_test_setup(sticky_answer_shall_not_wait, setup),
+        cmocka_unit_test_setup(new_answer_shall_not_be_forced_by_a_deferred_one, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
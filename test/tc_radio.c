@@ -0,0 +1,261 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_system.h"
+#include "sim_radio.h"
+#include "ldl_radio.h"
+
+#include <string.h>
+#include <stdio.h>
+
+struct harness {
+
+    struct sim_system sys;
+    struct sim_radio radio;
+    struct ldl_radio driver;
+
+    struct ldl_radio_tx_setting tx;
+    struct ldl_radio_rx_setting rx1;
+    struct ldl_radio_rx_setting rx2;
+};
+
+static struct harness h;
+
+/* helpers */
+
+static int setup(void **user)
+{
+    struct harness *self = &h;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 1U);
+    sim_radio_init(&self->radio, &self->sys.time);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1276, &self->radio);
+    LDL_Radio_setPA(&self->driver, LDL_RADIO_PA_BOOST);
+
+    self->tx.freq = 868100000UL;
+    self->tx.bw = LDL_BW_125;
+    self->tx.sf = LDL_SF_7;
+    self->tx.dbm = 1400;
+
+    self->rx1.freq = 868100000UL;
+    self->rx1.bw = LDL_BW_125;
+    self->rx1.sf = LDL_SF_7;
+    self->rx1.timeout = 8U;
+    self->rx1.max = 64U;
+
+    self->rx2.freq = 869525000UL;
+    self->rx2.bw = LDL_BW_125;
+    self->rx2.sf = LDL_SF_12;
+    self->rx2.timeout = 8U;
+    self->rx2.max = 64U;
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+    LDL_Radio_sleep(&self->driver);
+
+    *user = self;
+
+    return 0;
+}
+
+static uint32_t transactions(struct harness *self)
+{
+    uint32_t retval = self->radio.spi_transactions;
+
+    self->radio.spi_transactions = 0U;
+
+    return retval;
+}
+
+static uint32_t frf(const struct harness *self)
+{
+    return ((uint32_t)self->radio.reg[0x06] << 16) | ((uint32_t)self->radio.reg[0x07] << 8) | self->radio.reg[0x08];
+}
+
+/* one uplink as sequenced by the MAC: transmit, RX1, RX2 */
+static void uplink(struct harness *self, uint32_t *tx, uint32_t *rx1, uint32_t *rx2)
+{
+    (void)transactions(self);
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "hello", 5U);
+    LDL_Radio_clearInterrupt(&self->driver);
+    *tx = transactions(self);
+
+    LDL_Radio_receive(&self->driver, &self->rx1);
+    LDL_Radio_clearInterrupt(&self->driver);
+    *rx1 = transactions(self);
+
+    LDL_Radio_receive(&self->driver, &self->rx2);
+    LDL_Radio_clearInterrupt(&self->driver);
+    *rx2 = transactions(self);
+}
+
+/* tests */
+
+static void repeated_uplink_shall_need_fewer_transactions(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t first[3];
+    uint32_t second[3];
+
+    uplink(self, &first[0], &first[1], &first[2]);
+    uplink(self, &second[0], &second[1], &second[2]);
+
+    printf("%8s %4s %4s %4s\n", "uplink", "tx", "rx1", "rx2");
+    printf("%8s %4lu %4lu %4lu\n", "first", (unsigned long)first[0], (unsigned long)first[1], (unsigned long)first[2]);
+    printf("%8s %4lu %4lu %4lu\n", "second", (unsigned long)second[0], (unsigned long)second[1], (unsigned long)second[2]);
+
+    assert_true(second[0] < first[0]);
+    assert_true(second[1] < first[1]);
+    assert_true(second[2] <= first[2]);
+}
+
+static void receive_shall_leave_registers_as_written(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "hello", 5U);
+    LDL_Radio_clearInterrupt(&self->driver);
+    LDL_Radio_receive(&self->driver, &self->rx2);
+
+    assert_int_equal(0xd96199UL, frf(self));
+    assert_int_equal(0xc4U, self->radio.reg[0x1E]);        /* SF12, CRC on */
+    assert_int_equal(0x08U, self->radio.reg[0x1F]);        /* symbol timeout */
+    assert_int_equal(0x40U, self->radio.reg[0x33] & 0x40U);/* IQ inverted */
+    assert_int_equal(0x3fU, self->radio.reg[0x11]);        /* irq mask */
+    assert_int_equal(0x00U, self->radio.reg[0x40]);        /* dio mapping */
+}
+
+static void frequency_change_shall_be_latched(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    /* same RegFrfLsb (0x00) for both */
+    self->tx.freq = 868000000UL;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "hello", 5U);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(868000000UL, self->radio.tx.freq);
+
+    self->tx.freq = 868250000UL;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, "hello", 5U);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(868250000UL, self->radio.tx.freq);
+}
+
+static void receive_setup_shall_use_burst_transactions(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t n;
+
+    LDL_Radio_receive(&self->driver, &self->rx1);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    /* standby, Frf, irq flags/mask, modem config 2 and 3, RX */
+    (void)transactions(self);
+    LDL_Radio_receive(&self->driver, &self->rx2);
+    n = transactions(self);
+
+    assert_true(n <= 6U);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    LDL_Radio_receive(&self->driver, &self->rx1);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    /* RegModemConfig1 and RegSymbTimeoutLsb change, RegModemConfig2 bridges the gap */
+    self->rx1.bw = LDL_BW_250;
+    self->rx1.timeout = 16U;
+
+    (void)transactions(self);
+    LDL_Radio_receive(&self->driver, &self->rx1);
+    n = transactions(self);
+
+    /* standby, RegModemConfig1..RegSymbTimeoutLsb, irq flags/mask, RX */
+    assert_int_equal(4U, n);
+    assert_int_equal(0x82U, self->radio.reg[0x1D]);        /* BW250, CR4/5 */
+    assert_int_equal(0x74U, self->radio.reg[0x1E]);        /* unchanged */
+    assert_int_equal(16U, self->radio.reg[0x1F]);
+}
+
+static void reset_shall_invalidate_shadow(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint32_t first[3];
+    uint32_t second[3];
+
+    uplink(self, &first[0], &first[1], &first[2]);
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+    LDL_Radio_sleep(&self->driver);
+
+    uplink(self, &second[0], &second[1], &second[2]);
+
+    assert_int_equal(first[0], second[0]);
+    assert_int_equal(first[1], second[1]);
+    assert_int_equal(first[2], second[2]);
+
+    /* registers were written again after reset */
+    assert_int_equal(0xd96199UL, frf(self));
+}
+
+static void collect_shall_read_status_in_one_transaction(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    uint8_t frame[20U];
+    uint8_t buf[64U];
+    size_t i;
+
+    for(i=0U; i < sizeof(frame); i++){
+
+        frame[i] = (uint8_t)(i + 1U);
+    }
+
+    LDL_Radio_receive(&self->driver, &self->rx1);
+
+    self->radio.freq_error = -1200;
+    sim_radio_load(&self->radio, frame, sizeof(frame), -110, -725);
+
+    (void)transactions(self);
+
+    /* status, FIFO pointer, FIFO */
+    assert_int_equal(sizeof(frame), LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+    assert_int_equal(3U, transactions(self));
+
+    assert_memory_equal(frame, buf, sizeof(frame));
+    assert_int_equal(-110, meta.rssi);
+    assert_int_equal(-725, meta.snr);
+
+    /* one LSB is about 0.13Hz at 125kHz */
+    assert_true((meta.freqError >= -1201) && (meta.freqError <= -1199));
+
+    /* the same frame failing CRC */
+    self->radio.reg[0x12] |= 0x20U;
+
+    assert_int_equal(0U, LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(repeated_uplink_shall_need_fewer_transactions, setup),
+        cmocka_unit_test_setup(receive_shall_leave_registers_as_written, setup),
+        cmocka_unit_test_setup(frequency_change_shall_be_latched, setup),
+        cmocka_unit_test_setup(receive_setup_shall_use_burst_transactions, setup),
+        cmocka_unit_test_setup(reset_shall_invalidate_shadow, setup),
+        cmocka_unit_test_setup(collect_shall_read_status_in_one_transaction, setup)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,165 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "ldl_radio.h"
+#include "ldl_chip.h"
+
+#include <string.h>
+
+/* SX127x registers and SX126x opcodes */
+#define REG_MODEM_CONFIG1   0x1DU
+#define SET_PACKET_TYPE     0x8AU
+#define SET_PA_CONFIG       0x95U
+
+/* records the last bytes written to each address
+ *
+ * SX127x writes are bursts from a register address, SX126x writes are
+ * an opcode followed by its parameters. Reads return zeros. */
+struct board {
+
+    uint8_t reg[0x100];
+    uint8_t param[0x100][8U];
+    uint32_t writes[0x100];
+};
+
+static struct board board;
+
+/* chip */
+
+void LDL_Chip_reset(void *self, bool state)
+{
+    (void)self;
+    (void)state;
+}
+
+void LDL_Chip_write(void *self, uint8_t addr, const void *data, uint8_t size)
+{
+    struct board *b = (struct board *)self;
+    const uint8_t *ptr = (const uint8_t *)data;
+    size_t i;
+
+    b->writes[addr]++;
+
+    for(i=0U; i < size; i++){
+
+        if((addr + i) < sizeof(b->reg)){
+
+            b->reg[addr + i] = ptr[i];
+        }
+
+        if(i < sizeof(b->param[addr])){
+
+            b->param[addr][i] = ptr[i];
+        }
+    }
+}
+
+void LDL_Chip_read(void *self, uint8_t addr, void *data, uint8_t size)
+{
+    (void)self;
+    (void)addr;
+
+    (void)memset(data, 0, size);
+}
+
+/* helpers */
+
+static void transmit(struct ldl_radio *radio, enum ldl_radio_type type)
+{
+    struct ldl_radio_tx_setting tx;
+
+    (void)memset(&board, 0, sizeof(board));
+    (void)memset(&tx, 0, sizeof(tx));
+
+    tx.freq = 868100000UL;
+    tx.bw = LDL_BW_125;
+    tx.sf = LDL_SF_7;
+    tx.dbm = 1400;
+
+    LDL_Radio_init(radio, type, &board);
+    LDL_Radio_setPA(radio, LDL_RADIO_PA_BOOST);
+
+    LDL_Radio_reset(radio, true);
+    LDL_Radio_reset(radio, false);
+
+    LDL_Radio_transmit(radio, &tx, "hello", 5U);
+}
+
+/* tests */
+
+static void sx1272_shall_use_sx1272_ops(void **user)
+{
+    struct ldl_radio radio;
+
+    (void)user;
+
+    transmit(&radio, LDL_RADIO_SX1272);
+
+    /* register interface */
+    assert_int_equal(0U, board.writes[SET_PACKET_TYPE]);
+
+    /* Bw (7:6) is 125kHz, CodingRate (5:3) is 4/5 */
+    assert_int_equal(0x08U, board.reg[REG_MODEM_CONFIG1] & 0xf8U);
+}
+
+static void sx1276_shall_use_sx1276_ops(void **user)
+{
+    struct ldl_radio radio;
+
+    (void)user;
+
+    transmit(&radio, LDL_RADIO_SX1276);
+
+    assert_int_equal(0U, board.writes[SET_PACKET_TYPE]);
+
+    /* Bw (7:4) is 125kHz, CodingRate (3:1) is 4/5 */
+    assert_int_equal(0x72U, board.reg[REG_MODEM_CONFIG1] & 0xfeU);
+}
+
+static void sx1261_shall_use_sx1261_ops(void **user)
+{
+    struct ldl_radio radio;
+
+    (void)user;
+
+    transmit(&radio, LDL_RADIO_SX1261);
+
+    /* command interface, LoRa packet type */
+    assert_true(board.writes[SET_PACKET_TYPE] > 0U);
+    assert_int_equal(0x01U, board.param[SET_PACKET_TYPE][0]);
+
+    /* deviceSel selects the SX1261 PA */
+    assert_true(board.writes[SET_PA_CONFIG] > 0U);
+    assert_int_equal(0x01U, board.param[SET_PA_CONFIG][2]);
+}
+
+static void sx1262_shall_use_sx1262_ops(void **user)
+{
+    struct ldl_radio radio;
+
+    (void)user;
+
+    transmit(&radio, LDL_RADIO_SX1262);
+
+    assert_true(board.writes[SET_PACKET_TYPE] > 0U);
+    assert_int_equal(0x01U, board.param[SET_PACKET_TYPE][0]);
+
+    /* deviceSel selects the SX1262 PA */
+    assert_true(board.writes[SET_PA_CONFIG] > 0U);
+    assert_int_equal(0x00U, board.param[SET_PA_CONFIG][2]);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(sx1272_shall_use_sx1272_ops),
+        cmocka_unit_test(sx1276_shall_use_sx1276_ops),
+        cmocka_unit_test(sx1261_shall_use_sx1261_ops),
+        cmocka_unit_test(sx1262_shall_use_sx1262_ops)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
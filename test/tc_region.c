@@ -0,0 +1,272 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "ref_region.h"
+#include "ldl_region.h"
+#include "ldl_mac.h"
+
+#include <string.h>
+
+static const enum ldl_region regions[] = {
+    LDL_EU_863_870,
+    LDL_US_902_928,
+    LDL_AU_915_928,
+    LDL_EU_433
+};
+
+/* edges of the EU_863_870 sub-bands */
+static const uint32_t edges[] = {
+    863000000UL,
+    868000000UL,
+    868600000UL,
+    868700000UL,
+    869200000UL,
+    869400000UL,
+    869650000UL,
+    869700000UL,
+    870000000UL
+};
+
+/* helpers */
+
+static uint32_t next_rand(uint32_t *state)
+{
+    *state = (*state * 1103515245UL) + 12345UL;
+
+    return *state >> 8;
+}
+
+static void check_band(enum ldl_region region, uint32_t freq)
+{
+    uint8_t band = 0xaaU;
+    uint8_t ref_band = 0xaaU;
+    bool retval;
+
+    retval = LDL_Region_getBand(region, freq, &band);
+
+    assert_int_equal(ref_region_getBand(region, freq, &ref_band), retval);
+
+    if(retval){
+
+        assert_int_equal(ref_band, band);
+    }
+}
+
+static void check_cflist(enum ldl_region region, const uint8_t *cfList, uint8_t len)
+{
+    static struct ldl_mac mac;
+    static struct ldl_mac ref_mac;
+
+    (void)memset(&mac, 0, sizeof(mac));
+    (void)memset(&ref_mac, 0, sizeof(ref_mac));
+
+    mac.region = region;
+    ref_mac.region = region;
+
+    LDL_Region_processCFList(region, &mac, cfList, len);
+    ref_region_processCFList(region, &ref_mac, cfList, len);
+
+    assert_memory_equal(&ref_mac.ctx, &mac.ctx, sizeof(mac.ctx));
+}
+
+/* tests */
+
+static void rate_shall_convert_as_before(void **user)
+{
+    enum ldl_spreading_factor sf;
+    enum ldl_signal_bandwidth bw;
+    uint8_t mtu;
+    enum ldl_spreading_factor ref_sf;
+    enum ldl_signal_bandwidth ref_bw;
+    uint8_t ref_mtu;
+    size_t i;
+    uint8_t rate;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(rate=0U; rate < 16U; rate++){
+
+            LDL_Region_convertRate(regions[i], rate, &sf, &bw, &mtu);
+            ref_region_convertRate(regions[i], rate, &ref_sf, &ref_bw, &ref_mtu);
+
+            assert_int_equal(ref_sf, sf);
+            assert_int_equal(ref_bw, bw);
+            assert_int_equal(ref_mtu, mtu);
+        }
+    }
+}
+
+static void channel_shall_be_found_as_before(void **user)
+{
+    uint32_t freq;
+    uint8_t minRate;
+    uint8_t maxRate;
+    uint32_t ref_freq;
+    uint8_t ref_minRate;
+    uint8_t ref_maxRate;
+    bool retval;
+    size_t i;
+    uint16_t chIndex;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(chIndex=0U; chIndex <= UINT8_MAX; chIndex++){
+
+            retval = LDL_Region_getChannel(regions[i], (uint8_t)chIndex, &freq, &minRate, &maxRate);
+
+            assert_int_equal(ref_region_getChannel(regions[i], (uint8_t)chIndex, &ref_freq, &ref_minRate, &ref_maxRate), retval);
+
+            if(retval){
+
+                assert_int_equal(ref_freq, freq);
+                assert_int_equal(ref_minRate, minRate);
+                assert_int_equal(ref_maxRate, maxRate);
+            }
+        }
+    }
+}
+
+static void band_shall_be_found_as_before(void **user)
+{
+    uint32_t freq;
+    size_t i;
+    size_t j;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(freq=430000000UL; freq <= 930000000UL; freq += 25000UL){
+
+            check_band(regions[i], freq);
+        }
+
+        for(j=0U; j < (sizeof(edges)/sizeof(*edges)); j++){
+
+            check_band(regions[i], edges[j] - 1UL);
+            check_band(regions[i], edges[j]);
+            check_band(regions[i], edges[j] + 1UL);
+        }
+    }
+}
+
+static void rx1_rate_shall_be_found_as_before(void **user)
+{
+    uint8_t rate;
+    uint8_t ref_rate;
+    size_t i;
+    uint8_t tx_rate;
+    uint8_t offset;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(tx_rate=0U; tx_rate < 16U; tx_rate++){
+
+            for(offset=0U; offset < 8U; offset++){
+
+                rate = 0xaaU;
+                ref_rate = 0xaaU;
+
+                LDL_Region_getRX1DataRate(regions[i], tx_rate, offset, &rate);
+                ref_region_getRX1DataRate(regions[i], tx_rate, offset, &ref_rate);
+
+                assert_int_equal(ref_rate, rate);
+            }
+        }
+    }
+}
+
+static void rx1_freq_shall_be_found_as_before(void **user)
+{
+    uint32_t freq;
+    uint32_t ref_freq;
+    uint32_t tx_freq;
+    size_t i;
+    uint16_t chIndex;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(chIndex=0U; chIndex <= UINT8_MAX; chIndex++){
+
+            tx_freq = 902300000UL + (200000UL * chIndex);
+
+            LDL_Region_getRX1Freq(regions[i], tx_freq, (uint8_t)chIndex, &freq);
+            ref_region_getRX1Freq(regions[i], tx_freq, (uint8_t)chIndex, &ref_freq);
+
+            assert_int_equal(ref_freq, freq);
+        }
+    }
+}
+
+static void off_time_factor_shall_be_found_as_before(void **user)
+{
+    size_t i;
+    uint16_t band;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(band=0U; band <= UINT8_MAX; band++){
+
+            assert_int_equal(ref_region_getOffTimeFactor(regions[i], (uint8_t)band), LDL_Region_getOffTimeFactor(regions[i], (uint8_t)band));
+        }
+    }
+}
+
+static void cflist_shall_be_processed_as_before(void **user)
+{
+    uint8_t cfList[17U];
+    uint32_t state = 1U;
+    size_t i;
+    uint16_t n;
+    uint8_t j;
+
+    (void)user;
+
+    for(i=0U; i < (sizeof(regions)/sizeof(*regions)); i++){
+
+        for(n=0U; n < 64U; n++){
+
+            for(j=0U; j < sizeof(cfList); j++){
+
+                cfList[j] = (uint8_t)next_rand(&state);
+            }
+
+            /* frequency list, mask list and an unknown type */
+            cfList[15] = (uint8_t)(n % 3U);
+
+            check_cflist(regions[i], cfList, 16U);
+
+            /* wrong length */
+            check_cflist(regions[i], cfList, 15U);
+            check_cflist(regions[i], cfList, 17U);
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(rate_shall_convert_as_before),
+        cmocka_unit_test(channel_shall_be_found_as_before),
+        cmocka_unit_test(band_shall_be_found_as_before),
+        cmocka_unit_test(rx1_rate_shall_be_found_as_before),
+        cmocka_unit_test(rx1_freq_shall_be_found_as_before),
+        cmocka_unit_test(off_time_factor_shall_be_found_as_before),
+        cmocka_unit_test(cflist_shall_be_processed_as_before)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
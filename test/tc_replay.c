@@ -0,0 +1,309 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_system.h"
+#include "sim_radio.h"
+#include "sim_replay.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+struct harness {
+
+    struct sim_system sys;
+    struct sim_radio radio;
+    struct ldl_radio driver;
+    struct ldl_sm sm;
+    struct ldl_mac mac;
+
+    uint8_t trace[32768];
+
+    /* everything the session did that can be observed */
+    uint8_t out[4096];
+    size_t out_len;
+
+    uint32_t events;
+};
+
+static const uint8_t key[] = "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f";
+static const uint8_t eui[] = "\x00\x00\x00\x00\x00\x00\x00\x01";
+
+/* helpers */
+
+static void put(struct harness *self, const void *data, size_t len)
+{
+    assert_true((self->out_len + len) <= sizeof(self->out));
+
+    (void)memcpy(&self->out[self->out_len], data, len);
+    self->out_len += len;
+}
+
+static void handler(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)((struct sim_system *)app)->user;
+    uint8_t buf[UINT8_MAX];
+    uint8_t len;
+    uint8_t t = (uint8_t)type;
+
+    (void)arg;
+
+    put(self, &t, sizeof(t));
+
+    self->events |= (1UL << type);
+
+    if(type == LDL_MAC_TX_BEGIN){
+
+        put(self, &self->radio.tx.freq, sizeof(self->radio.tx.freq));
+        put(self, &self->radio.tx.sf, sizeof(self->radio.tx.sf));
+        put(self, &self->radio.tx.len, sizeof(self->radio.tx.len));
+        put(self, self->radio.tx.data, self->radio.tx.len);
+
+        /* answer join requests in RX1 */
+        if(self->radio.tx.data[0] == 0x00U){
+
+            len = sim_network_join_accept(key, 1U, 0x13U, 0x01020304UL, 0U, 1U, buf);
+            sim_radio_queue(&self->radio, buf, len, -80, 500);
+        }
+    }
+}
+
+static void init_harness(struct harness *self, const uint8_t *replay, size_t len)
+{
+    struct ldl_mac_init_arg arg;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 42U);
+    sim_system_record(&self->sys, self->trace, sizeof(self->trace));
+
+    if(replay != NULL){
+
+        sim_system_replay(&self->sys, replay, len);
+    }
+
+    self->sys.user = self;
+
+    sim_radio_init(&self->radio, &self->sys.time);
+    sim_radio_set_entropy(&self->radio, 0xdeadbeefUL);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1276, &self->radio);
+    LDL_Radio_setPA(&self->driver, LDL_RADIO_PA_BOOST);
+
+    LDL_SM_init(&self->sm, key, key);
+
+    (void)memset(&arg, 0, sizeof(arg));
+
+    arg.app = &self->sys;
+    arg.radio = &self->driver;
+    arg.sm = &self->sm;
+    arg.handler = handler;
+    arg.joinEUI = eui;
+    arg.devEUI = eui;
+    arg.trace = sim_system_trace;
+
+    LDL_MAC_init(&self->mac, LDL_EU_863_870, &arg);
+}
+
+/* advance the simulation to the next MAC or radio event (no further than until) */
+static void step(struct harness *self, uint32_t until)
+{
+    uint32_t next;
+    uint32_t when;
+
+    LDL_MAC_process(&self->mac);
+
+    next = LDL_MAC_ticksUntilNextEvent(&self->mac);
+    next = (next < (until - self->sys.time)) ? next : (until - self->sys.time);
+
+    if(sim_radio_pending(&self->radio, &when) && ((int32_t)(when - self->sys.time) <= (int32_t)next)){
+
+        if((int32_t)(when - self->sys.time) > 0){
+
+            self->sys.time = when;
+        }
+
+        LDL_Radio_interrupt(&self->driver, sim_radio_fire(&self->radio));
+    }
+    else{
+
+        self->sys.time += next;
+    }
+}
+
+/* run until an event is seen or limit seconds pass */
+static void run_until(struct harness *self, enum ldl_mac_response_type type, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    while(((self->events & (1UL << type)) == 0U) && ((int32_t)(until - self->sys.time) > 0)){
+
+        step(self, until);
+    }
+}
+
+/* run until the MAC can accept a request or limit seconds pass */
+static void run_until_ready(struct harness *self, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    while(!LDL_MAC_ready(&self->mac) && ((int32_t)(until - self->sys.time) > 0)){
+
+        step(self, until);
+    }
+}
+
+static void record_session(struct harness *self)
+{
+    init_harness(self, NULL, 0U);
+
+    run_until(self, LDL_MAC_STARTUP, 10U);
+
+    assert_true(LDL_MAC_otaa(&self->mac));
+
+    run_until(self, LDL_MAC_JOIN_COMPLETE, 600U);
+
+    run_until_ready(self, 600U);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    run_until(self, LDL_MAC_DATA_COMPLETE, 600U);
+
+    assert_false(self->sys.overflow);
+}
+
+/* tests */
+
+static void recorded_session_shall_join_and_send(void **user)
+{
+    static struct harness rec;
+
+    (void)user;
+
+    record_session(&rec);
+
+    assert_true(LDL_MAC_joined(&rec.mac));
+    assert_true((rec.events & (1UL << LDL_MAC_JOIN_COMPLETE)) != 0U);
+    assert_true((rec.events & (1UL << LDL_MAC_DATA_COMPLETE)) != 0U);
+    assert_int_equal(2U, rec.radio.tx_count);
+    assert_int_equal(1U, rec.radio.rx_count);
+    assert_true(rec.sys.log_len > 0U);
+}
+
+static void replayed_session_shall_reproduce_trace_and_output(void **user)
+{
+    static struct harness rec;
+    static struct harness rep;
+
+    (void)user;
+
+    record_session(&rec);
+
+    init_harness(&rep, rec.trace, rec.sys.log_len);
+
+    assert_true(sim_replay_run(&rep.mac, &rep.sys, &rep.radio));
+
+    assert_true(LDL_MAC_joined(&rep.mac));
+    assert_int_equal(rec.sys.log_len, rep.sys.log_len);
+    assert_memory_equal(rec.trace, rep.trace, rec.sys.log_len);
+    assert_int_equal(rec.out_len, rep.out_len);
+    assert_memory_equal(rec.out, rep.out, rec.out_len);
+}
+
+static void replay_shall_detect_changed_input(void **user)
+{
+    static struct harness rec;
+    static struct harness rep;
+    struct sim_trace_record r;
+    size_t pos = 0U;
+    bool ok;
+
+    (void)user;
+
+    record_session(&rec);
+
+    /* perturb every random number the session consumed */
+    while(sim_system_parse(rec.trace, rec.sys.log_len, &pos, &r)){
+
+        if(r.type == LDL_TRACE_RAND){
+
+            rec.trace[pos - 1U] ^= 0x01U;
+        }
+    }
+
+    init_harness(&rep, rec.trace, rec.sys.log_len);
+
+    ok = sim_replay_run(&rep.mac, &rep.sys, &rep.radio);
+
+    assert_true(!ok || (rec.out_len != rep.out_len) || (memcmp(rec.out, rep.out, rec.out_len) != 0));
+}
+
+static void collected_timeout_shall_replay(void **user)
+{
+    static struct harness rec;
+    static struct harness rep;
+    static uint8_t trace[sizeof(rec.trace) + 8U];
+    static const uint8_t timeout[] = {(uint8_t)LDL_TRACE_RX, 5U, 0U, 0U, 0U, 0U, 0U, 1U};
+    struct sim_trace_record r;
+    size_t pos = 0U;
+    size_t at = 0U;
+    bool found = false;
+
+    (void)user;
+
+    record_session(&rec);
+
+    /* the last RX window timed out */
+    while(sim_system_parse(rec.trace, rec.sys.log_len, &pos, &r)){
+
+        if((r.type == LDL_TRACE_RADIO_EVENT) && (r.hdr[0] == (uint8_t)LDL_RADIO_EVENT_RX_TIMEOUT)){
+
+            at = pos;
+        }
+    }
+
+    assert_true(at > 0U);
+
+    /* report it the way SX126x does: RX_READY and a collect that timed out */
+    (void)memcpy(trace, rec.trace, at);
+    trace[at - 1U] = (uint8_t)LDL_RADIO_EVENT_RX_READY;
+    (void)memcpy(&trace[at], timeout, sizeof(timeout));
+    (void)memcpy(&trace[at + sizeof(timeout)], &rec.trace[at], rec.sys.log_len - at);
+
+    init_harness(&rep, trace, rec.sys.log_len + sizeof(timeout));
+
+    assert_true(sim_replay_run(&rep.mac, &rep.sys, &rep.radio));
+
+    assert_int_equal(rec.out_len, rep.out_len);
+    assert_memory_equal(rec.out, rep.out, rec.out_len);
+
+    /* and the outcome is traced again */
+    pos = 0U;
+
+    while(sim_system_parse(rep.trace, rep.sys.log_len, &pos, &r)){
+
+        if((r.type == LDL_TRACE_RX) && (r.hdrLen == 5U) && (r.hdr[4] != 0U)){
+
+            found = true;
+        }
+    }
+
+    assert_true(found);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(recorded_session_shall_join_and_send),
+        cmocka_unit_test(replayed_session_shall_reproduce_trace_and_output),
+        cmocka_unit_test(replay_shall_detect_changed_input),
+        cmocka_unit_test(collected_timeout_shall_replay)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,309 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "ldl_mac.h"
+#include "ldl_region.h"
+#include "ldl_system.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Benchmark for RX window scheduling
+ *
+ * For every region and rate an uplink is sent from a joined session
+ * and both RX windows are allowed to time out. The gateway clock is
+ * perfect so a downlink preamble would start exactly RX1Delay (and
+ * RX1Delay + 1s) after the end of the uplink in true time.
+ *
+ * The device is disturbed by:
+ *
+ * - xtal error (device clock runs fast or slow by up to ppm)
+ * - timer latency (process runs late after a timer expires)
+ * - interrupt jitter (radio interrupts are delivered late)
+ *
+ * A window is considered to catch the downlink if the receiver opens
+ * no later than 3 symbols into the 8 symbol preamble and stays open
+ * until at least 5 preamble symbols have been seen.
+ *
+ * The table printed reports per window:
+ *
+ * - open: receiver on time relative to preamble start (us, min/max)
+ * - margin: what the MAC reported in the slot event (us)
+ * - caught: trials where the downlink would have been received
+ *
+ * and rx_on: mean receiver on time per uplink (us).
+ *
+ * */
+
+#define TRIALS 16U
+#define PREAMBLE_DETECT 5
+
+struct profile {
+
+    const char *name;
+    uint32_t eps;           /**< error budget reported to the MAC (ticks per second) */
+    int32_t ppm;            /**< maximum actual clock error */
+    uint32_t advance;       /**< timing advance reported to the MAC (ticks) */
+    uint32_t latency;       /**< maximum timer latency (ticks) */
+    uint32_t jitter;        /**< maximum interrupt latency (ticks) */
+};
+
+struct window_stats {
+
+    uint32_t opened;
+    uint32_t caught;
+    int32_t open_min;
+    int32_t open_max;
+    uint32_t margin;
+    uint32_t error_over_margin;
+};
+
+struct harness {
+
+    struct sim_harness sim;
+
+    const struct profile *profile;
+
+    uint32_t tx_end;
+    uint32_t rx_on;
+
+    struct window_stats window[2];
+};
+
+static const struct profile profiles[] = {
+    {"ideal", 0U, 0, 0U, 0U, 0U},
+    {"typical", 30U, 20, 1000U, 1000U, 100U},
+    {"worst", 100U, 100, 3000U, 3000U, 1000U}
+};
+
+static const enum ldl_region regions[] = {
+    LDL_EU_863_870,
+    LDL_EU_433,
+    LDL_US_902_928,
+    LDL_AU_915_928
+};
+
+static const char *region_names[] = {
+    "EU_863_870",
+    "EU_433",
+    "US_902_928",
+    "AU_915_928"
+};
+
+/* helpers */
+
+static uint32_t random_up_to(uint32_t max)
+{
+    return (max > 0U) ? ((uint32_t)rand() % (max + 1U)) : 0U;
+}
+
+static uint32_t symbol_period(enum ldl_spreading_factor sf, enum ldl_signal_bandwidth bw)
+{
+    return (((uint32_t)1U << sf) * LDL_System_tps()) / LDL_MAC_bwToNumber(bw);
+}
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)sim;
+    struct window_stats *w;
+    uint32_t arrival;
+    uint32_t period;
+    int32_t open;
+
+    switch(type){
+    case LDL_MAC_TX_BEGIN:
+
+        self->tx_end = self->sim.radio.tx.time + LDL_MAC_transmitTimeUp(self->sim.radio.tx.bw, self->sim.radio.tx.sf, self->sim.radio.tx.len);
+        self->rx_on = self->sim.radio.rx_on;
+        break;
+
+    case LDL_MAC_RX1_SLOT:
+    case LDL_MAC_RX2_SLOT:
+
+        w = &self->window[(type == LDL_MAC_RX1_SLOT) ? 0 : 1];
+
+        w->margin = arg->rx_slot.margin;
+
+        if(self->sim.radio.rx){
+
+            arrival = self->tx_end + ((uint32_t)self->sim.mac.ctx.rx1Delay * LDL_System_tps()) + ((type == LDL_MAC_RX1_SLOT) ? 0U : LDL_System_tps());
+            period = symbol_period(arg->rx_slot.sf, arg->rx_slot.bw);
+            open = (int32_t)(self->sim.radio.rx_open - arrival);
+
+            w->opened++;
+
+            if((open <= (int32_t)((8 - PREAMBLE_DETECT) * period)) && ((open + (int32_t)(arg->rx_slot.timeout * period)) >= (int32_t)(PREAMBLE_DETECT * period))){
+
+                w->caught++;
+            }
+
+            w->open_min = (open < w->open_min) ? open : w->open_min;
+            w->open_max = (open > w->open_max) ? open : w->open_max;
+
+            if(arg->rx_slot.error > arg->rx_slot.margin){
+
+                w->error_over_margin++;
+            }
+        }
+        break;
+
+    case LDL_MAC_DATA_COMPLETE:
+
+        self->rx_on = self->sim.radio.rx_on - self->rx_on;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* timers and interrupts are serviced late by up to the profile limits */
+static void on_step(struct sim_harness *sim)
+{
+    struct harness *self = (struct harness *)sim;
+
+    sim->jitter = random_up_to(self->profile->jitter);
+    sim->latency = random_up_to(self->profile->latency);
+}
+
+static void init_harness(struct harness *self, enum ldl_region region, const struct profile *profile, uint32_t seed)
+{
+    self->profile = profile;
+
+    sim_harness_init(&self->sim, seed);
+
+    sim_system_set_eps(profile->eps);
+    sim_system_set_advance(profile->advance);
+
+    self->sim.sys.ppm = (profile->ppm > 0) ? ((int32_t)random_up_to(2U * (uint32_t)profile->ppm) - profile->ppm) : 0;
+
+    self->sim.on_event = on_event;
+    self->sim.on_step = on_step;
+
+    sim_harness_start(&self->sim, region, true);
+}
+
+static bool run_rate(struct harness *self, enum ldl_region region, const struct profile *profile, uint8_t rate, uint32_t *rx_on)
+{
+    bool retval = true;
+    uint32_t trial;
+
+    *rx_on = 0U;
+
+    (void)memset(self->window, 0, sizeof(self->window));
+
+    self->window[0].open_min = INT32_MAX;
+    self->window[0].open_max = INT32_MIN;
+    self->window[1].open_min = INT32_MAX;
+    self->window[1].open_max = INT32_MIN;
+
+    for(trial=0U; retval && (trial < TRIALS); trial++){
+
+        init_harness(self, region, profile, trial + 1U);
+
+        LDL_MAC_disableADR(&self->sim.mac);
+
+        if(LDL_MAC_setRate(&self->sim.mac, rate)){
+
+            assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+            sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+
+            *rx_on += self->rx_on;
+        }
+        else{
+
+            retval = false;
+        }
+    }
+
+    *rx_on /= TRIALS;
+
+    return retval;
+}
+
+static void print_window(const struct window_stats *w)
+{
+    if(w->opened > 0U){
+
+        printf(" %8ld %8ld %7lu %3lu/%-3lu", (long)w->open_min, (long)w->open_max, (unsigned long)w->margin, (unsigned long)w->caught, (unsigned long)TRIALS);
+    }
+    else{
+
+        printf(" %8s %8s %7lu %3lu/%-3lu", "-", "-", (unsigned long)w->margin, 0UL, (unsigned long)TRIALS);
+    }
+}
+
+/* tests */
+
+static void rx_windows_shall_be_scheduled_within_margin(void **user)
+{
+    static struct harness h;
+    const struct profile *profile;
+    uint32_t rx_on;
+    size_t p;
+    size_t r;
+    uint8_t rate;
+
+    (void)user;
+
+    srand(1);
+
+    for(p=0U; p < (sizeof(profiles)/sizeof(*profiles)); p++){
+
+        profile = &profiles[p];
+
+        printf("\nprofile=%s eps=%lu ppm=%ld advance=%lu latency=%lu jitter=%lu\n\n",
+            profile->name, (unsigned long)profile->eps, (long)profile->ppm,
+            (unsigned long)profile->advance, (unsigned long)profile->latency, (unsigned long)profile->jitter
+        );
+
+        printf("%-10s %4s | %8s %8s %7s %7s | %8s %8s %7s %7s | %8s\n", "region", "rate", "rx1_min", "rx1_max", "margin", "caught", "rx2_min", "rx2_max", "margin", "caught", "rx_on");
+
+        for(r=0U; r < (sizeof(regions)/sizeof(*regions)); r++){
+
+            for(rate=0U; rate < 16U; rate++){
+
+                if(run_rate(&h, regions[r], profile, rate, &rx_on)){
+
+                    printf("%-10s %4u |", region_names[r], rate);
+                    print_window(&h.window[0]);
+                    printf(" |");
+                    print_window(&h.window[1]);
+                    printf(" | %8lu\n", (unsigned long)rx_on);
+
+                    /* the MAC must never open a window it judged to be late */
+                    assert_int_equal(0U, h.window[0].error_over_margin);
+                    assert_int_equal(0U, h.window[1].error_over_margin);
+
+                    /* without disturbance every window must catch the downlink */
+                    if(p == 0U){
+
+                        assert_int_equal(TRIALS, h.window[0].caught);
+                        assert_int_equal(TRIALS, h.window[1].caught);
+                    }
+
+                    /* RX2 is slow enough in every region to absorb typical disturbance */
+                    if(p == 1U){
+
+                        assert_int_equal(TRIALS, h.window[1].caught);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(rx_windows_shall_be_scheduled_within_margin)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
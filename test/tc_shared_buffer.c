@@ -0,0 +1,210 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_harness.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+/* not a valid frame of any type */
+static const uint8_t junk[] = "\x40\xff\xff\xff\xff\x00\x00\x00\x01\x11\x22\x33\x44\x55\x66\x77\x88\x99\xaa\xbb\xcc\xdd\xee";
+
+struct harness {
+
+    struct sim_harness sim;
+
+    /* answer the next uplinks with junk */
+    uint8_t junk;
+
+    /* answer join requests once junk has run out */
+    bool accept;
+
+    /* answer the next data uplink with this many bytes */
+    uint8_t answer;
+
+    /* uplinks in order */
+    struct sim_radio_frame tx[2U];
+    uint8_t tx_count;
+};
+
+/* helpers */
+
+static void on_event(struct sim_harness *sim, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)sim;
+    uint8_t buf[UINT8_MAX];
+    uint8_t payload[UINT8_MAX - 13U];
+    uint8_t len;
+
+    (void)arg;
+
+    if(type == LDL_MAC_TX_BEGIN){
+
+        if(self->tx_count < (sizeof(self->tx)/sizeof(*self->tx))){
+
+            self->tx[self->tx_count] = self->sim.radio.tx;
+        }
+
+        self->tx_count++;
+
+        if(self->junk > 0U){
+
+            self->junk--;
+            sim_radio_queue(&self->sim.radio, junk, sizeof(junk) - 1U, -80, 500);
+        }
+        else if(self->accept && (self->sim.radio.tx.data[0] == 0x00U)){
+
+            len = sim_network_join_accept(sim_harness_key, 1U, 0x13U, 0x01020304UL, 0U, 1U, buf);
+            sim_radio_queue(&self->sim.radio, buf, len, -80, 500);
+        }
+        else if((self->answer > 0U) && (self->sim.radio.tx.data[0] != 0x00U)){
+
+            (void)memset(payload, 0x55, sizeof(payload));
+
+            len = sim_network_data_down(&self->sim.sm, self->sim.mac.ctx.devAddr, 1U, NULL, 0U, 10U, payload, self->answer, buf);
+            sim_radio_queue(&self->sim.radio, buf, len, -80, 500);
+
+            self->answer = 0U;
+        }
+        else{
+
+            /* nothing */
+        }
+    }
+}
+
+static void init(struct harness *self, bool joined)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_harness_init(&self->sim, 42U);
+    self->sim.on_event = on_event;
+
+    sim_harness_start(&self->sim, LDL_EU_863_870, joined);
+
+    LDL_MAC_disableADR(&self->sim.mac);
+}
+
+static int setup_joined(void **user)
+{
+    static struct harness h;
+
+    init(&h, true);
+
+    *user = &h;
+
+    return 0;
+}
+
+static int setup_not_joined(void **user)
+{
+    static struct harness h;
+
+    init(&h, false);
+
+    *user = &h;
+
+    return 0;
+}
+
+/* tests */
+
+static void join_request_shall_be_rebuilt_after_downlink(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    self->junk = 1U;
+    self->accept = true;
+
+    assert_true(LDL_MAC_otaa(&self->sim.mac));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_JOIN_COMPLETE, 600U);
+
+    assert_int_equal(2U, self->tx_count);
+
+    /* the junk was collected over the first request */
+    assert_int_equal(self->tx[0].len, self->tx[1].len);
+    assert_memory_equal(self->tx[0].data, self->tx[1].data, self->tx[0].len);
+}
+
+static void repeated_frame_shall_survive_downlink(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_mac_data_opts opts;
+
+    (void)memset(&opts, 0, sizeof(opts));
+    opts.nbTrans = 2U;
+
+    self->junk = 1U;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, &opts));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+
+    assert_int_equal(2U, self->tx_count);
+
+    assert_int_equal(self->tx[0].len, self->tx[1].len);
+    assert_memory_equal(self->tx[0].data, self->tx[1].data, self->tx[0].len);
+}
+
+static void downlink_shall_be_collected_into_tx_buffer(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t buf[64U];
+    uint8_t len;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, "hello", 5U, NULL));
+
+    len = sim_network_data_down(&self->sim.sm, self->sim.mac.ctx.devAddr, 1U, NULL, 0U, 10U, "on", 2U, buf);
+    sim_radio_queue(&self->sim.radio, buf, len, -80, 500);
+
+    sim_harness_run_until(&self->sim, LDL_MAC_RX, 600U);
+
+    assert_int_equal(10U, self->sim.rx_port);
+    assert_int_equal(2U, self->sim.rx_size);
+    assert_memory_equal("on", self->sim.rx_data, 2U);
+}
+
+static void downlink_shall_not_give_way_to_repeated_frame(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_mac_data_opts opts;
+    static const uint8_t data[200U];
+
+    (void)memset(&opts, 0, sizeof(opts));
+    opts.nbTrans = 3U;
+
+    /* more than would fit after the uplink */
+    self->answer = 50U;
+
+    assert_true(LDL_MAC_setRate(&self->sim.mac, 5U));
+
+    assert_true(LDL_MAC_unconfirmedData(&self->sim.mac, 1U, data, sizeof(data), &opts));
+
+    sim_harness_run_until(&self->sim, LDL_MAC_DATA_COMPLETE, 600U);
+
+    assert_true((self->sim.events & (1UL << LDL_MAC_RX)) != 0U);
+    assert_int_equal(50U, self->sim.rx_size);
+
+    /* a downlink ends the repetitions */
+    assert_int_equal(1U, self->tx_count);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(join_request_shall_be_rebuilt_after_downlink, setup_not_joined),
+        cmocka_unit_test_setup(repeated_frame_shall_survive_downlink, setup_joined),
+        cmocka_unit_test_setup(downlink_shall_be_collected_into_tx_buffer, setup_joined),
+        cmocka_unit_test_setup(downlink_shall_not_give_way_to_repeated_frame, setup_joined)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,541 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_system.h"
+#include "sim_sx126x.h"
+#include "sim_network.h"
+#include "ldl_mac.h"
+#include "ldl_sm.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+static const uint8_t key[] = "\x00\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0a\x0b\x0c\x0d\x0e\x0f";
+static const uint8_t eui[] = "\x00\x00\x00\x00\x00\x00\x00\x01";
+
+/* configuration commands, which are only sent when they change */
+static const uint8_t config[] = {0x96U, 0x8aU, 0x8fU, 0x98U, 0x86U, 0x8bU, 0x8cU, 0x08U, 0x8eU, 0x95U};
+
+struct harness {
+
+    struct sim_system sys;
+    struct sim_sx126x radio;
+    struct ldl_radio driver;
+    struct ldl_sm sm;
+    struct ldl_mac mac;
+
+    struct ldl_radio_tx_setting tx;
+    struct ldl_radio_rx_setting rx;
+
+    /* last radio event (driver tests) */
+    enum ldl_radio_event event;
+
+    uint32_t events;
+
+    /* last LDL_MAC_RX */
+    uint8_t rx_port;
+    uint8_t rx_data[UINT8_MAX];
+    uint8_t rx_size;
+};
+
+static struct harness h;
+
+/* helpers */
+
+static void radio_handler(struct ldl_mac *mac, enum ldl_radio_event event)
+{
+    (void)mac;
+
+    h.event = event;
+}
+
+static void handler(void *app, enum ldl_mac_response_type type, const union ldl_mac_response_arg *arg)
+{
+    struct harness *self = (struct harness *)((struct sim_system *)app)->user;
+
+    self->events |= (1UL << type);
+
+    if(type == LDL_MAC_RX){
+
+        self->rx_port = arg->rx.port;
+        self->rx_size = arg->rx.size;
+        (void)memcpy(self->rx_data, arg->rx.data, self->rx_size);
+    }
+}
+
+static void init(struct harness *self)
+{
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 1U);
+    self->sys.user = self;
+
+    sim_sx126x_init(&self->radio, &self->sys.time);
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1262, &self->radio);
+}
+
+static int setup_driver(void **user)
+{
+    struct harness *self = &h;
+
+    init(self);
+
+    LDL_Radio_setHandler(&self->driver, NULL, radio_handler);
+
+    self->tx.freq = 868100000UL;
+    self->tx.bw = LDL_BW_125;
+    self->tx.sf = LDL_SF_7;
+    self->tx.dbm = 1400;
+
+    self->rx.freq = 868100000UL;
+    self->rx.bw = LDL_BW_125;
+    self->rx.sf = LDL_SF_7;
+    self->rx.timeout = 8U;
+    self->rx.max = 64U;
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+    LDL_Radio_sleep(&self->driver);
+
+    *user = self;
+
+    return 0;
+}
+
+static uint32_t transactions(struct harness *self)
+{
+    uint32_t retval = self->radio.spi_transactions;
+
+    self->radio.spi_transactions = 0U;
+
+    return retval;
+}
+
+static uint32_t config_commands(const struct harness *self)
+{
+    uint32_t retval = 0U;
+    size_t i;
+
+    for(i=0U; i < sizeof(config); i++){
+
+        retval += self->radio.opcode_count[config[i]];
+    }
+
+    return retval;
+}
+
+/* complete the operation in progress and pass DIO1 to the driver */
+static void fire(struct harness *self)
+{
+    uint32_t when;
+
+    assert_true(sim_sx126x_pending(&self->radio, &when));
+
+    self->sys.time = when;
+
+    LDL_Radio_interrupt(&self->driver, sim_sx126x_fire(&self->radio));
+}
+
+static void step(struct harness *self, uint32_t until)
+{
+    uint32_t next;
+    uint32_t when;
+
+    LDL_MAC_process(&self->mac);
+
+    next = LDL_MAC_ticksUntilNextEvent(&self->mac);
+    next = (next < (until - self->sys.time)) ? next : (until - self->sys.time);
+
+    if(sim_sx126x_pending(&self->radio, &when) && ((int32_t)(when - self->sys.time) <= (int32_t)next)){
+
+        self->sys.time = when;
+
+        LDL_Radio_interrupt(&self->driver, sim_sx126x_fire(&self->radio));
+    }
+    else{
+
+        self->sys.time += next;
+    }
+}
+
+static void run_until(struct harness *self, enum ldl_mac_response_type type, uint32_t limit)
+{
+    uint32_t until = self->sys.time + (limit * LDL_System_tps());
+
+    self->events = 0U;
+
+    while(((self->events & (1UL << type)) == 0U) && ((int32_t)(until - self->sys.time) > 0)){
+
+        step(self, until);
+    }
+
+    assert_true((self->events & (1UL << type)) != 0U);
+}
+
+static int setup_mac(void **user)
+{
+    static struct ldl_mac_session session;
+    struct harness *self = &h;
+    struct ldl_mac_init_arg arg;
+
+    init(self);
+
+    LDL_SM_init(&self->sm, key, key);
+
+    (void)memset(&arg, 0, sizeof(arg));
+
+    arg.app = &self->sys;
+    arg.radio = &self->driver;
+    arg.sm = &self->sm;
+    arg.handler = handler;
+    arg.joinEUI = eui;
+    arg.devEUI = eui;
+
+    /* start from the default session for the region, as if joined */
+    LDL_MAC_init(&self->mac, LDL_EU_863_870, &arg);
+
+    session = self->mac.ctx;
+    session.joined = true;
+    session.devAddr = 0x01020304UL;
+
+    arg.session = &session;
+
+    LDL_MAC_init(&self->mac, LDL_EU_863_870, &arg);
+
+    run_until(self, LDL_MAC_STARTUP, 10U);
+
+    LDL_MAC_disableADR(&self->mac);
+
+    *user = self;
+
+    return 0;
+}
+
+/* tests */
+
+static void transmit_shall_configure_chip(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    const uint8_t data[] = "hello world";
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+
+    assert_int_equal(0U, self->radio.errors);
+    assert_int_equal(SIM_SX126X_TX, self->radio.mode);
+
+    assert_int_equal(0x01U, self->radio.packet_type);
+    assert_true((self->tx.freq - self->radio.tx.freq) < 2U);
+    assert_int_equal(LDL_SF_7, self->radio.tx.sf);
+    assert_int_equal(LDL_BW_125, self->radio.tx.bw);
+    assert_int_equal(14, self->radio.power);
+
+    /* public network sync word, IQ not inverted */
+    assert_int_equal(0x34U, self->radio.reg[0x40]);
+    assert_int_equal(0x44U, self->radio.reg[0x41]);
+    assert_int_equal(0x0dU, self->radio.reg[0x36]);
+
+    assert_int_equal(sizeof(data), self->radio.tx.len);
+    assert_memory_equal(data, self->radio.tx.data, sizeof(data));
+
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_TX_COMPLETE, self->event);
+}
+
+static void repeated_transmit_shall_only_send_changes(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    const uint8_t data[] = "hello world";
+    uint32_t first;
+    uint32_t config_first;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+    fire(self);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    first = transactions(self);
+    config_first = config_commands(self);
+
+    /* warm sleep keeps the configuration */
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+    fire(self);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(config_first, config_commands(self));
+    assert_true(transactions(self) < first);
+
+    /* a new frequency is the only change */
+    self->tx.freq = 868300000UL;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+
+    assert_int_equal(config_first + 1U, config_commands(self));
+    assert_true((self->tx.freq - self->radio.tx.freq) < 2U);
+
+    assert_int_equal(0U, self->radio.errors);
+    assert_int_equal(3U, self->radio.tx_count);
+}
+
+static void reset_shall_send_configuration_again(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    const uint8_t data[] = "hello world";
+    uint32_t config_first;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+    fire(self);
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    config_first = config_commands(self);
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+
+    assert_int_equal(2U * config_first, config_commands(self));
+    assert_int_equal(0U, self->radio.errors);
+    assert_memory_equal(data, self->radio.tx.data, sizeof(data));
+}
+
+static void receive_shall_time_out(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    uint8_t buf[64U];
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+
+    assert_int_equal(SIM_SX126X_RX, self->radio.mode);
+    assert_int_equal(self->rx.timeout, self->radio.symb_timeout);
+
+    /* explicit header with inverted IQ */
+    assert_int_equal(0x00U, self->radio.pkt[2]);
+    assert_int_equal(0x01U, self->radio.pkt[5]);
+    assert_int_equal(0x09U, self->radio.reg[0x36]);
+
+    (void)transactions(self);
+
+    fire(self);
+
+    /* DIO1 does not tell the two apart and the handler must not use SPI */
+    assert_int_equal(LDL_RADIO_EVENT_RX_READY, self->event);
+    assert_int_equal(0U, transactions(self));
+
+    assert_int_equal(0U, LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+    assert_true(meta.timeout);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void received_frame_shall_be_collected(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    const uint8_t data[] = "a downlink frame";
+    uint8_t buf[64U];
+
+    sim_sx126x_queue(&self->radio, data, sizeof(data), -60, 500);
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_RX_READY, self->event);
+
+    assert_int_equal(sizeof(data), LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+    assert_memory_equal(data, buf, sizeof(data));
+
+    assert_int_equal(-60, meta.rssi);
+    assert_int_equal(500, meta.snr);
+    assert_false(meta.timeout);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void frame_shall_fill_buffer(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    uint8_t data[32U];
+    uint8_t buf[sizeof(data)];
+    size_t i;
+
+    for(i=0U; i < sizeof(data); i++){
+
+        data[i] = (uint8_t)(i + 1U);
+    }
+
+    sim_sx126x_queue(&self->radio, data, sizeof(data), -60, 500);
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+
+    /* frame wraps around the end of the data buffer */
+    self->radio.rx_base = 0xf0U;
+
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_RX_READY, self->event);
+
+    assert_int_equal(sizeof(data), LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+    assert_memory_equal(data, buf, sizeof(data));
+
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void short_frame_shall_be_collected(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    const uint8_t data[] = {0xa5U};
+    uint8_t buf[sizeof(data)];
+
+    sim_sx126x_queue(&self->radio, data, sizeof(data), -60, 500);
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+
+    fire(self);
+
+    assert_int_equal(sizeof(data), LDL_Radio_collect(&self->driver, &meta, buf, sizeof(buf)));
+    assert_memory_equal(data, buf, sizeof(data));
+
+    LDL_Radio_clearInterrupt(&self->driver);
+
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void cad_shall_report_activity(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_cad_setting cad;
+
+    (void)memset(&cad, 0, sizeof(cad));
+
+    cad.freq = 868100000UL;
+    cad.bw = LDL_BW_125;
+    cad.sf = LDL_SF_7;
+
+    LDL_Radio_cad(&self->driver, &cad);
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_CAD_DONE, self->event);
+    assert_false(LDL_Radio_cadDetected(&self->driver));
+
+    sim_sx126x_set_activity(&self->radio, sim_sx126x_freq(&self->radio), true);
+
+    LDL_Radio_cad(&self->driver, &cad);
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_CAD_DONE, self->event);
+    assert_true(LDL_Radio_cadDetected(&self->driver));
+
+    assert_int_equal(2U, self->radio.cad_count);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void entropy_shall_be_read_from_rssi(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    sim_sx126x_set_entropy(&self->radio, 0xa5a5c3c3UL);
+
+    LDL_Radio_entropyBegin(&self->driver);
+
+    assert_int_equal(0xa5a5c3c3UL, LDL_Radio_entropyEnd(&self->driver));
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void uplink_and_downlink_shall_complete(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    const uint8_t data[] = "downlink";
+    uint8_t buf[64U];
+    uint8_t len;
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    len = sim_network_data_down(&self->sm, self->mac.ctx.devAddr, 1U, NULL, 0U, 2U, data, sizeof(data), buf);
+
+    sim_sx126x_queue(&self->radio, buf, len, -60, 500);
+
+    run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_true((self->events & (1UL << LDL_MAC_RX)) != 0U);
+
+    assert_int_equal(1U, self->radio.tx_count);
+    assert_int_equal(1U, self->radio.rx_count);
+
+    assert_int_equal(2U, self->rx_port);
+    assert_int_equal(sizeof(data), self->rx_size);
+    assert_memory_equal(data, self->rx_data, sizeof(data));
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void empty_windows_shall_time_out(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    assert_true(LDL_MAC_unconfirmedData(&self->mac, 1U, "hello", 5U, NULL));
+
+    run_until(self, LDL_MAC_DATA_COMPLETE, 60U);
+
+    assert_true((self->events & (1UL << LDL_MAC_DATA_COMPLETE)) != 0U);
+    assert_true((self->events & (1UL << LDL_MAC_DOWNSTREAM)) == 0U);
+
+    /* both windows opened and closed on a timeout */
+    assert_int_equal(1U, self->radio.tx_count);
+    assert_int_equal(0U, self->radio.rx_count);
+    assert_true((self->events & (1UL << LDL_MAC_RX1_SLOT)) != 0U);
+    assert_true((self->events & (1UL << LDL_MAC_RX2_SLOT)) != 0U);
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void fsk_rate_shall_be_rejected(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    /* DR7 is FSK in this region but the SX126x driver has no FSK modem */
+    assert_false(LDL_MAC_setRate(&self->mac, 7U));
+    assert_int_equal(LDL_ERRNO_RATE, LDL_MAC_errno(&self->mac));
+
+    assert_true(LDL_MAC_setRate(&self->mac, 6U));
+    assert_int_equal(6U, LDL_MAC_getRate(&self->mac));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(transmit_shall_configure_chip, setup_driver),
+        cmocka_unit_test_setup(repeated_transmit_shall_only_send_changes, setup_driver),
+        cmocka_unit_test_setup(reset_shall_send_configuration_again, setup_driver),
+        cmocka_unit_test_setup(receive_shall_time_out, setup_driver),
+        cmocka_unit_test_setup(received_frame_shall_be_collected, setup_driver),
+        cmocka_unit_test_setup(frame_shall_fill_buffer, setup_driver),
+        cmocka_unit_test_setup(short_frame_shall_be_collected, setup_driver),
+        cmocka_unit_test_setup(cad_shall_report_activity, setup_driver),
+        cmocka_unit_test_setup(entropy_shall_be_read_from_rssi, setup_driver),
+        cmocka_unit_test_setup(uplink_and_downlink_shall_complete, setup_mac),
+        cmocka_unit_test_setup(empty_windows_shall_time_out, setup_mac),
+        cmocka_unit_test_setup(fsk_rate_shall_be_rejected, setup_mac)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,228 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+
+#include "cmocka.h"
+
+#include "sim_system.h"
+#include "sim_sx126x.h"
+#include "sim_async.h"
+#include "ldl_radio.h"
+#include "ldl_system.h"
+
+#include <string.h>
+
+struct harness {
+
+    struct sim_system sys;
+    struct sim_sx126x radio;
+    struct sim_async async;
+    struct ldl_radio driver;
+
+    struct ldl_radio_tx_setting tx;
+    struct ldl_radio_rx_setting rx;
+
+    /* last radio event other than chip complete */
+    enum ldl_radio_event event;
+};
+
+static struct harness h;
+
+/* helpers */
+
+static void radio_handler(struct ldl_mac *mac, enum ldl_radio_event event)
+{
+    (void)mac;
+
+    if(event != LDL_RADIO_EVENT_CHIP_COMPLETE){
+
+        h.event = event;
+    }
+}
+
+/* BUSY falling edge */
+static void ready(void *board)
+{
+    sim_sx126x_wait_busy((struct sim_sx126x *)board);
+}
+
+static int setup(void **user)
+{
+    struct harness *self = &h;
+
+    (void)memset(self, 0, sizeof(*self));
+
+    sim_system_init(&self->sys, 1U);
+
+    sim_sx126x_init(&self->radio, &self->sys.time);
+
+    /* every wait for BUSY must be made by the worker */
+    self->radio.check_busy = true;
+
+    LDL_Radio_init(&self->driver, LDL_RADIO_SX1262, &self->radio);
+    LDL_Radio_setHandler(&self->driver, NULL, radio_handler);
+
+    sim_async_init(&self->async, &self->radio, &self->driver);
+    self->async.ready = ready;
+
+    self->tx.freq = 868100000UL;
+    self->tx.bw = LDL_BW_125;
+    self->tx.sf = LDL_SF_7;
+    self->tx.dbm = 1400;
+
+    self->rx.freq = 868100000UL;
+    self->rx.bw = LDL_BW_125;
+    self->rx.sf = LDL_SF_7;
+    self->rx.timeout = 8U;
+    self->rx.max = 64U;
+
+    LDL_Radio_reset(&self->driver, true);
+    LDL_Radio_reset(&self->driver, false);
+    LDL_Radio_sleep(&self->driver);
+    sim_async_wait(&self->async);
+
+    *user = self;
+
+    return 0;
+}
+
+static int teardown(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+
+    sim_async_deinit(&self->async);
+
+    return 0;
+}
+
+/* resume until the driver has nothing left to do */
+static void finish(struct harness *self)
+{
+    sim_async_wait(&self->async);
+
+    while(LDL_Radio_pending(&self->driver)){
+
+        LDL_Radio_resume(&self->driver);
+        sim_async_wait(&self->async);
+    }
+}
+
+static void fire(struct harness *self)
+{
+    uint32_t when;
+
+    assert_true(sim_sx126x_pending(&self->radio, &when));
+
+    self->sys.time = when;
+
+    LDL_Radio_interrupt(&self->driver, sim_sx126x_fire(&self->radio));
+}
+
+/* tests */
+
+static void transfers_shall_wait_for_busy_except_to_wake(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    const uint8_t data[] = "hello world";
+
+    self->radio.spi_transactions = 0U;
+    self->radio.busy_waits = 0U;
+    self->radio.wakes = 0U;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+    finish(self);
+
+    assert_int_equal(0U, self->radio.errors);
+    assert_int_equal(SIM_SX126X_TX, self->radio.mode);
+
+    assert_int_equal(sizeof(data), self->radio.tx.len);
+    assert_memory_equal(data, self->radio.tx.data, sizeof(data));
+
+    /* woken from sleep without waiting, then a wait ahead of every transfer */
+    assert_int_equal(1U, self->radio.wakes);
+    assert_int_equal(self->radio.spi_transactions - 1U, self->radio.busy_waits);
+
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_TX_COMPLETE, self->event);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+    finish(self);
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+static void long_frame_shall_be_written_over_several_batches(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    uint8_t data[UINT8_MAX];
+    uint32_t batches;
+    size_t i;
+
+    for(i=0U; i < sizeof(data); i++){
+
+        data[i] = (uint8_t)i;
+    }
+
+    batches = self->async.batches;
+
+    LDL_Radio_transmit(&self->driver, &self->tx, data, sizeof(data));
+    finish(self);
+
+    assert_true((self->async.batches - batches) > 1U);
+
+    assert_int_equal(0U, self->radio.errors);
+    assert_int_equal(SIM_SX126X_TX, self->radio.mode);
+
+    assert_int_equal(sizeof(data), self->radio.tx.len);
+    assert_memory_equal(data, self->radio.tx.data, sizeof(data));
+}
+
+static void received_frame_shall_be_collected(void **user)
+{
+    struct harness *self = (struct harness *)(*user);
+    struct ldl_radio_packet_metadata meta;
+    const uint8_t data[] = "a downlink frame";
+    uint8_t buf[64U];
+
+    sim_sx126x_queue(&self->radio, data, sizeof(data), -60, 500);
+
+    LDL_Radio_receive(&self->driver, &self->rx);
+    finish(self);
+
+    fire(self);
+
+    assert_int_equal(LDL_RADIO_EVENT_RX_READY, self->event);
+
+    LDL_Radio_collectBegin(&self->driver, buf, sizeof(buf));
+    sim_async_wait(&self->async);
+
+    while(!LDL_Radio_collectResume(&self->driver)){
+
+        sim_async_wait(&self->async);
+    }
+
+    assert_int_equal(sizeof(data), LDL_Radio_collectEnd(&self->driver, &meta));
+    assert_memory_equal(data, buf, sizeof(data));
+
+    assert_int_equal(-60, meta.rssi);
+    assert_int_equal(500, meta.snr);
+
+    LDL_Radio_clearInterrupt(&self->driver);
+    finish(self);
+
+    assert_int_equal(SIM_SX126X_SLEEP, self->radio.mode);
+    assert_int_equal(0U, self->radio.errors);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(transfers_shall_wait_for_busy_except_to_wake, setup, teardown),
+        cmocka_unit_test_setup_teardown(long_frame_shall_be_written_over_several_batches, setup, teardown),
+        cmocka_unit_test_setup_teardown(received_frame_shall_be_collected, setup, teardown)
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}